@@ -0,0 +1,12 @@
+/*
+
+    IMPORTANT! This file is auto-generated each time you save your
+    project - if you alter its contents, your changes may be overwritten!
+
+*/
+
+#pragma once
+
+#ifndef JucePlugin_LV2URI
+ #define JucePlugin_LV2URI "urn:orbitaudio:OrbitPlugin"
+#endif
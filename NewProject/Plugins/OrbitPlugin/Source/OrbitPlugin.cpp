@@ -0,0 +1,29 @@
+/*
+  ==============================================================================
+    OrbitPlugin: the OrbitAudio engine as an LV2/VST3 effect.
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "../../../Source/OrbitAudioProcessor.h"
+
+//==============================================================================
+// I'm the plugin build of OrbitAudioProcessor: the same DSP the app runs, plus the host's
+// generic editor (a slider, toggle or menu per parameter, grouped as the layout is).
+class OrbitPlugin  : public OrbitAudioProcessor
+{
+public:
+    OrbitPlugin() = default;
+
+    juce::AudioProcessorEditor* createEditor() override     { return new juce::GenericAudioProcessorEditor (*this); }
+    bool hasEditor() const override                         { return true; }
+
+private:
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (OrbitPlugin)
+};
+
+//==============================================================================
+juce::AudioProcessor* JUCE_CALLTYPE createPluginFilter()
+{
+    return new OrbitPlugin();
+}
@@ -0,0 +1,554 @@
+#include "AmbisonicBank.h"
+#include "SpatialDsp.h"
+#include "OrbitTrajectory.h"
+
+//==============================================================================
+AmbisonicBank::AmbisonicBank()
+{
+    // One aligned block for everything the field and the convolution touch per sub-block.
+    const size_t total = 2 * (size_t) maxChannels * controlBlockSize                  // encoded, rotated
+                       + (size_t) maxChannels * fftSize                             // input frames
+                       + (size_t) maxChannels * maxPartitions * spectrumSize        // input spectra
+                       + 4 * (size_t) fftSize                                       // FFT in and out
+                       + 2 * (size_t) spectrumSize;                                 // accumulators
+    workspace.calloc (total + 16);
+
+    auto* next = juce::snapPointerToAlignment (workspace.get(), 64);
+    const auto take = [&next] (size_t count) { auto* p = next; next += count; return p; };
+    encoded      = take ((size_t) maxChannels * controlBlockSize);
+    rotated      = take ((size_t) maxChannels * controlBlockSize);
+    inputFrames  = take ((size_t) maxChannels * fftSize);
+    inputSpectra = take ((size_t) maxChannels * maxPartitions * spectrumSize);
+    fftInput     = reinterpret_cast<Complex*> (take (2 * (size_t) fftSize));
+    fftOutput    = reinterpret_cast<Complex*> (take (2 * (size_t) fftSize));
+    accumulators = take (2 * (size_t) spectrumSize);
+}
+
+//==============================================================================
+void AmbisonicBank::setHrirSet (std::shared_ptr<const HrirSet> newSet)
+{
+    jassert (newSet == nullptr || ! newSet->isEmpty());
+    const auto& source = newSet != nullptr ? newSet : AmbisonicHrirFilters::getParametricHead();
+    auto filters = std::make_shared<const AmbisonicHrirFilters> (*source, preparedSampleRate.load());
+
+    std::shared_ptr<const AmbisonicHrirFilters> toRelease;
+    {
+        const juce::SpinLock::ScopedLockType lock (filterLock);
+        toRelease = std::move (retiredFilters);
+        pendingFilters = std::move (filters);
+        hrirSet = std::move (newSet);
+    }
+}
+
+void AmbisonicBank::adoptPendingFilters()
+{
+    const juce::SpinLock::ScopedTryLockType lock (filterLock);
+
+    // Filters designed for another rate wait for prepareToPlay() to redesign them.
+    if (! lock.isLocked() || pendingFilters == nullptr
+        || ! juce::approximatelyEqual (pendingFilters->getSampleRate(), sampleRate))
+        return;
+
+    // setHrirSet() has already released the previous retired filters, so nothing is freed here.
+    jassert (retiredFilters == nullptr);
+    retiredFilters = std::move (activeFilters);
+    activeFilters = std::move (pendingFilters);
+}
+
+void AmbisonicBank::setOrder (int newOrder)
+{
+    newOrder = juce::jlimit (1, Ambisonics::maxOrder, newOrder);
+
+    if (newOrder != order)
+    {
+        order = newOrder;
+        reset();
+    }
+}
+
+void AmbisonicBank::setDepth (float d)
+{
+    depth = juce::jlimit (0.0f, 1.0f, d);
+}
+
+void AmbisonicBank::setWidth (float w)
+{
+    width = juce::jlimit (0.0f, 1.0f, w);
+}
+
+//==============================================================================
+void AmbisonicBank::prepareToPlay (int /*samplesPerBlockExpected*/, double sampleRateIn)
+{
+    sampleRate = sampleRateIn;
+    preparedSampleRate.store (sampleRate);
+    lfoPhase = 0.0;
+    depthLPF_L = depthLPF_R = 0.0f;
+    depthMix = depth;
+    depthAlpha = depthMix > 0.0f
+        ? SpatialDsp::onePoleAlpha (juce::jmap (depthMix, SpatialDsp::nearDepthCutoffHz, SpatialDsp::farDepthCutoffHz), sampleRate)
+        : 0.0f;
+
+    // The audio callback isn't running here, so I can redesign for a new rate in place.
+    std::shared_ptr<const HrirSet> set;
+    {
+        const juce::SpinLock::ScopedLockType lock (filterLock);
+        set = hrirSet;
+        if (pendingFilters != nullptr && ! juce::approximatelyEqual (pendingFilters->getSampleRate(), sampleRate))
+            pendingFilters = nullptr;
+    }
+
+    adoptPendingFilters();
+
+    if (activeFilters == nullptr || ! juce::approximatelyEqual (activeFilters->getSampleRate(), sampleRate))
+        activeFilters = std::make_shared<const AmbisonicHrirFilters> (set != nullptr ? *set : *AmbisonicHrirFilters::getParametricHead(),
+                                                                      sampleRate);
+
+    reset();
+}
+
+void AmbisonicBank::reset()
+{
+    juce::FloatVectorOperations::clear (inputFrames, maxChannels * fftSize);
+    juce::FloatVectorOperations::clear (inputSpectra, maxChannels * maxPartitions * spectrumSize);
+    newestSpectrum = 0;
+    inputPos = 0;
+
+    // Every channel starts drained: silent, and skipped until something reaches it.
+    std::fill (std::begin (quietPartitions), std::end (quietPartitions), maxPartitions + 1);
+    std::fill (std::begin (hadInput), std::end (hadInput), false);
+
+    gainsOrder = 0;
+    rotationValid = false;
+}
+
+//==============================================================================
+void AmbisonicBank::updateGains (int numInputChannels, SourceLayout layout)
+{
+    const bool fromScratch = gainsOrder != order || gainsInputs != numInputChannels || gainsLayout != layout;
+
+    if (! fromScratch && juce::approximatelyEqual (gainsWidth, width))
+        return;
+
+    // A new layout is a different set of sources, so it starts where it is; only a width
+    // change glides.
+    gainsRamping = ! fromScratch;
+    if (gainsRamping)
+        std::memcpy (previousGains, gains, sizeof (gains));
+
+    gainsInputs = numInputChannels;
+    gainsLayout = layout;
+    gainsOrder = order;
+    gainsWidth = width;
+
+    // The ring before any rotation: source s at s turns of the spread clockwise from the
+    // front. A stereo pair's channels sit either side of its place, up to 30 degrees out
+    // (a quarter of the spacing, when the sources are closer), each at half gain so a
+    // centred mono signal in both comes out as loud as one mono channel.
+    const int numSources = SpatializerBank::getNumSources (numInputChannels, layout);
+    const float spread = juce::MathConstants<float>::twoPi / (float) numSources;
+    const float pairOffset = width * juce::jmin (0.25f * spread, juce::MathConstants<float>::pi / 6.0f);
+
+    for (int ch = 0; ch < numInputChannels; ++ch)
+    {
+        float azimuth = spread * (float) ch;
+        float gain = 1.0f;
+
+        if (layout == SourceLayout::StereoPairs)
+        {
+            const int source = ch / 2;
+            azimuth = spread * (float) source;
+
+            // A trailing odd channel is a mono source.
+            if (2 * source + 1 < numInputChannels)
+            {
+                azimuth += (ch % 2 == 0 ? -pairOffset : pairOffset);
+                gain = 0.5f;
+            }
+        }
+
+        Ambisonics::encode (order, Ambisonics::toDirection (azimuth, 0.0f), gains[ch]);
+        juce::FloatVectorOperations::multiply (gains[ch], gain, Ambisonics::getNumChannels (order));
+    }
+}
+
+void AmbisonicBank::encode (const float* const* inputs, int numInputChannels, int offset, int n, const float* ramp)
+{
+    const int numChannels = Ambisonics::getNumChannels (order);
+    std::fill (std::begin (encodedLive), std::end (encodedLive), false);
+
+    for (int c = 0; c < numChannels; ++c)
+        juce::FloatVectorOperations::clear (encoded + c * controlBlockSize, n);
+
+    for (int ch = 0; ch < numInputChannels; ++ch)
+    {
+        const float* in = inputs[ch] + offset;
+
+        if (gainsRamping)
+        {
+            // gain = previous + (new - previous) * ramp, per sample.
+            alignas (16) float rampedIn[controlBlockSize];
+            juce::FloatVectorOperations::multiply (rampedIn, in, ramp, n);
+
+            for (int c = 0; c < numChannels; ++c)
+            {
+                const float from = previousGains[ch][c], to = gains[ch][c];
+                if (from == 0.0f && to == 0.0f)
+                    continue;
+
+                juce::FloatVectorOperations::addWithMultiply (encoded + c * controlBlockSize, in, from, n);
+                juce::FloatVectorOperations::addWithMultiply (encoded + c * controlBlockSize, rampedIn, to - from, n);
+                encodedLive[c] = true;
+            }
+        }
+        else
+        {
+            // On the ear-level ring the height channels' gains are exactly zero.
+            for (int c = 0; c < numChannels; ++c)
+            {
+                if (gains[ch][c] == 0.0f)
+                    continue;
+
+                juce::FloatVectorOperations::addWithMultiply (encoded + c * controlBlockSize, in, gains[ch][c], n);
+                encodedLive[c] = true;
+            }
+        }
+    }
+}
+
+void AmbisonicBank::rotate (int n, const float* ramp, const juce::dsp::Matrix<float>& to)
+{
+    // Harmonics only mix within their degree, so each row only reads its own block, and
+    // a row whose live inputs all have zero coefficients stays empty.
+    const auto& from = *currentRotation;
+
+    for (int l = 0; l <= order; ++l)
+    {
+        const int first = Ambisonics::getChannel (l, -l), last = Ambisonics::getChannel (l, l);
+
+        for (int row = first; row <= last; ++row)
+        {
+            auto* out = rotated + row * controlBlockSize;
+            alignas (16) float change[controlBlockSize];
+            bool live = false, changing = false;
+            juce::FloatVectorOperations::clear (out, n);
+
+            for (int column = first; column <= last; ++column)
+            {
+                const float a = from ((size_t) row, (size_t) column), b = to ((size_t) row, (size_t) column);
+                if (! encodedLive[column] || (a == 0.0f && b == 0.0f))
+                    continue;
+
+                const auto* in = encoded + column * controlBlockSize;
+                juce::FloatVectorOperations::addWithMultiply (out, in, a, n);
+                live = true;
+
+                if (b != a)
+                {
+                    if (! changing)
+                        juce::FloatVectorOperations::clear (change, n);
+
+                    juce::FloatVectorOperations::addWithMultiply (change, in, b - a, n);
+                    changing = true;
+                }
+            }
+
+            // out = from * in + ramp * (to - from) * in
+            if (changing)
+                juce::FloatVectorOperations::addWithMultiply (out, change, ramp, n);
+
+            rotatedLive[row] = live;
+        }
+    }
+}
+
+//==============================================================================
+void AmbisonicBank::renderEars (float* left, float* right, int numSamples)
+{
+    const int numChannels = Ambisonics::getNumChannels (order);
+    const int numPartitions = activeFilters->getNumPartitions();
+
+    // Y = sum over channels and partitions of X[c][newest - p] * H[c][p], in split complex
+    // form, for both ears in one pass over the input spectra.
+    float* leftRe = accumulators;
+    float* leftIm = leftRe + binStride;
+    float* rightRe = accumulators + spectrumSize;
+    float* rightIm = rightRe + binStride;
+    juce::FloatVectorOperations::clear (accumulators, 2 * spectrumSize);
+
+    for (int c = 0; c < numChannels; ++c)
+    {
+        if (! convolving[c])
+            continue;
+
+        for (int p = 0; p < numPartitions; ++p)
+        {
+            const int slot = (newestSpectrum - p + maxPartitions) % maxPartitions;
+            const float* xRe = inputSpectra + (c * maxPartitions + slot) * spectrumSize;
+            const float* xIm = xRe + binStride;
+            const float* lRe = activeFilters->getPartition (order, c, 0, p);
+            const float* lIm = lRe + binStride;
+            const float* rRe = activeFilters->getPartition (order, c, 1, p);
+            const float* rIm = rRe + binStride;
+
+            for (int b = 0; b < binStride; ++b)
+            {
+                leftRe[b]  += xRe[b] * lRe[b] - xIm[b] * lIm[b];
+                leftIm[b]  += xRe[b] * lIm[b] + xIm[b] * lRe[b];
+                rightRe[b] += xRe[b] * rRe[b] - xIm[b] * rIm[b];
+                rightIm[b] += xRe[b] * rIm[b] + xIm[b] * rRe[b];
+            }
+        }
+    }
+
+    // Both ears' outputs are real, so one inverse transform of left + i * right gives the
+    // left ear in the real part and the right in the imaginary part.
+    for (int b = 0; b < numBins; ++b)
+    {
+        fftInput[b] = { leftRe[b] - rightIm[b], leftIm[b] + rightRe[b] };
+
+        if (b > 0 && b < fftSize / 2)
+            fftInput[fftSize - b] = { leftRe[b] + rightIm[b], rightRe[b] - leftIm[b] };
+    }
+
+    fft.perform (fftInput, fftOutput, true);
+
+    // Overlap-save: the second half of the frame is the valid, alias-free output.
+    const auto* valid = fftOutput + partitionSize + inputPos;
+    for (int i = 0; i < numSamples; ++i)
+    {
+        left[i] = valid[i].real();
+        right[i] = valid[i].imag();
+    }
+}
+
+void AmbisonicBank::transformPair (int first, int second)
+{
+    // Two real frames go through one complex FFT, as the real and imaginary parts; each
+    // spectrum is then the Hermitian or anti-Hermitian part of the result. That halves the
+    // forward transforms wherever the real-only one is a complex one underneath.
+    const float* a = inputFrames + first * fftSize;
+    const float* b = second >= 0 ? inputFrames + second * fftSize : nullptr;
+
+    for (int i = 0; i < fftSize; ++i)
+        fftInput[i] = { a[i], b != nullptr ? b[i] : 0.0f };
+
+    fft.perform (fftInput, fftOutput, false);
+
+    float* firstSpectrum = inputSpectra + (first * maxPartitions + newestSpectrum) * spectrumSize;
+    float* secondSpectrum = second >= 0 ? inputSpectra + (second * maxPartitions + newestSpectrum) * spectrumSize : nullptr;
+
+    for (int k = 0; k < numBins; ++k)
+    {
+        const auto z = fftOutput[k];
+        const auto mirrored = std::conj (fftOutput[(fftSize - k) % fftSize]);
+
+        // A = (Z[k] + conj Z[N - k]) / 2, B = (Z[k] - conj Z[N - k]) / 2i.
+        firstSpectrum[k] = 0.5f * (z.real() + mirrored.real());
+        firstSpectrum[binStride + k] = 0.5f * (z.imag() + mirrored.imag());
+
+        if (secondSpectrum != nullptr)
+        {
+            secondSpectrum[k] = 0.5f * (z.imag() - mirrored.imag());
+            secondSpectrum[binStride + k] = 0.5f * (mirrored.real() - z.real());
+        }
+    }
+}
+
+void AmbisonicBank::convolve (int done, int numSamples, float* left, float* right)
+{
+    jassert (inputPos + numSamples <= partitionSize);
+    const int numChannels = Ambisonics::getNumChannels (order);
+    int numConvolving = 0;
+    int unpaired = -1;
+
+    for (int c = 0; c < numChannels; ++c)
+    {
+        // A channel that's been silent for longer than the spectrum ring holds has only
+        // zeros left in it, so there's nothing to transform or accumulate.
+        convolving[c] = rotatedLive[c] || quietPartitions[c] <= maxPartitions;
+        if (! convolving[c])
+            continue;
+
+        ++numConvolving;
+        hadInput[c] = hadInput[c] || rotatedLive[c];
+
+        // I transform the partially filled newest partition on every call, which is what
+        // keeps the convolution at zero latency for any block size.
+        auto* frame = inputFrames + c * fftSize;
+        juce::FloatVectorOperations::copy (frame + partitionSize + inputPos, rotated + c * controlBlockSize + done, numSamples);
+
+        if (unpaired < 0)
+        {
+            unpaired = c;
+        }
+        else
+        {
+            transformPair (unpaired, c);
+            unpaired = -1;
+        }
+    }
+
+    if (unpaired >= 0)
+        transformPair (unpaired, -1);
+
+    renderEars (left, right, numSamples);
+    liveChannels.store (numConvolving);
+
+    inputPos += numSamples;
+    if (inputPos == partitionSize)
+    {
+        // The newest partition is complete: it becomes history and a new one starts.
+        for (int c = 0; c < numChannels; ++c)
+        {
+            if (convolving[c])
+            {
+                auto* frame = inputFrames + c * fftSize;
+                juce::FloatVectorOperations::copy (frame, frame + partitionSize, partitionSize);
+                juce::FloatVectorOperations::clear (frame + partitionSize, partitionSize);
+            }
+
+            quietPartitions[c] = hadInput[c] ? 0 : juce::jmin (quietPartitions[c] + 1, maxPartitions + 1);
+            hadInput[c] = false;
+        }
+
+        newestSpectrum = (newestSpectrum + 1) % maxPartitions;
+        inputPos = 0;
+    }
+}
+
+//==============================================================================
+void AmbisonicBank::process (juce::AudioBuffer<float>& buffer,
+                             int startSample,
+                             int numSamples,
+                             int numInputChannels,
+                             SourceLayout layout,
+                             const OrbitPath& path,
+                             float loopsPerSecond)
+{
+    jassert (buffer.getNumChannels() >= 2);
+    numInputChannels = juce::jmin (numInputChannels, buffer.getNumChannels(), maxInputs);
+
+    const float* inputs[maxInputs];
+    for (int ch = 0; ch < numInputChannels; ++ch)
+        inputs[ch] = buffer.getReadPointer (ch, startSample);
+
+    process (inputs, numInputChannels, buffer.getWritePointer (0, startSample), buffer.getWritePointer (1, startSample),
+             numSamples, layout, path, loopsPerSecond);
+}
+
+void AmbisonicBank::process (const float* const* inputs,
+                             int numInputChannels,
+                             float* outLeft,
+                             float* outRight,
+                             int numSamples,
+                             SourceLayout layout,
+                             const OrbitPath& path,
+                             float loopsPerSecond)
+{
+    adoptPendingFilters();
+
+    const int numSources = SpatializerBank::getNumSources (numInputChannels, layout);
+    if (activeFilters == nullptr || numSources == 0)
+        return;
+
+    numInputChannels = juce::jmin (numInputChannels, layout == SourceLayout::StereoPairs ? maxInputs : maxSources);
+    updateGains (numInputChannels, layout);
+
+    const float depthVal = depth;
+    const float depthAlphaTarget = depthVal > 0.0f
+        ? SpatialDsp::onePoleAlpha (juce::jmap (depthVal, SpatialDsp::nearDepthCutoffHz, SpatialDsp::farDepthCutoffHz), sampleRate)
+        : 0.0f;
+
+    const double phaseIncrement = juce::MathConstants<double>::twoPi * (double) loopsPerSecond / sampleRate;
+
+    alignas (16) float ramp[controlBlockSize];
+    alignas (16) float mixL[controlBlockSize];
+    alignas (16) float mixR[controlBlockSize];
+
+    for (int offset = 0; offset < numSamples; offset += controlBlockSize)
+    {
+        const int n = juce::jmin (controlBlockSize, numSamples - offset);
+
+        lfoPhase += phaseIncrement * n;
+        if (lfoPhase > juce::MathConstants<double>::twoPi)
+            lfoPhase -= juce::MathConstants<double>::twoPi;
+
+        // The whole ring turns to put source 0 at the path's azimuth, then the other way
+        // from the head, whose rotation undoes itself column by column. A still source
+        // heard by a still head keeps the matrix it has.
+        const float yaw = path.getPosition (lfoPhase).azimuth;
+        const auto head = headMotion.at ((offset + n) / sampleRate);
+        const bool turning = ! rotationValid || yaw != rotationYaw || head != rotationHead;
+        rotationYaw = yaw;
+        rotationHead = head;
+
+        if (turning)
+        {
+            Ambisonics::setRotation (cartesian, yaw, 0.0f, 0.0f);
+
+            for (size_t column = 0; column < 3; ++column)
+                head.toHeadRelative (cartesian (0, column), cartesian (1, column), cartesian (2, column));
+
+            rotator.compute (cartesian, *targetRotation);
+        }
+
+        // Right after a reset there's no previous rotation to ramp from.
+        if (! rotationValid)
+        {
+            for (size_t row = 0; row < (size_t) maxChannels; ++row)
+                for (size_t column = 0; column < (size_t) maxChannels; ++column)
+                    (*currentRotation) (row, column) = (*targetRotation) (row, column);
+
+            rotationValid = true;
+        }
+
+        SpatialDsp::fillRamp (ramp, 0.0f, 1.0f, n);
+        encode (inputs, numInputChannels, offset, n, ramp);
+        rotate (n, ramp, turning ? *targetRotation : *currentRotation);
+        gainsRamping = false;
+
+        // The sub-block may straddle a partition boundary when buffers aren't a multiple
+        // of the partition size, so I decode it in at most two pieces.
+        for (int done = 0; done < n;)
+        {
+            const int piece = juce::jmin (n - done, partitionSize - inputPos);
+            convolve (done, piece, mixL + done, mixR + done);
+            done += piece;
+        }
+
+        if (depthMix > 0.0f || depthVal > 0.0f)
+        {
+            alignas (16) float alphaRamp[controlBlockSize];
+            alignas (16) float mixRamp[controlBlockSize];
+            alignas (16) float filtered[controlBlockSize];
+            SpatialDsp::fillRamp (alphaRamp, depthAlpha, depthAlphaTarget, n);
+            SpatialDsp::fillRamp (mixRamp, depthMix, depthVal, n);
+
+            const auto depthStage = [&] (float* channel, float& state)
+            {
+                juce::FloatVectorOperations::copy (filtered, channel, n);
+                SpatialDsp::onePoleInPlace (filtered, alphaRamp, state, n);
+                juce::FloatVectorOperations::subtract (filtered, channel, n);
+                juce::FloatVectorOperations::addWithMultiply (channel, filtered, mixRamp, n);
+            };
+
+            depthStage (mixL, depthLPF_L);
+            depthStage (mixR, depthLPF_R);
+        }
+        else
+        {
+            depthLPF_L = mixL[n - 1];
+            depthLPF_R = mixR[n - 1];
+        }
+
+        // Every input has been encoded for this sub-block, so I can overwrite it with the mix.
+        juce::FloatVectorOperations::copy (outLeft + offset, mixL, n);
+        juce::FloatVectorOperations::copy (outRight + offset, mixR, n);
+
+        if (turning)
+            std::swap (currentRotation, targetRotation);
+
+        depthAlpha = depthAlphaTarget;
+        depthMix = depthVal;
+    }
+}
@@ -0,0 +1,172 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "Ambisonics.h"
+#include "AmbisonicHrirFilters.h"
+#include "SpatializerBank.h"
+
+//==============================================================================
+// I'm the SpatializerBank's ambisonic alternative for many sources: its cost grows with
+// the ambisonic order, not with the number of sources. I place the sources on the same
+// ring (spread evenly at ear level, source 0 at the path's azimuth) and mix them down to
+// binaural stereo in three steps:
+//
+//  - Encode: every input channel adds itself to a first to third order ambisonic field
+//    (4, 9 or 16 channels) with a gain vector. The sources sit still relative to each
+//    other, so the vectors only change with the layout or the width.
+//  - Rotate: the ring's motion round the orbit is one rotation of the whole field, a
+//    block-diagonal matrix from Ambisonics::Rotator, worked out once per sub-block and
+//    ramped per sample like every other control. The listener's head turning, tipping
+//    or leaning is folded into the same matrix, so head tracking costs nothing more.
+//  - Decode: each field channel is convolved with its pair of AmbisonicHrirFilters ear
+//    filters, summed, with the HrtfRenderer's zero-latency partitioned overlap-save,
+//    accumulated in the frequency domain. The field channels go through the forward FFT
+//    two at a time and both ears come back through one inverse, packed as the real and
+//    imaginary parts of a complex transform. The filters come from the loaded HRIR set,
+//    or from the parametric head when there isn't one.
+//
+// Channels with nothing in them (the height channels, for the ear-level ring) are
+// skipped in all three steps once their history has drained. I apply the depth low-pass
+// after decoding; the ITD and shadow controls belong to the head the filters came from.
+// I never allocate on the audio thread and add no latency.
+class AmbisonicBank
+{
+public:
+    static constexpr int maxSources = SpatializerBank::maxSources;
+    static constexpr int controlBlockSize = Spatializer::controlBlockSize;
+    using SourceLayout = SpatializerBank::SourceLayout;
+
+    AmbisonicBank();
+    ~AmbisonicBank() = default;
+
+    // I design the decoding filters for a new HRIR set (nullptr goes back to the parametric
+    // head) and hand them to the audio thread. Call from the message thread.
+    void setHrirSet (std::shared_ptr<const HrirSet> newSet);
+
+    // I reset the field and convolution state and rebuild the filters if the rate changed.
+    void prepareToPlay (int samplesPerBlockExpected, double sampleRate);
+
+    // As SpatializerBank::process(): I read numInputChannels input channels from buffer and
+    // replace channels 0 and 1 with the binaural mix of all sources.
+    void process (juce::AudioBuffer<float>& buffer,
+                  int startSample,
+                  int numSamples,
+                  int numInputChannels,
+                  SourceLayout layout,
+                  const OrbitPath& path,
+                  float loopsPerSecond);
+
+    // As above, from separate input buffers into outLeft and outRight; an output may be
+    // one of the inputs.
+    void process (const float* const* inputs,
+                  int numInputChannels,
+                  float* outLeft,
+                  float* outRight,
+                  int numSamples,
+                  SourceLayout layout,
+                  const OrbitPath& path,
+                  float loopsPerSecond);
+
+    // I silence the field and the convolution history, as prepareToPlay() does, for a
+    // caller that stopped feeding me for a while. Audio thread.
+    void reset();
+
+    // Like the other processors' setters, these belong to the thread that calls process().
+    // The order runs from 1 to Ambisonics::maxOrder; changing it restarts the decoder.
+    void setOrder (int order);
+    void setDepth (float depth);
+    void setWidth (float width);     // how far a stereo pair's channels spread about its place
+
+    // As Spatializer::setHeadMotion(), in all three angles.
+    void setHeadMotion (const HeadMotion& motion)   { headMotion = motion; }
+
+    int getOrder() const                        { return order; }
+    double getOrbitPhase() const                { return lfoPhase; }
+    int getLatencySamples() const               { return 0; }
+
+    // Any thread: how many field channels the last block convolved, after skipping the
+    // empty ones.
+    int getNumLiveChannels() const              { return liveChannels.load(); }
+
+private:
+    static constexpr int partitionSize = AmbisonicHrirFilters::partitionSize;
+    static constexpr int fftSize = AmbisonicHrirFilters::fftSize;
+    static constexpr int numBins = AmbisonicHrirFilters::numBins;
+    static constexpr int binStride = AmbisonicHrirFilters::binStride;
+    static constexpr int spectrumSize = AmbisonicHrirFilters::spectrumSize;
+    static constexpr int maxPartitions = AmbisonicHrirFilters::maxPartitions;
+    static constexpr int maxChannels = Ambisonics::maxChannels;
+    static constexpr int maxInputs = 2 * maxSources;
+    static_assert (controlBlockSize == partitionSize, "one rotation per partition");
+
+    void adoptPendingFilters();
+
+    void updateGains (int numInputChannels, SourceLayout layout);
+    void encode (const float* const* inputs, int numInputChannels, int offset, int numSamples, const float* ramp);
+    void rotate (int numSamples, const float* ramp, const juce::dsp::Matrix<float>& to);
+    void transformPair (int first, int second);
+    void convolve (int done, int numSamples, float* left, float* right);
+    void renderEars (float* left, float* right, int numSamples);
+
+    double sampleRate = 44100.0;
+    double lfoPhase = 0.0;
+    int order = 1;
+    float depth = 0.0f, width = 1.0f;
+    float depthAlpha = 0.0f, depthMix = 0.0f;
+    float depthLPF_L = 0.0f, depthLPF_R = 0.0f;
+
+    // The filters follow the HrtfRenderer's cache hand-over: the audio thread owns
+    // activeFilters, setHrirSet() parks new ones in pendingFilters, and the old ones wait
+    // in retiredFilters to be released on the message thread.
+    juce::SpinLock filterLock;
+    std::shared_ptr<const HrirSet> hrirSet;
+    std::shared_ptr<const AmbisonicHrirFilters> activeFilters, pendingFilters, retiredFilters;
+    std::atomic<double> preparedSampleRate { 44100.0 };
+
+    // Encoding: one gain vector per input channel, ramped from the previous ones when the
+    // layout or width changes. gainsInputs, gainsLayout, gainsOrder and gainsWidth are what
+    // they were worked out for; a gainsOrder of 0 means they need working out from scratch.
+    float gains[maxInputs][maxChannels] = {};
+    float previousGains[maxInputs][maxChannels] = {};
+    bool encodedLive[maxChannels] = {};
+    int gainsInputs = 0, gainsOrder = 0;
+    SourceLayout gainsLayout = SourceLayout::MonoChannels;
+    float gainsWidth = 0.0f;
+    bool gainsRamping = false;
+
+    // Rotation: the field matrices at the start and end of the sub-block, and the orbit's
+    // yaw and the head orientation the newest one was worked out for.
+    Ambisonics::Rotator rotator;
+    juce::dsp::Matrix<float> cartesian { 3, 3 };
+    juce::dsp::Matrix<float> rotationA { maxChannels, maxChannels }, rotationB { maxChannels, maxChannels };
+    juce::dsp::Matrix<float>* currentRotation = &rotationA;
+    juce::dsp::Matrix<float>* targetRotation = &rotationB;
+    float rotationYaw = 0.0f;
+    HeadOrientation rotationHead;
+    HeadMotion headMotion;
+    bool rotationValid = false;
+
+    // Decoding: per field channel, the last two partitions of input and a ring of recent
+    // input spectra (newestSpectrum is the one being filled), as in the HrtfRenderer.
+    // quietPartitions counts whole partitions a channel has had no input; once its
+    // filters have rung out it's skipped.
+    juce::dsp::FFT fft { AmbisonicHrirFilters::fftOrder };
+    juce::HeapBlock<float> workspace;
+    float* encoded = nullptr;                  // maxChannels * controlBlockSize
+    float* rotated = nullptr;                  // maxChannels * controlBlockSize
+    float* inputFrames = nullptr;              // maxChannels * fftSize
+    float* inputSpectra = nullptr;             // maxChannels * maxPartitions * spectrumSize
+    using Complex = juce::dsp::Complex<float>;
+    Complex* fftInput = nullptr;               // fftSize
+    Complex* fftOutput = nullptr;              // fftSize
+    float* accumulators = nullptr;             // 2 * spectrumSize, left then right
+    bool rotatedLive[maxChannels] = {};
+    bool convolving[maxChannels] = {};
+    bool hadInput[maxChannels] = {};
+    int quietPartitions[maxChannels] = {};
+    int newestSpectrum = 0;
+    int inputPos = 0;
+    std::atomic<int> liveChannels { 0 };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (AmbisonicBank)
+};
@@ -0,0 +1,224 @@
+#include <JuceHeader.h>
+#include "AmbisonicBank.h"
+#include "OrbitTrajectory.h"
+
+//==============================================================================
+// I test the AmbisonicBank end to end: with an HRIR set that is itself third order in
+// direction, encoding, rotating and decoding a source reproduces its HRIR exactly, on the
+// measured grid or between it, and at any buffer size; the parametric head puts a source
+// on the right in the right ear; the ring's height channels are skipped; and a source
+// circling the head glides without clicks.
+class AmbisonicBankTest : public juce::UnitTest
+{
+public:
+    AmbisonicBankTest() : juce::UnitTest ("AmbisonicBank", "Audio") {}
+
+    static constexpr double sampleRate = 48000.0;
+    static constexpr int irLength = 8;
+
+    // Each ear's IR is a fixed mix of the third-order harmonics of the direction, so the
+    // decoding filters can fit it exactly.
+    struct HarmonicHead
+    {
+        float weights[2][irLength][Ambisonics::maxChannels] = {};
+
+        explicit HarmonicHead (juce::Random& random)
+        {
+            for (auto& ear : weights)
+                for (auto& tap : ear)
+                    for (auto& w : tap)
+                        w = random.nextFloat() - 0.5f;
+        }
+
+        float getTap (int ear, int tap, float azimuth, float elevation) const
+        {
+            float gains[Ambisonics::maxChannels];
+            Ambisonics::encode (Ambisonics::maxOrder, Ambisonics::toDirection (azimuth, elevation), gains);
+
+            float sum = 0.0f;
+            for (int c = 0; c < Ambisonics::maxChannels; ++c)
+                sum += weights[ear][tap][c] * gains[c];
+            return sum;
+        }
+
+        std::shared_ptr<const HrirSet> makeSet() const
+        {
+            auto set = std::make_shared<HrirSet>();
+            juce::AudioBuffer<float> ir (2, 32);
+
+            for (int elevation = -90; elevation <= 90; elevation += 15)
+            {
+                for (int azimuth = 0; azimuth < 360; azimuth += std::abs (elevation) == 90 ? 360 : 15)
+                {
+                    ir.clear();
+                    for (int ear = 0; ear < 2; ++ear)
+                        for (int tap = 0; tap < irLength; ++tap)
+                            ir.setSample (ear, tap, getTap (ear, tap, juce::degreesToRadians ((float) azimuth),
+                                                            juce::degreesToRadians ((float) elevation)));
+
+                    set->addMeasurement ((float) azimuth, (float) elevation, ir, sampleRate);
+                }
+            }
+
+            return set;
+        }
+    };
+
+    static OrbitPath stillAt (float azimuth)
+    {
+        return OrbitPath::still ({ azimuth, 0.0f, SpatialDsp::referenceDistance });
+    }
+
+    // An impulse on one mono source at azimuth, processed blockSize samples at a time.
+    static juce::AudioBuffer<float> impulseResponse (AmbisonicBank& bank, float azimuth, int blockSize, int length = 256)
+    {
+        juce::AudioBuffer<float> buffer (2, length);
+        buffer.clear();
+        buffer.setSample (0, 0, 1.0f);
+
+        const auto path = stillAt (azimuth);
+        for (int start = 0; start < length; start += blockSize)
+            bank.process (buffer, start, juce::jmin (blockSize, length - start), 1,
+                          AmbisonicBank::SourceLayout::MonoChannels, path, 0.0f);
+
+        return buffer;
+    }
+
+    static float rms (const juce::AudioBuffer<float>& buffer, int channel)
+    {
+        return buffer.getRMSLevel (channel, 0, buffer.getNumSamples());
+    }
+
+    void runTest() override
+    {
+        auto random = getRandom();
+        const auto pi = juce::MathConstants<float>::pi;
+
+        beginTest ("a third-order head decodes exactly, on its grid and between it, at any buffer size");
+        {
+            const HarmonicHead head (random);
+            AmbisonicBank bank;
+            bank.setHrirSet (head.makeSet());
+            bank.setOrder (3);
+            bank.prepareToPlay (512, sampleRate);
+
+            for (const float degrees : { 0.0f, 90.0f, 37.0f, 200.0f, 311.5f })
+            {
+                const float azimuth = juce::degreesToRadians (degrees);
+                bank.prepareToPlay (512, sampleRate);
+                const auto whole = impulseResponse (bank, azimuth, 512);
+
+                for (int ear = 0; ear < 2; ++ear)
+                {
+                    for (int tap = 0; tap < 32; ++tap)
+                    {
+                        const float expected = tap < irLength ? head.getTap (ear, tap, azimuth, 0.0f) : 0.0f;
+                        expectWithinAbsoluteError (whole.getSample (ear, tap), expected, 0.01f,
+                                                   juce::String (degrees) + " degrees, tap " + juce::String (tap));
+                    }
+                }
+
+                // Blocks that straddle partitions, sub-blocks and the control grid.
+                bank.prepareToPlay (512, sampleRate);
+                const auto pieces = impulseResponse (bank, azimuth, 37);
+                for (int ear = 0; ear < 2; ++ear)
+                    for (int i = 0; i < pieces.getNumSamples(); ++i)
+                        expectWithinAbsoluteError (pieces.getSample (ear, i), whole.getSample (ear, i), 1.0e-5f);
+            }
+        }
+
+        beginTest ("the parametric head: a source on the right is louder on the right");
+        {
+            AmbisonicBank bank;
+            bank.prepareToPlay (512, sampleRate);
+
+            for (int order = 1; order <= Ambisonics::maxOrder; ++order)
+            {
+                bank.setOrder (order);
+                juce::AudioBuffer<float> buffer (2, 4096);
+
+                const auto render = [&] (float azimuth)
+                {
+                    for (int i = 0; i < buffer.getNumSamples(); ++i)
+                        buffer.setSample (0, i, random.nextFloat() - 0.5f);
+
+                    bank.prepareToPlay (512, sampleRate);
+                    for (int start = 0; start < buffer.getNumSamples(); start += 512)
+                        bank.process (buffer, start, 512, 1, AmbisonicBank::SourceLayout::MonoChannels, stillAt (azimuth), 0.0f);
+                };
+
+                render (0.5f * pi);
+                expectGreaterThan (juce::Decibels::gainToDecibels (rms (buffer, 1) / rms (buffer, 0)), 3.0f,
+                                   "order " + juce::String (order));
+
+                render (-0.5f * pi);
+                expectGreaterThan (juce::Decibels::gainToDecibels (rms (buffer, 0) / rms (buffer, 1)), 3.0f);
+
+                render (0.0f);
+                expectWithinAbsoluteError (juce::Decibels::gainToDecibels (rms (buffer, 0) / rms (buffer, 1)), 0.0f, 0.5f,
+                                           "in front, both ears alike");
+            }
+        }
+
+        beginTest ("32 sources on the ear-level ring fill only the horizontal channels");
+        {
+            AmbisonicBank bank;
+            bank.prepareToPlay (256, sampleRate);
+            juce::AudioBuffer<float> buffer (AmbisonicBank::maxSources, 1024);
+
+            const auto render = [&] (AmbisonicBank::SourceLayout layout)
+            {
+                for (int ch = 0; ch < buffer.getNumChannels(); ++ch)
+                    for (int i = 0; i < buffer.getNumSamples(); ++i)
+                        buffer.setSample (ch, i, 0.1f * (random.nextFloat() - 0.5f));
+
+                for (int start = 0; start < buffer.getNumSamples(); start += 256)
+                    bank.process (buffer, start, 256, buffer.getNumChannels(), layout,
+                                  OrbitPath::getBuiltIn (Spatializer::OrbitMode::Orbit), 0.5f);
+            };
+
+            // Degree l has two horizontal harmonics (one for W), whose terms are all even in z.
+            const int horizontal[] = { 0, 3, 6, 10 };
+
+            for (int order = 1; order <= Ambisonics::maxOrder; ++order)
+            {
+                bank.setOrder (order);
+                render (AmbisonicBank::SourceLayout::MonoChannels);
+                expectEquals (bank.getNumLiveChannels(), horizontal[order], "order " + juce::String (order));
+
+                const auto level = rms (buffer, 0);
+                expect (std::isfinite (level) && level > 0.001f);
+
+                render (AmbisonicBank::SourceLayout::StereoPairs);
+                expectEquals (bank.getNumLiveChannels(), horizontal[order]);
+            }
+        }
+
+        beginTest ("a source circling the head glides without clicks");
+        {
+            AmbisonicBank bank;
+            bank.setOrder (3);
+            bank.prepareToPlay (128, sampleRate);
+
+            const int length = (int) sampleRate;
+            juce::AudioBuffer<float> buffer (2, length);
+            for (int i = 0; i < length; ++i)
+                buffer.setSample (0, i, 0.5f * std::sin (juce::MathConstants<float>::twoPi * 200.0f * (float) i / (float) sampleRate));
+
+            for (int start = 0; start < length; start += 128)
+                bank.process (buffer, start, 128, 1, AmbisonicBank::SourceLayout::MonoChannels,
+                              OrbitPath::getBuiltIn (Spatializer::OrbitMode::Orbit), 2.0f);
+
+            // A 200 Hz tone's second difference is tiny; a step in any gain or filter isn't.
+            float worst = 0.0f;
+            for (int ear = 0; ear < 2; ++ear)
+                for (int i = 1024; i < length - 1; ++i)
+                    worst = juce::jmax (worst, std::abs (buffer.getSample (ear, i + 1) - 2.0f * buffer.getSample (ear, i)
+                                                         + buffer.getSample (ear, i - 1)));
+
+            expectLessThan (worst, 0.01f);
+        }
+    }
+};
+
+static AmbisonicBankTest ambisonicBankTest;
@@ -0,0 +1,196 @@
+#include "AmbisonicHrirFilters.h"
+#include "Spatializer.h"
+
+//==============================================================================
+AmbisonicHrirFilters::AmbisonicHrirFilters (const HrirSet& set, double sampleRateIn)
+    : sampleRate (sampleRateIn)
+{
+    jassert (! set.isEmpty());
+    const int numMeasurements = set.size();
+
+    // Partition count from the longest IR once it's at the device rate.
+    const double speedRatio = set.getSampleRate() / sampleRate;
+    int longest = 1;
+    for (int m = 0; m < numMeasurements; ++m)
+        longest = juce::jmax (longest, (int) std::ceil (set.getImpulseResponse (m).getNumSamples() / speedRatio));
+
+    numPartitions = juce::jlimit (1, maxPartitions, (longest + partitionSize - 1) / partitionSize);
+    const int numTaps = numPartitions * partitionSize;
+
+    // Every measurement at the device rate, both ears, zero-padded to numTaps.
+    std::vector<float> measured ((size_t) numMeasurements * 2 * (size_t) numTaps, 0.0f);
+    for (int m = 0; m < numMeasurements; ++m)
+    {
+        for (int ear = 0; ear < 2; ++ear)
+        {
+            const auto taps = set.getResampledTaps (m, ear, sampleRate, numTaps);
+            std::copy (taps.begin(), taps.end(), measured.begin() + (m * 2 + ear) * numTaps);
+        }
+    }
+
+    int total = 0;
+    for (int order = 1; order <= Ambisonics::maxOrder; ++order)
+    {
+        orderOffsets[order] = total;
+        total += Ambisonics::getNumChannels (order) * 2 * numPartitions * spectrumSize;
+    }
+
+    arena.calloc ((size_t) total + 16);
+    filters = juce::snapPointerToAlignment (arena.get(), 64);
+
+    const auto weights = getQuadratureWeights (set);
+    juce::dsp::FFT fft (fftOrder);
+    std::vector<float> fftBuffer (2 * fftSize);
+    std::vector<float> channelTaps;
+    float gains[Ambisonics::maxChannels];
+
+    for (int order = 1; order <= Ambisonics::maxOrder; ++order)
+    {
+        const int numChannels = Ambisonics::getNumChannels (order);
+
+        // Least squares: find the filters H minimising sum over measurements of
+        // weight * |encode (direction) . H - hrir|^2, i.e. solve (Yt W Y + lambda I) H = Yt W hrirs.
+        juce::dsp::Matrix<float> design ((size_t) numMeasurements, (size_t) numChannels);
+        juce::dsp::Matrix<float> weighted ((size_t) numChannels, (size_t) numMeasurements);
+
+        for (int m = 0; m < numMeasurements; ++m)
+        {
+            Ambisonics::encode (order, Ambisonics::toDirection (juce::degreesToRadians (set.getAzimuth (m)),
+                                                                juce::degreesToRadians (set.getElevation (m))), gains);
+
+            for (int c = 0; c < numChannels; ++c)
+            {
+                design ((size_t) m, (size_t) c) = gains[c];
+                weighted ((size_t) c, (size_t) m) = weights[(size_t) m] * gains[c];
+            }
+        }
+
+        auto normal = weighted * design;
+
+        float trace = 0.0f;
+        for (int c = 0; c < numChannels; ++c)
+            trace += normal ((size_t) c, (size_t) c);
+
+        for (int c = 0; c < numChannels; ++c)
+            normal ((size_t) c, (size_t) c) += regularisation * trace / (float) numChannels;
+
+        // Solving for one measurement's column of Yt W gives what its IR adds to every
+        // channel's filter.
+        channelTaps.assign ((size_t) numChannels * 2 * (size_t) numTaps, 0.0f);
+        juce::dsp::Matrix<float> share ((size_t) numChannels, 1);
+
+        for (int m = 0; m < numMeasurements; ++m)
+        {
+            for (int c = 0; c < numChannels; ++c)
+                share ((size_t) c, 0) = weighted ((size_t) c, (size_t) m);
+
+            const bool solved = normal.solve (share);
+            jassertquiet (solved);
+
+            for (int c = 0; c < numChannels; ++c)
+                for (int ear = 0; ear < 2; ++ear)
+                    juce::FloatVectorOperations::addWithMultiply (channelTaps.data() + (c * 2 + ear) * numTaps,
+                                                                  measured.data() + (m * 2 + ear) * numTaps,
+                                                                  share ((size_t) c, 0), numTaps);
+        }
+
+        for (int c = 0; c < numChannels; ++c)
+        {
+            for (int ear = 0; ear < 2; ++ear)
+            {
+                for (int p = 0; p < numPartitions; ++p)
+                {
+                    // Each partition goes in the first half of a zero-padded FFT frame.
+                    std::fill (fftBuffer.begin(), fftBuffer.end(), 0.0f);
+                    const auto* first = channelTaps.data() + (c * 2 + ear) * numTaps + p * partitionSize;
+                    std::copy (first, first + partitionSize, fftBuffer.begin());
+
+                    fft.performRealOnlyForwardTransform (fftBuffer.data(), true);
+
+                    auto* dest = filters + getPartitionOffset (order, c, ear, p);
+                    for (int b = 0; b < numBins; ++b)
+                    {
+                        dest[b] = fftBuffer[(size_t) (2 * b)];
+                        dest[binStride + b] = fftBuffer[(size_t) (2 * b + 1)];
+                    }
+                }
+            }
+        }
+    }
+}
+
+std::vector<float> AmbisonicHrirFilters::getQuadratureWeights (const HrirSet& set)
+{
+    // A ring covers the band of sphere from halfway to the ring below to halfway to the
+    // one above (the lowest and highest reach the poles), shared out evenly along it.
+    const int numRings = set.getNumRings();
+    std::vector<float> ringWeights ((size_t) numRings);
+
+    for (int r = 0; r < numRings; ++r)
+    {
+        const float elevation = set.getRingElevation (r);
+        const float bottom = r == 0 ? -90.0f : 0.5f * (elevation + set.getRingElevation (r - 1));
+        const float top = r == numRings - 1 ? 90.0f : 0.5f * (elevation + set.getRingElevation (r + 1));
+        const float area = juce::MathConstants<float>::twoPi
+                             * (std::sin (juce::degreesToRadians (top)) - std::sin (juce::degreesToRadians (bottom)));
+
+        int count = 0;
+        for (int m = 0; m < set.size(); ++m)
+            if (juce::approximatelyEqual (set.getElevation (m), elevation))
+                ++count;
+
+        ringWeights[(size_t) r] = area / (float) juce::jmax (1, count);
+    }
+
+    std::vector<float> weights ((size_t) set.size());
+    for (int m = 0; m < set.size(); ++m)
+        for (int r = 0; r < numRings; ++r)
+            if (juce::approximatelyEqual (set.getElevation (m), set.getRingElevation (r)))
+                weights[(size_t) m] = ringWeights[(size_t) r];
+
+    return weights;
+}
+
+//==============================================================================
+std::shared_ptr<const HrirSet> AmbisonicHrirFilters::getParametricHead()
+{
+    static const std::shared_ptr<const HrirSet> head = []
+    {
+        constexpr double headRate = 48000.0;
+        constexpr int runIn = Spatializer::controlBlockSize;
+        constexpr int length = 128;     // past the slowest shadow filter's tail at this rate
+
+        auto set = std::make_shared<HrirSet>();
+        Spatializer spatializer;
+        juce::AudioBuffer<float> buffer (2, runIn + length);
+        juce::AudioBuffer<float> ir (2, length);
+
+        for (int elevation = -90; elevation <= 90; elevation += 15)
+        {
+            // The poles are a single point each.
+            const int azimuthStep = std::abs (elevation) == 90 ? 360 : 15;
+
+            for (int azimuth = 0; azimuth < 360; azimuth += azimuthStep)
+            {
+                const Spatializer::Position position { juce::degreesToRadians ((float) azimuth),
+                                                       juce::degreesToRadians ((float) elevation),
+                                                       SpatialDsp::referenceDistance };
+
+                // An impulse in both channels, after a sub-block of silence so every cue has settled.
+                spatializer.prepareToPlay (runIn + length, headRate);
+                buffer.clear();
+                buffer.setSample (0, runIn, 1.0f);
+                buffer.setSample (1, runIn, 1.0f);
+                spatializer.process (buffer, 0, runIn + length, position);
+
+                ir.copyFrom (0, 0, buffer, 0, runIn, length);
+                ir.copyFrom (1, 0, buffer, 1, runIn, length);
+                set->addMeasurement ((float) azimuth, (float) elevation, ir, headRate);
+            }
+        }
+
+        return std::shared_ptr<const HrirSet> (std::move (set));
+    }();
+
+    return head;
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "Ambisonics.h"
+#include "HrirSet.h"
+#include "HrirSpectrumCache.h"
+
+//==============================================================================
+// I turn an HRIR set into spherical-harmonic-domain filters: one pair of ear filters
+// per ambisonic channel, so that filtering each channel of a field with its pair and
+// summing gives what the listener would hear from everything in it. Decoding a field
+// then costs the same however many sources went into it.
+//
+// For every order I fit the filters to all the measurements at once by least squares:
+// each measurement stands for the patch of sphere nearest it (the band between its ring
+// and the next, shared out along the ring), and a little Tikhonov regularisation keeps
+// harmonics the set doesn't sample (the poles, for sets without them) from blowing up.
+// The fit is a dsp::Matrix solve per measurement; then every filter is resampled to the
+// device rate, cut into partitions and transformed, laid out like the HrirSpectrumCache's
+// filters. I'm built off the audio thread and then only read.
+class AmbisonicHrirFilters
+{
+public:
+    static constexpr int partitionSize = HrirSpectrumCache::partitionSize;
+    static constexpr int fftOrder = HrirSpectrumCache::fftOrder;
+    static constexpr int fftSize = HrirSpectrumCache::fftSize;
+    static constexpr int numBins = HrirSpectrumCache::numBins;
+    static constexpr int binStride = HrirSpectrumCache::binStride;
+    static constexpr int spectrumSize = 2 * binStride;   // split re/im
+
+    // Every channel's filter is convolved all the time, so I cut them shorter than the
+    // HrtfRenderer's: 512 taps, past 10 ms at 48 kHz, where measured HRIRs have died away.
+    static constexpr int maxPartitions = 16;
+
+    // Regularisation, relative to the fit's mean diagonal.
+    static constexpr float regularisation = 1.0e-3f;
+
+    AmbisonicHrirFilters (const HrirSet& set, double sampleRate);
+    ~AmbisonicHrirFilters() = default;
+
+    double getSampleRate() const                { return sampleRate; }
+    int getNumPartitions() const                { return numPartitions; }
+
+    // One ear's partition of one channel's filter at an order (1 to maxOrder).
+    const float* getPartition (int order, int channel, int ear, int partition) const noexcept
+    {
+        return filters + getPartitionOffset (order, channel, ear, partition);
+    }
+
+    // The parametric head's own impulse responses (the Spatializer's, at full ITD and
+    // shadow, at the reference distance) every 15 degrees round the sphere, for decoding
+    // before any HRIR set is loaded. Built once, on first use.
+    static std::shared_ptr<const HrirSet> getParametricHead();
+
+private:
+    int getPartitionOffset (int order, int channel, int ear, int partition) const noexcept
+    {
+        return orderOffsets[order] + ((channel * 2 + ear) * numPartitions + partition) * spectrumSize;
+    }
+
+    static std::vector<float> getQuadratureWeights (const HrirSet& set);
+
+    double sampleRate = 44100.0;
+    int numPartitions = 1;
+    int orderOffsets[Ambisonics::maxOrder + 1] = {};
+
+    juce::HeapBlock<float> arena;
+    float* filters = nullptr;   // arena, aligned to a cache line
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (AmbisonicHrirFilters)
+};
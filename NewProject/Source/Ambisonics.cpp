@@ -0,0 +1,154 @@
+#include "Ambisonics.h"
+
+namespace Ambisonics
+{
+
+//==============================================================================
+Direction toDirection (float azimuth, float elevation) noexcept
+{
+    const float cosElevation = std::cos (elevation);
+    return { std::cos (azimuth) * cosElevation, -std::sin (azimuth) * cosElevation, std::sin (elevation) };
+}
+
+void encode (int order, Direction d, float* gains) noexcept
+{
+    jassert (order >= 0 && order <= maxOrder);
+    const float x = d.x, y = d.y, z = d.z;
+
+    gains[0] = 1.0f;
+
+    if (order < 1)
+        return;
+
+    gains[1] = y;
+    gains[2] = z;
+    gains[3] = x;
+
+    if (order < 2)
+        return;
+
+    const float root3 = std::sqrt (3.0f);
+    gains[4] = root3 * x * y;
+    gains[5] = root3 * y * z;
+    gains[6] = 0.5f * (3.0f * z * z - 1.0f);
+    gains[7] = root3 * x * z;
+    gains[8] = 0.5f * root3 * (x * x - y * y);
+
+    if (order < 3)
+        return;
+
+    const float root5over8 = std::sqrt (5.0f / 8.0f);
+    const float root3over8 = std::sqrt (3.0f / 8.0f);
+    const float root15 = std::sqrt (15.0f);
+    gains[9]  = root5over8 * y * (3.0f * x * x - y * y);
+    gains[10] = root15 * x * y * z;
+    gains[11] = root3over8 * y * (5.0f * z * z - 1.0f);
+    gains[12] = 0.5f * z * (5.0f * z * z - 3.0f);
+    gains[13] = root3over8 * x * (5.0f * z * z - 1.0f);
+    gains[14] = 0.5f * root15 * z * (x * x - y * y);
+    gains[15] = root5over8 * x * (x * x - 3.0f * y * y);
+}
+
+void setRotation (juce::dsp::Matrix<float>& dest, float yaw, float pitch, float roll) noexcept
+{
+    jassert (dest.getNumRows() == 3 && dest.getNumColumns() == 3);
+
+    // Turning clockwise is a negative turn about z (up), tipping up a negative one about
+    // y (left), and rolling right a positive one about x (front).
+    const float cy = std::cos (yaw),   sy = std::sin (yaw);
+    const float cp = std::cos (pitch), sp = std::sin (pitch);
+    const float cr = std::cos (roll),  sr = std::sin (roll);
+
+    dest (0, 0) = cy * cp;   dest (0, 1) = sy * cr - cy * sp * sr;   dest (0, 2) = -cy * sp * cr - sy * sr;
+    dest (1, 0) = -sy * cp;  dest (1, 1) = cy * cr + sy * sp * sr;   dest (1, 2) = sy * sp * cr - cy * sr;
+    dest (2, 0) = sp;        dest (2, 1) = cp * sr;                  dest (2, 2) = cp * cr;
+}
+
+//==============================================================================
+Rotator::Rotator()
+{
+    for (int l = 2; l <= maxOrder; ++l)
+    {
+        for (int m = -l; m <= l; ++m)
+        {
+            const auto am = (double) std::abs (m);
+            const double delta = m == 0 ? 1.0 : 0.0;
+
+            for (int n = -l; n <= l; ++n)
+            {
+                const double denominator = std::abs (n) == l ? 2.0 * l * (2.0 * l - 1.0)
+                                                             : (double) (l + n) * (double) (l - n);
+                auto& c = coefficients[getChannel (l, m)][n + l];
+                c.u = (float) std::sqrt ((double) (l + m) * (double) (l - m) / denominator);
+                c.v = (float) (0.5 * std::sqrt ((1.0 + delta) * (l + am - 1.0) * (l + am) / denominator) * (1.0 - 2.0 * delta));
+                c.w = (float) (-0.5 * std::sqrt (juce::jmax (0.0, (l - am - 1.0) * (l - am)) / denominator) * (1.0 - delta));
+            }
+        }
+    }
+}
+
+void Rotator::compute (const juce::dsp::Matrix<float>& rotation, juce::dsp::Matrix<float>& dest) const noexcept
+{
+    jassert (rotation.getNumRows() == 3 && rotation.getNumColumns() == 3);
+    jassert (dest.getNumRows() == (size_t) maxChannels && dest.getNumColumns() == (size_t) maxChannels);
+
+    const auto at = [&dest] (int row, int column) -> float& { return dest ((size_t) row, (size_t) column); };
+
+    at (0, 0) = 1.0f;
+
+    // ACN channels 1, 2 and 3 are y, z and x.
+    const int axes[] = { 1, 2, 0 };
+    for (int i = 0; i < 3; ++i)
+        for (int j = 0; j < 3; ++j)
+            at (1 + i, 1 + j) = rotation ((size_t) axes[i], (size_t) axes[j]);
+
+    const auto band1 = [&at] (int i, int j)       { return at (getChannel (1, i), getChannel (1, j)); };
+
+    for (int l = 2; l <= maxOrder; ++l)
+    {
+        const auto previous = [&at, l] (int a, int b)   { return at (getChannel (l - 1, a), getChannel (l - 1, b)); };
+
+        // Ivanic and Ruedenberg's P, from degree 1 and the degree below.
+        const auto p = [&] (int i, int a, int b)
+        {
+            if (b == l)
+                return band1 (i, 1) * previous (a, l - 1) - band1 (i, -1) * previous (a, 1 - l);
+            if (b == -l)
+                return band1 (i, 1) * previous (a, 1 - l) + band1 (i, -1) * previous (a, l - 1);
+            return band1 (i, 0) * previous (a, b);
+        };
+
+        for (int m = -l; m <= l; ++m)
+        {
+            for (int n = -l; n <= l; ++n)
+            {
+                // A zero coefficient's term would read outside the degree below, so I skip it.
+                const auto& c = coefficients[getChannel (l, m)][n + l];
+                float value = 0.0f;
+
+                if (c.u != 0.0f)
+                    value += c.u * p (0, m, n);
+
+                if (c.v != 0.0f)
+                {
+                    if (m == 0)
+                        value += c.v * (p (1, 1, n) + p (-1, -1, n));
+                    else if (m > 0)
+                        value += c.v * (m == 1 ? juce::MathConstants<float>::sqrt2 * p (1, 0, n)
+                                               : p (1, m - 1, n) - p (-1, 1 - m, n));
+                    else
+                        value += c.v * (m == -1 ? juce::MathConstants<float>::sqrt2 * p (-1, 0, n)
+                                                : p (1, m + 1, n) + p (-1, -m - 1, n));
+                }
+
+                if (c.w != 0.0f)
+                    value += c.w * (m > 0 ? p (1, m + 1, n) + p (-1, -m - 1, n)
+                                          : p (1, m - 1, n) - p (-1, 1 - m, n));
+
+                at (getChannel (l, m), getChannel (l, n)) = value;
+            }
+        }
+    }
+}
+
+}
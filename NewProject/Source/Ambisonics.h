@@ -0,0 +1,65 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+// The ambisonic maths the AmbisonicBank runs on: real spherical harmonics up to third
+// order in ACN channel order with SN3D normalisation (the AmbiX convention), and the
+// matrices that rotate a field made of them.
+//
+// Directions are Cartesian, x to the front, y to the left and z up. Angles are the orbit
+// paths': azimuth in radians clockwise from the front (pi/2 = right), elevation up from
+// ear level.
+namespace Ambisonics
+{
+    constexpr int maxOrder = 3;
+    constexpr int maxChannels = (maxOrder + 1) * (maxOrder + 1);
+
+    constexpr int getNumChannels (int order) noexcept                   { return (order + 1) * (order + 1); }
+
+    // The ACN channel of the harmonic of degree l and index m (-l to l).
+    constexpr int getChannel (int degree, int index) noexcept           { return degree * degree + degree + index; }
+
+    struct Direction
+    {
+        float x = 1.0f, y = 0.0f, z = 0.0f;
+    };
+
+    Direction toDirection (float azimuth, float elevation) noexcept;
+
+    // I write getNumChannels (order) gains: what a plane wave from direction puts in each
+    // channel per unit of signal.
+    void encode (int order, Direction direction, float* gains) noexcept;
+
+    // I fill dest (3 x 3) with the rotation that rolls the scene roll radians to the right
+    // about the front, then tips it pitch radians up, then turns it yaw radians clockwise.
+    void setRotation (juce::dsp::Matrix<float>& dest, float yaw, float pitch, float roll) noexcept;
+
+    //==============================================================================
+    // I turn a rotation of directions into the matrix that rotates an ambisonic field the
+    // same way: with rotation R and its field matrix M, encode (R d) = M encode (d) for any
+    // direction d. Harmonics only mix within their degree, so M is block diagonal.
+    //
+    // Degree 1 is R itself with its axes in ACN order (y, z, x); each higher degree follows
+    // from the one below it by Ivanic and Ruedenberg's recursion, whose coefficients I work
+    // out once here. The matrices are the same under SN3D and N3D, since those only scale
+    // whole degrees.
+    class Rotator
+    {
+    public:
+        Rotator();
+
+        // I write every degree's block of dest (maxChannels square) and never touch the
+        // entries between degrees, which the caller keeps at zero. Audio-thread safe.
+        void compute (const juce::dsp::Matrix<float>& rotation, juce::dsp::Matrix<float>& dest) const noexcept;
+
+    private:
+        struct Coefficients
+        {
+            float u = 0.0f, v = 0.0f, w = 0.0f;
+        };
+
+        // For the element in row (l, m) and column (l, n), at [getChannel (l, m)][n + l].
+        Coefficients coefficients[maxChannels][2 * maxOrder + 1];
+    };
+}
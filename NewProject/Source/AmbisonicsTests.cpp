@@ -0,0 +1,125 @@
+#include <JuceHeader.h>
+#include "Ambisonics.h"
+
+//==============================================================================
+// I test the ambisonic maths: SN3D gains carry unit energy per degree and put the front
+// on X, the rotations turn the way the orbit paths count angles, and a field matrix
+// rotates an encoded direction exactly as encoding the rotated direction would, while
+// staying orthogonal.
+class AmbisonicsTest : public juce::UnitTest
+{
+public:
+    AmbisonicsTest() : juce::UnitTest ("Ambisonics", "Audio") {}
+
+    static Ambisonics::Direction multiply (const juce::dsp::Matrix<float>& r, Ambisonics::Direction d)
+    {
+        return { r (0, 0) * d.x + r (0, 1) * d.y + r (0, 2) * d.z,
+                 r (1, 0) * d.x + r (1, 1) * d.y + r (1, 2) * d.z,
+                 r (2, 0) * d.x + r (2, 1) * d.y + r (2, 2) * d.z };
+    }
+
+    void expectDirection (Ambisonics::Direction actual, Ambisonics::Direction expected, const juce::String& what)
+    {
+        expectWithinAbsoluteError (actual.x, expected.x, 1.0e-5f, what);
+        expectWithinAbsoluteError (actual.y, expected.y, 1.0e-5f, what);
+        expectWithinAbsoluteError (actual.z, expected.z, 1.0e-5f, what);
+    }
+
+    void runTest() override
+    {
+        using namespace Ambisonics;
+        const auto pi = juce::MathConstants<float>::pi;
+        auto random = getRandom();
+
+        const auto randomDirection = [&]
+        {
+            return toDirection (random.nextFloat() * 2.0f * pi, std::asin (random.nextFloat() * 2.0f - 1.0f));
+        };
+
+        beginTest ("the gains: unit energy per degree, front on X, left on Y, up on Z");
+        {
+            float gains[maxChannels];
+
+            for (int trial = 0; trial < 100; ++trial)
+            {
+                encode (maxOrder, randomDirection(), gains);
+                expectEquals (gains[0], 1.0f);
+
+                for (int l = 1; l <= maxOrder; ++l)
+                {
+                    float energy = 0.0f;
+                    for (int m = -l; m <= l; ++m)
+                        energy += gains[getChannel (l, m)] * gains[getChannel (l, m)];
+
+                    expectWithinAbsoluteError (energy, 1.0f, 1.0e-5f, "degree " + juce::String (l));
+                }
+            }
+
+            encode (1, toDirection (0.0f, 0.0f), gains);
+            expectWithinAbsoluteError (gains[3], 1.0f, 1.0e-6f);
+            encode (1, toDirection (-0.5f * pi, 0.0f), gains);
+            expectWithinAbsoluteError (gains[1], 1.0f, 1.0e-6f, "azimuth -90 is left");
+            encode (1, toDirection (0.0f, 0.5f * pi), gains);
+            expectWithinAbsoluteError (gains[2], 1.0f, 1.0e-6f);
+        }
+
+        beginTest ("yaw turns clockwise, pitch tips the front up, roll tips the top right");
+        {
+            juce::dsp::Matrix<float> r (3, 3);
+
+            for (int trial = 0; trial < 20; ++trial)
+            {
+                const float azimuth = random.nextFloat() * 2.0f * pi, elevation = random.nextFloat() - 0.5f;
+                const float yaw = random.nextFloat() * 2.0f * pi;
+                setRotation (r, yaw, 0.0f, 0.0f);
+                expectDirection (multiply (r, toDirection (azimuth, elevation)), toDirection (azimuth + yaw, elevation), "yaw");
+            }
+
+            setRotation (r, 0.0f, 0.5f * pi, 0.0f);
+            expectDirection (multiply (r, toDirection (0.0f, 0.0f)), { 0.0f, 0.0f, 1.0f }, "pitch");
+            setRotation (r, 0.0f, 0.0f, 0.5f * pi);
+            expectDirection (multiply (r, { 0.0f, 0.0f, 1.0f }), toDirection (0.5f * pi, 0.0f), "roll");
+        }
+
+        beginTest ("the field matrix rotates an encoded direction like encoding the rotated one");
+        {
+            Rotator rotator;
+            juce::dsp::Matrix<float> r (3, 3), m (maxChannels, maxChannels);
+            float before[maxChannels], after[maxChannels];
+
+            for (int trial = 0; trial < 50; ++trial)
+            {
+                setRotation (r, random.nextFloat() * 2.0f * pi, (random.nextFloat() - 0.5f) * pi, random.nextFloat() * 2.0f * pi);
+                rotator.compute (r, m);
+
+                const auto d = randomDirection();
+                encode (maxOrder, d, before);
+                encode (maxOrder, multiply (r, d), after);
+
+                for (int row = 0; row < maxChannels; ++row)
+                {
+                    float rotated = 0.0f;
+                    for (int column = 0; column < maxChannels; ++column)
+                        rotated += m ((size_t) row, (size_t) column) * before[column];
+
+                    expectWithinAbsoluteError (rotated, after[row], 1.0e-4f, "channel " + juce::String (row));
+                }
+
+                // Orthogonal: the rotation keeps the field's energy.
+                for (int i = 0; i < maxChannels; ++i)
+                {
+                    for (int j = 0; j < maxChannels; ++j)
+                    {
+                        float dot = 0.0f;
+                        for (int k = 0; k < maxChannels; ++k)
+                            dot += m ((size_t) k, (size_t) i) * m ((size_t) k, (size_t) j);
+
+                        expectWithinAbsoluteError (dot, i == j ? 1.0f : 0.0f, 1.0e-4f);
+                    }
+                }
+            }
+        }
+    }
+};
+
+static AmbisonicsTest ambisonicsTest;
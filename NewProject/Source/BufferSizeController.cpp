@@ -0,0 +1,107 @@
+#include "BufferSizeController.h"
+
+//==============================================================================
+void BufferSizeController::setAvailableBufferSizes (const juce::Array<int>& sizes)
+{
+    availableSizes.clearQuick();
+    for (auto size : sizes)
+        if (size > 0 && size <= settings.maxBufferSize)
+            availableSizes.addIfNotAlreadyThere (size);
+
+    availableSizes.sort();
+    attempts.assign ((size_t) availableSizes.size(), Attempts());
+}
+
+void BufferSizeController::start (int bufferSize, double nowSeconds)
+{
+    currentSize = bufferSize;
+    startSeconds = nowSeconds;
+    cleanSinceSeconds = nowSeconds;
+    settled = false;
+    baselineProblems = 0;
+    lastNumCallbacks = 0;
+}
+
+//==============================================================================
+BufferSizeController::Decision BufferSizeController::update (const CallbackMonitor::Stats& stats, double nowSeconds)
+{
+    if (currentSize <= 0 || availableSizes.isEmpty())
+        return {};
+
+    // The monitor starts over with the device: if that happened without a start() (a new
+    // sample rate, say), I start over too.
+    if (stats.numCallbacks < lastNumCallbacks)
+        start (currentSize, nowSeconds);
+
+    lastNumCallbacks = stats.numCallbacks;
+
+    // Whatever happened while the device was opening doesn't count against the size.
+    if (! settled)
+    {
+        if (nowSeconds - startSeconds < settings.settleSeconds)
+            return {};
+
+        settled = true;
+        baselineProblems = stats.getNumProblems();
+        cleanSinceSeconds = nowSeconds;
+        return {};
+    }
+
+    const int problems = juce::jmax (0, stats.getNumProblems() - baselineProblems);
+    const double load = stats.deadlineMs > 0.0 ? stats.p99Ms / stats.deadlineMs : 0.0;
+    const int index = availableSizes.indexOf (currentSize);
+
+    if (problems > 0 || load > settings.maxLoad)
+    {
+        Decision decision;
+        decision.reason << currentSize << " samples: ";
+
+        if (problems > 0)
+            decision.reason << problems << (problems == 1 ? " xrun" : " xruns") << " in "
+                            << juce::String (nowSeconds - cleanSinceSeconds, 1) << " s";
+        else
+            decision.reason << "p99 at " << juce::roundToInt (100.0 * load) << "% of the deadline";
+
+        if (index >= 0)
+        {
+            auto& a = attempts[(size_t) index];
+            ++a.failures;
+            a.retryAfterSeconds = nowSeconds + settings.stableSeconds * std::pow (2.0, (double) a.failures);
+
+            if (a.failures >= settings.maxAttempts)
+                decision.reason << ", not trying it again";
+        }
+
+        // Only new trouble counts from here, whether or not there's a bigger size to go to.
+        baselineProblems = stats.getNumProblems();
+        cleanSinceSeconds = nowSeconds;
+
+        for (auto size : availableSizes)
+            if (size > currentSize)
+                return { size, decision.reason };
+
+        return {};
+    }
+
+    if (nowSeconds - cleanSinceSeconds < settings.stableSeconds || load >= settings.maxLoadToStepDown)
+        return {};
+
+    // One size down at a time: if the next one has let me down, the smaller ones won't do better.
+    int smaller = -1;
+    for (int i = 0; i < availableSizes.size() && availableSizes[i] < currentSize; ++i)
+        smaller = i;
+
+    if (smaller < 0)
+        return {};
+
+    const auto& a = attempts[(size_t) smaller];
+    if (a.failures >= settings.maxAttempts || nowSeconds < a.retryAfterSeconds)
+        return {};
+
+    Decision decision;
+    decision.bufferSize = availableSizes[smaller];
+    decision.reason << currentSize << " samples: clean for "
+                    << juce::String (nowSeconds - cleanSinceSeconds, 1) << " s, p99 at "
+                    << juce::roundToInt (100.0 * load) << "% of the deadline";
+    return decision;
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "CallbackMonitor.h"
+
+//==============================================================================
+// I pick the device buffer size from what the CallbackMonitor measures, so each machine
+// ends up on the smallest buffer it can play without dropouts.
+//
+// I only decide; the caller applies the size and tells me with start(). Every buffer size
+// gets a few seconds to settle (devices often glitch as they open), then:
+//  - any xrun, or a p99 callback above maxLoad of the deadline, moves me up one size
+//    straight away;
+//  - a size that has run clean for stableSeconds, with its p99 under maxLoadToStepDown of
+//    the deadline, moves me down one size.
+// A size that dropped out isn't tried again until twice as long has passed as the last
+// time, and after maxAttempts I give up on it for good. So the steps down get rarer and
+// the size settles rather than going back and forth.
+//
+// Message thread only; nothing here touches the device.
+class BufferSizeController
+{
+public:
+    struct Settings
+    {
+        double settleSeconds = 2.0;        // what I ignore after each start()
+        double stableSeconds = 30.0;       // clean time before I try a smaller size
+        double maxLoad = 0.8;              // p99 over the deadline that counts as trouble
+        double maxLoadToStepDown = 0.35;   // ...and that leaves room for half the buffer
+        int maxBufferSize = 2048;
+        int maxAttempts = 3;               // failures before I stop trying a size
+    };
+
+    struct Decision
+    {
+        int bufferSize = 0;                // 0 when I'd stay where I am
+        juce::String reason;
+
+        bool changesSize() const noexcept  { return bufferSize > 0; }
+    };
+
+    BufferSizeController() = default;
+    explicit BufferSizeController (const Settings& newSettings) : settings (newSettings) {}
+
+    // The sizes the device offers. I forget what I learned about the old ones.
+    void setAvailableBufferSizes (const juce::Array<int>& sizes);
+
+    // The device has (re)started at this size; statistics from now on are about it.
+    void start (int bufferSize, double nowSeconds);
+
+    int getCurrentBufferSize() const noexcept   { return currentSize; }
+
+    // I look at the monitor's totals since the device started and say whether to move.
+    Decision update (const CallbackMonitor::Stats& stats, double nowSeconds);
+
+private:
+    struct Attempts
+    {
+        int failures = 0;
+        double retryAfterSeconds = 0.0;
+    };
+
+    Settings settings;
+    juce::Array<int> availableSizes;       // ascending, up to maxBufferSize
+    std::vector<Attempts> attempts;        // one per available size
+
+    int currentSize = 0;
+    double startSeconds = 0.0;
+    double cleanSinceSeconds = 0.0;        // since the last trouble, or settling
+    bool settled = false;
+    int baselineProblems = 0;
+    juce::int64 lastNumCallbacks = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (BufferSizeController)
+};
@@ -0,0 +1,143 @@
+#include <JuceHeader.h>
+#include "BufferSizeController.h"
+
+//==============================================================================
+// I test BufferSizeController's decisions on made-up statistics: it ignores a device's
+// start-up, steps up on the first xrun, steps down only after a long clean stretch with
+// room to spare, and gives up on a size that keeps failing, so it settles.
+class BufferSizeControllerTest : public juce::UnitTest
+{
+public:
+    BufferSizeControllerTest() : juce::UnitTest ("BufferSizeController", "Audio") {}
+
+    // Stats as the monitor would report them for this size, with p99 at load of the deadline.
+    static CallbackMonitor::Stats makeStats (int bufferSize, juce::int64 numCallbacks, int xruns, double load = 0.2)
+    {
+        CallbackMonitor::Stats stats;
+        stats.numCallbacks = numCallbacks;
+        stats.deadlineMs = 1000.0 * bufferSize / 48000.0;
+        stats.p99Ms = load * stats.deadlineMs;
+        stats.dspOverruns = xruns;
+        return stats;
+    }
+
+    // I tick the controller every quarter second, as MainComponent does, and apply its
+    // decisions. failingBelow is the smallest size that plays cleanly; smaller ones get
+    // an xrun a second. I return the size it's on at the end.
+    static int run (BufferSizeController& controller, int initialSize, int failingBelow,
+                    double seconds, juce::StringArray& log)
+    {
+        int size = initialSize;
+        double startedAt = 0.0;
+        juce::int64 callbacks = 0;
+        controller.start (size, 0.0);
+
+        for (double now = 0.25; now <= seconds; now += 0.25)
+        {
+            callbacks += 48;
+            const int xruns = size < failingBelow ? (int) (now - startedAt) : 0;
+            const auto decision = controller.update (makeStats (size, callbacks, xruns), now);
+
+            if (decision.changesSize())
+            {
+                log.add (juce::String (size) + " -> " + juce::String (decision.bufferSize) + ": " + decision.reason);
+                size = decision.bufferSize;
+                startedAt = now;
+                callbacks = 0;
+                controller.start (size, now);
+            }
+        }
+
+        return size;
+    }
+
+    void runTest() override
+    {
+        const juce::Array<int> sizes { 32, 64, 128, 256, 512, 1024, 4096 };
+
+        beginTest ("start-up glitches don't count, the first xrun after them steps up");
+        {
+            BufferSizeController controller;
+            controller.setAvailableBufferSizes (sizes);
+            controller.start (128, 0.0);
+
+            // Two xruns while the device opens.
+            expect (! controller.update (makeStats (128, 10, 2), 1.0).changesSize());
+            expect (! controller.update (makeStats (128, 20, 2), 2.0).changesSize());
+            expect (! controller.update (makeStats (128, 30, 2), 3.0).changesSize());
+
+            const auto decision = controller.update (makeStats (128, 40, 3), 3.25);
+            expectEquals (decision.bufferSize, 256);
+            expect (decision.reason.contains ("1 xrun"), decision.reason);
+
+            // A p99 close to the deadline is trouble too, xruns or not.
+            controller.start (256, 4.0);
+            controller.update (makeStats (256, 10, 0), 6.5);
+            expectEquals (controller.update (makeStats (256, 20, 0, 0.9), 6.75).bufferSize, 512);
+        }
+
+        beginTest ("steps down only after a clean stretch with room to spare");
+        {
+            BufferSizeController controller;
+            controller.setAvailableBufferSizes (sizes);
+            controller.start (512, 0.0);
+            controller.update (makeStats (512, 100, 0), 2.0);
+
+            expect (! controller.update (makeStats (512, 200, 0), 20.0).changesSize(), "not clean for long enough");
+            expect (! controller.update (makeStats (512, 300, 0, 0.5), 40.0).changesSize(), "too busy to halve");
+
+            const auto decision = controller.update (makeStats (512, 400, 0), 40.3);
+            expectEquals (decision.bufferSize, 256);
+            expect (decision.reason.contains ("clean for 38.3 s"), decision.reason);
+
+            // Nothing under the smallest size, and nothing over maxBufferSize.
+            controller.start (32, 50.0);
+            controller.update (makeStats (32, 100, 0), 52.0);
+            expect (! controller.update (makeStats (32, 1000, 0), 100.0).changesSize());
+
+            controller.start (1024, 100.0);
+            controller.update (makeStats (1024, 100, 0), 102.0);
+            expect (! controller.update (makeStats (1024, 200, 1), 103.0).changesSize(), "4096 is over the limit");
+        }
+
+        beginTest ("converges on the smallest size that plays cleanly");
+        {
+            BufferSizeController controller;
+            controller.setAvailableBufferSizes (sizes);
+            juce::StringArray log;
+
+            // 128 is where this machine stops dropping out. From 32, it climbs there at once...
+            expectEquals (run (controller, 32, 128, 20.0, log), 128);
+            expectEquals (log.size(), 2);
+
+            // ...then over an hour tries 64 twice more, further apart each time (down and
+            // back up each time)...
+            log.clear();
+            expectEquals (run (controller, 128, 128, 3600.0, log), 128);
+            expectEquals (log.size(), 4, log.joinIntoString ("\n"));
+            expect (log[3].contains ("not trying it again"), log[3]);
+
+            // ...and then stays put.
+            log.clear();
+            expectEquals (run (controller, 128, 128, 3600.0, log), 128);
+            expectEquals (log.size(), 0, log.joinIntoString ("\n"));
+        }
+
+        beginTest ("a device restart nobody told me about starts the clock over");
+        {
+            BufferSizeController controller;
+            controller.setAvailableBufferSizes (sizes);
+            controller.start (256, 0.0);
+            controller.update (makeStats (256, 1000, 0), 2.0);
+            controller.update (makeStats (256, 5000, 0), 29.0);
+
+            // The monitor's totals went back to zero: its xruns are start-up again.
+            expect (! controller.update (makeStats (256, 10, 4), 30.0).changesSize());
+            expect (! controller.update (makeStats (256, 1000, 4), 32.0).changesSize());
+            expect (! controller.update (makeStats (256, 2000, 4), 40.0).changesSize());
+            expectEquals (controller.update (makeStats (256, 9000, 4), 62.0).bufferSize, 128);
+        }
+    }
+};
+
+static BufferSizeControllerTest bufferSizeControllerTest;
@@ -0,0 +1,207 @@
+#include "CallbackMonitor.h"
+
+//==============================================================================
+juce::String CallbackMonitor::Stats::toString() const
+{
+    juce::String s;
+    s << "p50 " << juce::String (p50Ms, 2) << " / p99 " << juce::String (p99Ms, 2)
+      << " / max " << juce::String (maxMs, 2) << " ms of " << juce::String (deadlineMs, 2) << " ms"
+      << ", load " << juce::roundToInt (loadPercent) << "%"
+      << ", xruns: " << dspOverruns << " DSP, " << lateCallbacks << " late, ";
+
+    if (deviceXRuns >= 0)
+        s << deviceXRuns << " device";
+    else
+        s << "device n/a";
+
+    if (droppedRecords > 0)
+        s << " (" << droppedRecords << " records dropped)";
+
+    return s;
+}
+
+//==============================================================================
+CallbackMonitor::CallbackMonitor()
+    : records ((size_t) ringSize)
+{
+}
+
+void CallbackMonitor::prepare (double newSampleRate, int newExpectedBlockSize)
+{
+    sampleRate.store (newSampleRate);
+    expectedBlockSize.store (juce::jmax (1, newExpectedBlockSize));
+    loadMeasurer.reset (newSampleRate, juce::jmax (1, newExpectedBlockSize));
+    droppedRecords.store (0);
+    dropPending = false;
+
+    // The message thread notices the new generation and starts its statistics over.
+    generation.fetch_add (1);
+}
+
+void CallbackMonitor::registerCallback (double startMs, double endMs, int numSamples) noexcept
+{
+    const auto rate = sampleRate.load (std::memory_order_relaxed);
+    if (rate <= 0.0)
+        return;
+
+    const auto durationMs = endMs - startMs;
+    loadMeasurer.registerRenderTime (durationMs, numSamples);
+
+    Record record;
+    record.startMs = startMs;
+    record.durationMs = (float) durationMs;
+    record.marginMs = (float) (1000.0 * numSamples / rate - durationMs);
+    record.numSamples = numSamples;
+    record.generation = generation.load (std::memory_order_relaxed);
+    record.afterDrop = dropPending;
+
+    const auto scope = fifo.write (1);
+    if (scope.blockSize1 > 0)
+    {
+        records[(size_t) scope.startIndex1] = record;
+        dropPending = false;
+    }
+    else
+    {
+        droppedRecords.fetch_add (1, std::memory_order_relaxed);
+        dropPending = true;
+    }
+}
+
+//==============================================================================
+int CallbackMonitor::collect()
+{
+    const auto currentGeneration = generation.load();
+    if (currentGeneration != seenGeneration)
+    {
+        seenGeneration = currentGeneration;
+        total.clear();
+        interval.clear();
+        lastEndMs = 0.0;
+        lastNumSamples = 0;
+    }
+
+    const auto rate = sampleRate.load();
+    const auto expected = expectedBlockSize.load();
+    int numRead = 0;
+
+    const auto scope = fifo.read (fifo.getNumReady());
+    scope.forEach ([&] (int index)
+    {
+        auto record = records[(size_t) index];
+        ++numRead;
+
+        if (record.generation != seenGeneration)
+            return;
+
+        // A whole buffer of idle time between two callbacks means the device (or the OS)
+        // didn't call us when it should have; our own overruns only shorten that gap.
+        if (lastEndMs > 0.0 && ! record.afterDrop && lastNumSamples > 0)
+        {
+            const auto expectedPeriodMs = 1000.0 * lastNumSamples / rate;
+            if (record.startMs - lastEndMs > expectedPeriodMs)
+            {
+                ++total.late;
+                ++interval.late;
+            }
+        }
+
+        lastEndMs = record.startMs + record.durationMs;
+        lastNumSamples = record.numSamples;
+
+        const auto fill = (double) record.numSamples / expected;
+        total.add (record, fill);
+        interval.add (record, fill);
+    });
+
+    return numRead;
+}
+
+CallbackMonitor::Stats CallbackMonitor::getStats() const
+{
+    auto stats = makeStats (total);
+    stats.dspOverruns = loadMeasurer.getXRunCount();
+    stats.loadPercent = loadMeasurer.getLoadAsPercentage();
+    return stats;
+}
+
+CallbackMonitor::Stats CallbackMonitor::takeIntervalStats()
+{
+    auto stats = makeStats (interval);
+    stats.loadPercent = loadMeasurer.getLoadAsPercentage();
+    interval.clear();
+    return stats;
+}
+
+CallbackMonitor::Stats CallbackMonitor::makeStats (const Histogram& histogram) const
+{
+    Stats stats;
+    stats.numCallbacks = histogram.count;
+    stats.p50Ms = histogram.getPercentileMs (0.5);
+    stats.p99Ms = histogram.getPercentileMs (0.99);
+    stats.maxMs = histogram.maxMs;
+    stats.worstMarginMs = histogram.count > 0 ? histogram.worstMarginMs : 0.0;
+    stats.minFill = histogram.minFill;
+    stats.dspOverruns = histogram.overruns;
+    stats.lateCallbacks = histogram.late;
+    stats.deviceXRuns = deviceXRuns;
+    stats.droppedRecords = droppedRecords.load();
+
+    if (const auto rate = sampleRate.load(); rate > 0.0)
+        stats.deadlineMs = 1000.0 * expectedBlockSize.load() / rate;
+
+    // Percentiles come from bin edges; never report one above the exact maximum.
+    stats.p50Ms = juce::jmin (stats.p50Ms, stats.maxMs);
+    stats.p99Ms = juce::jmin (stats.p99Ms, stats.maxMs);
+    return stats;
+}
+
+//==============================================================================
+void CallbackMonitor::Histogram::clear()
+{
+    *this = Histogram();
+}
+
+void CallbackMonitor::Histogram::add (const Record& record, double fill)
+{
+    ++bins[(size_t) getBin (record.durationMs)];
+    ++count;
+    maxMs = juce::jmax (maxMs, (double) record.durationMs);
+    worstMarginMs = juce::jmin (worstMarginMs, (double) record.marginMs);
+    minFill = juce::jmin (minFill, fill);
+
+    if (record.marginMs < 0.0f)
+        ++overruns;
+}
+
+double CallbackMonitor::Histogram::getPercentileMs (double proportion) const
+{
+    if (count == 0)
+        return 0.0;
+
+    const auto rank = juce::jmax ((juce::int64) 1, (juce::int64) std::ceil (proportion * (double) count));
+    juce::int64 seen = 0;
+
+    for (int bin = 0; bin < numBins; ++bin)
+    {
+        seen += bins[(size_t) bin];
+        if (seen >= rank)
+            return getBinUpperMs (bin);
+    }
+
+    return maxMs;
+}
+
+int CallbackMonitor::Histogram::getBin (double ms) noexcept
+{
+    const auto us = ms * 1000.0;
+    if (us < 1.0)
+        return 0;
+
+    return juce::jlimit (1, numBins - 1, 1 + (int) (std::log2 (us) * binsPerOctave));
+}
+
+double CallbackMonitor::Histogram::getBinUpperMs (int bin) noexcept
+{
+    return bin == 0 ? 0.001 : std::exp2 ((double) bin / binsPerOctave) / 1000.0;
+}
@@ -0,0 +1,138 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+// I time every audio callback so a dropout can be pinned on our DSP or on the device.
+//
+// On the audio thread I only read the clock, feed the AudioProcessLoadMeasurer (which
+// never blocks: it try-locks and skips the sample if it can't) and push one Record into
+// a preallocated AbstractFifo ring. If the ring is full I drop the record and count it.
+//
+// On the message thread collect() drains the ring into log-spaced duration histograms,
+// so percentiles come without sorting or allocating. I tell three kinds of trouble apart:
+//  - DSP overruns: a callback took longer than its buffer lasts (our fault).
+//  - late callbacks: the gap between two callbacks left a whole buffer idle, so the
+//    device or the OS stalled us (not our fault).
+//  - device xruns: what the driver itself reports, where it supports that.
+class CallbackMonitor
+{
+public:
+    // What the audio thread records for one callback.
+    struct Record
+    {
+        double startMs = 0.0;       // Time::getMillisecondCounterHiRes() at entry
+        float durationMs = 0.0f;
+        float marginMs = 0.0f;      // deadline minus duration; negative is an overrun
+        int numSamples = 0;
+        int generation = 0;         // which prepare() this belongs to
+        bool afterDrop = false;     // records were dropped just before this one
+    };
+
+    struct Stats
+    {
+        juce::int64 numCallbacks = 0;
+        double p50Ms = 0.0, p99Ms = 0.0, maxMs = 0.0;
+        double deadlineMs = 0.0;    // one expected buffer at the current rate
+        double worstMarginMs = 0.0;
+        double minFill = 1.0;       // smallest callback, as a fraction of the expected buffer
+        double loadPercent = 0.0;
+        int dspOverruns = 0;
+        int lateCallbacks = 0;
+        int deviceXRuns = -1;       // -1 if the device doesn't report them
+        int droppedRecords = 0;
+
+        int getNumProblems() const  { return dspOverruns + lateCallbacks + juce::jmax (0, deviceXRuns); }
+        juce::String toString() const;
+    };
+
+    static constexpr int ringSize = 8192;
+
+    CallbackMonitor();
+    ~CallbackMonitor() = default;
+
+    // Call me from prepareToPlay, before callbacks start. I restart all statistics.
+    void prepare (double sampleRate, int expectedBlockSize);
+
+    //==============================================================================
+    // Audio thread: I time the scope around one callback.
+    class ScopedCallback
+    {
+    public:
+        ScopedCallback (CallbackMonitor& monitor, int numSamples) noexcept
+            : owner (monitor), samples (numSamples), startMs (juce::Time::getMillisecondCounterHiRes()) {}
+
+        ~ScopedCallback() noexcept    { owner.registerCallback (startMs, juce::Time::getMillisecondCounterHiRes(), samples); }
+
+    private:
+        CallbackMonitor& owner;
+        int samples;
+        double startMs;
+
+        JUCE_DECLARE_NON_COPYABLE (ScopedCallback)
+    };
+
+    // Audio thread: what ScopedCallback calls; public so tests can feed exact timings.
+    void registerCallback (double startMs, double endMs, int numSamples) noexcept;
+
+    //==============================================================================
+    // Message thread: I drain the ring and return how many records I took.
+    int collect();
+
+    // Message thread: the driver's own xrun count (AudioIODevice::getXRunCount()).
+    void setDeviceXRunCount (int count)     { deviceXRuns = count; }
+
+    // Everything since prepare().
+    Stats getStats() const;
+
+    // Everything since the previous call, for periodic log lines. I start a new interval.
+    Stats takeIntervalStats();
+
+private:
+    // Durations in log-spaced bins, binsPerOctave to the octave from 1 us up to ~1 s,
+    // so percentiles are within about 4% at any buffer size.
+    struct Histogram
+    {
+        static constexpr int binsPerOctave = 16;
+        static constexpr int numBins = 20 * binsPerOctave + 1;
+
+        std::array<juce::int64, (size_t) numBins> bins {};
+        juce::int64 count = 0;
+        double maxMs = 0.0;
+        double worstMarginMs = std::numeric_limits<double>::max();
+        double minFill = 1.0;
+        int overruns = 0;
+        int late = 0;
+
+        void clear();
+        void add (const Record& record, double fill);
+        double getPercentileMs (double proportion) const;
+
+        static int getBin (double ms) noexcept;
+        static double getBinUpperMs (int bin) noexcept;
+    };
+
+    Stats makeStats (const Histogram& histogram) const;
+
+    // Written by prepare(), read on both threads.
+    std::atomic<double> sampleRate { 0.0 };
+    std::atomic<int> expectedBlockSize { 0 };
+    std::atomic<int> generation { 0 };
+
+    juce::AudioProcessLoadMeasurer loadMeasurer;
+
+    // The ring. Only the audio thread writes, only the message thread reads.
+    juce::AbstractFifo fifo { ringSize };
+    std::vector<Record> records;
+    std::atomic<int> droppedRecords { 0 };
+    bool dropPending = false;   // audio thread only
+
+    // Message thread only.
+    Histogram total, interval;
+    int seenGeneration = -1;
+    double lastEndMs = 0.0;
+    int lastNumSamples = 0;
+    int deviceXRuns = -1;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (CallbackMonitor)
+};
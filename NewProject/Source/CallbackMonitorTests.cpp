@@ -0,0 +1,163 @@
+#include <JuceHeader.h>
+#include "CallbackMonitor.h"
+
+//==============================================================================
+// I test the CallbackMonitor with exact, made-up timings: percentiles and margins must
+// come out of the histogram, DSP overruns and late callbacks must be told apart, a full
+// ring must drop records rather than block, and a writer thread racing the reader must
+// lose nothing it didn't report as dropped.
+class CallbackMonitorTest : public juce::UnitTest
+{
+public:
+    CallbackMonitorTest() : juce::UnitTest ("CallbackMonitor", "Audio") {}
+
+    void runTest() override
+    {
+        const double sampleRate = 48000.0;
+        const int blockSize = 480;           // a 10 ms deadline
+        const double periodMs = 10.0;
+
+        beginTest ("percentiles, margin and fill come from the recorded callbacks");
+        {
+            CallbackMonitor monitor;
+            monitor.prepare (sampleRate, blockSize);
+
+            // 100 callbacks taking 0.1 ms .. 10 ms, one every period.
+            double t = 1000.0;
+            for (int i = 1; i <= 100; ++i, t += periodMs)
+                monitor.registerCallback (t, t + 0.1 * i, blockSize);
+
+            // One half-size callback, on time.
+            monitor.registerCallback (t, t + 0.5, blockSize / 2);
+
+            expectEquals (monitor.collect(), 101);
+            const auto stats = monitor.getStats();
+            expectEquals ((int) stats.numCallbacks, 101);
+            expectWithinAbsoluteError (stats.deadlineMs, 10.0, 1.0e-9);
+            expectWithinAbsoluteError (stats.maxMs, 10.0, 1.0e-4);
+            expectWithinAbsoluteError (stats.p50Ms, 5.0, 5.0 * 0.05);
+            expectWithinAbsoluteError (stats.p99Ms, 9.9, 9.9 * 0.05);
+            expectWithinAbsoluteError (stats.worstMarginMs, 0.0, 1.0e-4);
+            expectWithinAbsoluteError (stats.minFill, 0.5, 1.0e-9);
+            expectEquals (stats.dspOverruns, 0);
+            expectEquals (stats.lateCallbacks, 0);
+        }
+
+        beginTest ("overruns are ours, idle gaps are the device's");
+        {
+            CallbackMonitor monitor;
+            monitor.prepare (sampleRate, blockSize);
+
+            double t = 1000.0;
+            monitor.registerCallback (t, t + 2.0, blockSize);
+
+            // We overrun: 15 ms for a 10 ms buffer. The next callback follows straight away,
+            // which is catching up, not a late callback.
+            t += periodMs;
+            monitor.registerCallback (t, t + 15.0, blockSize);
+            t += 15.0;
+            monitor.registerCallback (t, t + 1.0, blockSize);
+
+            // The device skips a whole buffer.
+            t += 2.0 * periodMs + 1.0;
+            monitor.registerCallback (t, t + 1.0, blockSize);
+
+            expectEquals (monitor.collect(), 4);
+            const auto stats = monitor.getStats();
+            expectEquals (stats.dspOverruns, 1);
+            expectEquals (stats.lateCallbacks, 1);
+            expectWithinAbsoluteError (stats.worstMarginMs, -5.0, 1.0e-4);
+            expectWithinAbsoluteError (stats.maxMs, 15.0, 1.0e-4);
+
+            monitor.setDeviceXRunCount (3);
+            expectEquals (monitor.getStats().getNumProblems(), 5);
+            expect (monitor.getStats().toString().contains ("1 DSP, 1 late, 3 device"));
+        }
+
+        beginTest ("interval statistics restart after each take");
+        {
+            CallbackMonitor monitor;
+            monitor.prepare (sampleRate, blockSize);
+
+            for (int i = 0; i < 10; ++i)
+                monitor.registerCallback (i * periodMs, i * periodMs + 1.0, blockSize);
+            monitor.collect();
+            expectEquals ((int) monitor.takeIntervalStats().numCallbacks, 10);
+
+            for (int i = 10; i < 14; ++i)
+                monitor.registerCallback (i * periodMs, i * periodMs + 2.0, blockSize);
+            monitor.collect();
+
+            const auto interval = monitor.takeIntervalStats();
+            expectEquals ((int) interval.numCallbacks, 4);
+            expectWithinAbsoluteError (interval.maxMs, 2.0, 1.0e-4);
+            expectEquals ((int) monitor.getStats().numCallbacks, 14);
+            expectEquals ((int) monitor.takeIntervalStats().numCallbacks, 0);
+        }
+
+        beginTest ("prepare starts over and leaves older records out");
+        {
+            CallbackMonitor monitor;
+            monitor.prepare (sampleRate, blockSize);
+            monitor.registerCallback (0.0, 20.0, blockSize);
+
+            monitor.prepare (96000.0, 64);
+            monitor.registerCallback (100.0, 100.1, 64);
+
+            expectEquals (monitor.collect(), 2);
+            const auto stats = monitor.getStats();
+            expectEquals ((int) stats.numCallbacks, 1);
+            expectEquals (stats.dspOverruns, 0);
+            expectWithinAbsoluteError (stats.deadlineMs, 64.0 / 96.0, 1.0e-9);
+        }
+
+        beginTest ("a full ring drops records instead of blocking");
+        {
+            CallbackMonitor monitor;
+            monitor.prepare (sampleRate, blockSize);
+
+            const int numCallbacks = CallbackMonitor::ringSize + 100;
+            for (int i = 0; i < numCallbacks; ++i)
+                monitor.registerCallback (i * periodMs, i * periodMs + 1.0, blockSize);
+
+            const auto numRead = monitor.collect();
+            expectEquals (numRead + monitor.getStats().droppedRecords, numCallbacks);
+
+            // The gap across the dropped records is not counted as a late callback.
+            const auto t = numCallbacks * periodMs + 50.0 * periodMs;
+            monitor.registerCallback (t, t + 1.0, blockSize);
+            expectEquals (monitor.collect(), 1);
+            expectEquals (monitor.getStats().lateCallbacks, 0);
+        }
+
+        beginTest ("a writer thread racing the reader loses only what it reports");
+        {
+            CallbackMonitor monitor;
+            monitor.prepare (sampleRate, blockSize);
+
+            const int numCallbacks = 100000;
+            std::atomic<bool> done { false };
+
+            std::thread writer ([&]
+            {
+                for (int i = 0; i < numCallbacks; ++i)
+                    monitor.registerCallback (i * periodMs, i * periodMs + 1.0, blockSize);
+                done = true;
+            });
+
+            int numRead = 0;
+            while (! done.load())
+                numRead += monitor.collect();
+
+            writer.join();
+            numRead += monitor.collect();
+
+            const auto stats = monitor.getStats();
+            expectEquals (numRead + stats.droppedRecords, numCallbacks);
+            expectEquals ((int) stats.numCallbacks, numRead);
+            expectEquals (stats.lateCallbacks, 0);
+        }
+    }
+};
+
+static CallbackMonitorTest callbackMonitorTest;
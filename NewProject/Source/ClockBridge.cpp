@@ -0,0 +1,263 @@
+#include "ClockBridge.h"
+
+//==============================================================================
+juce::String ClockBridge::Stats::toString() const
+{
+    if (! running)
+        return "input bridge waiting";
+
+    juce::String s;
+    s << "input bridge " << (driftPpm >= 0.0 ? "+" : "") << juce::String (driftPpm, 1) << " ppm, "
+      << juce::String (latencyMs, 1) << "/" << juce::String (targetMs, 1) << " ms";
+
+    if (underruns > 0 || overruns > 0)
+        s << ", " << underruns << " under/" << overruns << " overruns";
+
+    return s;
+}
+
+//==============================================================================
+ClockBridge::ClockBridge()
+    : ring (maxChannels, ringSize)
+{
+    ring.clear();
+}
+
+void ClockBridge::prepareInput (double sampleRate, int blockSize, int numInputChannels)
+{
+    inputRunning = false;
+    inputRate = sampleRate;
+    inputBlockSize = juce::jmax (1, blockSize);
+    inputChannels = juce::jlimit (0, maxChannels, numInputChannels);
+    ++generation;
+    inputRunning = true;
+}
+
+void ClockBridge::releaseInput()
+{
+    inputRunning = false;
+}
+
+void ClockBridge::pushInput (const float* const* input, int numInputChannels, int numSamples) noexcept
+{
+    pushInput (input, numInputChannels, numSamples, juce::Time::getMillisecondCounterHiRes());
+}
+
+void ClockBridge::pushInput (const float* const* input, int numInputChannels, int numSamples, double nowMs) noexcept
+{
+    if (! inputRunning.load() || numSamples <= 0)
+        return;
+
+    const auto channels = juce::jmin (numInputChannels, inputChannels.load());
+    const auto numToWrite = juce::jmin (numSamples, fifo.getFreeSpace());
+
+    if (numToWrite < numSamples)
+        ++overrunCount;
+
+    int start1, size1, start2, size2;
+    fifo.prepareToWrite (numToWrite, start1, size1, start2, size2);
+
+    for (int ch = 0; ch < channels; ++ch)
+    {
+        if (input[ch] == nullptr)
+        {
+            ring.clear (ch, start1, size1);
+            ring.clear (ch, start2, size2);
+            continue;
+        }
+
+        ring.copyFrom (ch, start1, input[ch], size1);
+        ring.copyFrom (ch, start2, input[ch] + size1, size2);
+    }
+
+    fifo.finishedWrite (size1 + size2);
+
+    // The time first: a reader that sees the new total sees this time or a later one.
+    lastPushMs = nowMs;
+    totalPushed += size1 + size2;
+}
+
+//==============================================================================
+void ClockBridge::prepareOutput (double sampleRate, int blockSize)
+{
+    outputRate = sampleRate;
+    outputBlockSize = juce::jmax (1, blockSize);
+    ++generation;
+}
+
+void ClockBridge::restart() noexcept
+{
+    seenGeneration = generation.load();
+    numChannels = inputChannels.load();
+
+    const auto inRate = inputRate.load();
+    const auto outRate = outputRate.load();
+    nominalRatio = (inRate > 0.0 && outRate > 0.0) ? inRate / outRate : 1.0;
+    useSinc = std::abs (nominalRatio - 1.0) > maxCorrection;
+
+    // The fill just before a pull swings by an input block as blocks land, and a pull takes
+    // an output block's worth; half as much again covers callbacks arriving late.
+    const auto outputBlockIn = outputBlockSize.load() * nominalRatio;
+    targetFill = juce::jmin (1.5 * (inputBlockSize.load() + outputBlockIn) + 32.0, ringSize / 2.0);
+
+    const auto pullSeconds = outRate > 0.0 ? outputBlockSize.load() / outRate : 0.0;
+    smoothingCoefficient = 1.0 - std::exp (-pullSeconds / fillSmoothingSeconds);
+
+    integral = 0.0;
+    correction = 0.0;
+    primed = false;
+    skip (fifo.getNumReady());
+
+    for (auto& interpolator : sincInterpolators)
+        interpolator.reset();
+    for (auto& interpolator : lagrangeInterpolators)
+        interpolator.reset();
+
+    publishedTargetMs = inRate > 0.0 ? 1000.0 * (targetFill + getBaseLatency()) / inRate : 0.0;
+    running = false;
+}
+
+void ClockBridge::skip (int numSamples) noexcept
+{
+    fifo.finishedRead (numSamples);
+    totalRead += numSamples;
+}
+
+double ClockBridge::getFillAt (double nowMs, double inRate) const noexcept
+{
+    // The total and the time must come from the same push; another push in between
+    // changes the total, and then I read both again.
+    juce::int64 pushed;
+    double pushMs;
+
+    do
+    {
+        pushed = totalPushed.load();
+        pushMs = lastPushMs.load();
+    }
+    while (pushed != totalPushed.load());
+
+    // What the input has captured since, up to a block: past that, it's late, not filling.
+    const auto sincePush = juce::jlimit (0.0, (double) inputBlockSize.load(), (nowMs - pushMs) * 0.001 * inRate);
+    return (double) (pushed - totalRead) + sincePush;
+}
+
+int ClockBridge::resample (double ratio, int readIndex, juce::AudioBuffer<float>& dest, int startSample, int numSamples) noexcept
+{
+    // Reading from readIndex to the end of the ring, and wrapping back to its start, the
+    // interpolators return how far they got modulo ringSize. All channels use the same ratio,
+    // so they all use the same number of samples.
+    const auto toEnd = ringSize - readIndex;
+    const auto channels = juce::jmin (numChannels, dest.getNumChannels());
+    int used = 0;
+
+    for (int ch = 0; ch < channels; ++ch)
+    {
+        const auto* in = ring.getReadPointer (ch, readIndex);
+        auto* out = dest.getWritePointer (ch, startSample);
+
+        used = useSinc ? sincInterpolators[(size_t) ch].process (ratio, in, out, numSamples, toEnd, ringSize)
+                       : lagrangeInterpolators[(size_t) ch].process (ratio, in, out, numSamples, toEnd, ringSize);
+    }
+
+    for (int ch = channels; ch < dest.getNumChannels(); ++ch)
+        dest.clear (ch, startSample, numSamples);
+
+    return used;
+}
+
+void ClockBridge::pullOutput (juce::AudioBuffer<float>& dest, int startSample, int numSamples) noexcept
+{
+    pullOutput (dest, startSample, numSamples, juce::Time::getMillisecondCounterHiRes());
+}
+
+void ClockBridge::pullOutput (juce::AudioBuffer<float>& dest, int startSample, int numSamples, double nowMs) noexcept
+{
+    if (generation.load() != seenGeneration)
+        restart();
+
+    const auto inRate = inputRate.load();
+    const auto outRate = outputRate.load();
+
+    if (! inputRunning.load() || inRate <= 0.0 || outRate <= 0.0 || numChannels == 0)
+    {
+        dest.clear (startSample, numSamples);
+        primed = false;
+        running = false;
+        return;
+    }
+
+    const auto fill = getFillAt (nowMs, inRate);
+
+    if (! primed)
+    {
+        if (fill < targetFill)
+        {
+            dest.clear (startSample, numSamples);
+            return;
+        }
+
+        // Start from exactly the target, so the latency is the same after every restart.
+        skip (juce::jmin (fifo.getNumReady(), (int) (fill - targetFill)));
+        averageFill = targetFill;
+        primed = true;
+        running = true;
+    }
+    else if (fill > 2.0 * targetFill + inputBlockSize.load())
+    {
+        // The output stalled and the input piled up: skip back to the target.
+        skip (juce::jmin (fifo.getNumReady(), (int) (fill - targetFill)));
+        averageFill = targetFill;
+        ++overrunCount;
+    }
+    else
+    {
+        averageFill += smoothingCoefficient * (fill - averageFill);
+
+        const auto dt = numSamples / outRate;
+        const auto error = (averageFill - targetFill) / inRate;     // seconds of input
+        integral = juce::jlimit (-maxCorrection / integralGain, maxCorrection / integralGain, integral + error * dt);
+        correction = juce::jlimit (-maxCorrection, maxCorrection, proportionalGain * error + integralGain * integral);
+    }
+
+    // A fuller ring means reading faster: more input samples per output sample.
+    const auto ratio = nominalRatio * (1.0 + correction);
+    const auto needed = (int) std::ceil (numSamples * ratio) + 1;
+
+    if (fifo.getNumReady() < needed)
+    {
+        dest.clear (startSample, numSamples);
+        ++underrunCount;
+        primed = false;
+        running = false;
+        return;
+    }
+
+    int start1, size1, start2, size2;
+    fifo.prepareToRead (needed, start1, size1, start2, size2);
+    skip (resample (ratio, start1, dest, startSample, numSamples));
+
+    publishedCorrection = correction;
+    publishedDrift = integralGain * integral;
+    publishedLatencyMs = 1000.0 * (averageFill + getBaseLatency()) / inRate;
+}
+
+double ClockBridge::getBaseLatency() const noexcept
+{
+    return useSinc ? juce::WindowedSincInterpolator::getBaseLatency()
+                   : juce::LagrangeInterpolator::getBaseLatency();
+}
+
+//==============================================================================
+ClockBridge::Stats ClockBridge::getStats() const
+{
+    Stats stats;
+    stats.running = running.load();
+    stats.correctionPpm = publishedCorrection.load() * 1.0e6;
+    stats.driftPpm = publishedDrift.load() * 1.0e6;
+    stats.latencyMs = publishedLatencyMs.load();
+    stats.targetMs = publishedTargetMs.load();
+    stats.underruns = underrunCount.load();
+    stats.overruns = overrunCount.load();
+    return stats;
+}
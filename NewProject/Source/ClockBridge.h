@@ -0,0 +1,125 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+// I join an input device and an output device that run on clocks of their own: a USB
+// mic into the built-in output, say. JUCE's combined devices assume both sides tick
+// together, so the FIFO between them slowly fills or drains until it clicks. I resample
+// the input to the output's clock instead, at a ratio that follows the drift.
+//
+// The input thread pushes into a preallocated AbstractFifo ring; the output thread pulls
+// from it through one JUCE interpolator per channel. When the nominal rates differ I use
+// WindowedSincInterpolator, which filters the images a rate change leaves; when they only
+// drift apart, LagrangeInterpolator is clean enough at a ratio within a few hundred ppm
+// of 1 and a fraction of the cost. Each pull, a PI controller compares the FIFO fill with
+// a target and nudges the ratio, so the fill, and with it the latency, stays put while the
+// integral term learns the clocks' real ratio.
+//
+// Counted at the pull alone, the fill only moves in whole input blocks: with both devices
+// at 256 samples it reads the same for minutes, then jumps. So each push is timestamped,
+// and I add what the input device has captured since its last push, at its nominal rate,
+// which makes the fill a smooth function of time that a light smoothing cleans up.
+//
+// The two sides share only the ring and atomics. Each side's prepare may come while the
+// other runs: the input side only publishes its format, and the output side starts over
+// (empties the ring and fills it back to the target) when it sees a new one. On an
+// underrun I output silence and refill to the target; when the fill runs far past it
+// (the output stalled) I skip back to the target, so the latency never grows.
+class ClockBridge
+{
+public:
+    static constexpr int maxChannels = 32;
+    static constexpr int ringSize = 1 << 15;        // per channel; past half a second at 48 kHz
+
+    // Settles in about half a minute, a little under critically damped.
+    static constexpr double proportionalGain = 0.3;     // correction per second of fill error
+    static constexpr double integralGain = 0.03;        // ...per second of error, per second
+    static constexpr double maxCorrection = 0.005;      // 5000 ppm, far past any real crystal
+    static constexpr double fillSmoothingSeconds = 0.5; // for callbacks that come early or late
+
+    struct Stats
+    {
+        bool running = false;           // both sides prepared and the ring primed
+        double correctionPpm = 0.0;     // how far the ratio sits from the nominal one
+        double driftPpm = 0.0;          // the integral term alone: the clocks' learned skew
+        double latencyMs = 0.0;         // smoothed fill plus the interpolator's delay
+        double targetMs = 0.0;          // the target fill, plus the same delay
+        int underruns = 0;
+        int overruns = 0;               // input dropped on a full ring, or skipped on a stall
+
+        juce::String toString() const;
+    };
+
+    ClockBridge();
+    ~ClockBridge() = default;
+
+    //==============================================================================
+    // Input device: before its callbacks start, and when they stop.
+    void prepareInput (double sampleRate, int blockSize, int numChannels);
+    void releaseInput();
+
+    // Input thread. Channels past the prepared count are ignored. nowMs is on the
+    // Time::getMillisecondCounterHiRes() clock, which the overload without it reads.
+    void pushInput (const float* const* input, int numChannels, int numSamples, double nowMs) noexcept;
+    void pushInput (const float* const* input, int numChannels, int numSamples) noexcept;
+
+    //==============================================================================
+    // Output device: before its callbacks start.
+    void prepareOutput (double sampleRate, int blockSize);
+
+    // Output thread: I fill numSamples of each of dest's channels, with silence past the
+    // input's channels and until the ring is primed. nowMs as for pushInput().
+    void pullOutput (juce::AudioBuffer<float>& dest, int startSample, int numSamples, double nowMs) noexcept;
+    void pullOutput (juce::AudioBuffer<float>& dest, int startSample, int numSamples) noexcept;
+
+    //==============================================================================
+    // Any thread.
+    Stats getStats() const;
+    int getNumInputChannels() const noexcept    { return inputChannels.load(); }
+
+private:
+    //==============================================================================
+    juce::AbstractFifo fifo { ringSize };
+    juce::AudioBuffer<float> ring;
+
+    // Written by the prepare calls; the output thread picks up a new generation.
+    std::atomic<double> inputRate { 0.0 }, outputRate { 0.0 };
+    std::atomic<int> inputBlockSize { 0 }, outputBlockSize { 0 };
+    std::atomic<int> inputChannels { 0 };
+    std::atomic<int> generation { 0 };
+    std::atomic<bool> inputRunning { false };
+    std::atomic<int> overrunCount { 0 };
+
+    // Input thread only writes these: everything pushed so far, and when it last pushed.
+    std::atomic<juce::int64> totalPushed { 0 };
+    std::atomic<double> lastPushMs { 0.0 };
+
+    // Output thread only.
+    std::array<juce::WindowedSincInterpolator, maxChannels> sincInterpolators;
+    std::array<juce::LagrangeInterpolator, maxChannels> lagrangeInterpolators;
+    bool useSinc = false;
+    int seenGeneration = -1;
+    int numChannels = 0;
+    double nominalRatio = 1.0;      // input samples per output sample
+    double targetFill = 0.0;        // input samples
+    double averageFill = 0.0;
+    juce::int64 totalRead = 0;
+    double integral = 0.0;
+    double correction = 0.0;
+    double smoothingCoefficient = 0.0;
+    bool primed = false;
+
+    void restart() noexcept;
+    void skip (int numSamples) noexcept;
+    double getFillAt (double nowMs, double inRate) const noexcept;
+    double getBaseLatency() const noexcept;     // input samples
+    int resample (double ratio, int readIndex, juce::AudioBuffer<float>& dest, int startSample, int numSamples) noexcept;
+
+    // Published by the output thread for getStats().
+    std::atomic<bool> running { false };
+    std::atomic<double> publishedCorrection { 0.0 }, publishedDrift { 0.0 }, publishedLatencyMs { 0.0 }, publishedTargetMs { 0.0 };
+    std::atomic<int> underrunCount { 0 };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ClockBridge)
+};
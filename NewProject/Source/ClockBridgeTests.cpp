@@ -0,0 +1,206 @@
+#include <JuceHeader.h>
+#include "ClockBridge.h"
+
+//==============================================================================
+// I test ClockBridge between two dummy devices, each calling back at its own real rate
+// on a simulated timeline: with the clocks skewed, the controller learns the skew and
+// holds the latency at the target without dropouts (also with equal block sizes, where
+// only the timestamps show the fill moving), and a tone comes through clean, both when
+// only the clocks drift (Lagrange) and across 44.1 to 48 kHz (windowed sinc); a stalled
+// output skips back to the target and a stalled input refills to it.
+class ClockBridgeTest : public juce::UnitTest
+{
+public:
+    ClockBridgeTest() : juce::UnitTest ("ClockBridge", "Audio") {}
+
+    // A device that believes it runs at nominalRate, while its crystal gives actualRate.
+    struct DummyDevice
+    {
+        double nominalRate = 48000.0, actualRate = 48000.0;
+        int blockSize = 256;
+        juce::int64 samplesDone = 0;
+        bool stalled = false;
+
+        double nextCallbackTime() const   { return (double) samplesDone / actualRate; }
+    };
+
+    // Both devices' callbacks in time order. The input plays a tone in its own samples;
+    // the output keeps what it pulled once 'keepAfter' seconds have passed.
+    struct Simulation
+    {
+        ClockBridge& bridge;
+        DummyDevice& input;
+        DummyDevice& output;
+        double toneHz = 1000.0;
+        juce::AudioBuffer<float> inBlock, outBlock;
+        std::vector<float> kept;
+
+        Simulation (ClockBridge& b, DummyDevice& in, DummyDevice& out)
+            : bridge (b), input (in), output (out),
+              inBlock (2, in.blockSize), outBlock (2, out.blockSize)
+        {
+            bridge.prepareInput (input.nominalRate, input.blockSize, 2);
+            bridge.prepareOutput (output.nominalRate, output.blockSize);
+        }
+
+        void run (double untilSeconds, double keepAfter = 1.0e9)
+        {
+            for (;;)
+            {
+                const auto inTime = input.nextCallbackTime(), outTime = output.nextCallbackTime();
+                if (juce::jmin (inTime, outTime) >= untilSeconds)
+                    return;
+
+                if (inTime <= outTime)
+                {
+                    for (int i = 0; i < input.blockSize; ++i)
+                    {
+                        const auto phase = juce::MathConstants<double>::twoPi * toneHz
+                                           * (double) (input.samplesDone + i) / input.nominalRate;
+                        inBlock.setSample (0, i, 0.5f * (float) std::sin (phase));
+                        inBlock.setSample (1, i, -0.5f * (float) std::sin (phase));
+                    }
+
+                    if (! input.stalled)
+                        bridge.pushInput (inBlock.getArrayOfReadPointers(), 2, input.blockSize, 1000.0 * inTime);
+
+                    input.samplesDone += input.blockSize;
+                }
+                else
+                {
+                    if (! output.stalled)
+                    {
+                        bridge.pullOutput (outBlock, 0, output.blockSize, 1000.0 * outTime);
+
+                        if (outTime >= keepAfter)
+                            kept.insert (kept.end(), outBlock.getReadPointer (0), outBlock.getReadPointer (0) + output.blockSize);
+                    }
+
+                    output.samplesDone += output.blockSize;
+                }
+            }
+        }
+    };
+
+    // The residual after a least-squares fit of a sine at frequency hz, relative to it, in dB.
+    static double residualDb (const std::vector<float>& x, int start, int numSamples, double hz, double sampleRate)
+    {
+        double ss = 0, sc = 0, cc = 0, xs = 0, xc = 0;
+        for (int i = 0; i < numSamples; ++i)
+        {
+            const auto w = juce::MathConstants<double>::twoPi * hz * i / sampleRate;
+            const auto s = std::sin (w), c = std::cos (w), v = (double) x[(size_t) (start + i)];
+            ss += s * s; sc += s * c; cc += c * c; xs += v * s; xc += v * c;
+        }
+
+        const auto det = ss * cc - sc * sc;
+        const auto a = (xs * cc - xc * sc) / det, b = (xc * ss - xs * sc) / det;
+
+        double signal = 0, residual = 0;
+        for (int i = 0; i < numSamples; ++i)
+        {
+            const auto w = juce::MathConstants<double>::twoPi * hz * i / sampleRate;
+            const auto fit = a * std::sin (w) + b * std::cos (w);
+            const auto e = (double) x[(size_t) (start + i)] - fit;
+            signal += fit * fit;
+            residual += e * e;
+        }
+
+        return 10.0 * std::log10 (residual / signal + 1.0e-30);
+    }
+
+    void checkSkewed (DummyDevice input, DummyDevice output, double maxResidualDb)
+    {
+        ClockBridge bridge;
+        Simulation sim (bridge, input, output);
+
+        sim.run (90.0);
+        const auto settled = bridge.getStats();
+        expect (settled.running);
+
+        sim.run (100.0, 99.0);
+        const auto stats = bridge.getStats();
+
+        // What the output has to read per nominal sample, beyond the nominal ratio.
+        const auto skewPpm = ((input.actualRate / input.nominalRate) / (output.actualRate / output.nominalRate) - 1.0) * 1.0e6;
+        expectWithinAbsoluteError (stats.driftPpm, skewPpm, 2.0, "the integral learned the skew");
+        expectWithinAbsoluteError (stats.correctionPpm, skewPpm, 2.0);
+        expectWithinAbsoluteError (stats.latencyMs, settled.latencyMs, 0.05, "the latency held still");
+        expectWithinAbsoluteError (stats.latencyMs, stats.targetMs, 0.05);
+        expectEquals (stats.underruns, settled.underruns, "no underruns once settled");
+        expectEquals (stats.overruns, 0);
+        expectEquals (stats.underruns, 0, "the priming target covers both block sizes");
+
+        // The tone, as the output device hears it: its frequency scaled by both clocks.
+        const auto heardHz = sim.toneHz * (input.actualRate / input.nominalRate) * (output.nominalRate / output.actualRate);
+        const auto window = (int) (output.nominalRate / 100.0);
+
+        for (int start = 0; start + window <= (int) sim.kept.size(); start += window)
+            expectLessThan (residualDb (sim.kept, start, window, heardHz, output.nominalRate), maxResidualDb);
+    }
+
+    void runTest() override
+    {
+        beginTest ("drifting clocks at one rate: the ratio learns the skew and the latency holds");
+        {
+            checkSkewed ({ 48000.0, 48000.0 * (1.0 + 250.0e-6), 480 },
+                         { 48000.0, 48000.0 * (1.0 - 100.0e-6), 256 }, -60.0);
+
+            checkSkewed ({ 48000.0, 48000.0 * (1.0 - 80.0e-6), 64 },
+                         { 48000.0, 48000.0, 1024 }, -60.0);
+
+            checkSkewed ({ 48000.0, 48000.0 * (1.0 + 150.0e-6), 256 },
+                         { 48000.0, 48000.0, 256 }, -60.0);
+        }
+
+        beginTest ("44.1 kHz in, 48 kHz out, through the windowed sinc");
+        {
+            checkSkewed ({ 44100.0, 44100.0 * (1.0 + 120.0e-6), 441 },
+                         { 48000.0, 48000.0, 512 }, -60.0);
+        }
+
+        beginTest ("a stalled output skips back to the target, a stalled input refills to it");
+        {
+            ClockBridge bridge;
+            DummyDevice input { 48000.0, 48000.0 * (1.0 + 50.0e-6), 256 };
+            DummyDevice output { 48000.0, 48000.0, 256 };
+            Simulation sim (bridge, input, output);
+
+            sim.run (60.0);
+            const auto before = bridge.getStats();
+            expect (before.running);
+
+            // The output device stops calling for half a second while the input goes on.
+            output.stalled = true;
+            sim.run (60.5);
+            output.stalled = false;
+            sim.run (62.0);
+            auto stats = bridge.getStats();
+            expectEquals (stats.overruns, 1);
+            expectEquals (stats.underruns, 0);
+            expectWithinAbsoluteError (stats.latencyMs, stats.targetMs, 0.1);
+
+            // The input device stops: one underrun, silence, then the same latency again.
+            input.stalled = true;
+            sim.run (62.5);
+            expectEquals (bridge.getStats().underruns, 1);
+            expect (! bridge.getStats().running);
+
+            input.stalled = false;
+            sim.run (70.0);
+            stats = bridge.getStats();
+            expect (stats.running);
+            expectEquals (stats.underruns, 1);
+            expectWithinAbsoluteError (stats.latencyMs, stats.targetMs, 0.1);
+
+            // A new input format starts over.
+            bridge.prepareInput (44100.0, 512, 2);
+            juce::AudioBuffer<float> out (2, 256);
+            bridge.pullOutput (out, 0, 256);
+            expect (! bridge.getStats().running);
+            expectEquals (out.getMagnitude (0, 256), 0.0f);
+        }
+    }
+};
+
+static ClockBridgeTest clockBridgeTest;
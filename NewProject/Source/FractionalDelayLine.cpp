@@ -0,0 +1,83 @@
+#include "FractionalDelayLine.h"
+
+//==============================================================================
+FractionalDelayLine::FractionalDelayLine()
+{
+    prepare (defaultMaxDelaySamples);
+}
+
+void FractionalDelayLine::prepare (int maxDelay)
+{
+    // Room for the longest delay, a sub-block being written and the interpolator's taps.
+    const int newCapacity = juce::nextPowerOfTwo (juce::jmax (1, maxDelay) + maxBlockSize + 4);
+
+    if (newCapacity != capacity)
+    {
+        storage.malloc ((size_t) newCapacity * sizeof (float) + cacheLineSize);
+        const auto address = reinterpret_cast<uintptr_t> (storage.get());
+        buffer = reinterpret_cast<float*> ((address + cacheLineSize - 1) & ~(uintptr_t) (cacheLineSize - 1));
+        capacity = newCapacity;
+        mask = capacity - 1;
+    }
+
+    maxDelaySamples = capacity - maxBlockSize - 4;
+    reset();
+}
+
+void FractionalDelayLine::reset()
+{
+    juce::FloatVectorOperations::clear (buffer, capacity);
+    writeIndex = 0;
+}
+
+void FractionalDelayLine::write (const float* input, int numSamples)
+{
+    jassert (numSamples <= maxBlockSize);
+
+    for (int i = 0; i < numSamples; ++i)
+        buffer[(writeIndex + i) & mask] = input[i];
+
+    writeIndex = (writeIndex + numSamples) & mask;
+}
+
+//==============================================================================
+void FractionalDelayLine::read (float* output, int numSamples, float delayStart, float delayEnd) const
+{
+    jassert (numSamples <= maxBlockSize);
+
+    delayStart = juce::jlimit (0.0f, (float) maxDelaySamples, delayStart);
+    delayEnd   = juce::jlimit (0.0f, (float) maxDelaySamples, delayEnd);
+
+    // I split the read into branch-free passes over small arrays so the index and
+    // weight maths vectorise; only the final tap gather is scalar.
+    alignas (16) int tapIndex[maxBlockSize];
+    alignas (16) float frac[maxBlockSize];
+
+    const float delayStep = (delayEnd - delayStart) / (float) numSamples;
+    const int firstIndex = writeIndex - numSamples + capacity;
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        const float d = delayStart + delayStep * (float) (i + 1);
+        const int whole = (int) d;
+        frac[i] = d - (float) whole;
+        tapIndex[i] = firstIndex + i - whole;
+    }
+
+    // Lagrange weights for a total delay of (1 + frac) over taps n, n-1, n-2, n-3:
+    // keeping the fractional part in [1, 2) is where 3rd-order Lagrange is flattest.
+    for (int i = 0; i < numSamples; ++i)
+    {
+        const float f = frac[i];
+        const float h0 = -f * (f - 1.0f) * (f - 2.0f) * (1.0f / 6.0f);
+        const float h1 = (f + 1.0f) * (f - 1.0f) * (f - 2.0f) * 0.5f;
+        const float h2 = -(f + 1.0f) * f * (f - 2.0f) * 0.5f;
+        const float h3 = (f + 1.0f) * f * (f - 1.0f) * (1.0f / 6.0f);
+
+        const int t = tapIndex[i];
+        output[i] = h0 * buffer[t & mask]
+                  + h1 * buffer[(t - 1) & mask]
+                  + h2 * buffer[(t - 2) & mask]
+                  + h3 * buffer[(t - 3) & mask];
+    }
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+// I'm a mono delay line with sub-sample resolution, for ITD and for the propagation
+// delay whose glide gives Doppler. I keep a power-of-two ring buffer so wrapping is a
+// bit mask, and I read with 3rd-order Lagrange interpolation so the delay can glide
+// smoothly between whole samples.
+//
+// The ring is sized in prepare() for the longest delay the owner needs at its sample
+// rate, and starts on a cache line, so a bank of lines never shares a line between two
+// rings. Nothing allocates after prepare().
+//
+// I work block-wise: write() a sub-block of up to maxBlockSize samples, then
+// read() the same number of samples back with a delay that ramps linearly
+// across the sub-block. My interpolation adds a constant latency of
+// interpolationLatency samples on top of the requested delay.
+class FractionalDelayLine
+{
+public:
+    static constexpr int maxBlockSize = 32;
+    static constexpr int interpolationLatency = 1;
+    static constexpr int defaultMaxDelaySamples = 128 - maxBlockSize - 4;
+    static constexpr size_t cacheLineSize = 64;
+
+    // I start with room for defaultMaxDelaySamples, enough for ITD alone.
+    FractionalDelayLine();
+
+    // I resize the ring for delays up to maxDelay samples (and clear it). This allocates
+    // when the ring's power-of-two size changes, so call me from prepareToPlay(), not the
+    // audio thread.
+    void prepare (int maxDelay);
+    int getMaxDelaySamples() const noexcept { return maxDelaySamples; }
+
+    // I clear the ring buffer and rewind the write position.
+    void reset();
+
+    // I append numSamples (<= maxBlockSize) input samples.
+    void write (const float* input, int numSamples);
+
+    // I read the numSamples most recently written samples, delayed by delayStart
+    // ramping to delayEnd (both in samples, 0 to getMaxDelaySamples()). The ramp reaches
+    // delayEnd on the last sample, matching the Spatializer's control-point ramps.
+    void read (float* output, int numSamples, float delayStart, float delayEnd) const;
+
+private:
+    juce::HeapBlock<char> storage;
+    float* buffer = nullptr;        // storage, rounded up to a cache line
+    int capacity = 0, mask = 0, maxDelaySamples = 0;
+    int writeIndex = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (FractionalDelayLine)
+};
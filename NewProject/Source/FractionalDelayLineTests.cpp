@@ -0,0 +1,92 @@
+#include <JuceHeader.h>
+#include "FractionalDelayLine.h"
+
+//==============================================================================
+// I test the FractionalDelayLine: whole-sample delays must be exact shifts, a
+// half-sample delay of a slow sine must land between the neighbouring samples, and a
+// ring prepared for a delay must hold all of it.
+class FractionalDelayLineTest : public juce::UnitTest
+{
+public:
+    FractionalDelayLineTest() : juce::UnitTest ("FractionalDelayLine", "Audio") {}
+
+    void runTest() override
+    {
+        constexpr int block = FractionalDelayLine::maxBlockSize;
+        constexpr int latency = FractionalDelayLine::interpolationLatency;
+
+        beginTest ("integer delay: impulse is shifted exactly");
+        {
+            // I push an impulse and expect it back exactly delay + latency samples later.
+            FractionalDelayLine line;
+            line.reset();
+            const float delay = 7.0f;
+
+            float in[block] = {}, out[block] = {};
+            in[0] = 1.0f;
+            line.write (in, block);
+            line.read (out, block, delay, delay);
+
+            for (int i = 0; i < block; ++i)
+                expectWithinAbsoluteError (out[i], i == (int) delay + latency ? 1.0f : 0.0f, 1.0e-6f);
+        }
+
+        beginTest ("fractional delay: half-sample shift of a slow sine");
+        {
+            // I delay a 500 Hz sine (44.1 kHz) by 10.5 samples and compare with the analytic value.
+            FractionalDelayLine line;
+            line.reset();
+            const double w = juce::MathConstants<double>::twoPi * 500.0 / 44100.0;
+            const float delay = 10.5f;
+
+            float maxError = 0.0f;
+            float in[block], out[block];
+            for (int b = 0; b < 8; ++b)
+            {
+                for (int i = 0; i < block; ++i)
+                    in[i] = (float) std::sin (w * (b * block + i));
+
+                line.write (in, block);
+                line.read (out, block, delay, delay);
+
+                if (b == 0)
+                    continue;
+
+                for (int i = 0; i < block; ++i)
+                {
+                    const double expected = std::sin (w * (b * block + i - delay - latency));
+                    maxError = juce::jmax (maxError, (float) std::abs (out[i] - expected));
+                }
+            }
+            expectLessThan (maxError, 1.0e-3f, "half-sample delay should interpolate accurately");
+        }
+
+        beginTest ("prepare: the ring holds any delay asked for");
+        {
+            // I size for each delay, then expect an impulse back exactly that late.
+            for (int maxDelay : { 10, 96, 1000, 5000 })
+            {
+                FractionalDelayLine line;
+                line.prepare (maxDelay);
+                expect (line.getMaxDelaySamples() >= maxDelay);
+
+                float in[block] = {}, out[block] = {};
+                in[0] = 1.0f;
+                int arrivedAt = -1;
+                for (int b = 0; b * block <= maxDelay + latency; ++b)
+                {
+                    line.write (in, block);
+                    line.read (out, block, (float) maxDelay, (float) maxDelay);
+                    in[0] = 0.0f;
+
+                    for (int i = 0; i < block; ++i)
+                        if (out[i] > 0.5f)
+                            arrivedAt = b * block + i;
+                }
+                expectEquals (arrivedAt, maxDelay + latency, "delay of " + juce::String (maxDelay));
+            }
+        }
+    }
+};
+
+static FractionalDelayLineTest fractionalDelayLineTest;
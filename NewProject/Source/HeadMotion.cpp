@@ -0,0 +1,86 @@
+#include "HeadMotion.h"
+
+//==============================================================================
+void HeadOrientation::toHeadRelative (float& x, float& y, float& z) const noexcept
+{
+    // The head's frame is the world's turned by Rz(-yaw), then Ry(-pitch), then Rx(roll);
+    // undoing those in the opposite order takes a world direction into it.
+    if (yaw != 0.0f)
+    {
+        const float c = std::cos (yaw), s = std::sin (yaw);
+        const float turnedX = c * x - s * y;
+        y = s * x + c * y;
+        x = turnedX;
+    }
+
+    if (pitch != 0.0f)
+    {
+        const float c = std::cos (pitch), s = std::sin (pitch);
+        const float tippedX = c * x + s * z;
+        z = c * z - s * x;
+        x = tippedX;
+    }
+
+    if (roll != 0.0f)
+    {
+        const float c = std::cos (roll), s = std::sin (roll);
+        const float leanedY = c * y + s * z;
+        z = c * z - s * y;
+        y = leanedY;
+    }
+}
+
+//==============================================================================
+namespace
+{
+    HeadOrientation extrapolate (const HeadOrientation& from, const HeadOrientation& rate, double seconds) noexcept
+    {
+        const auto t = (float) seconds;
+        const auto pi = juce::MathConstants<float>::pi;
+
+        // Yaw and roll go round; pitch stops at straight up or down.
+        return { std::remainder (from.yaw + rate.yaw * t, 2.0f * pi),
+                 juce::jlimit (-0.5f * pi, 0.5f * pi, from.pitch + rate.pitch * t),
+                 std::remainder (from.roll + rate.roll * t, 2.0f * pi) };
+    }
+}
+
+HeadOrientation HeadMotion::at (double seconds) const noexcept
+{
+    if (isStill())
+        return start;
+
+    return extrapolate (start, rate, juce::jlimit (0.0, horizon, seconds));
+}
+
+HeadMotion HeadMotion::after (double seconds) const noexcept
+{
+    if (seconds <= 0.0 || isStill())
+        return *this;
+
+    HeadMotion later;
+    later.start = at (seconds);
+    later.rate = rate;
+    later.horizon = juce::jmax (0.0, horizon - seconds);
+    return later;
+}
+
+HeadMotion HeadMotion::predict (const HeadPose& pose, double now, double lookahead) noexcept
+{
+    HeadMotion motion;
+    if (! pose.valid)
+        return motion;
+
+    const double age = now - pose.time;
+    if (age > staleAfter)
+    {
+        motion.start = pose.orientation;
+        return motion;
+    }
+
+    const double ahead = juce::jlimit (0.0, maxPrediction, age + lookahead);
+    motion.start = extrapolate (pose.orientation, pose.rate, ahead);
+    motion.rate = pose.rate;
+    motion.horizon = maxPrediction - ahead;
+    return motion;
+}
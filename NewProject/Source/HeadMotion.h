@@ -0,0 +1,77 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+// Where the listener's head is pointing, in radians, with the Ambisonics::setRotation()
+// conventions: yaw turns it clockwise seen from above (pi/2 = facing right), pitch tips
+// it up and roll leans it over to the right. All zero is facing straight ahead, level.
+struct HeadOrientation
+{
+    float yaw = 0.0f;
+    float pitch = 0.0f;
+    float roll = 0.0f;
+
+    bool isZero() const noexcept   { return yaw == 0.0f && pitch == 0.0f && roll == 0.0f; }
+
+    bool operator== (const HeadOrientation& other) const noexcept
+    {
+        return yaw == other.yaw && pitch == other.pitch && roll == other.roll;
+    }
+
+    bool operator!= (const HeadOrientation& other) const noexcept   { return ! operator== (other); }
+
+    // I turn a world direction (x front, y left, z up) into the same direction relative to
+    // the head: the scene counter-rotated by undoing the yaw, then the pitch, then the roll.
+    void toHeadRelative (float& x, float& y, float& z) const noexcept;
+};
+
+//==============================================================================
+// One head tracker measurement: the orientation, how fast it was changing (radians per
+// second, per angle), and when it arrived, in seconds on getClock(). A pose that was
+// never measured isn't valid.
+struct HeadPose
+{
+    HeadOrientation orientation;
+    HeadOrientation rate;
+    double time = 0.0;
+    bool valid = false;
+
+    // The clock poses are stamped with and predicted against, on any thread.
+    static double getClock() noexcept   { return juce::Time::getMillisecondCounterHiRes() * 0.001; }
+};
+
+//==============================================================================
+// I'm the head's motion over one audio block, predicted from the latest pose: where it
+// will be by the time the block is heard, turning on at the measured rate. The audio
+// thread makes me once per block with predict() and the processors ask at() for each
+// sub-block, so a turning head is followed smoothly within the block rather than in
+// block-sized steps.
+//
+// Prediction is plain rate extrapolation, which hides the sensor's, the network's and
+// the output's latency while the head keeps turning and overshoots a little when it
+// stops. I cap it at maxPrediction past the measurement, beyond which a guess is worse
+// than standing still, and hold a pose that's older than staleAfter (the tracker has
+// stopped sending) where it was.
+struct HeadMotion
+{
+    static constexpr double maxPrediction = 0.1;
+    static constexpr double staleAfter = 0.25;
+
+    HeadOrientation start;          // at the block's first sample
+    HeadOrientation rate;
+    double horizon = 0.0;           // how far past start I may still extrapolate, in seconds
+
+    bool isStill() const noexcept   { return rate.isZero(); }
+
+    // Where the head is seconds after the block's first sample.
+    HeadOrientation at (double seconds) const noexcept;
+
+    // The same motion measured from seconds into the block, for a processor that runs the
+    // block in slices.
+    HeadMotion after (double seconds) const noexcept;
+
+    // The motion for a block starting now (on HeadPose::getClock()) and heard lookahead
+    // seconds later. An invalid pose gives a head that's still, facing ahead.
+    static HeadMotion predict (const HeadPose& pose, double now, double lookahead) noexcept;
+};
@@ -0,0 +1,112 @@
+#include "HeadMotionRecording.h"
+#include "HeadTracker.h"
+
+//==============================================================================
+juce::Result HeadMotionRecording::parse (const juce::String& text)
+{
+    frames.clear();
+    const auto lines = juce::StringArray::fromLines (text);
+
+    for (int i = 0; i < lines.size(); ++i)
+    {
+        const auto line = lines[i].trim();
+        if (line.isEmpty() || line.startsWithChar ('#'))
+            continue;
+
+        auto fields = juce::StringArray::fromTokens (line, ", \t", {});
+        fields.removeEmptyStrings();
+
+        const auto fail = [&] (const juce::String& problem)
+        {
+            frames.clear();
+            return juce::Result::fail ("Line " + juce::String (i + 1) + ": " + problem);
+        };
+
+        if (fields.size() != 4)
+            return fail ("expected time, yaw, pitch and roll, found " + juce::String (fields.size()) + " fields");
+
+        for (const auto& field : fields)
+            if (! field.containsOnly ("0123456789.-+eE") || ! field.containsAnyOf ("0123456789"))
+                return fail ("\"" + field + "\" isn't a number");
+
+        Frame frame;
+        frame.time = fields[0].getDoubleValue();
+        frame.yaw = fields[1].getFloatValue();
+        frame.pitch = fields[2].getFloatValue();
+        frame.roll = fields[3].getFloatValue();
+
+        if (frame.time < 0.0 || (! frames.empty() && frame.time < frames.back().time))
+            return fail ("the time goes backwards");
+
+        frames.push_back (frame);
+    }
+
+    if (frames.empty())
+        return juce::Result::fail ("There are no measurements in the recording");
+
+    return juce::Result::ok();
+}
+
+juce::Result HeadMotionRecording::load (const juce::File& file)
+{
+    if (! file.existsAsFile())
+    {
+        frames.clear();
+        return juce::Result::fail ("Can't find " + file.getFullPathName());
+    }
+
+    return parse (file.loadFileAsString());
+}
+
+//==============================================================================
+juce::Result HeadMotionRecording::play (const juce::String& host, int port, double speed, int passes,
+                                       juce::Thread* thread) const
+{
+    jassert (speed > 0.0);
+
+    juce::OSCSender sender;
+    if (! sender.connect (host, port))
+        return juce::Result::fail ("Can't send to " + host + ":" + juce::String (port));
+
+    if (frames.empty())
+        return juce::Result::ok();
+
+    // A pass lasts the recording plus one average spacing, so the next pass's first frame
+    // comes a measurement after the last one rather than on top of it.
+    const double spacing = frames.size() > 1 && getLength() > 0.0 ? getLength() / (double) (frames.size() - 1) : 0.01;
+    const double passLength = (getLength() + spacing) / speed;
+
+    const juce::OSCAddressPattern address (HeadTracker::orientationAddress);
+    const double startMs = juce::Time::getMillisecondCounterHiRes();
+    const auto startTimeTag = juce::OSCTimeTag (juce::Time::getCurrentTime()).getRawTimeTag();
+
+    for (int pass = 0; passes <= 0 || pass < passes; ++pass)
+    {
+        for (const auto& frame : frames)
+        {
+            // The time the frame is sent, from the start, which is also the sensor time its
+            // bundle carries: a tracker's clock runs with the wall clock, whatever the speed.
+            const double time = pass * passLength + frame.time / speed;
+
+            // Short sleeps, so a stop request is noticed and the pace doesn't drift.
+            const double dueMs = startMs + time * 1000.0;
+
+            for (double waitMs = dueMs - juce::Time::getMillisecondCounterHiRes(); waitMs > 0.0;
+                 waitMs = dueMs - juce::Time::getMillisecondCounterHiRes())
+            {
+                if (thread != nullptr && thread->threadShouldExit())
+                    return juce::Result::ok();
+
+                juce::Thread::sleep (juce::jlimit (1, 20, (int) waitMs));
+            }
+
+            juce::OSCBundle bundle (juce::OSCTimeTag (startTimeTag + (juce::uint64) std::llround (time * 4294967296.0)));
+            bundle.addElement (juce::OSCMessage (address, frame.yaw, frame.pitch, frame.roll));
+
+            if (! sender.send (bundle))
+                return juce::Result::fail ("Sending to " + host + ":" + juce::String (port) + " failed");
+        }
+    }
+
+    return juce::Result::ok();
+}
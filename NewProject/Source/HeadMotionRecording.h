@@ -0,0 +1,38 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+// I'm a recorded head movement, for trying head tracking without a tracker and for
+// testing it without one: a list of measurements I can load from text and play back to
+// a HeadTracker's port as the OSC a real tracker would send, at the recorded pace.
+//
+// A recording is one measurement per line: the time in seconds from the start, then
+// yaw, pitch and roll in degrees, with the HeadOrientation conventions, separated by
+// commas or spaces. Blank lines and lines starting with # are skipped, and the times
+// must not go backwards.
+struct HeadMotionRecording
+{
+    struct Frame
+    {
+        double time = 0.0;
+        float yaw = 0.0f, pitch = 0.0f, roll = 0.0f;
+    };
+
+    std::vector<Frame> frames;
+
+    // I replace the frames with the ones in text or in a file, or explain what's wrong
+    // with it (leaving me empty).
+    juce::Result parse (const juce::String& text);
+    juce::Result load (const juce::File& file);
+
+    double getLength() const noexcept   { return frames.empty() ? 0.0 : frames.back().time; }
+
+    // I send every frame to host:port as a HeadTracker orientation message, at the
+    // recorded pace sped up by speed, passes times over (or for ever if passes is 0). Each
+    // goes in a bundle time-tagged with when it was sent, as a tracker's timestamp would
+    // be, so the tags keep counting up from pass to pass. I block until the last frame has gone, or
+    // until thread, if there is one, is asked to exit.
+    juce::Result play (const juce::String& host, int port, double speed = 1.0, int passes = 1,
+                       juce::Thread* thread = nullptr) const;
+};
@@ -0,0 +1,261 @@
+#include <JuceHeader.h>
+#include "HeadMotion.h"
+#include "Ambisonics.h"
+#include "AmbisonicBank.h"
+#include "AmbisonicHrirFilters.h"
+#include "HrtfRenderer.h"
+#include "OrbitEngine.h"
+#include "OrbitTrajectory.h"
+#include "Spatializer.h"
+#include "SpatializerBank.h"
+
+//==============================================================================
+// I test head tracking from the pose on: counter-rotating a direction undoes exactly the
+// rotation Ambisonics::setRotation() makes for the same angles; prediction extrapolates,
+// stops at its cap and holds a stale pose; every processor hears a source ahead on the
+// left when the head turns right, and follows a head turning within a block; and the
+// engine predicts from the pose it was handed, only while tracking is on.
+class HeadMotionTest : public juce::UnitTest
+{
+public:
+    HeadMotionTest() : juce::UnitTest ("HeadMotion", "Audio") {}
+
+    static constexpr double sampleRate = 48000.0;
+    static constexpr int blockSize = 512;
+
+    static HeadMotion facing (float yawDegrees)
+    {
+        HeadMotion motion;
+        motion.start.yaw = juce::degreesToRadians (yawDegrees);
+        return motion;
+    }
+
+    // The same seeded noise in both channels.
+    static void fillNoise (juce::AudioBuffer<float>& buffer)
+    {
+        juce::Random random (23);
+        for (int i = 0; i < buffer.getNumSamples(); ++i)
+        {
+            const float x = random.nextFloat() - 0.5f;
+            for (int ch = 0; ch < buffer.getNumChannels(); ++ch)
+                buffer.setSample (ch, i, x);
+        }
+    }
+
+    // How much louder the left ear is than the right, after the first block.
+    static float leftOverRightDecibels (const juce::AudioBuffer<float>& buffer)
+    {
+        const int length = buffer.getNumSamples() - blockSize;
+        return juce::Decibels::gainToDecibels (buffer.getRMSLevel (0, blockSize, length)
+                                                 / buffer.getRMSLevel (1, blockSize, length));
+    }
+
+    void runTest() override
+    {
+        auto random = getRandom();
+        const auto pi = juce::MathConstants<float>::pi;
+
+        beginTest ("counter-rotating undoes the head's rotation");
+        {
+            juce::dsp::Matrix<float> rotation (3, 3);
+
+            for (int trial = 0; trial < 100; ++trial)
+            {
+                const HeadOrientation head { (random.nextFloat() * 2.0f - 1.0f) * pi,
+                                             (random.nextFloat() - 0.5f) * pi,
+                                             (random.nextFloat() * 2.0f - 1.0f) * pi };
+                Ambisonics::setRotation (rotation, head.yaw, head.pitch, head.roll);
+
+                const auto d = Ambisonics::toDirection ((random.nextFloat() * 2.0f - 1.0f) * pi, (random.nextFloat() - 0.5f) * pi);
+                const float local[3] = { d.x, d.y, d.z };
+                float world[3] = {};
+                for (size_t row = 0; row < 3; ++row)
+                    for (size_t column = 0; column < 3; ++column)
+                        world[row] += rotation (row, column) * local[column];
+
+                head.toHeadRelative (world[0], world[1], world[2]);
+                for (size_t i = 0; i < 3; ++i)
+                    expectWithinAbsoluteError (world[i], local[i], 1.0e-5f);
+            }
+
+            // Turning right puts what was ahead on the left; tipping up puts it below;
+            // leaning right puts what was overhead on the left.
+            const Spatializer::Position ahead { 0.0f, 0.0f, 2.0f };
+            const auto turned = Spatializer::toHeadRelative (ahead, { 0.5f * pi, 0.0f, 0.0f });
+            expectWithinAbsoluteError (turned.azimuth, -0.5f * pi, 1.0e-5f);
+            expectWithinAbsoluteError (turned.distance, 2.0f, 1.0e-6f);
+
+            const auto tipped = Spatializer::toHeadRelative (ahead, { 0.0f, 0.25f * pi, 0.0f });
+            expectWithinAbsoluteError (tipped.elevation, -0.25f * pi, 1.0e-5f);
+
+            const auto leaned = Spatializer::toHeadRelative ({ 0.0f, 0.5f * pi, 1.0f }, { 0.0f, 0.0f, 0.5f * pi });
+            expectWithinAbsoluteError (leaned.azimuth, -0.5f * pi, 1.0e-4f);
+            expectWithinAbsoluteError (leaned.elevation, 0.0f, 1.0e-4f);
+        }
+
+        beginTest ("prediction extrapolates, stops at its cap and holds a stale pose");
+        {
+            HeadPose pose;
+            pose.orientation = { 0.2f, 0.0f, 0.0f };
+            pose.rate = { 2.0f, -1.0f, 0.0f };
+            pose.time = 10.0;
+            pose.valid = true;
+
+            // Measured 20 ms ago and heard 30 ms from now: 50 ms ahead at the block's start.
+            const auto motion = HeadMotion::predict (pose, 10.02, 0.03);
+            expectWithinAbsoluteError (motion.start.yaw, 0.3f, 1.0e-5f);
+            expectWithinAbsoluteError (motion.start.pitch, -0.05f, 1.0e-5f);
+            expectWithinAbsoluteError (motion.at (0.01).yaw, 0.32f, 1.0e-5f);
+            expectWithinAbsoluteError (motion.at (1.0).yaw, 0.4f, 1.0e-5f, "no more than maxPrediction past the pose");
+
+            const auto capped = HeadMotion::predict (pose, 10.09, 0.03);
+            expectWithinAbsoluteError (capped.start.yaw, 0.4f, 1.0e-5f);
+            expectWithinAbsoluteError (capped.at (0.01).yaw, 0.4f, 1.0e-5f);
+
+            const auto stale = HeadMotion::predict (pose, 10.0 + HeadMotion::staleAfter + 0.01, 0.03);
+            expect (stale.isStill());
+            expect (stale.start == pose.orientation);
+
+            expect (HeadMotion::predict ({}, 10.0, 0.03).start.isZero(), "no pose yet: facing ahead");
+
+            // Yaw wraps round behind the head; pitch stops at straight up.
+            pose.orientation = { 3.1f, 1.5f, 0.0f };
+            pose.rate = { 1.0f, 1.0f, 0.0f };
+            const auto over = HeadMotion::predict (pose, 10.0, 0.1);
+            expectWithinAbsoluteError (over.start.yaw, 3.2f - 2.0f * pi, 1.0e-5f);
+            expectWithinAbsoluteError (over.start.pitch, 0.5f * pi, 1.0e-6f);
+        }
+
+        beginTest ("every processor hears a source ahead on the left when the head turns right");
+        {
+            const auto ahead = OrbitPath::still ({ 0.0f, 0.0f, SpatialDsp::referenceDistance });
+            juce::AudioBuffer<float> buffer (2, 8 * blockSize);
+
+            const auto check = [&] (const juce::String& processor, auto&& render)
+            {
+                for (const float yaw : { 0.0f, 90.0f, -90.0f })
+                {
+                    fillNoise (buffer);
+                    render (facing (yaw));
+                    const float difference = leftOverRightDecibels (buffer);
+
+                    if (yaw == 0.0f)
+                        expectWithinAbsoluteError (difference, 0.0f, 0.5f, processor + " facing the source");
+                    else
+                        expect (yaw > 0.0f ? difference > 3.0f : difference < -3.0f,
+                                processor + " turned " + juce::String (yaw) + " degrees: " + juce::String (difference) + " dB");
+                }
+            };
+
+            check ("Spatializer", [&] (const HeadMotion& motion)
+            {
+                Spatializer spatializer;
+                spatializer.prepareToPlay (blockSize, sampleRate);
+                spatializer.setHeadMotion (motion);
+                for (int start = 0; start < buffer.getNumSamples(); start += blockSize)
+                    spatializer.process (buffer, start, blockSize, ahead, 0.0f);
+            });
+
+            check ("SpatializerBank", [&] (const HeadMotion& motion)
+            {
+                SpatializerBank bank;
+                bank.prepareToPlay (blockSize, sampleRate);
+                bank.setHeadMotion (motion);
+                for (int start = 0; start < buffer.getNumSamples(); start += blockSize)
+                    bank.process (buffer, start, blockSize, 1, SpatializerBank::SourceLayout::MonoChannels, ahead, 0.0f);
+            });
+
+            check ("HrtfRenderer", [&] (const HeadMotion& motion)
+            {
+                HrtfRenderer renderer;
+                renderer.setHrirSet (AmbisonicHrirFilters::getParametricHead());
+                renderer.prepareToPlay (blockSize, sampleRate);
+                renderer.setHeadMotion (motion);
+                for (int start = 0; start < buffer.getNumSamples(); start += blockSize)
+                    renderer.process (buffer, start, blockSize, ahead, 0.0f);
+            });
+
+            check ("AmbisonicBank", [&] (const HeadMotion& motion)
+            {
+                AmbisonicBank bank;
+                bank.setOrder (3);
+                bank.prepareToPlay (blockSize, sampleRate);
+                bank.setHeadMotion (motion);
+                for (int start = 0; start < buffer.getNumSamples(); start += blockSize)
+                    bank.process (buffer, start, blockSize, 1, AmbisonicBank::SourceLayout::MonoChannels, ahead, 0.0f);
+            });
+        }
+
+        beginTest ("a head turning within a block is followed sub-block by sub-block");
+        {
+            // Starting ahead and turning left at 15 radians a second: by the end of a 100 ms
+            // block the source is well round to the right, and got there a sub-block at a time.
+            HeadMotion motion;
+            motion.rate.yaw = -15.0f;
+            motion.horizon = HeadMotion::maxPrediction;
+
+            Spatializer spatializer;
+            spatializer.prepareToPlay (4800, sampleRate);
+            spatializer.setHeadMotion (motion);
+
+            juce::AudioBuffer<float> buffer (2, 4800);
+            fillNoise (buffer);
+            spatializer.process (buffer, 0, 4800, OrbitPath::still ({ 0.0f, 0.0f, SpatialDsp::referenceDistance }), 0.0f);
+
+            const auto cues = spatializer.getCurrentCues();
+            expectGreaterThan (cues.rightGain, cues.leftGain);
+            expectGreaterThan (cues.leftDelay, 0.0f);
+
+            // Right over left, 10 ms in and in the last 10 ms: the difference grew as the head turned.
+            const auto rightOverLeft = [&] (int start)
+            {
+                return juce::Decibels::gainToDecibels (buffer.getRMSLevel (1, start, 480) / buffer.getRMSLevel (0, start, 480));
+            };
+
+            expectGreaterThan (rightOverLeft (4320), rightOverLeft (480) + 3.0f);
+
+            expectEquals (spatializer.getCurrentPosition().azimuth, 0.0f, "the source itself stays put in the world");
+        }
+
+        beginTest ("the engine predicts from the pose it was handed, only while tracking");
+        {
+            OrbitEngine engine;
+            auto parameters = OrbitEngine::Parameters();
+            parameters.headTracking = true;
+            parameters.headPredictionMs = 0.0f;
+            parameters.limiterEnabled = false;
+            engine.setParameters (parameters);
+            engine.prepareToPlay (blockSize, sampleRate);
+
+            HeadPose pose;
+            pose.orientation.yaw = 0.5f * pi;
+            pose.time = HeadPose::getClock();
+            pose.valid = true;
+            engine.setHeadPose (pose);
+
+            juce::AudioBuffer<float> buffer (2, 8 * blockSize);
+            const auto render = [&]
+            {
+                fillNoise (buffer);
+                for (int start = 0; start < buffer.getNumSamples(); start += blockSize)
+                    engine.process (buffer, start, blockSize);
+            };
+
+            render();
+            expectGreaterThan (leftOverRightDecibels (buffer), 3.0f);
+
+            OrbitEngine::PositionFrame frames[16];
+            const int numFrames = engine.readPositionFrames (frames, 16);
+            expect (numFrames > 0);
+            expectWithinAbsoluteError (frames[numFrames - 1].head.yaw, 0.5f * pi, 1.0e-5f);
+            expectEquals (frames[numFrames - 1].position.azimuth, 0.0f, "the radar shows the source where it is in the world");
+
+            parameters.headTracking = false;
+            engine.setParameters (parameters);
+            render();
+            expectWithinAbsoluteError (leftOverRightDecibels (buffer), 0.0f, 0.5f);
+        }
+    }
+};
+
+static HeadMotionTest headMotionTest;
@@ -0,0 +1,148 @@
+#include "HeadTracker.h"
+
+const char* const HeadTracker::orientationAddress = "/orbit/head/ypr";
+
+//==============================================================================
+HeadTracker::HeadTracker()
+{
+    receiver.addListener (this);
+}
+
+HeadTracker::~HeadTracker()
+{
+    disconnect();
+    receiver.removeListener (this);
+}
+
+bool HeadTracker::connect (int port, Callback& callbackToUse)
+{
+    disconnect();
+
+    callback = &callbackToUse;
+    pose = {};
+    numMeasurements = 0;
+
+    if (! receiver.connect (port))
+    {
+        callback = nullptr;
+        return false;
+    }
+
+    connectedPort = port;
+    return true;
+}
+
+void HeadTracker::disconnect()
+{
+    // Once this returns the receiver's thread has stopped, so nothing calls back any more.
+    if (connectedPort != 0)
+        receiver.disconnect();
+
+    connectedPort = 0;
+    callback = nullptr;
+}
+
+//==============================================================================
+namespace
+{
+    // An OSC time tag in seconds. It's 32.32 fixed point, so even counting from 1900 a
+    // double keeps it to within a microsecond.
+    double toSeconds (const juce::OSCTimeTag& timeTag) noexcept
+    {
+        const auto raw = timeTag.getRawTimeTag();
+        return (double) (raw >> 32) + (double) (raw & 0xffffffffu) / 4294967296.0;
+    }
+}
+
+void HeadTracker::oscMessageReceived (const juce::OSCMessage& message)
+{
+    receiveMessage (message, {});
+}
+
+void HeadTracker::oscBundleReceived (const juce::OSCBundle& bundle)
+{
+    receiveBundle (bundle, {});
+}
+
+void HeadTracker::receiveBundle (const juce::OSCBundle& bundle, const juce::OSCTimeTag& outerTimeTag)
+{
+    // A bundle marked "immediately" has no time of its own; it's inside its parent's.
+    const auto timeTag = bundle.getTimeTag().isImmediately() ? outerTimeTag : bundle.getTimeTag();
+
+    for (const auto& element : bundle)
+    {
+        if (element.isMessage())
+            receiveMessage (element.getMessage(), timeTag);
+        else if (element.isBundle())
+            receiveBundle (element.getBundle(), timeTag);
+    }
+}
+
+void HeadTracker::receiveMessage (const juce::OSCMessage& message, const juce::OSCTimeTag& timeTag)
+{
+    static const juce::OSCAddress orientation (orientationAddress);
+
+    if (message.size() < 3 || ! message.getAddressPattern().matches (orientation))
+        return;
+
+    float values[3] = {};
+
+    for (int i = 0; i < 3; ++i)
+    {
+        const auto& argument = message[i];
+
+        if (argument.isFloat32())
+            values[i] = argument.getFloat32();
+        else if (argument.isInt32())
+            values[i] = (float) argument.getInt32();
+        else
+            return;
+    }
+
+    const double arrivalTime = HeadPose::getClock();
+    addMeasurement (values[0], values[1], values[2], arrivalTime,
+                    timeTag.isImmediately() ? arrivalTime : toSeconds (timeTag));
+}
+
+//==============================================================================
+void HeadTracker::addMeasurement (float yawDegrees, float pitchDegrees, float rollDegrees,
+                                  double arrivalTime, double sensorTime)
+{
+    // Trackers differ on where the angles wrap; I keep yaw and roll between -180 and 180.
+    const HeadOrientation measured { juce::degreesToRadians (std::remainder (yawDegrees, 360.0f)),
+                                     juce::degreesToRadians (juce::jlimit (-90.0f, 90.0f, pitchDegrees)),
+                                     juce::degreesToRadians (std::remainder (rollDegrees, 360.0f)) };
+
+    // The spacing between the last two measurements; if the sensor's clock went backwards
+    // (it restarted) the arrival times will have to do.
+    double spacing = sensorTime - lastSensorTime;
+    if (spacing <= 0.0)
+        spacing = arrivalTime - pose.time;
+
+    if (! pose.valid || spacing <= 0.0 || spacing > maxGap)
+    {
+        pose.rate = {};
+    }
+    else
+    {
+        // The shorter way round, so turning past behind isn't a full turn the other way.
+        const auto estimate = [spacing] (float from, float to, float previous)
+        {
+            const float rate = std::remainder (to - from, juce::MathConstants<float>::twoPi) / (float) spacing;
+            return previous + rateSmoothing * (rate - previous);
+        };
+
+        pose.rate = { estimate (pose.orientation.yaw, measured.yaw, pose.rate.yaw),
+                      estimate (pose.orientation.pitch, measured.pitch, pose.rate.pitch),
+                      estimate (pose.orientation.roll, measured.roll, pose.rate.roll) };
+    }
+
+    pose.orientation = measured;
+    pose.time = arrivalTime;
+    pose.valid = true;
+    lastSensorTime = sensorTime;
+    ++numMeasurements;
+
+    if (callback != nullptr)
+        callback->headPoseReceived (pose);
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "HeadMotion.h"
+
+//==============================================================================
+// I listen for a head tracker on a local UDP port and turn what it sends into HeadPoses.
+// A tracker sends one OSC message per measurement, at 100 to 200 a second:
+//
+//     /orbit/head/ypr  yaw pitch roll
+//
+// yaw, pitch and roll in degrees (floats or ints) with the HeadOrientation conventions;
+// further arguments are ignored. Bundles of them are unpacked, and a bundle's time tag,
+// unless it's "immediately", is taken as the sensor's own timestamp for what's in it: a
+// 64-bit clock, so its spacing stays exact however long the sensor has been up (a float
+// count of seconds can't resolve 5 ms after a day). Anything else on the port is ignored.
+//
+// I stamp each measurement with its arrival time on HeadPose::getClock() and estimate how
+// fast each angle is turning from the last two, smoothed, so the audio thread can predict
+// past the latency. The sensor's timestamps, when it sends them, give the steadier spacing
+// for that; the arrival times jitter with the network. After a gap longer than maxGap the
+// estimate starts again from still.
+//
+// Everything happens on the OSC receiver's thread, which hands each pose to the callback
+// as it's made; it never blocks the audio thread, which only sees poses through the
+// engine's lock-free latest-value slot.
+class HeadTracker  : private juce::OSCReceiver::Listener<juce::OSCReceiver::RealtimeCallback>
+{
+public:
+    static constexpr int defaultPort = 9000;
+    static constexpr double maxGap = 0.1;            // seconds between measurements
+    static constexpr float rateSmoothing = 0.5f;     // how much of each new rate estimate to take
+
+    static const char* const orientationAddress;
+
+    struct Callback
+    {
+        virtual ~Callback() = default;
+
+        // Called on the receiver's thread with every new pose.
+        virtual void headPoseReceived (const HeadPose& pose) = 0;
+    };
+
+    HeadTracker();
+    ~HeadTracker() override;
+
+    // Message thread. I start listening on port and calling callback, and return false if
+    // the port can't be opened (another tracker listener has it, say).
+    bool connect (int port, Callback& callback);
+    void disconnect();
+    bool isConnected() const noexcept          { return connectedPort != 0; }
+    int getPort() const noexcept               { return connectedPort; }
+
+    // Any thread: how many measurements have arrived since connect().
+    int getNumMeasurements() const noexcept    { return numMeasurements.load(); }
+
+    // Receiver thread (or a test, before connecting): I take one measurement, in degrees,
+    // that arrived at arrivalTime and was taken at sensorTime, and hand on the new pose.
+    void addMeasurement (float yawDegrees, float pitchDegrees, float rollDegrees,
+                         double arrivalTime, double sensorTime);
+
+    // The receiver's side of what addMeasurement() last made.
+    const HeadPose& getLatestPose() const noexcept   { return pose; }
+
+private:
+    void oscMessageReceived (const juce::OSCMessage& message) override;
+    void oscBundleReceived (const juce::OSCBundle& bundle) override;
+    void receiveBundle (const juce::OSCBundle& bundle, const juce::OSCTimeTag& outerTimeTag);
+    void receiveMessage (const juce::OSCMessage& message, const juce::OSCTimeTag& timeTag);
+
+    juce::OSCReceiver receiver { "Head tracker" };
+    Callback* callback = nullptr;
+    int connectedPort = 0;
+    std::atomic<int> numMeasurements { 0 };
+
+    HeadPose pose;
+    double lastSensorTime = 0.0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (HeadTracker)
+};
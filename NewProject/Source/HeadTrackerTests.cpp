@@ -0,0 +1,170 @@
+#include <JuceHeader.h>
+#include "HeadTracker.h"
+#include "HeadMotionRecording.h"
+
+//==============================================================================
+// I test the head tracker's side: the turning rate comes from the sensor's timestamps,
+// the short way round past behind the head, and starts again after a gap; recordings
+// parse, and say which line is wrong when they don't; and a recording played to a
+// HeadTracker over local UDP arrives whole, in order and with the right rate, as do
+// bundles, while other messages are ignored. This is what CI runs instead of a tracker.
+class HeadTrackerTest : public juce::UnitTest
+{
+public:
+    HeadTrackerTest() : juce::UnitTest ("HeadTracker", "Audio") {}
+
+    // A slow turn to the right past 180 degrees and a nod, at 100 measurements a second.
+    static juce::String makeRecording (int numFrames)
+    {
+        juce::String text ("# seconds, yaw, pitch, roll (degrees)\n");
+        for (int i = 0; i < numFrames; ++i)
+        {
+            const double time = i * 0.01;
+            text << juce::String (time, 3) << ", " << juce::String (170.0 + 90.0 * time, 3) << ", "
+                 << juce::String (-30.0 * time, 3) << ", 0\n";
+        }
+        return text;
+    }
+
+    struct PoseCollector  : public HeadTracker::Callback
+    {
+        void headPoseReceived (const HeadPose& pose) override
+        {
+            const juce::SpinLock::ScopedLockType lock (mutex);
+            poses.push_back (pose);
+        }
+
+        std::vector<HeadPose> getPoses()
+        {
+            const juce::SpinLock::ScopedLockType lock (mutex);
+            return poses;
+        }
+
+        juce::SpinLock mutex;
+        std::vector<HeadPose> poses;
+    };
+
+    static bool waitFor (HeadTracker& tracker, int count)
+    {
+        for (int attempt = 0; attempt < 200 && tracker.getNumMeasurements() < count; ++attempt)
+            juce::Thread::sleep (10);
+
+        return tracker.getNumMeasurements() >= count;
+    }
+
+    void runTest() override
+    {
+        const auto degrees = [] (double d) { return juce::degreesToRadians ((float) d); };
+
+        beginTest ("the rate comes from the sensor's clock, the short way round, and restarts after a gap");
+        {
+            HeadTracker tracker;
+
+            // The arrivals bunch up, as they do over a network; the sensor's stamps don't.
+            for (int i = 0; i < 20; ++i)
+                tracker.addMeasurement ((float) (170.0 + 0.9 * i), 0.0f, 0.0f, 100.0 + 0.02 * (i / 2), 5.0 + 0.01 * i);
+
+            const auto& pose = tracker.getLatestPose();
+            expect (pose.valid);
+            expectWithinAbsoluteError (pose.orientation.yaw, degrees (187.1 - 360.0), 1.0e-4f);
+            expectWithinAbsoluteError (pose.rate.yaw, degrees (90.0), 0.01f, "through 180 degrees");
+            expectEquals (pose.time, 100.18);
+            expectEquals (tracker.getNumMeasurements(), 20);
+
+            tracker.addMeasurement (0.0f, 0.0f, 0.0f, 101.0, 6.0);
+            expect (tracker.getLatestPose().rate.isZero(), "after a gap");
+
+            // A sensor that restarts its clock falls back on the arrival times.
+            tracker.addMeasurement (1.0f, 0.0f, 0.0f, 101.01, 0.0);
+            expectWithinAbsoluteError (tracker.getLatestPose().rate.yaw, HeadTracker::rateSmoothing * degrees (100.0), 0.01f);
+        }
+
+        beginTest ("recordings parse, and say which line is wrong");
+        {
+            HeadMotionRecording recording;
+            expect (recording.parse (makeRecording (50)).wasOk());
+            expectEquals ((int) recording.frames.size(), 50);
+            expectWithinAbsoluteError (recording.getLength(), 0.49, 1.0e-9);
+            expectWithinAbsoluteError (recording.frames[10].yaw, 179.0f, 1.0e-4f);
+
+            expect (recording.parse ("0 1 2 3\n\n# a comment\n0.01\t4 5 6").wasOk(), "spaces and tabs");
+            expectEquals ((int) recording.frames.size(), 2);
+
+            auto result = recording.parse ("0, 1, 2, 3\n0.01, 1, 2\n");
+            expect (result.failed() && result.getErrorMessage().startsWith ("Line 2"));
+            expect (recording.frames.empty());
+
+            result = recording.parse ("0, 1, 2, 3\n# then\n0.01, 1, up, 3\n");
+            expect (result.failed() && result.getErrorMessage().startsWith ("Line 3"));
+
+            result = recording.parse ("0.02, 1, 2, 3\n0.01, 1, 2, 3\n");
+            expect (result.failed() && result.getErrorMessage().startsWith ("Line 2"));
+
+            expect (recording.parse ("# nothing\n").failed());
+        }
+
+        beginTest ("a recording played over local UDP arrives whole, in order and with its rate");
+        {
+            PoseCollector collector;
+            HeadTracker tracker;
+
+            // Somewhere free on this machine.
+            auto random = getRandom();
+            bool connected = false;
+            for (int attempt = 0; attempt < 20 && ! connected; ++attempt)
+                connected = tracker.connect (20000 + random.nextInt (20000), collector);
+
+            expect (connected);
+            if (! connected)
+                return;
+
+            // Twice over at double speed: the head really turns twice as fast, and the
+            // second pass's timestamps carry on from the first's. They're time tags from
+            // today's date, where a float clock would only resolve 128 s.
+            HeadMotionRecording recording;
+            recording.parse (makeRecording (30));
+            const double speed = 2.0;
+            expect (recording.play ("127.0.0.1", tracker.getPort(), speed, 2).wasOk());
+            expect (waitFor (tracker, 60));
+
+            const auto poses = collector.getPoses();
+            expectEquals ((int) poses.size(), 60);
+            if (poses.size() == 60)
+            {
+                for (size_t i = 1; i < poses.size(); ++i)
+                    expect (poses[i].time >= poses[i - 1].time);
+
+                const auto& last = poses.back();
+                expectWithinAbsoluteError (last.orientation.yaw, degrees (196.1 - 360.0), 1.0e-4f);
+                expectWithinAbsoluteError (last.orientation.pitch, degrees (-8.7), 1.0e-4f);
+                expectWithinAbsoluteError (last.rate.yaw, degrees (90.0 * speed), 0.02f, "at the wall clock's pace");
+                expectWithinAbsoluteError (last.rate.pitch, degrees (-30.0 * speed), 0.02f);
+            }
+
+            // Bundles are unpacked; other addresses and arguments are ignored.
+            juce::OSCSender sender;
+            expect (sender.connect ("127.0.0.1", tracker.getPort()));
+
+            juce::OSCBundle bundle;
+            bundle.addElement (juce::OSCMessage (HeadTracker::orientationAddress, 10.0f, 0.0f, 0.0f));
+            bundle.addElement (juce::OSCMessage (HeadTracker::orientationAddress, (juce::int32) 20, (juce::int32) 0, (juce::int32) 5));
+            sender.send (juce::OSCMessage ("/orbit/head/quaternion", 1.0f, 0.0f, 0.0f, 0.0f));
+            sender.send (juce::OSCMessage (HeadTracker::orientationAddress, juce::String ("left"), 0.0f, 0.0f));
+            sender.send (juce::OSCMessage (HeadTracker::orientationAddress, 0.0f, 0.0f));
+            sender.send (bundle);
+
+            expect (waitFor (tracker, 62));
+            juce::Thread::sleep (50);
+            expectEquals (tracker.getNumMeasurements(), 62);
+
+            const auto last = collector.getPoses().back();
+            expectWithinAbsoluteError (last.orientation.yaw, degrees (20.0), 1.0e-5f);
+            expectWithinAbsoluteError (last.orientation.roll, degrees (5.0), 1.0e-5f);
+
+            tracker.disconnect();
+            expect (! tracker.isConnected());
+        }
+    }
+};
+
+static HeadTrackerTest headTrackerTest;
@@ -0,0 +1,188 @@
+#include "HrirSet.h"
+#include <regex>
+
+//==============================================================================
+float HrirSet::wrapDegrees (float degrees)
+{
+    const float wrapped = std::fmod (degrees, 360.0f);
+    return wrapped < 0.0f ? wrapped + 360.0f : wrapped;
+}
+
+bool HrirSet::parseAngles (const juce::String& fileName, float& azimuthDegrees, float& elevationDegrees)
+{
+    const auto name = fileName.toStdString();
+    std::smatch match;
+
+    // MIT KEMAR: H<elevation>e<azimuth>a, e.g. H-10e030a.
+    static const std::regex kemar (R"(H(-?\d+)e(\d+)a)", std::regex::icase);
+    if (std::regex_search (name, match, kemar))
+    {
+        elevationDegrees = std::stof (match[1].str());
+        azimuthDegrees = wrapDegrees (std::stof (match[2].str()));
+        return true;
+    }
+
+    // Generic: az/azi/azimuth followed by an angle, with an optional el/ele/elevation.
+    static const std::regex azimuth (R"((?:^|[^a-z])az[a-z]*[_\-]?(-?\d+(?:\.\d+)?))", std::regex::icase);
+    static const std::regex elevation (R"((?:^|[^a-z])el[a-z]*[_\-]?(-?\d+(?:\.\d+)?))", std::regex::icase);
+
+    if (! std::regex_search (name, match, azimuth))
+        return false;
+
+    azimuthDegrees = wrapDegrees (std::stof (match[1].str()));
+    elevationDegrees = std::regex_search (name, match, elevation) ? std::stof (match[1].str()) : 0.0f;
+    return true;
+}
+
+//==============================================================================
+void HrirSet::addMeasurement (float azimuthDegrees, float elevationDegrees,
+                              const juce::AudioBuffer<float>& stereoIr, double irSampleRate)
+{
+    jassert (stereoIr.getNumChannels() >= 1);
+    jassert (sampleRate == 0.0 || juce::approximatelyEqual (sampleRate, irSampleRate));
+    sampleRate = irSampleRate;
+
+    Measurement m;
+    m.azimuth = wrapDegrees (azimuthDegrees);
+    m.elevation = juce::jlimit (-90.0f, 90.0f, elevationDegrees);
+
+    // A mono file is used for both ears.
+    const int length = juce::jmin (stereoIr.getNumSamples(), maxIrLength);
+    m.ir.setSize (2, length);
+    for (int ch = 0; ch < 2; ++ch)
+        m.ir.copyFrom (ch, 0, stereoIr, juce::jmin (ch, stereoIr.getNumChannels() - 1), 0, length);
+
+    // Replace an existing measurement at the same angle rather than keeping duplicates.
+    for (auto& existing : measurements)
+    {
+        if (juce::approximatelyEqual (existing.azimuth, m.azimuth)
+            && juce::approximatelyEqual (existing.elevation, m.elevation))
+        {
+            existing = std::move (m);
+            return;
+        }
+    }
+
+    measurements.push_back (std::move (m));
+    sortMeasurements();
+}
+
+void HrirSet::sortMeasurements()
+{
+    std::sort (measurements.begin(), measurements.end(), [] (const Measurement& a, const Measurement& b)
+    {
+        return a.elevation != b.elevation ? a.elevation < b.elevation : a.azimuth < b.azimuth;
+    });
+
+    rings.clear();
+    for (int i = 0; i < size(); ++i)
+    {
+        if (rings.empty() || ! juce::approximatelyEqual (rings.back().elevation, getElevation (i)))
+            rings.push_back ({ getElevation (i), i, 0 });
+
+        ++rings.back().count;
+    }
+}
+
+juce::Result HrirSet::loadFromFolder (const juce::File& folder)
+{
+    if (! folder.isDirectory())
+        return juce::Result::fail ("HRIR folder not found: " + folder.getFullPathName());
+
+    juce::AudioFormatManager formatManager;
+    formatManager.registerBasicFormats();
+
+    struct Candidate { juce::File file; float azimuth, elevation; };
+    std::vector<Candidate> candidates;
+
+    for (const auto& file : folder.findChildFiles (juce::File::findFiles, false, formatManager.getWildcardForAllFormats()))
+    {
+        float azimuth = 0.0f, elevation = 0.0f;
+        if (parseAngles (file.getFileNameWithoutExtension(), azimuth, elevation))
+            candidates.push_back ({ file, azimuth, elevation });
+    }
+
+    if (candidates.empty())
+        return juce::Result::fail ("No HRIR files with an azimuth in their name in " + folder.getFullPathName());
+
+    measurements.clear();
+    rings.clear();
+    sampleRate = 0.0;
+
+    for (const auto& c : candidates)
+    {
+        std::unique_ptr<juce::AudioFormatReader> reader (formatManager.createReaderFor (c.file));
+        if (reader == nullptr || reader->lengthInSamples <= 0)
+            continue;
+
+        if (sampleRate > 0.0 && ! juce::approximatelyEqual (sampleRate, reader->sampleRate))
+            return juce::Result::fail ("HRIR files use different sample rates: " + c.file.getFileName());
+
+        const int length = (int) juce::jmin ((juce::int64) maxIrLength, reader->lengthInSamples);
+        juce::AudioBuffer<float> ir ((int) juce::jmin (2u, reader->numChannels), length);
+        reader->read (&ir, 0, length, 0, true, true);
+        addMeasurement (c.azimuth, c.elevation, ir, reader->sampleRate);
+    }
+
+    if (measurements.empty())
+        return juce::Result::fail ("No readable HRIR files in " + folder.getFullPathName());
+
+    return juce::Result::ok();
+}
+
+//==============================================================================
+std::vector<float> HrirSet::getResampledTaps (int index, int ear, double targetRate, int maxLength) const
+{
+    const auto& ir = getImpulseResponse (index);
+    const auto* source = ir.getReadPointer (ear);
+    const int length = ir.getNumSamples();
+
+    // speedRatio is source samples per output sample.
+    const double speedRatio = sampleRate / targetRate;
+
+    if (juce::approximatelyEqual (speedRatio, 1.0))
+        return std::vector<float> (source, source + juce::jmin (length, maxLength));
+
+    const int outputLength = juce::jmin (maxLength, (int) std::ceil (length / speedRatio));
+    std::vector<float> padded ((size_t) length + 8, 0.0f);
+    std::copy (source, source + length, padded.begin());
+
+    std::vector<float> output ((size_t) outputLength);
+    juce::LagrangeInterpolator interpolator;
+    interpolator.process (speedRatio, padded.data(), output.data(), outputLength, (int) padded.size(), 0);
+    juce::FloatVectorOperations::multiply (output.data(), (float) speedRatio, outputLength);
+    return output;
+}
+
+//==============================================================================
+void HrirSet::findRings (float elevationDegrees, int& lower, int& upper, float& fraction) const
+{
+    jassert (! rings.empty());
+    const int n = getNumRings();
+
+    upper = (int) (std::upper_bound (rings.begin(), rings.end(), elevationDegrees,
+                                     [] (float e, const Ring& r) { return e < r.elevation; })
+                   - rings.begin());
+    lower = juce::jmax (0, upper - 1);
+    upper = juce::jmin (upper, n - 1);
+
+    const float gap = getRingElevation (upper) - getRingElevation (lower);
+    fraction = gap > 0.0f ? juce::jlimit (0.0f, 1.0f, (elevationDegrees - getRingElevation (lower)) / gap) : 0.0f;
+}
+
+void HrirSet::findNeighbours (int ring, float azimuthDegrees, int& lower, int& upper, float& fraction) const
+{
+    const auto& r = rings[(size_t) ring];
+    const auto first = measurements.begin() + r.begin;
+    const float azimuth = wrapDegrees (azimuthDegrees);
+
+    // The last measurement at or below azimuth; below the first one I wrap to the last.
+    const int next = (int) (std::upper_bound (first, first + r.count, azimuth,
+                                              [] (float a, const Measurement& m) { return a < m.azimuth; })
+                            - first);
+    lower = r.begin + (next + r.count - 1) % r.count;
+    upper = r.begin + next % r.count;
+
+    const float gap = wrapDegrees (getAzimuth (upper) - getAzimuth (lower));
+    fraction = gap > 0.0f ? wrapDegrees (azimuth - getAzimuth (lower)) / gap : 0.0f;
+}
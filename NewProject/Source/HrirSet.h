@@ -0,0 +1,82 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+// I hold measured head-related impulse responses (HRIRs). Each measurement is a stereo
+// IR (channel 0 = left ear, channel 1 = right ear) for a source at one azimuth, in
+// degrees clockwise from the front (90 = right), and one elevation (0 = ear level,
+// positive = up). I group measurements into rings of equal elevation, each sorted by
+// azimuth, which is how measured sets are laid out.
+//
+// I load from a folder with one audio file per angle, named with the angle in it, e.g.
+// "azi030_ele000.wav", "az_-30_el_10.wav" or the MIT KEMAR style "H0e030a.wav". I'm
+// built on the message thread and then only read.
+class HrirSet
+{
+public:
+    // I truncate longer HRIRs so the convolution cost stays bounded.
+    static constexpr int maxIrLength = 512;
+
+    HrirSet() = default;
+    ~HrirSet() = default;
+
+    // I replace my contents with every parseable file in folder. I fail if the folder
+    // has no usable HRIRs or if files disagree on sample rate.
+    juce::Result loadFromFolder (const juce::File& folder);
+
+    // I add one measurement directly (used for generated sets and in tests).
+    void addMeasurement (float azimuthDegrees, float elevationDegrees,
+                         const juce::AudioBuffer<float>& stereoIr, double irSampleRate);
+
+    int size() const                                { return (int) measurements.size(); }
+    bool isEmpty() const                            { return measurements.empty(); }
+    double getSampleRate() const                    { return sampleRate; }
+    float getAzimuth (int index) const              { return measurements[(size_t) index].azimuth; }
+    float getElevation (int index) const            { return measurements[(size_t) index].elevation; }
+    const juce::AudioBuffer<float>& getImpulseResponse (int index) const { return measurements[(size_t) index].ir; }
+
+    // I return one ear's IR resampled to sampleRate, at most maxLength taps, scaled so the
+    // filter keeps its gain when its length changes. For the filter builders, off the audio thread.
+    std::vector<float> getResampledTaps (int index, int ear, double sampleRate, int maxLength) const;
+
+    // Rings of equal elevation, lowest first.
+    int getNumRings() const                         { return (int) rings.size(); }
+    float getRingElevation (int ring) const         { return rings[(size_t) ring].elevation; }
+
+    // I find the two rings either side of elevationDegrees and how far between them it
+    // lies (0 = lower). Outside the measured range I clamp to the nearest ring.
+    void findRings (float elevationDegrees, int& lower, int& upper, float& fraction) const;
+
+    // I find the two measurements either side of azimuthDegrees on one ring and how far
+    // between them it lies (0 = lower, 1 = upper). With one measurement both are the same.
+    void findNeighbours (int ring, float azimuthDegrees, int& lower, int& upper, float& fraction) const;
+
+    // I pull azimuth/elevation out of a file name; false if there's no azimuth in it.
+    static bool parseAngles (const juce::String& fileName, float& azimuthDegrees, float& elevationDegrees);
+
+    // I wrap any angle into [0, 360).
+    static float wrapDegrees (float degrees);
+
+private:
+    struct Measurement
+    {
+        float azimuth = 0.0f;
+        float elevation = 0.0f;
+        juce::AudioBuffer<float> ir;
+    };
+
+    struct Ring
+    {
+        float elevation = 0.0f;
+        int begin = 0, count = 0;   // range in measurements
+    };
+
+    void sortMeasurements();
+
+    std::vector<Measurement> measurements;   // sorted by elevation, then azimuth
+    std::vector<Ring> rings;
+    double sampleRate = 0.0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (HrirSet)
+};
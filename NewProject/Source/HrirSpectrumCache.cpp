@@ -0,0 +1,130 @@
+#include "HrirSpectrumCache.h"
+
+//==============================================================================
+HrirSpectrumCache::HrirSpectrumCache (const HrirSet& set, double sampleRateIn)
+    : sampleRate (sampleRateIn)
+{
+    jassert (! set.isEmpty());
+
+    // Partition count from the longest IR once it's at the device rate.
+    const double speedRatio = set.getSampleRate() / sampleRate;
+    int longest = 1;
+    for (int m = 0; m < set.size(); ++m)
+        longest = juce::jmax (longest, (int) std::ceil (set.getImpulseResponse (m).getNumSamples() / speedRatio));
+
+    numPartitions = juce::jlimit (1, maxPartitions, (longest + partitionSize - 1) / partitionSize);
+    filterSize = 2 * numPartitions * 2 * binStride;
+    gridStride = (filterSize + 15) & ~15;
+
+    std::vector<float> measured;
+    transformMeasurements (set, measured);
+
+    // Grid rows run from the lowest to the highest measured ring; the top row is clamped
+    // onto the highest ring if the range isn't a whole number of steps.
+    minElevation = set.getRingElevation (0);
+    maxElevation = set.getRingElevation (set.getNumRings() - 1);
+    numElevations = (int) std::ceil ((maxElevation - minElevation) / elevationStep) + 1;
+    numAzimuths = juce::roundToInt (360.0f / azimuthStep);
+
+    arena.calloc ((size_t) numAzimuths * (size_t) numElevations * (size_t) gridStride + 16);
+    grid = juce::snapPointerToAlignment (arena.get(), 64);
+
+    for (int e = 0; e < numElevations; ++e)
+    {
+        int lowerRing = 0, upperRing = 0;
+        float ringFraction = 0.0f;
+        set.findRings (getRowElevation (e), lowerRing, upperRing, ringFraction);
+
+        for (int a = 0; a < numAzimuths; ++a)
+        {
+            auto* dest = grid + (size_t) (e * numAzimuths + a) * (size_t) gridStride;
+
+            const auto addRing = [&] (int ring, float ringWeight)
+            {
+                int lower = 0, upper = 0;
+                float fraction = 0.0f;
+                set.findNeighbours (ring, (float) a * azimuthStep, lower, upper, fraction);
+                juce::FloatVectorOperations::addWithMultiply (dest, measured.data() + (size_t) lower * (size_t) filterSize,
+                                                              ringWeight * (1.0f - fraction), filterSize);
+                juce::FloatVectorOperations::addWithMultiply (dest, measured.data() + (size_t) upper * (size_t) filterSize,
+                                                              ringWeight * fraction, filterSize);
+            };
+
+            addRing (lowerRing, 1.0f - ringFraction);
+            if (upperRing != lowerRing)
+                addRing (upperRing, ringFraction);
+        }
+    }
+}
+
+void HrirSpectrumCache::transformMeasurements (const HrirSet& set, std::vector<float>& spectra) const
+{
+    juce::dsp::FFT fft (fftOrder);
+    std::vector<float> fftBuffer (2 * fftSize);
+    spectra.assign ((size_t) set.size() * (size_t) filterSize, 0.0f);
+
+    for (int m = 0; m < set.size(); ++m)
+    {
+        for (int ear = 0; ear < 2; ++ear)
+        {
+            const auto taps = set.getResampledTaps (m, ear, sampleRate, numPartitions * partitionSize);
+
+            for (int p = 0; p < numPartitions; ++p)
+            {
+                // Each partition goes in the first half of a zero-padded FFT frame.
+                std::fill (fftBuffer.begin(), fftBuffer.end(), 0.0f);
+                const int first = p * partitionSize;
+                const int count = juce::jlimit (0, partitionSize, (int) taps.size() - first);
+                std::copy (taps.begin() + first, taps.begin() + first + count, fftBuffer.begin());
+
+                fft.performRealOnlyForwardTransform (fftBuffer.data(), true);
+
+                auto* dest = spectra.data() + (size_t) m * (size_t) filterSize + (size_t) getPartitionOffset (ear, p);
+                for (int b = 0; b < numBins; ++b)
+                {
+                    dest[b] = fftBuffer[(size_t) (2 * b)];
+                    dest[binStride + b] = fftBuffer[(size_t) (2 * b + 1)];
+                }
+            }
+        }
+    }
+}
+
+float HrirSpectrumCache::getRowElevation (int row) const noexcept
+{
+    return juce::jmin (minElevation + (float) row * elevationStep, maxElevation);
+}
+
+//==============================================================================
+HrirSpectrumCache::Cell HrirSpectrumCache::lookup (float azimuthDegrees, float elevationDegrees) const noexcept
+{
+    const float a = HrirSet::wrapDegrees (azimuthDegrees) / azimuthStep;
+    const int a0 = juce::jmin ((int) a, numAzimuths - 1);
+    const int a1 = (a0 + 1) % numAzimuths;
+    const float azimuthFraction = juce::jlimit (0.0f, 1.0f, a - (float) a0);
+
+    const float elevation = juce::jlimit (minElevation, maxElevation, elevationDegrees);
+    const int e0 = juce::jmin ((int) ((elevation - minElevation) / elevationStep), numElevations - 1);
+    const int e1 = juce::jmin (e0 + 1, numElevations - 1);
+    const float rowGap = getRowElevation (e1) - getRowElevation (e0);
+    const float elevationFraction = rowGap > 0.0f ? (elevation - getRowElevation (e0)) / rowGap : 0.0f;
+
+    Cell cell;
+    cell.index[0] = e0 * numAzimuths + a0;
+    cell.index[1] = e0 * numAzimuths + a1;
+    cell.index[2] = e1 * numAzimuths + a0;
+    cell.index[3] = e1 * numAzimuths + a1;
+    cell.weight[0] = (1.0f - elevationFraction) * (1.0f - azimuthFraction);
+    cell.weight[1] = (1.0f - elevationFraction) * azimuthFraction;
+    cell.weight[2] = elevationFraction * (1.0f - azimuthFraction);
+    cell.weight[3] = elevationFraction * azimuthFraction;
+    return cell;
+}
+
+void HrirSpectrumCache::blend (const Cell& cell, float* dest) const noexcept
+{
+    juce::FloatVectorOperations::copyWithMultiply (dest, getGridPoint (cell.index[0]), cell.weight[0], filterSize);
+
+    for (int i = 1; i < 4; ++i)
+        juce::FloatVectorOperations::addWithMultiply (dest, getGridPoint (cell.index[i]), cell.weight[i], filterSize);
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "HrirSet.h"
+#include "Spatializer.h"
+
+//==============================================================================
+// I precompute an HRIR set into frequency-domain filter partitions on a dense
+// azimuth/elevation grid, so rendering never transforms or interpolates IRs itself.
+//
+// At load time I resample every measurement to the device rate, split it into
+// partitionSize-tap partitions and FFT each one. Then I fill every grid point by
+// interpolating the measured spectra: along each measured elevation ring by azimuth,
+// then between rings by elevation. All grid points live in one contiguous, cache-line
+// aligned arena, so a lookup is index arithmetic on the angle (O(1)) and blending the
+// four surrounding grid points (bilinear in azimuth/elevation) is a handful of straight
+// multiply-adds over contiguous floats. I'm built off the audio thread and then only read.
+class HrirSpectrumCache
+{
+public:
+    // One partition per control sub-block; FFTs are twice that for overlap-save.
+    static constexpr int partitionSize = Spatializer::controlBlockSize;
+    static constexpr int fftOrder = 6;
+    static constexpr int fftSize = 1 << fftOrder;
+    static_assert (fftSize == 2 * partitionSize, "overlap-save needs a double-length FFT");
+
+    // Spectra are stored split (all real parts, then all imaginary parts), padded so every
+    // array starts 16-byte aligned.
+    static constexpr int numBins = fftSize / 2 + 1;
+    static constexpr int binStride = (numBins + 3) & ~3;
+
+    // I cut IRs to maxPartitions * partitionSize taps at the device rate.
+    static constexpr int maxPartitions = 64;
+
+    static constexpr float azimuthStep = 2.0f;
+    static constexpr float elevationStep = 10.0f;
+
+    HrirSpectrumCache (const HrirSet& set, double sampleRate);
+    ~HrirSpectrumCache() = default;
+
+    double getSampleRate() const                { return sampleRate; }
+    int getNumPartitions() const                { return numPartitions; }
+    int getNumAzimuths() const                  { return numAzimuths; }
+    int getNumElevations() const                { return numElevations; }
+
+    // Floats in one filter (both ears, all partitions), as stored per grid point.
+    int getFilterSize() const                   { return filterSize; }
+
+    // Where one ear's partition starts inside a filter: re[binStride] then im[binStride].
+    int getPartitionOffset (int ear, int partition) const noexcept
+    {
+        return (ear * numPartitions + partition) * 2 * binStride;
+    }
+
+    // The four grid points around an angle and their bilinear weights.
+    struct Cell
+    {
+        int index[4] = {};
+        float weight[4] = {};
+    };
+
+    Cell lookup (float azimuthDegrees, float elevationDegrees) const noexcept;
+    const float* getGridPoint (int index) const noexcept   { return grid + (size_t) index * (size_t) gridStride; }
+
+    // I write the blended filter for cell into dest (getFilterSize() floats).
+    void blend (const Cell& cell, float* dest) const noexcept;
+
+private:
+    void transformMeasurements (const HrirSet& set, std::vector<float>& spectra) const;
+    float getRowElevation (int row) const noexcept;
+
+    double sampleRate = 44100.0;
+    int numPartitions = 1;
+    int filterSize = 0;
+    int gridStride = 0;   // filterSize rounded up to a whole number of cache lines
+    int numAzimuths = 0, numElevations = 1;
+    float minElevation = 0.0f, maxElevation = 0.0f;
+
+    juce::HeapBlock<float> arena;
+    float* grid = nullptr;   // arena, aligned to a cache line
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (HrirSpectrumCache)
+};
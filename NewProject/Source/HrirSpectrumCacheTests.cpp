@@ -0,0 +1,88 @@
+#include <JuceHeader.h>
+#include "HrirSpectrumCache.h"
+
+//==============================================================================
+// I test the HrirSpectrumCache: grid points on measured angles must hold the measured
+// spectra, points between measurements must interpolate them, and lookups must give
+// bilinear weights that sum to one.
+class HrirSpectrumCacheTest : public juce::UnitTest
+{
+public:
+    HrirSpectrumCacheTest() : juce::UnitTest ("HrirSpectrumCache", "Audio") {}
+
+    // A single left-ear impulse of the given gain has a flat spectrum at that gain.
+    static juce::AudioBuffer<float> makeImpulse (float gain)
+    {
+        juce::AudioBuffer<float> ir (2, 40);
+        ir.clear();
+        ir.setSample (0, 0, gain);
+        return ir;
+    }
+
+    void runTest() override
+    {
+        const double sampleRate = 48000.0;
+
+        HrirSet set;
+        set.addMeasurement (0.0f, 0.0f, makeImpulse (1.0f), sampleRate);
+        set.addMeasurement (90.0f, 0.0f, makeImpulse (0.5f), sampleRate);
+        set.addMeasurement (0.0f, 20.0f, makeImpulse (0.2f), sampleRate);
+
+        const HrirSpectrumCache cache (set, sampleRate);
+
+        const auto leftBin = [&] (const float* filter, int bin) { return filter[cache.getPartitionOffset (0, 0) + bin]; };
+
+        beginTest ("grid layout follows the measured range");
+        {
+            expectEquals (cache.getNumPartitions(), 2);
+            expectEquals (cache.getNumAzimuths(), 180);
+            expectEquals (cache.getNumElevations(), 3);
+        }
+
+        beginTest ("measured angles reproduce the measured spectra");
+        {
+            const auto* front = cache.getGridPoint (0);
+            const auto* right = cache.getGridPoint (45);
+            const auto* up = cache.getGridPoint (2 * cache.getNumAzimuths());
+
+            for (int bin = 0; bin < HrirSpectrumCache::numBins; bin += 8)
+            {
+                expectWithinAbsoluteError (leftBin (front, bin), 1.0f, 1.0e-4f);
+                expectWithinAbsoluteError (leftBin (right, bin), 0.5f, 1.0e-4f);
+                expectWithinAbsoluteError (leftBin (up, bin), 0.2f, 1.0e-4f);
+            }
+
+            // The impulse sits in the first partition, so the second one is silent.
+            expectWithinAbsoluteError (front[cache.getPartitionOffset (0, 1)], 0.0f, 1.0e-6f);
+        }
+
+        beginTest ("grid points between measurements interpolate");
+        {
+            // 30 degrees at ear level: a third of the way from the 0 to the 90 degree measurement.
+            expectWithinAbsoluteError (leftBin (cache.getGridPoint (15), 0), 1.0f - 0.5f / 3.0f, 1.0e-3f);
+
+            // 10 degrees up at the front: halfway between the two rings.
+            expectWithinAbsoluteError (leftBin (cache.getGridPoint (cache.getNumAzimuths()), 0), 0.6f, 1.0e-3f);
+        }
+
+        beginTest ("lookup weights are bilinear and sum to one");
+        {
+            const auto cell = cache.lookup (3.0f, 5.0f);
+            expectEquals (cell.index[0], 1);
+            expectEquals (cell.index[1], 2);
+            expectEquals (cell.index[2], cache.getNumAzimuths() + 1);
+            expectWithinAbsoluteError (cell.weight[0], 0.25f, 1.0e-5f);
+            expectWithinAbsoluteError (cell.weight[3], 0.25f, 1.0e-5f);
+            expectWithinAbsoluteError (cell.weight[0] + cell.weight[1] + cell.weight[2] + cell.weight[3], 1.0f, 1.0e-5f);
+
+            std::vector<float> blended ((size_t) cache.getFilterSize());
+            cache.blend (cache.lookup (0.0f, 30.0f), blended.data());
+            expectWithinAbsoluteError (leftBin (blended.data(), 4), 0.2f, 1.0e-4f, "elevation clamps to the top ring");
+
+            const auto wrapped = cache.lookup (359.0f, 0.0f);
+            expectEquals (wrapped.index[1], 0, "azimuth wraps past 360");
+        }
+    }
+};
+
+static HrirSpectrumCacheTest hrirSpectrumCacheTest;
@@ -0,0 +1,298 @@
+#include "HrtfRenderer.h"
+#include "SpatialDsp.h"
+#include "OrbitTrajectory.h"
+
+//==============================================================================
+HrtfRenderer::HrtfRenderer()
+{
+    // One aligned block for everything the convolution touches per sub-block.
+    const size_t total = (size_t) maxPartitions * spectrumSize   // input spectra
+                       + 2 * (size_t) maxFilterSize               // previous/current filter
+                       + 2 * (size_t) fftSize                     // FFT buffer
+                       + (size_t) fftSize                         // input frame
+                       + (size_t) spectrumSize;                   // accumulator
+    workspace.calloc (total + 16);
+
+    auto* next = juce::snapPointerToAlignment (workspace.get(), 64);
+    const auto take = [&next] (size_t count) { auto* p = next; next += count; return p; };
+    inputSpectra = take ((size_t) maxPartitions * spectrumSize);
+    filters[0]   = take ((size_t) maxFilterSize);
+    filters[1]   = take ((size_t) maxFilterSize);
+    fftBuffer    = take (2 * (size_t) fftSize);
+    inputFrame   = take ((size_t) fftSize);
+    accumulator  = take ((size_t) spectrumSize);
+}
+
+//==============================================================================
+void HrtfRenderer::setHrirSet (std::shared_ptr<const HrirSet> newSet)
+{
+    jassert (newSet != nullptr && ! newSet->isEmpty());
+    auto cache = std::make_shared<const HrirSpectrumCache> (*newSet, preparedSampleRate.load());
+
+    std::shared_ptr<const HrirSpectrumCache> toRelease;
+    {
+        const juce::SpinLock::ScopedLockType lock (cacheLock);
+        toRelease = std::move (retiredCache);
+        pendingCache = std::move (cache);
+        hrirSet = std::move (newSet);
+    }
+    hasSet.store (true);
+}
+
+void HrtfRenderer::adoptPendingCache()
+{
+    const juce::SpinLock::ScopedTryLockType lock (cacheLock);
+
+    // A cache built for another rate waits for prepareToPlay() to rebuild it.
+    if (! lock.isLocked() || pendingCache == nullptr
+        || ! juce::approximatelyEqual (pendingCache->getSampleRate(), sampleRate))
+        return;
+
+    // setHrirSet() has already released the previous retired cache, so nothing is freed here.
+    jassert (retiredCache == nullptr);
+    retiredCache = std::move (activeCache);
+    activeCache = std::move (pendingCache);
+    filterValid = false;
+}
+
+void HrtfRenderer::setDepth (float d)
+{
+    depth = juce::jlimit (0.0f, 1.0f, d);
+}
+
+//==============================================================================
+void HrtfRenderer::prepareToPlay (int /*samplesPerBlockExpected*/, double sampleRateIn)
+{
+    sampleRate = sampleRateIn;
+    preparedSampleRate.store (sampleRate);
+    lfoPhase = 0.0;
+    OrbitPath::getBuiltIn (Spatializer::OrbitMode::Orbit);   // compiled now, not on the first callback
+    depthLPF = 0.0f;
+    depthMix = depth;
+    depthAlpha = depthMix > 0.0f
+        ? SpatialDsp::onePoleAlpha (juce::jmap (depthMix, SpatialDsp::nearDepthCutoffHz, SpatialDsp::farDepthCutoffHz), sampleRate)
+        : 0.0f;
+
+    // The audio callback isn't running here, so I can rebuild for a new rate in place.
+    std::shared_ptr<const HrirSet> set;
+    {
+        const juce::SpinLock::ScopedLockType lock (cacheLock);
+        set = hrirSet;
+        if (pendingCache != nullptr && ! juce::approximatelyEqual (pendingCache->getSampleRate(), sampleRate))
+            pendingCache = nullptr;
+    }
+
+    adoptPendingCache();
+
+    if (set != nullptr && (activeCache == nullptr || ! juce::approximatelyEqual (activeCache->getSampleRate(), sampleRate)))
+        activeCache = std::make_shared<const HrirSpectrumCache> (*set, sampleRate);
+
+    resetConvolution();
+}
+
+void HrtfRenderer::resetConvolution()
+{
+    juce::FloatVectorOperations::clear (inputSpectra, maxPartitions * spectrumSize);
+    juce::FloatVectorOperations::clear (inputFrame, fftSize);
+    newestSpectrum = 0;
+    inputPos = 0;
+    filterValid = false;
+}
+
+//==============================================================================
+void HrtfRenderer::renderEars (const float* filter, float* left, float* right, int numSamples)
+{
+    const int numPartitions = activeCache->getNumPartitions();
+    float* ears[] = { left, right };
+
+    for (int ear = 0; ear < 2; ++ear)
+    {
+        // Y = sum over partitions of X[newest - p] * H[p], in split complex form.
+        float* accRe = accumulator;
+        float* accIm = accumulator + binStride;
+        juce::FloatVectorOperations::clear (accumulator, spectrumSize);
+
+        for (int p = 0; p < numPartitions; ++p)
+        {
+            const int slot = (newestSpectrum - p + maxPartitions) % maxPartitions;
+            const float* xRe = inputSpectra + slot * spectrumSize;
+            const float* xIm = xRe + binStride;
+            const float* hRe = filter + activeCache->getPartitionOffset (ear, p);
+            const float* hIm = hRe + binStride;
+
+            for (int b = 0; b < binStride; ++b)
+            {
+                accRe[b] += xRe[b] * hRe[b] - xIm[b] * hIm[b];
+                accIm[b] += xRe[b] * hIm[b] + xIm[b] * hRe[b];
+            }
+        }
+
+        for (int b = 0; b < numBins; ++b)
+        {
+            fftBuffer[2 * b] = accRe[b];
+            fftBuffer[2 * b + 1] = accIm[b];
+        }
+
+        fft.performRealOnlyInverseTransform (fftBuffer);
+
+        // Overlap-save: the second half of the frame is the valid, alias-free output.
+        juce::FloatVectorOperations::copy (ears[ear], fftBuffer + partitionSize + inputPos, numSamples);
+    }
+}
+
+void HrtfRenderer::convolve (const float* input, float* left, float* right, int numSamples,
+                             const float* fade, bool filterChanged)
+{
+    jassert (inputPos + numSamples <= partitionSize);
+
+    // I transform the partially filled newest partition on every call, which is what
+    // keeps the convolution at zero latency for any block size.
+    juce::FloatVectorOperations::copy (inputFrame + partitionSize + inputPos, input, numSamples);
+    juce::FloatVectorOperations::copy (fftBuffer, inputFrame, fftSize);
+    fft.performRealOnlyForwardTransform (fftBuffer, true);
+
+    float* newest = inputSpectra + newestSpectrum * spectrumSize;
+    for (int b = 0; b < numBins; ++b)
+    {
+        newest[b] = fftBuffer[2 * b];
+        newest[binStride + b] = fftBuffer[2 * b + 1];
+    }
+
+    renderEars (filters[1], left, right, numSamples);
+
+    if (filterChanged)
+    {
+        alignas (16) float oldLeft[partitionSize];
+        alignas (16) float oldRight[partitionSize];
+        renderEars (filters[0], oldLeft, oldRight, numSamples);
+
+        // out = old + fade * (new - old)
+        juce::FloatVectorOperations::subtract (left, oldLeft, numSamples);
+        juce::FloatVectorOperations::multiply (left, fade, numSamples);
+        juce::FloatVectorOperations::add (left, oldLeft, numSamples);
+        juce::FloatVectorOperations::subtract (right, oldRight, numSamples);
+        juce::FloatVectorOperations::multiply (right, fade, numSamples);
+        juce::FloatVectorOperations::add (right, oldRight, numSamples);
+    }
+
+    inputPos += numSamples;
+    if (inputPos == partitionSize)
+    {
+        // The newest partition is complete: it becomes history and a new one starts.
+        juce::FloatVectorOperations::copy (inputFrame, inputFrame + partitionSize, partitionSize);
+        juce::FloatVectorOperations::clear (inputFrame + partitionSize, partitionSize);
+        newestSpectrum = (newestSpectrum + 1) % maxPartitions;
+        inputPos = 0;
+    }
+}
+
+//==============================================================================
+void HrtfRenderer::process (juce::AudioBuffer<float>& buffer,
+                            int startSample,
+                            int numSamples,
+                            const OrbitPath& path,
+                            float loopsPerSecond)
+{
+    jassert (buffer.getNumChannels() >= 2);
+    adoptPendingCache();
+
+    if (activeCache == nullptr)
+        return;
+
+    const float depthVal = depth;
+    const float depthAlphaTarget = depthVal > 0.0f
+        ? SpatialDsp::onePoleAlpha (juce::jmap (depthVal, SpatialDsp::nearDepthCutoffHz, SpatialDsp::farDepthCutoffHz), sampleRate)
+        : 0.0f;
+
+    const double phaseIncrement = juce::MathConstants<double>::twoPi * (double) loopsPerSecond / sampleRate;
+
+    alignas (16) float mono[controlBlockSize];
+    alignas (16) float ramp[controlBlockSize];
+
+    for (int offset = 0; offset < numSamples; offset += controlBlockSize)
+    {
+        const int n = juce::jmin (controlBlockSize, numSamples - offset);
+        auto* left  = buffer.getWritePointer (0, startSample + offset);
+        auto* right = buffer.getWritePointer (1, startSample + offset);
+
+        lfoPhase += phaseIncrement * n;
+        if (lfoPhase > juce::MathConstants<double>::twoPi)
+            lfoPhase -= juce::MathConstants<double>::twoPi;
+
+        // New filter for this sub-block: an O(1) cache lookup and a four-way blend, done
+        // only when the source has actually moved to a different cell or weight.
+        // The source follows the path's azimuth and elevation, as the turned head hears it.
+        const auto source = Spatializer::toHeadRelative (path.getPosition (lfoPhase),
+                                                         headMotion.at ((offset + n) / sampleRate));
+        const auto cell = activeCache->lookup (juce::radiansToDegrees (source.azimuth),
+                                               juce::radiansToDegrees (source.elevation));
+        const bool filterChanged = ! filterValid
+            || std::memcmp (&cell, &currentCell, sizeof (cell)) != 0;
+
+        if (filterChanged)
+        {
+            std::swap (filters[0], filters[1]);
+            activeCache->blend (cell, filters[1]);
+            currentCell = cell;
+
+            // Right after a reset there's no previous filter to fade from.
+            if (! filterValid)
+                juce::FloatVectorOperations::copy (filters[0], filters[1], activeCache->getFilterSize());
+            filterValid = true;
+        }
+
+        // The HRIRs carry all the spatial cues, so I feed them the mono sum.
+        juce::FloatVectorOperations::add (mono, left, right, n);
+        juce::FloatVectorOperations::multiply (mono, 0.5f, n);
+
+        if (depthMix > 0.0f || depthVal > 0.0f)
+        {
+            alignas (16) float filtered[controlBlockSize];
+            alignas (16) float mixRamp[controlBlockSize];
+            SpatialDsp::fillRamp (ramp, depthAlpha, depthAlphaTarget, n);
+            SpatialDsp::fillRamp (mixRamp, depthMix, depthVal, n);
+            juce::FloatVectorOperations::copy (filtered, mono, n);
+            SpatialDsp::onePoleInPlace (filtered, ramp, depthLPF, n);
+            juce::FloatVectorOperations::subtract (filtered, mono, n);
+            juce::FloatVectorOperations::addWithMultiply (mono, filtered, mixRamp, n);
+        }
+        else
+        {
+            depthLPF = mono[n - 1];
+        }
+
+        // The sub-block may straddle a partition boundary when buffers aren't a multiple
+        // of the partition size, so I convolve it in at most two pieces.
+        SpatialDsp::fillRamp (ramp, 0.0f, 1.0f, n);
+
+        for (int done = 0; done < n;)
+        {
+            const int piece = juce::jmin (n - done, partitionSize - inputPos);
+            convolve (mono + done, left + done, right + done, piece, ramp + done, filterChanged);
+            done += piece;
+        }
+
+        depthAlpha = depthAlphaTarget;
+        depthMix = depthVal;
+    }
+}
+
+void HrtfRenderer::process (juce::AudioBuffer<float>& buffer,
+                            int startSample,
+                            int numSamples,
+                            float manualPan,
+                            Spatializer::OrbitMode orbitMode,
+                            float panSpeedHz)
+{
+    jassert (orbitMode != Spatializer::OrbitMode::Path);
+
+    if (orbitMode == Spatializer::OrbitMode::Manual)
+    {
+        if (manualPan != manualPathPan)
+            manualPath.placeAt (Spatializer::getManualPosition (manualPathPan = manualPan));
+
+        process (buffer, startSample, numSamples, manualPath, 0.0f);
+    }
+    else
+        process (buffer, startSample, numSamples, OrbitPath::getBuiltIn (orbitMode), panSpeedHz);
+}
@@ -0,0 +1,128 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "HrirSet.h"
+#include "HrirSpectrumCache.h"
+#include "Spatializer.h"
+#include "OrbitTrajectory.h"
+
+//==============================================================================
+// I'm the measured-HRTF alternative to the Spatializer's parametric head model: I
+// convolve the (mono-summed) source with the HRIR pair for its current direction instead
+// of approximating ITD and head shadow. I follow the same orbit paths (azimuth and
+// elevation; distance cues stay with the parametric head) and depth control.
+//
+// I render with a zero-latency, uniformly partitioned overlap-save convolution whose
+// filter partitions come straight from an HrirSpectrumCache: every sub-block I look up
+// the source's grid cell, blend its four precomputed spectra, and cross-fade the output
+// from the previous filter to the new one. The only FFTs on the audio thread are one
+// forward transform of the input and the inverse transforms of the ear signals; nothing
+// on the filter side is transformed, and nothing allocates.
+//
+// Latency: partitions are one control sub-block long and the partially filled input
+// block is transformed on every call, so I add no latency at any buffer size, including
+// the 128-sample buffers the app prefers.
+class HrtfRenderer
+{
+public:
+    static constexpr int controlBlockSize = Spatializer::controlBlockSize;
+
+    HrtfRenderer();
+    ~HrtfRenderer() = default;
+
+    // I build the spectrum cache for a new HRIR set and hand it to the audio thread. Call
+    // from the message thread; the previous cache is kept alive until the next call.
+    void setHrirSet (std::shared_ptr<const HrirSet> newSet);
+    bool hasHrirSet() const { return hasSet.load(); }
+
+    // I reset the convolution and LFO state and rebuild the cache if the rate changed.
+    void prepareToPlay (int samplesPerBlockExpected, double sampleRate);
+
+    // I replace channels 0 and 1 with the binaural rendering of their mono sum. Without
+    // an HRIR set I leave the buffer untouched.
+    // The source follows path, loopsPerSecond times around it a second.
+    void process (juce::AudioBuffer<float>& buffer,
+                  int startSample,
+                  int numSamples,
+                  const OrbitPath& path,
+                  float loopsPerSecond);
+
+    // As above, on a built-in mode's path at panSpeedHz, or placed at manualPan in Manual.
+    void process (juce::AudioBuffer<float>& buffer,
+                  int startSample,
+                  int numSamples,
+                  float manualPan,
+                  Spatializer::OrbitMode orbitMode,
+                  float panSpeedHz);
+
+    // Depth 0–1: HF rolloff for distance, as in the Spatializer (and, like its setters,
+    // called from the thread that calls process()).
+    void setDepth (float depth);
+
+    // As Spatializer::setHeadMotion(): I pick each sub-block's filter for where the source
+    // is relative to the head.
+    void setHeadMotion (const HeadMotion& motion)   { headMotion = motion; }
+
+    // Where the orbit has got to (radians), as Spatializer::getOrbitPhase().
+    double getOrbitPhase() const { return lfoPhase; }
+
+    // I report the latency I add, in samples.
+    int getLatencySamples() const { return 0; }
+
+private:
+    static constexpr int partitionSize = HrirSpectrumCache::partitionSize;
+    static constexpr int fftSize = HrirSpectrumCache::fftSize;
+    static constexpr int numBins = HrirSpectrumCache::numBins;
+    static constexpr int binStride = HrirSpectrumCache::binStride;
+    static constexpr int spectrumSize = 2 * binStride;   // split re/im
+    static constexpr int maxPartitions = HrirSpectrumCache::maxPartitions;
+    static constexpr int maxFilterSize = 2 * maxPartitions * spectrumSize;
+    static_assert (controlBlockSize == partitionSize, "one filter update per partition");
+
+    void adoptPendingCache();
+    void resetConvolution();
+
+    // I convolve numSamples (within one partition) of mono input with the current filter,
+    // cross-fading from the previous one by fade when the filter just changed.
+    void convolve (const float* input, float* left, float* right, int numSamples,
+                   const float* fade, bool filterChanged);
+    void renderEars (const float* filter, float* left, float* right, int numSamples);
+
+    double sampleRate = 44100.0;
+    double lfoPhase = 0.0;
+    HeadMotion headMotion;
+
+    // Manual mode's still path, moved only when the pan does.
+    OrbitPath manualPath = OrbitPath::still (Spatializer::getManualPosition (0.0f));
+    float manualPathPan = 0.0f;
+    float depthAlpha = 0.0f, depthMix = 0.0f;
+    float depthLPF = 0.0f;
+
+    // The audio thread owns activeCache. setHrirSet() parks a new one in pendingCache and the
+    // audio thread swaps it in under a try-lock, parking the old one in retiredCache so it's
+    // released on the message thread. hrirSet is kept to rebuild at a new sample rate.
+    juce::SpinLock cacheLock;
+    std::shared_ptr<const HrirSet> hrirSet;
+    std::shared_ptr<const HrirSpectrumCache> activeCache, pendingCache, retiredCache;
+    std::atomic<double> preparedSampleRate { 44100.0 };
+    std::atomic<bool> hasSet { false };
+
+    // Overlap-save state: the last two partitions of input, and a ring of the input
+    // spectra of the most recent partitions (newestSpectrum is the one being filled).
+    juce::dsp::FFT fft { HrirSpectrumCache::fftOrder };
+    juce::HeapBlock<float> workspace;
+    float* inputSpectra = nullptr;                         // maxPartitions * spectrumSize
+    float* filters[2] = {};                                // previous, current blended filter
+    float* fftBuffer = nullptr;                            // 2 * fftSize (interleaved complex)
+    float* inputFrame = nullptr;                           // fftSize
+    float* accumulator = nullptr;                          // spectrumSize
+    int newestSpectrum = 0;
+    int inputPos = 0;
+
+    HrirSpectrumCache::Cell currentCell;
+    bool filterValid = false;
+
+    float depth = 0.0f;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (HrtfRenderer)
+};
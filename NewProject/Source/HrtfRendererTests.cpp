@@ -0,0 +1,199 @@
+#include <JuceHeader.h>
+#include "HrtfRenderer.h"
+
+//==============================================================================
+// I test HRIR loading and the HrtfRenderer: file names must parse to the right angles,
+// a folder of WAVs must load as sorted elevation rings, rendering must follow the measured
+// interaural level difference without adding latency, and the partitioned convolution
+// must match a direct one whatever the buffer size.
+class HrtfRendererTest : public juce::UnitTest
+{
+public:
+    HrtfRendererTest() : juce::UnitTest ("HrtfRenderer", "Audio") {}
+
+    // A pair of impulses with a per-ear gain: enough to tell the ears apart.
+    static juce::AudioBuffer<float> makeImpulsePair (float leftGain, float rightGain)
+    {
+        juce::AudioBuffer<float> ir (2, 64);
+        ir.clear();
+        ir.setSample (0, 0, leftGain);
+        ir.setSample (1, 0, rightGain);
+        return ir;
+    }
+
+    // Right-side measurement is louder in the right ear; left side mirrors it.
+    static std::shared_ptr<HrirSet> makeTwoPointSet (double sampleRate)
+    {
+        auto set = std::make_shared<HrirSet>();
+        set->addMeasurement (90.0f, 0.0f, makeImpulsePair (0.25f, 1.0f), sampleRate);
+        set->addMeasurement (270.0f, 0.0f, makeImpulsePair (1.0f, 0.25f), sampleRate);
+        return set;
+    }
+
+    void runTest() override
+    {
+        const double sampleRate = 48000.0;
+        const int blockSize = 128;
+
+        beginTest ("file names parse to azimuth/elevation");
+        {
+            float az = 0.0f, el = 0.0f;
+            expect (HrirSet::parseAngles ("azi030_ele000", az, el));
+            expectWithinAbsoluteError (az, 30.0f, 1.0e-4f);
+            expectWithinAbsoluteError (el, 0.0f, 1.0e-4f);
+
+            expect (HrirSet::parseAngles ("az_-30_el_10", az, el));
+            expectWithinAbsoluteError (az, 330.0f, 1.0e-4f);
+            expectWithinAbsoluteError (el, 10.0f, 1.0e-4f);
+
+            expect (HrirSet::parseAngles ("H-10e045a", az, el));
+            expectWithinAbsoluteError (az, 45.0f, 1.0e-4f);
+            expectWithinAbsoluteError (el, -10.0f, 1.0e-4f);
+
+            expect (! HrirSet::parseAngles ("readme", az, el));
+        }
+
+        beginTest ("folder of WAVs loads as sorted elevation rings");
+        {
+            juce::TemporaryFile tempDir;
+            const auto folder = tempDir.getFile();
+            folder.createDirectory();
+
+            const auto writeIr = [&] (const juce::String& fileName, float leftGain)
+            {
+                juce::WavAudioFormat wav;
+                std::unique_ptr<juce::OutputStream> stream = folder.getChildFile (fileName).createOutputStream();
+                if (auto writer = wav.createWriterFor (stream, juce::AudioFormatWriterOptions{}.withSampleRate (sampleRate)
+                                                                                              .withNumChannels (2)
+                                                                                              .withBitsPerSample (24)))
+                {
+                    const auto ir = makeImpulsePair (leftGain, 0.5f);
+                    writer->writeFromAudioSampleBuffer (ir, 0, ir.getNumSamples());
+                }
+            };
+
+            writeIr ("azi180_ele000.wav", 0.1f);
+            writeIr ("azi000_ele000.wav", 0.2f);
+            writeIr ("azi090_ele000.wav", 0.3f);
+            writeIr ("azi090_ele040.wav", 0.4f);
+
+            HrirSet set;
+            expect (set.loadFromFolder (folder).wasOk());
+            expectEquals (set.size(), 4);
+            expectEquals (set.getNumRings(), 2);
+            expectWithinAbsoluteError (set.getRingElevation (1), 40.0f, 1.0e-4f);
+            expectWithinAbsoluteError (set.getAzimuth (0), 0.0f, 1.0e-4f);
+            expectWithinAbsoluteError (set.getAzimuth (2), 180.0f, 1.0e-4f);
+            expectWithinAbsoluteError (set.getElevation (3), 40.0f, 1.0e-4f);
+            expectWithinAbsoluteError (set.getImpulseResponse (1).getSample (0, 0), 0.3f, 1.0e-4f);
+
+            int lower = 0, upper = 0;
+            float fraction = 0.0f;
+            set.findNeighbours (0, 270.0f, lower, upper, fraction);
+            expectEquals (lower, 2);
+            expectEquals (upper, 0);
+            expectWithinAbsoluteError (fraction, 0.5f, 1.0e-4f);
+
+            set.findNeighbours (1, 270.0f, lower, upper, fraction);
+            expectEquals (lower, 3);
+            expectEquals (upper, 3);
+
+            set.findRings (20.0f, lower, upper, fraction);
+            expectEquals (lower, 0);
+            expectEquals (upper, 1);
+            expectWithinAbsoluteError (fraction, 0.5f, 1.0e-4f);
+
+            folder.deleteRecursively();
+        }
+
+        beginTest ("manual pan: measured ILD, no added latency");
+        {
+            HrtfRenderer renderer;
+            renderer.setHrirSet (makeTwoPointSet (sampleRate));
+            renderer.prepareToPlay (blockSize, sampleRate);
+            expectEquals (renderer.getLatencySamples(), 0);
+
+            // The renderer starts facing front (both measurements at half weight), so I give
+            // it one block at pan +1 to ramp onto the 90-degree measurement first.
+            juce::AudioBuffer<float> buffer (2, blockSize);
+            buffer.clear();
+            renderer.process (buffer, 0, blockSize, 1.0f, Spatializer::OrbitMode::Manual, 0.05f);
+
+            buffer.clear();
+            buffer.setSample (0, 0, 1.0f);
+            buffer.setSample (1, 0, 1.0f);
+            renderer.process (buffer, 0, blockSize, 1.0f, Spatializer::OrbitMode::Manual, 0.05f);
+
+            expectWithinAbsoluteError (buffer.getSample (1, 0), 1.0f, 1.0e-3f, "impulse should come out undelayed");
+            expectWithinAbsoluteError (buffer.getSample (0, 0), 0.25f, 1.0e-3f, "far ear should carry the measured level");
+        }
+
+        beginTest ("pan 0 blends both neighbours equally");
+        {
+            HrtfRenderer renderer;
+            renderer.setHrirSet (makeTwoPointSet (sampleRate));
+            renderer.prepareToPlay (blockSize, sampleRate);
+
+            juce::AudioBuffer<float> buffer (2, blockSize);
+            buffer.clear();
+            buffer.setSample (0, 0, 1.0f);
+            buffer.setSample (1, 0, 1.0f);
+            renderer.process (buffer, 0, blockSize, 0.0f, Spatializer::OrbitMode::Manual, 0.05f);
+
+            expectWithinAbsoluteError (buffer.getSample (0, 0), 0.625f, 1.0e-3f);
+            expectWithinAbsoluteError (buffer.getSample (1, 0), 0.625f, 1.0e-3f);
+        }
+
+        beginTest ("partitioned convolution matches direct convolution at any buffer size");
+        {
+            // A long random IR spans several partitions; with a single measurement every
+            // direction uses it, so the output must be the plain convolution of the input.
+            juce::Random random (42);
+            juce::AudioBuffer<float> ir (2, 300);
+            for (int ch = 0; ch < 2; ++ch)
+                for (int i = 0; i < ir.getNumSamples(); ++i)
+                    ir.setSample (ch, i, (random.nextFloat() * 2.0f - 1.0f) * std::exp (-0.01f * (float) i));
+
+            auto set = std::make_shared<HrirSet>();
+            set->addMeasurement (0.0f, 0.0f, ir, sampleRate);
+
+            HrtfRenderer renderer;
+            renderer.setHrirSet (set);
+            renderer.prepareToPlay (blockSize, sampleRate);
+
+            const int totalLength = 1000;
+            std::vector<float> input ((size_t) totalLength);
+            for (auto& x : input)
+                x = random.nextFloat() * 2.0f - 1.0f;
+
+            juce::AudioBuffer<float> output (2, totalLength);
+            for (int ch = 0; ch < 2; ++ch)
+                output.copyFrom (ch, 0, input.data(), totalLength);
+
+            const int blockSizes[] = { 1, 7, 32, 45, 100, 13, 64, 128 };
+            for (int start = 0, b = 0; start < totalLength; ++b)
+            {
+                const int n = juce::jmin (blockSizes[b % juce::numElementsInArray (blockSizes)], totalLength - start);
+                renderer.process (output, start, n, 0.0f, Spatializer::OrbitMode::Orbit, 0.3f);
+                start += n;
+            }
+
+            float maxError = 0.0f;
+            for (int ch = 0; ch < 2; ++ch)
+            {
+                const auto* h = ir.getReadPointer (ch);
+                for (int i = 0; i < totalLength; ++i)
+                {
+                    float expected = 0.0f;
+                    for (int k = 0; k <= juce::jmin (i, ir.getNumSamples() - 1); ++k)
+                        expected += h[k] * input[(size_t) (i - k)];
+                    maxError = juce::jmax (maxError, std::abs (output.getSample (ch, i) - expected));
+                }
+            }
+
+            expectLessThan (maxError, 1.0e-3f);
+        }
+    }
+};
+
+static HrtfRendererTest hrtfRendererTest;
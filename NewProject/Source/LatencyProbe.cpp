@@ -0,0 +1,223 @@
+#include "LatencyProbe.h"
+
+//==============================================================================
+bool LatencyProbe::Measurement::matches (const juce::String& device, double rate, int blockSize) const
+{
+    return isValid() && deviceName == device && sampleRate == rate && bufferSize == blockSize;
+}
+
+juce::String LatencyProbe::Measurement::toString() const
+{
+    if (! isValid())
+        return "no measurement";
+
+    const auto ms = [this] (int samples) { return juce::String (toMs (samples), 2) + " ms"; };
+
+    juce::String s;
+    s << "round trip " << ms (roundTripSamples) << " (" << roundTripSamples << " samples)"
+      << ": device in " << ms (inputSamples) << ", out " << ms (outputSamples)
+      << ", unreported " << ms (getUnreportedSamples())
+      << "; DSP lookahead " << ms (dspSamples)
+      << "; input to output " << ms (getThroughSamples());
+    return s;
+}
+
+std::unique_ptr<juce::XmlElement> LatencyProbe::Measurement::toXml() const
+{
+    auto xml = std::make_unique<juce::XmlElement> (xmlTag);
+    xml->setAttribute ("deviceName", deviceName);
+    xml->setAttribute ("sampleRate", sampleRate);
+    xml->setAttribute ("bufferSize", bufferSize);
+    xml->setAttribute ("roundTripSamples", roundTripSamples);
+    xml->setAttribute ("inputSamples", inputSamples);
+    xml->setAttribute ("outputSamples", outputSamples);
+    xml->setAttribute ("unreportedSamples", getUnreportedSamples());
+    xml->setAttribute ("dspSamples", dspSamples);
+    xml->setAttribute ("throughSamples", getThroughSamples());
+    xml->setAttribute ("throughMs", toMs (getThroughSamples()));
+    xml->setAttribute ("confidence", (double) confidence);
+    xml->setAttribute ("time", time.toISO8601 (true));
+    return xml;
+}
+
+LatencyProbe::Measurement LatencyProbe::Measurement::fromXml (const juce::XmlElement* xml)
+{
+    Measurement m;
+    if (xml == nullptr || ! xml->hasTagName (xmlTag))
+        return m;
+
+    m.deviceName = xml->getStringAttribute ("deviceName");
+    m.sampleRate = xml->getDoubleAttribute ("sampleRate");
+    m.bufferSize = xml->getIntAttribute ("bufferSize");
+    m.roundTripSamples = xml->getIntAttribute ("roundTripSamples", -1);
+    m.inputSamples = xml->getIntAttribute ("inputSamples");
+    m.outputSamples = xml->getIntAttribute ("outputSamples");
+    m.dspSamples = xml->getIntAttribute ("dspSamples");
+    m.confidence = (float) xml->getDoubleAttribute ("confidence");
+    m.time = juce::Time::fromISO8601 (xml->getStringAttribute ("time"));
+    return m;
+}
+
+//==============================================================================
+void LatencyProbe::prepare (double newSampleRate)
+{
+    sampleRate.store (newSampleRate);
+
+    auto expected = State::running;
+    state.compare_exchange_strong (expected, State::interrupted);
+}
+
+bool LatencyProbe::begin()
+{
+    if (state.load() == State::running)
+        return false;
+
+    // The same burst every time: seeded noise, with 2 ms fades so it doesn't click.
+    const auto rate = sampleRate.load();
+    const int burstLength = juce::roundToInt (burstSeconds * rate);
+    const int fadeLength = juce::roundToInt (0.002 * rate);
+    juce::Random random (0x0b17);
+
+    burst.resize ((size_t) burstLength);
+    for (int i = 0; i < burstLength; ++i)
+    {
+        const float fade = (float) juce::jmin (1.0, juce::jmin (i, burstLength - 1 - i) / (double) fadeLength);
+        burst[(size_t) i] = fade * burstLevel * (random.nextFloat() * 2.0f - 1.0f);
+    }
+
+    recording.assign ((size_t) (burstLength + juce::roundToInt (maxRoundTripSeconds * rate)), 0.0f);
+    playPosition = 0;
+    recordPosition = 0;
+
+    state.store (State::running);
+    return true;
+}
+
+//==============================================================================
+void LatencyProbe::captureInput (const juce::AudioBuffer<float>& buffer, int startSample, int numSamples) noexcept
+{
+    if (state.load() != State::running)
+        return;
+
+    const int n = juce::jmin (numSamples, (int) recording.size() - recordPosition);
+    if (n <= 0 || buffer.getNumChannels() == 0)
+        return;
+
+    float* dest = recording.data() + recordPosition;
+    juce::FloatVectorOperations::copy (dest, buffer.getReadPointer (0, startSample), n);
+    for (int ch = 1; ch < buffer.getNumChannels(); ++ch)
+        juce::FloatVectorOperations::add (dest, buffer.getReadPointer (ch, startSample), n);
+
+    recordPosition += n;
+}
+
+void LatencyProbe::replaceOutput (juce::AudioBuffer<float>& buffer, int startSample, int numSamples) noexcept
+{
+    if (state.load() != State::running)
+        return;
+
+    // Silence around the burst, so nothing else is in the recording to correlate with.
+    buffer.clear (startSample, numSamples);
+
+    const int n = juce::jmin (numSamples, (int) burst.size() - playPosition);
+    if (n > 0)
+    {
+        for (int ch = 0; ch < buffer.getNumChannels(); ++ch)
+            buffer.copyFrom (ch, startSample, burst.data() + playPosition, n);
+
+        playPosition += n;
+    }
+
+    if (recordPosition == (int) recording.size())
+        state.store (State::finished);
+}
+
+std::optional<LatencyProbe::Result> LatencyProbe::takeResult()
+{
+    const auto current = state.load();
+
+    if (current == State::interrupted)
+    {
+        state.store (State::idle);
+        return Result();
+    }
+
+    if (current != State::finished)
+        return std::nullopt;
+
+    const auto result = findDelay (burst.data(), (int) burst.size(), recording.data(), (int) recording.size());
+    state.store (State::idle);
+    return result;
+}
+
+//==============================================================================
+LatencyProbe::Result LatencyProbe::findDelay (const float* reference, int referenceLength,
+                                              const float* recorded, int recordedLength)
+{
+    Result result;
+    const int numLags = recordedLength - referenceLength + 1;
+    if (referenceLength <= 0 || numLags <= 0)
+        return result;
+
+    // Zero-padded past both lengths, so the circular correlation doesn't wrap.
+    int order = 1;
+    while ((1 << order) < recordedLength + referenceLength)
+        ++order;
+
+    const int size = 1 << order;
+    const juce::dsp::FFT fft (order);
+
+    std::vector<float> x ((size_t) (2 * size), 0.0f), y ((size_t) (2 * size), 0.0f);
+    std::copy (reference, reference + referenceLength, x.begin());
+    std::copy (recorded, recorded + recordedLength, y.begin());
+    fft.performRealOnlyForwardTransform (x.data(), true);
+    fft.performRealOnlyForwardTransform (y.data(), true);
+
+    // conj(X) * Y comes back as the sum of reference[i] * recorded[i + lag] for every lag.
+    for (int b = 0; b <= size / 2; ++b)
+    {
+        const float xr = x[(size_t) (2 * b)], xi = x[(size_t) (2 * b + 1)];
+        const float yr = y[(size_t) (2 * b)], yi = y[(size_t) (2 * b + 1)];
+        y[(size_t) (2 * b)] = xr * yr + xi * yi;
+        y[(size_t) (2 * b + 1)] = xr * yi - xi * yr;
+    }
+
+    fft.performRealOnlyInverseTransform (y.data());
+
+    // I weigh each lag by the energy of the recording it covers, so a loud stretch of
+    // something else can't outscore the burst, and either polarity counts.
+    std::vector<double> energy ((size_t) recordedLength + 1, 0.0);
+    for (int i = 0; i < recordedLength; ++i)
+        energy[(size_t) i + 1] = energy[(size_t) i] + (double) recorded[i] * recorded[i];
+
+    const auto windowEnergy = [&] (int lag) { return energy[(size_t) (lag + referenceLength)] - energy[(size_t) lag]; };
+    const double floorEnergy = 1.0e-10 * referenceLength;
+
+    int bestLag = -1;
+    double bestScore = 0.0;
+    for (int lag = 0; lag < numLags; ++lag)
+    {
+        const double score = std::abs ((double) y[(size_t) lag]) / std::sqrt (windowEnergy (lag) + floorEnergy);
+        if (score > bestScore)
+        {
+            bestScore = score;
+            bestLag = lag;
+        }
+    }
+
+    if (bestLag < 0)
+        return result;
+
+    // The confidence is the plain normalized correlation at that lag, worked out directly.
+    double dot = 0.0, referenceEnergy = 0.0;
+    for (int i = 0; i < referenceLength; ++i)
+    {
+        dot += (double) reference[i] * recorded[bestLag + i];
+        referenceEnergy += (double) reference[i] * reference[i];
+    }
+
+    const double norm = std::sqrt (referenceEnergy * windowEnergy (bestLag));
+    result.confidence = norm > 0.0 ? (float) (std::abs (dot) / norm) : 0.0f;
+    result.roundTripSamples = result.confidence >= minConfidence ? bestLag : -1;
+    return result;
+}
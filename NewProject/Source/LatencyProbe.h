@@ -0,0 +1,103 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+// I measure how long the output takes to come back in at the input, like JUCE's
+// AudioLatencyDemo, for a loopback cable or a routed chain (BlackHole back into us).
+//
+// While a measurement runs, the audio thread records the input and replaces the output
+// with a 250 ms burst of seeded noise. Both buffers are allocated by begin() before the
+// run starts, and the state moves between the threads through one atomic, so the audio
+// side never locks or allocates. Once the recording is full, the message thread finds
+// the burst in it by cross-correlating with the reference (an FFT, both ways), which
+// is far steadier than spotting onsets when the path adds noise or filtering.
+//
+// The round trip covers the device's output and input stages and whatever routing sits
+// between them; the Measurement splits it into what the device reports and the rest,
+// and adds the DSP lookahead to give the latency from our input to our output.
+class LatencyProbe
+{
+public:
+    static constexpr double burstSeconds = 0.25;
+    static constexpr double maxRoundTripSeconds = 1.0;
+    static constexpr float burstLevel = 0.125f;     // -18 dBFS
+    static constexpr float minConfidence = 0.3f;    // normalized correlation at the peak
+
+    // What the correlation found. roundTripSamples is -1 if the burst didn't come back.
+    struct Result
+    {
+        int roundTripSamples = -1;
+        float confidence = 0.0f;
+    };
+
+    // One measurement in context, as it's saved with the device state.
+    struct Measurement
+    {
+        juce::String deviceName;
+        double sampleRate = 0.0;
+        int bufferSize = 0;
+        int roundTripSamples = -1;          // output back to input, measured
+        int inputSamples = 0;               // as the device reports its input stage
+        int outputSamples = 0;              // ...and its output stage
+        int dspSamples = 0;                 // the engine's lookahead
+        float confidence = 0.0f;
+        juce::Time time;
+
+        bool isValid() const noexcept               { return roundTripSamples >= 0 && sampleRate > 0.0; }
+
+        // Measured, but not reported by the device: converters, routing, safety buffers.
+        int getUnreportedSamples() const noexcept   { return roundTripSamples - inputSamples - outputSamples; }
+
+        // Our input to our output: both device stages, plus the DSP in between.
+        int getThroughSamples() const noexcept      { return roundTripSamples + dspSamples; }
+
+        double toMs (int samples) const noexcept    { return sampleRate > 0.0 ? 1000.0 * samples / sampleRate : 0.0; }
+
+        bool matches (const juce::String& device, double rate, int blockSize) const;
+
+        juce::String toString() const;
+        std::unique_ptr<juce::XmlElement> toXml() const;
+        static Measurement fromXml (const juce::XmlElement* xml);
+
+        static constexpr const char* xmlTag = "LATENCYMEASUREMENT";
+    };
+
+    LatencyProbe() = default;
+
+    // Call me from prepareToPlay. A measurement that was running is abandoned.
+    void prepare (double newSampleRate);
+
+    // Message thread: I build the burst and the recording and start a measurement on the
+    // next callback. False if one is already running.
+    bool begin();
+
+    bool isRunning() const noexcept     { return state.load() == State::running; }
+
+    // Audio thread, while running: I record the input (summed), before any processing...
+    void captureInput (const juce::AudioBuffer<float>& buffer, int startSample, int numSamples) noexcept;
+
+    // ...and replace the output with the burst, after it.
+    void replaceOutput (juce::AudioBuffer<float>& buffer, int startSample, int numSamples) noexcept;
+
+    // Message thread: once the recording is full, the result, and I go back to idle. If a
+    // restart cut the measurement short, a result that found nothing.
+    std::optional<Result> takeResult();
+
+    // Where reference turns up in recorded, by cross-correlation. Public for the tests.
+    static Result findDelay (const float* reference, int referenceLength,
+                             const float* recorded, int recordedLength);
+
+private:
+    enum class State { idle, running, finished, interrupted };
+
+    std::atomic<State> state { State::idle };
+    std::atomic<double> sampleRate { 48000.0 };
+
+    // Owned by the audio thread while running, by the message thread otherwise.
+    std::vector<float> burst, recording;
+    int playPosition = 0;
+    int recordPosition = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (LatencyProbe)
+};
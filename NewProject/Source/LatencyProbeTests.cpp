@@ -0,0 +1,138 @@
+#include <JuceHeader.h>
+#include "LatencyProbe.h"
+
+//==============================================================================
+// I test LatencyProbe: the correlation finds a delayed burst in noise, filtered and
+// with either polarity, and reports nothing when it isn't there; run through simulated
+// callbacks with a loopback, the probe measures the loop's exact delay; and a
+// measurement survives the trip through audioDeviceState.xml.
+class LatencyProbeTest : public juce::UnitTest
+{
+public:
+    LatencyProbeTest() : juce::UnitTest ("LatencyProbe", "Audio") {}
+
+    static std::vector<float> makeNoise (int numSamples, int seed, float level)
+    {
+        juce::Random random (seed);
+        std::vector<float> noise ((size_t) numSamples);
+        for (auto& s : noise)
+            s = level * (random.nextFloat() * 2.0f - 1.0f);
+        return noise;
+    }
+
+    void runTest() override
+    {
+        beginTest ("correlation finds the burst, filtered, inverted or buried in noise");
+        {
+            const auto reference = makeNoise (12000, 1, 0.125f);
+
+            for (int delay : { 0, 1, 480, 12345, 36000 })
+            {
+                for (float polarity : { 1.0f, -1.0f })
+                {
+                    auto recorded = makeNoise (60000, 2, 0.02f);
+
+                    // A one-pole low-pass on the way back, as a cheap converter would.
+                    float state = 0.0f;
+                    for (int i = 0; i < (int) reference.size(); ++i)
+                    {
+                        state += 0.6f * (reference[(size_t) i] - state);
+                        recorded[(size_t) (delay + i)] += polarity * state;
+                    }
+
+                    const auto result = LatencyProbe::findDelay (reference.data(), (int) reference.size(),
+                                                                 recorded.data(), (int) recorded.size());
+                    expectEquals (result.roundTripSamples, delay, "polarity " + juce::String (polarity));
+                    expectGreaterThan (result.confidence, LatencyProbe::minConfidence);
+                }
+            }
+
+            // Noise alone, or silence, finds nothing.
+            const auto noise = makeNoise (60000, 3, 0.1f);
+            expectEquals (LatencyProbe::findDelay (reference.data(), (int) reference.size(),
+                                                   noise.data(), (int) noise.size()).roundTripSamples, -1);
+
+            const std::vector<float> silence (60000, 0.0f);
+            expectEquals (LatencyProbe::findDelay (reference.data(), (int) reference.size(),
+                                                  silence.data(), (int) silence.size()).roundTripSamples, -1);
+        }
+
+        beginTest ("through a loopback the probe measures the loop's delay");
+        {
+            const double sampleRate = 48000.0;
+            const int blockSize = 128, loopDelay = 3 * blockSize + 17;
+
+            LatencyProbe probe;
+            probe.prepare (sampleRate);
+            expect (! probe.takeResult().has_value());
+            expect (probe.begin());
+            expect (! probe.begin(), "one measurement at a time");
+
+            // Everything played, so the input can hear it loopDelay samples later.
+            std::vector<float> played;
+            juce::AudioBuffer<float> buffer (2, blockSize);
+
+            for (int block = 0; probe.isRunning() && block < 1000; ++block)
+            {
+                for (int i = 0; i < blockSize; ++i)
+                {
+                    const int t = block * blockSize + i - loopDelay;
+                    const float in = t >= 0 ? played[(size_t) t] : 0.0f;
+                    buffer.setSample (0, i, in);
+                    buffer.setSample (1, i, 0.0f);
+                }
+
+                probe.captureInput (buffer, 0, blockSize);
+                buffer.applyGain (0.5f);   // whatever the DSP did, the probe overwrites it
+                probe.replaceOutput (buffer, 0, blockSize);
+
+                for (int i = 0; i < blockSize; ++i)
+                    played.push_back (buffer.getSample (0, i));
+            }
+
+            expect (! probe.isRunning());
+            const auto result = probe.takeResult();
+            expect (result.has_value());
+            expectEquals (result->roundTripSamples, loopDelay);
+            expect (! probe.takeResult().has_value(), "the result is taken once");
+
+            // A device restart in the middle abandons the run.
+            expect (probe.begin());
+            probe.captureInput (buffer, 0, blockSize);
+            probe.prepare (sampleRate);
+            expect (! probe.isRunning());
+            expectEquals (probe.takeResult()->roundTripSamples, -1);
+        }
+
+        beginTest ("a measurement goes through the device state XML and adds up");
+        {
+            LatencyProbe::Measurement m;
+            m.deviceName = "CoreAudio/BlackHole 2ch";
+            m.sampleRate = 48000.0;
+            m.bufferSize = 128;
+            m.roundTripSamples = 700;
+            m.inputSamples = 150;
+            m.outputSamples = 170;
+            m.dspSamples = 198;
+            m.confidence = 0.9f;
+            m.time = juce::Time (2026, 9, 17, 12, 0);
+
+            expectEquals (m.getUnreportedSamples(), 380);
+            expectEquals (m.getThroughSamples(), 898);
+
+            juce::XmlElement deviceState ("DEVICESETUP");
+            deviceState.addChildElement (m.toXml().release());
+            const auto parsed = juce::parseXML (deviceState.toString());
+            const auto back = LatencyProbe::Measurement::fromXml (parsed->getChildByName (LatencyProbe::Measurement::xmlTag));
+
+            expect (back.matches ("CoreAudio/BlackHole 2ch", 48000.0, 128));
+            expect (! back.matches ("CoreAudio/BlackHole 2ch", 44100.0, 128), "another rate is another measurement");
+            expectEquals (back.getThroughSamples(), 898);
+            expectEquals (parsed->getChildByName (LatencyProbe::Measurement::xmlTag)->getIntAttribute ("throughSamples"), 898);
+            expect (back.time == m.time);
+            expect (! LatencyProbe::Measurement::fromXml (nullptr).isValid());
+        }
+    }
+};
+
+static LatencyProbeTest latencyProbeTest;
@@ -0,0 +1,319 @@
+#include "LoudnessMeter.h"
+
+//==============================================================================
+namespace
+{
+    // I sum a[i] * b[i] in eight running sums side by side, so the loop vectorizes
+    // without the compiler having to reorder one long sum.
+    float sumOfProducts (const float* a, const float* b, int numSamples) noexcept
+    {
+        constexpr int lanes = 8;
+        float sums[lanes] = {};
+        int i = 0;
+
+        for (; i + lanes <= numSamples; i += lanes)
+            for (int j = 0; j < lanes; ++j)
+                sums[j] += a[i + j] * b[i + j];
+
+        float total = 0.0f;
+        for (int j = 0; j < lanes; ++j)
+            total += sums[j];
+
+        for (; i < numSamples; ++i)
+            total += a[i] * b[i];
+
+        return total;
+    }
+
+    // BS.1770's loudness of a mean square (summed over the channels).
+    float toLufs (double meanSquare) noexcept
+    {
+        if (meanSquare <= 0.0)
+            return LoudnessMeter::silenceDb;
+
+        return juce::jmax (LoudnessMeter::silenceDb, (float) (-0.691 + 10.0 * std::log10 (meanSquare)));
+    }
+
+    float toDecibels (double gain) noexcept
+    {
+        return juce::Decibels::gainToDecibels ((float) gain, LoudnessMeter::silenceDb);
+    }
+}
+
+//==============================================================================
+LoudnessMeter::LoudnessMeter()
+    : juce::Thread ("LoudnessMeter"),
+      summaries ((size_t) ringSize),
+      history ((size_t) shortTermSummaries)
+{
+    prepare (48000.0);
+}
+
+LoudnessMeter::~LoudnessMeter()
+{
+    stopAnalysis();
+}
+
+void LoudnessMeter::prepare (double sampleRate)
+{
+    intervalSamples = juce::jmax (1, juce::roundToInt (sampleRate / summariesPerSecond));
+
+    // The K-weighting filters, designed for this rate as in BS.1770 (the constants are the
+    // standard's 48 kHz filters, taken back to analogue).
+    {
+        const double k = std::tan (juce::MathConstants<double>::pi * 1681.974450955533 / sampleRate);
+        const double q = 0.7071752369554196;
+        const double vh = std::pow (10.0, 3.999843853973347 / 20.0);
+        const double vb = std::pow (vh, 0.4996667741545416);
+        const double a0 = 1.0 + k / q + k * k;
+
+        shelf.b0 = (vh + vb * k / q + k * k) / a0;
+        shelf.b1 = 2.0 * (k * k - vh) / a0;
+        shelf.b2 = (vh - vb * k / q + k * k) / a0;
+        shelf.a1 = 2.0 * (k * k - 1.0) / a0;
+        shelf.a2 = (1.0 - k / q + k * k) / a0;
+    }
+    {
+        const double k = std::tan (juce::MathConstants<double>::pi * 38.13547087602444 / sampleRate);
+        const double q = 0.5003270373238773;
+        const double a0 = 1.0 + k / q + k * k;
+
+        highPass.b0 = 1.0;
+        highPass.b1 = -2.0;
+        highPass.b2 = 1.0;
+        highPass.a1 = 2.0 * (k * k - 1.0) / a0;
+        highPass.a2 = (1.0 - k / q + k * k) / a0;
+    }
+
+    for (auto& state : filterState)
+        std::fill (std::begin (state), std::end (state), 0.0);
+
+    pending = {};
+    droppedSummaries.store (0);
+
+    // The analysis side notices the new generation and starts its measurements over.
+    generation.fetch_add (1);
+}
+
+//==============================================================================
+void LoudnessMeter::kWeight (int channel, const float* input, float* output, int numSamples) noexcept
+{
+    auto* s = filterState[channel];
+    double s0 = s[0], s1 = s[1], s2 = s[2], s3 = s[3];
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        const double x = input[i];
+        const double y = shelf.b0 * x + s0;
+        s0 = shelf.b1 * x - shelf.a1 * y + s1;
+        s1 = shelf.b2 * x - shelf.a2 * y;
+
+        const double z = highPass.b0 * y + s2;
+        s2 = highPass.b1 * y - highPass.a1 * z + s3;
+        s3 = highPass.b2 * y - highPass.a2 * z;
+
+        output[i] = (float) z;
+    }
+
+    s[0] = s0; s[1] = s1; s[2] = s2; s[3] = s3;
+}
+
+void LoudnessMeter::push (const float* left, const float* right, int numSamples) noexcept
+{
+    while (numSamples > 0)
+    {
+        // Chunks never cross from one summary into the next.
+        const int n = juce::jmin (numSamples, maxChunk, intervalSamples - pending.numSamples);
+        const float* channels[] = { left, right };
+
+        for (int ch = 0; ch < 2; ++ch)
+        {
+            const auto range = juce::FloatVectorOperations::findMinAndMax (channels[ch], n);
+            pending.peak[ch] = juce::jmax (pending.peak[ch], -range.getStart(), range.getEnd());
+            pending.sumSquares[ch] += sumOfProducts (channels[ch], channels[ch], n);
+
+            kWeight (ch, channels[ch], weighted, n);
+            pending.weightedSquares[ch] += sumOfProducts (weighted, weighted, n);
+        }
+
+        pending.crossProduct += sumOfProducts (left, right, n);
+        pending.numSamples += n;
+
+        if (pending.numSamples == intervalSamples)
+            publishSummary();
+
+        left += n;
+        right += n;
+        numSamples -= n;
+    }
+}
+
+void LoudnessMeter::publishSummary() noexcept
+{
+    pending.generation = generation.load (std::memory_order_relaxed);
+
+    const auto scope = fifo.write (1);
+    if (scope.blockSize1 > 0)
+        summaries[(size_t) scope.startIndex1] = pending;
+    else
+        droppedSummaries.fetch_add (1, std::memory_order_relaxed);
+
+    pending = {};
+}
+
+//==============================================================================
+void LoudnessMeter::startAnalysis()
+{
+    startThread (juce::Thread::Priority::low);
+}
+
+void LoudnessMeter::stopAnalysis()
+{
+    stopThread (1000);
+}
+
+void LoudnessMeter::run()
+{
+    while (! threadShouldExit())
+    {
+        collect();
+        wait (1000 / summariesPerSecond);
+    }
+}
+
+int LoudnessMeter::collect()
+{
+    const auto currentGeneration = generation.load();
+    if (currentGeneration != seenGeneration || integratedResetPending.exchange (false))
+    {
+        gateCounts.fill (0);
+        gateEnergies.fill (0.0);
+    }
+
+    if (currentGeneration != seenGeneration)
+    {
+        seenGeneration = currentGeneration;
+        std::fill (history.begin(), history.end(), Summary());
+        historyIndex = 0;
+        numSummaries = 0;
+        peakHold[0] = peakHold[1] = 0.0f;
+    }
+
+    int numRead = 0;
+    const auto scope = fifo.read (fifo.getNumReady());
+    scope.forEach ([&] (int index)
+    {
+        ++numRead;
+        const auto& summary = summaries[(size_t) index];
+
+        if (summary.generation == seenGeneration)
+            addSummary (summary);
+    });
+
+    publishReadings();
+    return numRead;
+}
+
+void LoudnessMeter::addSummary (const Summary& summary)
+{
+    historyIndex = (historyIndex + 1) % shortTermSummaries;
+    history[(size_t) historyIndex] = summary;
+    ++numSummaries;
+
+    // Peaks hold and fall at 20 dB a second.
+    const float fall = juce::Decibels::decibelsToGain (-20.0f / summariesPerSecond);
+    for (int ch = 0; ch < 2; ++ch)
+        peakHold[ch] = juce::jmax (summary.peak[ch], peakHold[ch] * fall);
+
+    // Every 100 ms, the last 400 ms is one gating block for the integrated loudness. Blocks
+    // under the absolute gate never count; I keep the rest in 0.1 LU bins, with their
+    // energy, so the relative gate can be applied later without keeping every block.
+    if (numSummaries >= momentarySummaries && numSummaries % gateHopSummaries == 0)
+    {
+        const auto energy = getWindowEnergy (momentarySummaries);
+        const auto lufs = toLufs (energy);
+
+        if (lufs > absoluteGateLufs)
+        {
+            const auto bin = juce::jlimit (0, numGateBins - 1, (int) ((lufs - absoluteGateLufs) * binsPerLu));
+            ++gateCounts[(size_t) bin];
+            gateEnergies[(size_t) bin] += energy;
+        }
+    }
+}
+
+double LoudnessMeter::getWindowEnergy (int numWindowSummaries) const noexcept
+{
+    const int count = (int) juce::jmin ((juce::int64) numWindowSummaries, numSummaries);
+    double energy = 0.0;
+    juce::int64 samples = 0;
+
+    for (int i = 0; i < count; ++i)
+    {
+        const auto& summary = history[(size_t) ((historyIndex - i + shortTermSummaries) % shortTermSummaries)];
+        energy += (double) summary.weightedSquares[0] + (double) summary.weightedSquares[1];
+        samples += summary.numSamples;
+    }
+
+    return samples > 0 ? energy / (double) samples : 0.0;
+}
+
+void LoudnessMeter::publishReadings()
+{
+    Readings r;
+    r.droppedSummaries = droppedSummaries.load();
+    r.momentaryLufs = toLufs (getWindowEnergy (momentarySummaries));
+    r.shortTermLufs = toLufs (getWindowEnergy (shortTermSummaries));
+
+    // RMS and correlation over the last 300 ms.
+    double squares[2] = {}, cross = 0.0;
+    juce::int64 samples = 0;
+    const int count = (int) juce::jmin ((juce::int64) rmsSummaries, numSummaries);
+
+    for (int i = 0; i < count; ++i)
+    {
+        const auto& summary = history[(size_t) ((historyIndex - i + shortTermSummaries) % shortTermSummaries)];
+        squares[0] += summary.sumSquares[0];
+        squares[1] += summary.sumSquares[1];
+        cross += summary.crossProduct;
+        samples += summary.numSamples;
+    }
+
+    for (int ch = 0; ch < 2; ++ch)
+    {
+        r.peakDb[ch] = toDecibels (peakHold[ch]);
+        r.rmsDb[ch] = samples > 0 ? toDecibels (std::sqrt (squares[ch] / (double) samples)) : silenceDb;
+    }
+
+    const auto norm = std::sqrt (squares[0] * squares[1]);
+    r.correlation = norm > 1.0e-12 ? (float) juce::jlimit (-1.0, 1.0, cross / norm) : 0.0f;
+
+    // Integrated: the mean of the blocks over the absolute gate sets a relative gate 10 LU
+    // under it, and the integrated loudness is the mean of the blocks over both.
+    juce::int64 gatedCount = 0;
+    double gatedEnergy = 0.0;
+    for (size_t bin = 0; bin < gateCounts.size(); ++bin)
+    {
+        gatedCount += gateCounts[bin];
+        gatedEnergy += gateEnergies[bin];
+    }
+
+    if (gatedCount > 0)
+    {
+        const auto relativeGate = toLufs (gatedEnergy / (double) gatedCount) - 10.0f;
+        const auto firstBin = juce::jmax (0, (int) std::floor ((relativeGate - absoluteGateLufs) * binsPerLu));
+
+        gatedCount = 0;
+        gatedEnergy = 0.0;
+        for (int bin = firstBin; bin < numGateBins; ++bin)
+        {
+            gatedCount += gateCounts[(size_t) bin];
+            gatedEnergy += gateEnergies[(size_t) bin];
+        }
+
+        if (gatedCount > 0)
+            r.integratedLufs = toLufs (gatedEnergy / (double) gatedCount);
+    }
+
+    readings.write (r);
+}
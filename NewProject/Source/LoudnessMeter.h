@@ -0,0 +1,126 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "TripleBuffer.h"
+
+//==============================================================================
+// I meter the stereo output: peak and RMS per channel, momentary, short-term and
+// integrated loudness (ITU-R BS.1770 / EBU R128, in LUFS) and the correlation between
+// the channels.
+//
+// The audio thread only condenses: for every 10 ms of audio it K-weights the samples
+// (the one serial loop, two biquads per channel) and reduces them to one Summary of
+// peaks and sums of squares, with a few vector reductions per block. The Summary goes
+// into a preallocated AbstractFifo ring, like CallbackMonitor's records; if the ring is
+// full I drop it and count it. Nothing on that side locks or allocates.
+//
+// A background thread drains the ring every 10 ms, slides the loudness windows over
+// the last 400 ms (momentary) and 3 s (short-term), gates 400 ms blocks every 100 ms
+// into a histogram for the integrated loudness, and publishes Readings through a
+// TripleBuffer for the UI to pick up at its own rate.
+class LoudnessMeter  : private juce::Thread
+{
+public:
+    // What the audio thread hands over for every 10 ms of audio.
+    struct Summary
+    {
+        float peak[2] = {};
+        float sumSquares[2] = {};
+        float weightedSquares[2] = {};   // after K-weighting
+        float crossProduct = 0.0f;       // sum of left times right
+        int numSamples = 0;
+        int generation = 0;              // which prepare() this belongs to
+    };
+
+    struct Readings
+    {
+        float peakDb[2] = { silenceDb, silenceDb };   // with a falling hold
+        float rmsDb[2] = { silenceDb, silenceDb };    // over the last 300 ms
+        float momentaryLufs = silenceDb;
+        float shortTermLufs = silenceDb;
+        float integratedLufs = silenceDb;             // silenceDb until a block passes the gate
+        float correlation = 0.0f;                     // -1 to 1, over the last 300 ms
+        int droppedSummaries = 0;
+    };
+
+    static constexpr float silenceDb = -100.0f;
+    static constexpr int summariesPerSecond = 100;
+    static constexpr int ringSize = 1024;            // 10 s of summaries
+
+    LoudnessMeter();
+    ~LoudnessMeter() override;
+
+    // Call me from prepareToPlay, before callbacks start. I restart every measurement.
+    void prepare (double sampleRate);
+
+    // Audio thread: I take in a block of the output.
+    void push (const float* left, const float* right, int numSamples) noexcept;
+
+    // I start and stop the background thread that runs collect() every 10 ms.
+    void startAnalysis();
+    void stopAnalysis();
+
+    // The analysis side: I drain the ring, update the measurements and publish them, and
+    // return how many summaries I took. The background thread calls me; while it's
+    // stopped a test can call me directly.
+    int collect();
+
+    // Any thread: I start the integrated loudness over at the next collect().
+    void resetIntegrated() noexcept     { integratedResetPending.store (true); }
+
+    // One reader thread (the UI): the latest published readings.
+    Readings getReadings() noexcept     { return readings.read(); }
+
+private:
+    static constexpr int maxChunk = 256;
+    static constexpr int momentarySummaries = 40;    // 400 ms
+    static constexpr int shortTermSummaries = 300;   // 3 s
+    static constexpr int rmsSummaries = 30;          // 300 ms
+    static constexpr int gateHopSummaries = 10;      // a gating block every 100 ms
+
+    // Block loudness in 0.1 LU bins from the absolute gate at -70 LUFS up to +10.
+    static constexpr float absoluteGateLufs = -70.0f;
+    static constexpr int binsPerLu = 10;
+    static constexpr int numGateBins = 80 * binsPerLu;
+
+    void run() override;
+
+    void kWeight (int channel, const float* input, float* output, int numSamples) noexcept;
+    void publishSummary() noexcept;
+    void addSummary (const Summary& summary);
+    void publishReadings();
+    double getWindowEnergy (int numWindowSummaries) const noexcept;
+
+    // Audio thread only (and prepare(), while it's stopped).
+    // In double: the high-pass sits at 38 Hz, which needs the precision at high rates.
+    struct Biquad
+    {
+        double b0 = 1.0, b1 = 0.0, b2 = 0.0, a1 = 0.0, a2 = 0.0;
+    };
+
+    Biquad shelf, highPass;                 // BS.1770's two K-weighting stages
+    double filterState[2][4] = {};          // per channel: both stages' two state variables
+    float weighted[maxChunk] = {};
+    Summary pending;
+    int intervalSamples = 480;
+
+    // The ring. Only the audio thread writes, only the analysis side reads.
+    juce::AbstractFifo fifo { ringSize };
+    std::vector<Summary> summaries;
+    std::atomic<int> generation { 0 };
+    std::atomic<int> droppedSummaries { 0 };
+    std::atomic<bool> integratedResetPending { false };
+
+    // Analysis side only: the last shortTermSummaries summaries, newest at historyIndex.
+    std::vector<Summary> history;
+    int historyIndex = 0;
+    juce::int64 numSummaries = 0;
+    int seenGeneration = -1;
+    float peakHold[2] = {};
+    std::array<juce::int64, (size_t) numGateBins> gateCounts {};
+    std::array<double, (size_t) numGateBins> gateEnergies {};
+
+    TripleBuffer<Readings> readings;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (LoudnessMeter)
+};
@@ -0,0 +1,141 @@
+#include <JuceHeader.h>
+#include "LoudnessMeter.h"
+
+//==============================================================================
+// I test LoudnessMeter against EBU Tech 3341's reference signals: a 1 kHz sine at
+// -23 dBFS reads -23 LUFS momentary, short-term and integrated at any rate, and quiet
+// passages under the relative gate don't drag the integrated loudness down. I also check
+// peak, RMS and correlation, and that a full ring drops summaries rather than blocking.
+class LoudnessMeterTest : public juce::UnitTest
+{
+public:
+    LoudnessMeterTest() : juce::UnitTest ("LoudnessMeter", "Audio") {}
+
+    // I push seconds of a stereo sine at levelDb (per channel) in 512-sample blocks,
+    // collecting every second so the ring never fills. rightSign flips the right channel.
+    static void pushSine (LoudnessMeter& meter, double sampleRate, double seconds, float levelDb,
+                          double frequency = 1000.0, float rightSign = 1.0f)
+    {
+        const float amplitude = juce::Decibels::decibelsToGain (levelDb);
+        const auto total = (juce::int64) (seconds * sampleRate);
+        std::vector<float> left (512), right (512);
+
+        for (juce::int64 start = 0; start < total; start += 512)
+        {
+            const int n = (int) juce::jmin ((juce::int64) 512, total - start);
+            for (int i = 0; i < n; ++i)
+            {
+                const auto t = (double) (start + i) / sampleRate;
+                left[(size_t) i] = amplitude * (float) std::sin (juce::MathConstants<double>::twoPi * frequency * t);
+                right[(size_t) i] = rightSign * left[(size_t) i];
+            }
+
+            meter.push (left.data(), right.data(), n);
+
+            if ((start / 512) % 64 == 0)
+                meter.collect();
+        }
+
+        meter.collect();
+    }
+
+    void runTest() override
+    {
+        beginTest ("a -23 dBFS sine reads -23 LUFS at every rate");
+        {
+            for (double sampleRate : { 44100.0, 48000.0, 96000.0, 192000.0 })
+            {
+                LoudnessMeter meter;
+                meter.prepare (sampleRate);
+                pushSine (meter, sampleRate, 4.0, -23.0f);
+
+                const auto r = meter.getReadings();
+                expectWithinAbsoluteError (r.momentaryLufs, -23.0f, 0.1f, juce::String (sampleRate) + " momentary");
+                expectWithinAbsoluteError (r.shortTermLufs, -23.0f, 0.1f, juce::String (sampleRate) + " short-term");
+                expectWithinAbsoluteError (r.integratedLufs, -23.0f, 0.1f, juce::String (sampleRate) + " integrated");
+                expectEquals (r.droppedSummaries, 0);
+            }
+        }
+
+        beginTest ("quiet passages under the relative gate don't count");
+        {
+            // Tech 3341 case 3: 10 s at -36, 60 s at -23, 10 s at -36 dBFS reads -23 LUFS.
+            LoudnessMeter meter;
+            meter.prepare (48000.0);
+            pushSine (meter, 48000.0, 10.0, -36.0f);
+            pushSine (meter, 48000.0, 60.0, -23.0f);
+            pushSine (meter, 48000.0, 10.0, -36.0f);
+
+            auto r = meter.getReadings();
+            expectWithinAbsoluteError (r.integratedLufs, -23.0f, 0.1f);
+            expectWithinAbsoluteError (r.shortTermLufs, -36.0f, 0.1f);
+
+            // Starting over forgets the loud part.
+            meter.resetIntegrated();
+            pushSine (meter, 48000.0, 2.0, -36.0f);
+            r = meter.getReadings();
+            expectWithinAbsoluteError (r.integratedLufs, -36.0f, 0.1f);
+
+            // Silence never passes the absolute gate.
+            LoudnessMeter silent;
+            silent.prepare (48000.0);
+            pushSine (silent, 48000.0, 1.0, -120.0f);
+            expectEquals (silent.getReadings().integratedLufs, LoudnessMeter::silenceDb);
+        }
+
+        beginTest ("peak, RMS and correlation");
+        {
+            LoudnessMeter meter;
+            meter.prepare (48000.0);
+            pushSine (meter, 48000.0, 1.0, -6.0f, 440.0);
+
+            auto r = meter.getReadings();
+            for (int ch = 0; ch < 2; ++ch)
+            {
+                expectWithinAbsoluteError (r.peakDb[ch], -6.0f, 0.05f);
+                expectWithinAbsoluteError (r.rmsDb[ch], -6.0f - 3.01f, 0.05f);
+            }
+            expectWithinAbsoluteError (r.correlation, 1.0f, 1.0e-4f);
+
+            meter.prepare (48000.0);
+            pushSine (meter, 48000.0, 1.0, -6.0f, 440.0, -1.0f);
+            r = meter.getReadings();
+            expectWithinAbsoluteError (r.correlation, -1.0f, 1.0e-4f);
+
+            // Uncorrelated noise sits near zero.
+            meter.prepare (48000.0);
+            juce::Random random (2);
+            std::vector<float> left (48000), right (48000);
+            for (size_t i = 0; i < left.size(); ++i)
+            {
+                left[i] = random.nextFloat() - 0.5f;
+                right[i] = random.nextFloat() - 0.5f;
+            }
+            meter.push (left.data(), right.data(), (int) left.size());
+            meter.collect();
+            expectLessThan (std::abs (meter.getReadings().correlation), 0.1f);
+        }
+
+        beginTest ("a full ring drops summaries instead of waiting");
+        {
+            LoudnessMeter meter;
+            meter.prepare (48000.0);
+
+            // 20 s with nobody collecting: twice what the ring holds.
+            std::vector<float> block (480, 0.1f);
+            for (int i = 0; i < 2000; ++i)
+                meter.push (block.data(), block.data(), (int) block.size());
+
+            expectEquals (meter.collect(), LoudnessMeter::ringSize - 1);
+            expectEquals (meter.getReadings().droppedSummaries, 2000 - (LoudnessMeter::ringSize - 1));
+
+            // A new prepare() starts the count and the readings over.
+            meter.prepare (48000.0);
+            expectEquals (meter.collect(), 0);
+            expectEquals (meter.getReadings().droppedSummaries, 0);
+            expectEquals (meter.getReadings().momentaryLufs, LoudnessMeter::silenceDb);
+        }
+    }
+};
+
+static LoudnessMeterTest loudnessMeterTest;
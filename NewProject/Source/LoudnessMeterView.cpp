@@ -0,0 +1,75 @@
+#include "LoudnessMeterView.h"
+
+//==============================================================================
+namespace
+{
+    constexpr float floorDb = -60.0f;
+
+    juce::String formatLufs (float lufs)
+    {
+        return lufs <= LoudnessMeter::silenceDb ? juce::String ("-inf") : juce::String (lufs, 1);
+    }
+}
+
+LoudnessMeterView::LoudnessMeterView (LoudnessMeter& meterToShow)
+    : meter (meterToShow)
+{
+    setTooltip ("Output levels: RMS bars with peak hold (dBFS), and loudness in LUFS over the last "
+                "400 ms (M), 3 s (S) and since the start (I, gated as in EBU R128). Click to "
+                "restart the integrated loudness.");
+    startTimerHz (refreshHz);
+}
+
+void LoudnessMeterView::timerCallback()
+{
+    const auto latest = meter.getReadings();
+    if (std::memcmp (&latest, &shown, sizeof (shown)) != 0)
+    {
+        shown = latest;
+        repaint();
+    }
+}
+
+void LoudnessMeterView::mouseDown (const juce::MouseEvent&)
+{
+    meter.resetIntegrated();
+}
+
+void LoudnessMeterView::paint (juce::Graphics& g)
+{
+    auto area = getLocalBounds();
+    auto bars = area.removeFromTop (juce::jmin (area.getHeight() / 2, 20)).reduced (0, 1);
+    const auto text = getLookAndFeel().findColour (juce::Label::textColourId);
+
+    for (int ch = 0; ch < 2; ++ch)
+    {
+        auto bar = (ch == 0 ? bars.removeFromTop (bars.getHeight() / 2) : bars).reduced (0, 1).toFloat();
+        const auto proportion = [&bar] (float db)
+        {
+            return bar.getWidth() * juce::jlimit (0.0f, 1.0f, (db - floorDb) / -floorDb);
+        };
+
+        g.setColour (text.withAlpha (0.12f));
+        g.fillRect (bar);
+
+        const auto rms = shown.rmsDb[ch];
+        g.setColour (rms > -1.0f ? juce::Colours::red : rms > -9.0f ? juce::Colours::orange : juce::Colours::limegreen);
+        g.fillRect (bar.withWidth (proportion (rms)));
+
+        g.setColour (text);
+        g.fillRect (bar.getX() + proportion (shown.peakDb[ch]) - 1.0f, bar.getY(), 2.0f, bar.getHeight());
+    }
+
+    juce::String readout;
+    readout << "M " << formatLufs (shown.momentaryLufs)
+            << "   S " << formatLufs (shown.shortTermLufs)
+            << "   I " << formatLufs (shown.integratedLufs) << " LUFS"
+            << "   corr " << (shown.correlation >= 0.0f ? "+" : "") << juce::String (shown.correlation, 2);
+
+    if (shown.droppedSummaries > 0)
+        readout << "   (" << shown.droppedSummaries << " dropped)";
+
+    g.setColour (text);
+    g.setFont (juce::FontOptions (12.0f));
+    g.drawText (readout, area, juce::Justification::centredLeft);
+}
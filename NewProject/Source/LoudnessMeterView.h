@@ -0,0 +1,31 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "LoudnessMeter.h"
+
+//==============================================================================
+// I draw a LoudnessMeter's readings in the control panel: a bar per channel (RMS filled,
+// the peak hold as a line, -60 to 0 dBFS) and the momentary, short-term and integrated
+// loudness and correlation as text. I pick the readings up at refreshHz on the message
+// thread and only repaint when they change. Clicking me restarts the integrated loudness.
+class LoudnessMeterView  : public juce::Component,
+                           public juce::SettableTooltipClient,
+                           private juce::Timer
+{
+public:
+    static constexpr int refreshHz = 30;
+
+    explicit LoudnessMeterView (LoudnessMeter& meterToShow);
+    ~LoudnessMeterView() override = default;
+
+    void paint (juce::Graphics& g) override;
+    void mouseDown (const juce::MouseEvent& event) override;
+
+private:
+    void timerCallback() override;
+
+    LoudnessMeter& meter;
+    LoudnessMeter::Readings shown;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (LoudnessMeterView)
+};
@@ -3,7 +3,7 @@
 //==============================================================================
 MainComponent::MainComponent()
 : audioDeviceSelector (deviceManager,
-                        2, 2,  // min/max input channels
+                        2, SpatializerBank::maxSources,  // min/max input channels
                         2, 2,  // min/max output channels
                         false, // no MIDI input
                         false, // no MIDI output
@@ -21,6 +21,35 @@ MainComponent::MainComponent()
     }
 
     const bool hadSavedState = (savedState != nullptr);
+    int savedJackPorts = 2;
+    bool savedJackMode = false;
+    juce::String savedBridgeInput;
+    bool savedBridgeMode = false;
+    int savedHeadPort = HeadTracker::defaultPort;
+    bool savedHeadTracking = false;
+    if (hadSavedState)
+    {
+        latencyMeasurement = LatencyProbe::Measurement::fromXml (savedState->getChildByName (LatencyProbe::Measurement::xmlTag));
+
+        if (auto* jack = savedState->getChildByName ("JACKCLIENT"))
+        {
+            savedJackPorts = jack->getIntAttribute ("inputPorts", savedJackPorts);
+            savedJackMode = jack->getBoolAttribute ("enabled");
+        }
+
+        if (auto* bridge = savedState->getChildByName ("CLOCKBRIDGE"))
+        {
+            savedBridgeInput = bridge->getStringAttribute ("inputDevice");
+            savedBridgeMode = bridge->getBoolAttribute ("enabled");
+        }
+
+        if (auto* head = savedState->getChildByName ("HEADTRACKER"))
+        {
+            savedHeadPort = head->getIntAttribute ("port", savedHeadPort);
+            savedHeadTracking = head->getBoolAttribute ("enabled");
+        }
+    }
+
     if (juce::RuntimePermissions::isRequired (juce::RuntimePermissions::recordAudio)
         && ! juce::RuntimePermissions::isGranted (juce::RuntimePermissions::recordAudio))
     {
@@ -48,12 +77,73 @@ MainComponent::MainComponent()
     {
         audioSettingsExpanded = audioSettingsToggle.getToggleState();
         audioDeviceSelector.setVisible (audioSettingsExpanded);
+        separateInputToggle.setVisible (audioSettingsExpanded);
+        separateInputCombo.setVisible (audioSettingsExpanded);
+        headTrackingToggle.setVisible (audioSettingsExpanded);
+        headPortSlider.setVisible (audioSettingsExpanded);
+        updateSeparateInputDevices();
         setSize (getPreferredSize().x, getPreferredSize().y);
         resized();
         if (onPreferredSizeChanged)
             onPreferredSizeChanged();
     };
     addAndMakeVisible (audioSettingsToggle);
+
+    autoBufferToggle.setToggleState (true, juce::dontSendNotification);
+    autoBufferToggle.setTooltip ("Move the buffer size up when the audio drops out, and back down after it has "
+                                 "run cleanly for a while, to find the lowest latency this machine can keep. "
+                                 "Each move is written to CallbackTiming.log.");
+    autoBufferToggle.onClick = [this] { controlledDeviceName = {}; };
+    addAndMakeVisible (autoBufferToggle);
+
+    separateInputToggle.setTooltip ("Open the input below as a device of its own, and resample it to the output "
+                                    "device's clock, following the drift between the two. For an input and output "
+                                    "that are separate hardware, e.g. a USB microphone into the built-in output.");
+    separateInputToggle.onClick = [this]
+    {
+        if (separateInputToggle.getToggleState())
+            separateInputToggle.setToggleState (startSeparateInput (separateInputCombo.getText(), true),
+                                                juce::dontSendNotification);
+        else
+            stopSeparateInput();
+    };
+    addChildComponent (separateInputToggle);
+    separateInputCombo.setTooltip ("The input device to run on its own clock.");
+    separateInputCombo.onChange = [this]
+    {
+        if (bridging.load())
+            separateInputToggle.setToggleState (startSeparateInput (separateInputCombo.getText(), true),
+                                                juce::dontSendNotification);
+    };
+    addChildComponent (separateInputCombo);
+
+    headTrackingToggle.setTooltip ("Listen for a head tracker on the UDP port beside, and turn the scene against the "
+                                   "head so sources stay put in the room. The tracker sends OSC /orbit/head/ypr with "
+                                   "yaw, pitch and roll in degrees; OrbitHeadSender plays recordings the same way.");
+    headTrackingToggle.onClick = [this]
+    {
+        if (headTrackingToggle.getToggleState())
+            headTrackingToggle.setToggleState (startHeadTracking (true), juce::dontSendNotification);
+        else
+            stopHeadTracking();
+    };
+    addChildComponent (headTrackingToggle);
+
+    headPortLabel.setText ("Port", juce::dontSendNotification);
+    headPortLabel.attachToComponent (&headPortSlider, true);
+    headPortSlider.setSliderStyle (juce::Slider::IncDecButtons);
+    headPortSlider.setTextBoxStyle (juce::Slider::TextBoxLeft, false, 60, 20);
+    headPortSlider.setRange (1024.0, 65535.0, 1.0);
+    headPortSlider.setValue (savedHeadPort, juce::dontSendNotification);
+    headPortSlider.setTooltip ("The local UDP port the head tracker sends to.");
+    headPortSlider.onValueChange = [this]
+    {
+        if (headTracker.isConnected())
+            headTrackingToggle.setToggleState (startHeadTracking (true), juce::dontSendNotification);
+        else
+            saveAudioState();
+    };
+    addChildComponent (headPortSlider);
     audioSettingsToggle.setTooltip ("Expand to choose audio input/output devices, buffer size, and sample rate.");
 
     quitButton.onClick = []
@@ -63,25 +153,147 @@ MainComponent::MainComponent()
     addAndMakeVisible (quitButton);
     quitButton.setTooltip ("Quit OrbitAudio.");
 
+    measureLatencyButton.setTooltip ("Play a short noise burst and time how long it takes to come back in, "
+                                     "through a loopback cable or routing. The result is saved with the device settings.");
+    measureLatencyButton.onClick = [this]
+    {
+        const auto options = juce::MessageBoxOptions()
+                                 .withIconType (juce::MessageBoxIconType::InfoIcon)
+                                 .withTitle ("Measure latency")
+                                 .withMessage ("OrbitAudio will play a quarter second of noise at -18 dBFS and listen for it "
+                                               "on its input. Route the output back to the input (a cable, or BlackHole) "
+                                               "and turn speakers down.")
+                                 .withButton ("Measure")
+                                 .withButton ("Cancel")
+                                 .withAssociatedComponent (this);
+
+        juce::AlertWindow::showAsync (options, [safeThis = juce::Component::SafePointer<MainComponent> (this)] (int button)
+        {
+            if (safeThis != nullptr && button == 1 && safeThis->latencyProbe.begin())
+                safeThis->measureLatencyButton.setEnabled (false);
+        });
+    };
+    addAndMakeVisible (measureLatencyButton);
+
     orbitModeCombo.addItem ("Manual", 1);
     orbitModeCombo.addItem ("Orbit (3D)", 2);
     orbitModeCombo.addItem ("Figure-8 (8D)", 3);
+    orbitModeCombo.addItem ("Path", 4);
     orbitModeCombo.setSelectedId (1, juce::dontSendNotification);
     orbitModeCombo.onChange = [this]
     {
         int id = orbitModeCombo.getSelectedId();
-        orbitMode.store (id - 1);
+        parameters.orbitMode = id == 1 ? Spatializer::OrbitMode::Manual
+                             : id == 2 ? Spatializer::OrbitMode::Orbit
+                             : id == 3 ? Spatializer::OrbitMode::Figure8
+                             : Spatializer::OrbitMode::Path;
         panSlider.setEnabled (id == 1);
+        publishParameters();
     };
     addAndMakeVisible (orbitModeCombo);
-    orbitModeCombo.setTooltip ("Manual: use pan knob. Orbit: circular motion. Figure-8: tighter 8D-style orbit.");
+    orbitModeCombo.setTooltip ("Manual: use pan knob. Orbit: circular motion. Figure-8: tighter 8D-style orbit. "
+                               "Path: the preset's own trajectory (circle, ellipse, spiral, keyframes or random walk).");
+
+    sourceLayoutCombo.addItem ("Stereo source", 1);
+    sourceLayoutCombo.addItem ("Stereo pairs", 2);
+    sourceLayoutCombo.addItem ("Mono channels", 3);
+    if (OrbitJackClient::isAvailable())
+        sourceLayoutCombo.addItem ("JACK ports", jackLayoutId);
+    sourceLayoutCombo.setSelectedId (1, juce::dontSendNotification);
+    sourceLayoutCombo.onChange = [this]
+    {
+        if (sourceLayoutCombo.getSelectedId() == jackLayoutId)
+        {
+            if (! jackClient.isOpen() && ! startJackMode())
+                sourceLayoutCombo.setSelectedId (parameters.sourceLayout + 1, juce::dontSendNotification);
+        }
+        else
+        {
+            if (jackClient.isOpen())
+                stopJackMode();
+
+            parameters.sourceLayout = sourceLayoutCombo.getSelectedId() - 1;
+            publishParameters();
+        }
+
+        updateSourceControls();
+    };
+    addAndMakeVisible (sourceLayoutCombo);
+    sourceLayoutCombo.setTooltip ("Stereo source: one source from inputs 1/2. Stereo pairs / Mono channels: "
+                                  "every active input pair or channel (e.g. BlackHole 16ch) is its own source, "
+                                  "spread around the orbit and mixed to binaural stereo. JACK ports: OrbitAudio "
+                                  "becomes a JACK client with its own input ports, one source each, instead of "
+                                  "using the audio device.");
+
+    jackPortsLabel.setText ("Ports", juce::dontSendNotification);
+    jackPortsLabel.setJustificationType (juce::Justification::centredRight);
+    addChildComponent (jackPortsLabel);
+    jackPortsSlider.setSliderStyle (juce::Slider::IncDecButtons);
+    jackPortsSlider.setTextBoxStyle (juce::Slider::TextBoxLeft, false, 40, 20);
+    jackPortsSlider.setRange (1.0, OrbitJackClient::maxInputPorts, 1.0);
+    jackPortsSlider.setValue (juce::jlimit (1, OrbitJackClient::maxInputPorts, savedJackPorts), juce::dontSendNotification);
+    jackPortsSlider.onValueChange = [this]
+    {
+        // Ports come and go while JACK runs; connections to the others stay.
+        jackClient.setNumInputPorts ((int) jackPortsSlider.getValue());
+        saveAudioState();
+    };
+    jackPortsSlider.setTooltip ("How many JACK input ports (in_1, in_2, ...) to offer. Each is spatialized as its "
+                                "own source, spread around the orbit.");
+    addChildComponent (jackPortsSlider);
+
+    headModelCombo.addItem ("Parametric head", 1);
+    headModelCombo.addItem ("Measured HRTF", 2);
+    headModelCombo.addItem ("Ambisonic, 1st order", 3);
+    headModelCombo.addItem ("Ambisonic, 2nd order", 4);
+    headModelCombo.addItem ("Ambisonic, 3rd order", 5);
+    headModelCombo.setSelectedId (1, juce::dontSendNotification);
+    headModelCombo.onChange = [this]
+    {
+        const int id = headModelCombo.getSelectedId();
+        parameters.useHrtf = id == 2;
+        parameters.ambisonicOrder = id >= 3 ? id - 2 : 0;
+        publishParameters();
+    };
+    addAndMakeVisible (headModelCombo);
+    headModelCombo.setTooltip ("Parametric head: ITD + head-shadow filter. Measured HRTF: convolve the stereo source "
+                               "with a measured HRIR set (load one first). Ambisonic: mix the multi-source layouts and "
+                               "JACK ports into one sound field and decode it with the loaded HRIR set, or the parametric "
+                               "head if none is loaded; higher orders are sharper and cost more. Otherwise multi-source "
+                               "layouts use the parametric head.");
+
+    loadHrirButton.onClick = [this]
+    {
+        hrirChooser = std::make_unique<juce::FileChooser> ("Choose a folder of HRIR files (one WAV per angle)",
+                                                           OrbitPreset::getHrirDirectory());
+        hrirChooser->launchAsync (juce::FileBrowserComponent::openMode | juce::FileBrowserComponent::canSelectDirectories,
+                                  [this] (const juce::FileChooser& chooser)
+                                  {
+                                      const auto folder = chooser.getResult();
+                                      // The ambisonic bus decodes with the new set as it is.
+                                      if (folder != juce::File() && loadHrirFolder (folder, true)
+                                          && headModelCombo.getSelectedId() == 1)
+                                          headModelCombo.setSelectedId (2);
+                                  });
+    };
+    addAndMakeVisible (loadHrirButton);
+    loadHrirButton.setTooltip ("Load a folder of HRIRs named by angle, e.g. azi030_ele000.wav (left ear = channel 1). "
+                               "Files placed in OrbitAudio/HRIR are loaded at startup.");
+
+    // I pick up an installed HRIR set quietly; an empty or missing folder just leaves HRTF unavailable.
+    loadHrirFolder (OrbitPreset::getHrirDirectory(), false);
 
     panSpeedSlider.setSliderStyle (juce::Slider::LinearHorizontal);
     panSpeedSlider.setTextBoxStyle (juce::Slider::TextBoxRight, false, 50, 20);
     panSpeedSlider.setRange (0.02, 0.5, 0.01);
     panSpeedSlider.setValue (0.05);
-    panSpeedSlider.onValueChange = [this] { panSpeedHz.store ((float) panSpeedSlider.getValue()); };
-    panSpeedSlider.setTooltip ("LFO speed for Orbit/Figure-8 modes (0.02 to 0.5 Hz).");
+    panSpeedSlider.onValueChange = [this]
+    {
+        parameters.panSpeedHz = (float) panSpeedSlider.getValue();
+        publishParameters();
+    };
+    panSpeedSlider.setTooltip ("Loops per second for Orbit, Figure-8 and Path modes (0.02 to 0.5 Hz). "
+                               "Paths locked to a number of beats follow the preset's tempo instead.");
     addAndMakeVisible (panSpeedSlider);
 
     panLabel.setText ("Pan", juce::dontSendNotification);
@@ -91,8 +303,12 @@ MainComponent::MainComponent()
     panSlider.setTextBoxStyle (juce::Slider::TextBoxBelow, false, 60, 20);
     panSlider.setRange (-1.0, 1.0, 0.001);
     panSlider.setValue (0.0);
-    panSlider.onValueChange = [this] { panValue.store ((float) panSlider.getValue()); };
-    panSlider.setTooltip ("Manual pan position: -1 = full left, +1 = full right. Disabled when Orbit or Figure-8 is active.");
+    panSlider.onValueChange = [this]
+    {
+        parameters.pan = (float) panSlider.getValue();
+        publishParameters();
+    };
+    panSlider.setTooltip ("Manual pan position: -1 = full left, +1 = full right. Used only in Manual mode.");
     addAndMakeVisible (panSlider);
 
     itdAmountLabel.setText ("ITD", juce::dontSendNotification);
@@ -103,9 +319,8 @@ MainComponent::MainComponent()
     itdAmountSlider.setValue (1.0);
     itdAmountSlider.onValueChange = [this]
     {
-        float v = (float) itdAmountSlider.getValue();
-        itdAmount.store (v);
-        spatializer.setItdAmount (v);
+        parameters.itdAmount = (float) itdAmountSlider.getValue();
+        publishParameters();
     };
     itdAmountSlider.setTooltip ("Interaural time difference: delay on the far ear for directional feel (0 = none, 1 = full).");
     addAndMakeVisible (itdAmountSlider);
@@ -118,9 +333,8 @@ MainComponent::MainComponent()
     shadowStrengthSlider.setValue (1.0);
     shadowStrengthSlider.onValueChange = [this]
     {
-        float v = (float) shadowStrengthSlider.getValue();
-        shadowStrength.store (v);
-        spatializer.setShadowStrength (v);
+        parameters.shadowStrength = (float) shadowStrengthSlider.getValue();
+        publishParameters();
     };
     shadowStrengthSlider.setTooltip ("Head-shadow effect: low-pass filter on the far ear (0 = none, 1 = maximum).");
     addAndMakeVisible (shadowStrengthSlider);
@@ -136,9 +350,8 @@ MainComponent::MainComponent()
     depthSlider.setTooltip ("HF rolloff for distance effect (0 = close, 1 = far)");
     depthSlider.onValueChange = [this]
     {
-        float v = (float) depthSlider.getValue();
-        depth.store (v);
-        spatializer.setDepth (v);
+        parameters.depth = (float) depthSlider.getValue();
+        publishParameters();
     };
     addAndMakeVisible (depthSlider);
     addAndMakeVisible (depthLabel);
@@ -152,9 +365,8 @@ MainComponent::MainComponent()
     widthSlider.setTooltip ("Stereo field scale (0 = narrow, 1 = full)");
     widthSlider.onValueChange = [this]
     {
-        float v = (float) widthSlider.getValue();
-        width.store (v);
-        spatializer.setWidth (v);
+        parameters.width = (float) widthSlider.getValue();
+        publishParameters();
     };
     addAndMakeVisible (widthSlider);
     addAndMakeVisible (widthLabel);
@@ -164,6 +376,7 @@ MainComponent::MainComponent()
     presetCombo.addItem ("Orbit", 2);
     presetCombo.addItem ("Wide", 3);
     presetCombo.addItem ("Narrow", 4);
+    presetCombo.addItem ("Spiral", 5);
     presetCombo.setSelectedId (1, juce::dontSendNotification);
     presetCombo.onChange = [this]
     {
@@ -172,6 +385,7 @@ MainComponent::MainComponent()
         else if (id == 2) loadPreset ("Orbit");
         else if (id == 3) loadPreset ("Wide");
         else if (id == 4) loadPreset ("Narrow");
+        else if (id == 5) loadPreset ("Spiral");
     };
     presetCombo.setTooltip ("Quick preset for spatialization settings.");
     addAndMakeVisible (presetCombo);
@@ -183,6 +397,7 @@ MainComponent::MainComponent()
         if (id == 2) savePreset ("Orbit");
         else if (id == 3) savePreset ("Wide");
         else if (id == 4) savePreset ("Narrow");
+        else if (id == 5) savePreset ("Spiral");
     };
     addAndMakeVisible (savePresetButton);
 
@@ -217,8 +432,12 @@ MainComponent::MainComponent()
 #endif
 
     reverbToggle.setToggleState (false, juce::dontSendNotification);
-    reverbToggle.onClick = [this] { reverbEnabled.store (reverbToggle.getToggleState()); };
-    reverbToggle.setTooltip ("Enable stereo reverb for added depth.");
+    reverbToggle.onClick = [this]
+    {
+        parameters.reverbEnabled = reverbToggle.getToggleState();
+        publishParameters();
+    };
+    reverbToggle.setTooltip ("Enable the room reverb: reflections that follow the source around the orbit, then a diffuse tail.");
     addAndMakeVisible (reverbToggle);
 
     reverbWetLabel.setText ("Reverb Wet", juce::dontSendNotification);
@@ -229,54 +448,118 @@ MainComponent::MainComponent()
     reverbWetSlider.setValue (0.33);
     reverbWetSlider.onValueChange = [this]
     {
-        float v = (float) reverbWetSlider.getValue();
-        reverbWet.store (v);
-        auto params = reverb.getParameters();
-        params.wetLevel = v;
-        reverb.setParameters (params);
+        parameters.reverbWet = (float) reverbWetSlider.getValue();
+        publishParameters();
     };
     reverbWetSlider.setTooltip ("Reverb wet mix when Reverb is on (0 = dry, 1 = full wet).");
     addAndMakeVisible (reverbWetSlider);
     addAndMakeVisible (reverbWetLabel);
+
+    callbackStatsLabel.setFont (juce::FontOptions (12.0f));
+    callbackStatsLabel.setTooltip ("Audio callback timing since the device started: percentiles and worst case "
+                                   "against the buffer deadline. DSP xruns are callbacks that overran; late ones are "
+                                   "gaps where the device didn't call us; device xruns are reported by the driver. "
+                                   "Output latency is the device's plus the output limiter's lookahead.");
+    addAndMakeVisible (callbackStatsLabel);
+
+    addAndMakeVisible (loudnessMeterView);
+    addAndMakeVisible (orbitRadarView);
+    loudnessMeter.startAnalysis();
+
+    timingLog = std::make_unique<juce::FileLogger> (getAudioStateFile().getSiblingFile ("CallbackTiming.log"),
+                                                    "OrbitAudio callback timing", 1024 * 1024);
+
+    if (savedJackMode && OrbitJackClient::isAvailable())
+        sourceLayoutCombo.setSelectedId (jackLayoutId);
+    else if (savedBridgeMode && savedBridgeInput.isNotEmpty())
+        separateInputToggle.setToggleState (startSeparateInput (savedBridgeInput, false), juce::dontSendNotification);
+
+    updateSeparateInputDevices();
+
+    if (savedHeadTracking)
+        headTrackingToggle.setToggleState (startHeadTracking (false), juce::dontSendNotification);
+
+    startTimerHz (statsTimerHz);
 }
 
 MainComponent::~MainComponent()
 {
+    stopTimer();
+    headTracker.disconnect();
+    jackClient.close();
+    inputDeviceManager.removeAudioCallback (&bridgeInputCallback);
+    inputDeviceManager.closeAudioDevice();
     deviceManager.removeChangeListener (this);
     shutdownAudio();
+    loudnessMeter.stopAnalysis();
 }
 
 //==============================================================================
 void MainComponent::prepareToPlay (int samplesPerBlockExpected, double sampleRate)
 {
     juce::FloatVectorOperations::disableDenormalisedNumberSupport();
-    spatializer.prepareToPlay (samplesPerBlockExpected, sampleRate);
-    reverb.setSampleRate (sampleRate);
-    auto params = reverb.getParameters();
-    params.wetLevel = reverbWet.load();
-    reverb.setParameters (params);
-    reverb.reset();
+    int numInputs = 2;
+    if (bridging.load())
+    {
+        numInputs = bridgeChannels;
+        clockBridge.prepareOutput (sampleRate, samplesPerBlockExpected);
+    }
+    else if (auto* device = deviceManager.getCurrentAudioDevice())
+    {
+        numInputs = device->getActiveInputChannels().countNumberOfSetBits();
+    }
+
+    engine.prepareToPlay (samplesPerBlockExpected, sampleRate, numInputs);
+    callbackMonitor.prepare (sampleRate, samplesPerBlockExpected);
+    loudnessMeter.prepare (sampleRate);
+    latencyProbe.prepare (sampleRate);
 }
 
 void MainComponent::getNextAudioBlock (const juce::AudioSourceChannelInfo& bufferToFill)
 {
-    // I run the spatializer with the current UI state, then optionally reverb.
-    const int mode = orbitMode.load();
-    const auto orbMode = mode == 0 ? Spatializer::OrbitMode::Manual
-                      : mode == 1 ? Spatializer::OrbitMode::Orbit
-                      : Spatializer::OrbitMode::Figure8;
-    spatializer.process (*bufferToFill.buffer,
-                         bufferToFill.startSample,
-                         bufferToFill.numSamples,
-                         panValue.load(),
-                         orbMode,
-                         panSpeedHz.load());
-
-    if (reverbEnabled.load())
-    {
-        auto* left  = bufferToFill.buffer->getWritePointer (0, bufferToFill.startSample);
-        auto* right = bufferToFill.buffer->getWritePointer (1, bufferToFill.startSample);
-        reverb.processStereo (left, right, bufferToFill.numSamples);
+    const CallbackMonitor::ScopedCallback timing (callbackMonitor, bufferToFill.numSamples);
+
+    if (bridging.load())
+    {
+        processBridgedInput (bufferToFill);
+    }
+    else
+    {
+        // While a latency measurement runs, the probe hears the input as it arrives...
+        latencyProbe.captureInput (*bufferToFill.buffer, bufferToFill.startSample, bufferToFill.numSamples);
+
+        // The engine picks up the latest published parameters and runs the spatializer (HRTF
+        // renderer, or the multi-source bank) and then the optional reverb.
+        engine.process (*bufferToFill.buffer, bufferToFill.startSample, bufferToFill.numSamples);
+    }
+
+    // The meter only condenses the block here; the loudness maths runs on its own thread.
+    loudnessMeter.push (bufferToFill.buffer->getReadPointer (0, bufferToFill.startSample),
+                        bufferToFill.buffer->getReadPointer (1, bufferToFill.startSample),
+                        bufferToFill.numSamples);
+
+    // ...and its burst replaces what we'd play.
+    latencyProbe.replaceOutput (*bufferToFill.buffer, bufferToFill.startSample, bufferToFill.numSamples);
+}
+
+void MainComponent::processBridgedInput (const juce::AudioSourceChannelInfo& bufferToFill)
+{
+    // The device opened output only: the input comes from the bridge, already on this
+    // device's clock, and the engine runs in bridgeBuffer, a block of it at a time.
+    auto& output = *bufferToFill.buffer;
+
+    for (int done = 0; done < bufferToFill.numSamples;)
+    {
+        const auto numSamples = juce::jmin (bufferToFill.numSamples - done, bridgeBlockSize);
+
+        clockBridge.pullOutput (bridgeBuffer, 0, numSamples);
+        latencyProbe.captureInput (bridgeBuffer, 0, numSamples);
+        engine.process (bridgeBuffer, 0, numSamples);
+
+        for (int ch = 0; ch < juce::jmin (2, output.getNumChannels()); ++ch)
+            output.copyFrom (ch, bufferToFill.startSample + done, bridgeBuffer, ch, 0, numSamples);
+
+        done += numSamples;
     }
 }
 
@@ -285,6 +568,229 @@ void MainComponent::releaseResources()
     // Called when the audio device stops or restarts; I don't need to free anything here.
 }
 
+//==============================================================================
+void MainComponent::jackAboutToStart (double sampleRate, int bufferSize)
+{
+    engine.prepareToPlay (bufferSize, sampleRate, OrbitJackClient::maxInputPorts);
+    callbackMonitor.prepare (sampleRate, bufferSize);
+    loudnessMeter.prepare (sampleRate);
+}
+
+void MainComponent::jackProcess (const float* const* inputs, int numInputs, float* left, float* right, int numSamples)
+{
+    const juce::ScopedNoDenormals noDenormals;
+    const CallbackMonitor::ScopedCallback timing (callbackMonitor, numSamples);
+
+    // Straight from the input ports' buffers into the output ports', one source per port.
+    engine.processPorts (inputs, numInputs, left, right, numSamples);
+    loudnessMeter.push (left, right, numSamples);
+}
+
+bool MainComponent::startJackMode()
+{
+    if (bridging.load())
+    {
+        separateInputToggle.setToggleState (false, juce::dontSendNotification);
+        stopSeparateInput();
+    }
+
+    // One real-time thread runs the engine at a time, so the device stops before JACK starts.
+    deviceManager.closeAudioDevice();
+
+    const auto error = jackClient.open ((int) jackPortsSlider.getValue(), *this);
+    if (error.isNotEmpty())
+    {
+        deviceManager.restartLastAudioDevice();
+        juce::AlertWindow::showMessageBoxAsync (juce::MessageBoxIconType::WarningIcon, "JACK not started", error);
+        return false;
+    }
+
+    timingLog->logMessage (juce::Time::getCurrentTime().toISO8601 (true) + "  JACK client " + jackClient.getClientName()
+                           + ", " + juce::String (jackClient.getNumInputPorts()) + " input ports, "
+                           + juce::String (jackClient.getBufferSize()) + " samples at "
+                           + juce::String (jackClient.getSampleRate()) + " Hz");
+    saveAudioState();
+    return true;
+}
+
+void MainComponent::stopJackMode()
+{
+    jackClient.close();
+    deviceManager.restartLastAudioDevice();
+    saveAudioState();
+}
+
+void MainComponent::updateSourceControls()
+{
+    // Only the ambisonic bus applies to JACK's sources, so the port count takes the place
+    // of the HRIR loader.
+    const bool jack = jackClient.isOpen();
+    loadHrirButton.setVisible (! jack);
+    jackPortsLabel.setVisible (jack);
+    jackPortsSlider.setVisible (jack);
+
+    // The probe plays through the device's callback.
+    measureLatencyButton.setEnabled (! jack && ! latencyProbe.isRunning());
+    separateInputToggle.setEnabled (! jack);
+}
+
+//==============================================================================
+void MainComponent::BridgeInputCallback::audioDeviceAboutToStart (juce::AudioIODevice* device)
+{
+    bridge.prepareInput (device->getCurrentSampleRate(), device->getCurrentBufferSizeSamples(),
+                         device->getActiveInputChannels().countNumberOfSetBits());
+}
+
+void MainComponent::BridgeInputCallback::audioDeviceStopped()
+{
+    bridge.releaseInput();
+}
+
+void MainComponent::BridgeInputCallback::audioDeviceIOCallbackWithContext (const float* const* inputChannelData, int numInputChannels,
+                                                                           float* const* outputChannelData, int numOutputChannels,
+                                                                           int numSamples, const juce::AudioIODeviceCallbackContext&)
+{
+    bridge.pushInput (inputChannelData, numInputChannels, numSamples);
+
+    for (int ch = 0; ch < numOutputChannels; ++ch)
+        if (outputChannelData[ch] != nullptr)
+            juce::FloatVectorOperations::clear (outputChannelData[ch], numSamples);
+}
+
+bool MainComponent::startSeparateInput (const juce::String& inputName, bool reportErrors)
+{
+    auto* type = deviceManager.getCurrentDeviceTypeObject();
+    if (type == nullptr || inputName.isEmpty())
+        return false;
+
+    // The input gets as many channels as the device had (the engine's sources), two at least.
+    auto setup = deviceManager.getAudioDeviceSetup();
+    if (! bridging.load())
+        if (auto* device = deviceManager.getCurrentAudioDevice())
+            bridgeChannels = juce::jlimit (2, ClockBridge::maxChannels, device->getActiveInputChannels().countNumberOfSetBits());
+
+    inputDeviceManager.removeAudioCallback (&bridgeInputCallback);
+    inputDeviceManager.getAvailableDeviceTypes();   // scans, the first time
+    if (inputDeviceManager.getCurrentAudioDeviceType() != type->getTypeName())
+        inputDeviceManager.setCurrentAudioDeviceType (type->getTypeName(), true);
+
+    juce::AudioDeviceManager::AudioDeviceSetup inputSetup;
+    inputSetup.inputDeviceName = inputName;
+    inputSetup.useDefaultInputChannels = false;
+    inputSetup.inputChannels.setRange (0, bridgeChannels, true);
+    inputSetup.useDefaultOutputChannels = false;
+
+    auto error = inputDeviceManager.setAudioDeviceSetup (inputSetup, true);
+    if (error.isEmpty() && inputDeviceManager.getCurrentAudioDevice() == nullptr)
+        error = "The input device didn't open.";
+
+    if (error.isNotEmpty())
+    {
+        stopSeparateInput();
+        if (reportErrors)
+            juce::AlertWindow::showMessageBoxAsync (juce::MessageBoxIconType::WarningIcon, "Separate input not started", error);
+        return false;
+    }
+
+    // The main device goes output only; prepareToPlay() sees bridging and readies the bridge.
+    bridging = true;
+    setup.inputDeviceName = {};
+    setup.useDefaultInputChannels = false;
+    setup.inputChannels.clear();
+    deviceManager.setAudioDeviceSetup (setup, true);
+    inputDeviceManager.addAudioCallback (&bridgeInputCallback);
+
+    if (auto* input = inputDeviceManager.getCurrentAudioDevice())
+        timingLog->logMessage (juce::Time::getCurrentTime().toISO8601 (true) + "  separate input " + getDeviceName (*input)
+                               + ", " + juce::String (input->getActiveInputChannels().countNumberOfSetBits()) + " channels, "
+                               + juce::String (input->getCurrentBufferSizeSamples()) + " samples at "
+                               + juce::String (input->getCurrentSampleRate()) + " Hz");
+    saveAudioState();
+    return true;
+}
+
+void MainComponent::stopSeparateInput()
+{
+    inputDeviceManager.removeAudioCallback (&bridgeInputCallback);
+    const auto inputName = inputDeviceManager.getAudioDeviceSetup().inputDeviceName;
+    inputDeviceManager.closeAudioDevice();
+
+    if (bridging.exchange (false))
+    {
+        // Back to one device, with the same input as its own.
+        auto setup = deviceManager.getAudioDeviceSetup();
+        setup.inputDeviceName = inputName;
+        setup.useDefaultInputChannels = false;
+        setup.inputChannels.clear();
+        setup.inputChannels.setRange (0, bridgeChannels, true);
+        deviceManager.setAudioDeviceSetup (setup, true);
+        saveAudioState();
+    }
+}
+
+void MainComponent::updateSeparateInputDevices()
+{
+    const auto current = bridging.load() ? inputDeviceManager.getAudioDeviceSetup().inputDeviceName
+                                         : deviceManager.getAudioDeviceSetup().inputDeviceName;
+    separateInputCombo.clear (juce::dontSendNotification);
+
+    if (auto* type = deviceManager.getCurrentDeviceTypeObject())
+        separateInputCombo.addItemList (type->getDeviceNames (true), 1);
+
+    separateInputCombo.setText (current, juce::dontSendNotification);
+}
+
+//==============================================================================
+bool MainComponent::startHeadTracking (bool reportErrors)
+{
+    const int port = (int) headPortSlider.getValue();
+    const bool connected = headTracker.connect (port, *this);
+    headMeasurementsSeen = 0;
+
+    if (! connected && reportErrors)
+        juce::AlertWindow::showMessageBoxAsync (juce::MessageBoxIconType::WarningIcon, "Head tracking not started",
+                                                "Can't listen on UDP port " + juce::String (port)
+                                                + ". Is another program using it?");
+
+    timingLog->logMessage (juce::Time::getCurrentTime().toISO8601 (true) + "  head tracking "
+                           + (connected ? "listening on port " : "failed on port ") + juce::String (port));
+
+    parameters.headTracking = connected;
+    updateHeadPrediction();
+    publishParameters();
+    saveAudioState();
+    return connected;
+}
+
+void MainComponent::stopHeadTracking()
+{
+    headTracker.disconnect();
+    parameters.headTracking = false;
+    publishParameters();
+    saveAudioState();
+}
+
+void MainComponent::updateHeadPrediction()
+{
+    // The engine adds its own latency; I add the device's output latency and the tracker's.
+    float predictionMs = trackerLatencyMs;
+    if (auto* device = deviceManager.getCurrentAudioDevice(); device != nullptr && ! jackClient.isOpen())
+        if (const auto rate = device->getCurrentSampleRate(); rate > 0.0)
+            predictionMs += (float) (1000.0 * device->getOutputLatencyInSamples() / rate);
+
+    if (std::abs (predictionMs - parameters.headPredictionMs) > 0.1f)
+    {
+        parameters.headPredictionMs = predictionMs;
+        publishParameters();
+    }
+}
+
+void MainComponent::headPoseReceived (const HeadPose& pose)
+{
+    // The tracker's thread is the engine's only head-pose writer.
+    engine.setHeadPose (pose);
+}
+
 //==============================================================================
 void MainComponent::paint (juce::Graphics& g)
 {
@@ -297,12 +803,23 @@ void MainComponent::resized()
 
     auto header = area.removeFromTop (28);
     audioSettingsToggle.setBounds (header.removeFromLeft (110).reduced (0, 4));
+    autoBufferToggle.setBounds (header.removeFromLeft (130).reduced (0, 4));
     quitButton.setBounds (header.removeFromRight (60).reduced (0, 4));
+    measureLatencyButton.setBounds (header.removeFromRight (124).reduced (4, 4));
 
     if (audioSettingsExpanded)
     {
         auto deviceArea = area.removeFromTop (340);
         audioDeviceSelector.setBounds (deviceArea);
+
+        auto bridgeRow = area.removeFromTop (32);
+        separateInputToggle.setBounds (bridgeRow.removeFromLeft (160).reduced (0, 4));
+        separateInputCombo.setBounds (bridgeRow.removeFromLeft (260).reduced (4));
+
+        auto headRow = area.removeFromTop (32);
+        headTrackingToggle.setBounds (headRow.removeFromLeft (160).reduced (0, 4));
+        headRow.removeFromLeft (40);    // the port label
+        headPortSlider.setBounds (headRow.removeFromLeft (130).reduced (4));
     }
 
     auto controls = area;
@@ -316,16 +833,28 @@ void MainComponent::resized()
     orbitModeCombo.setBounds (row1.removeFromLeft (110).reduced (4, 8));
     panSpeedSlider.setBounds (row1.reduced (4, 8));
 
-    auto row2 = controls.removeFromTop (rowH);
+    auto sourcesRow = controls.removeFromTop (rowH);
+    sourceLayoutCombo.setBounds (sourcesRow.removeFromLeft (200).reduced (4));
+    headModelCombo.setBounds (sourcesRow.removeFromLeft (170).reduced (4));
+    auto jackArea = sourcesRow;
+    loadHrirButton.setBounds (sourcesRow.removeFromLeft (110).reduced (4));
+    jackPortsLabel.setBounds (jackArea.removeFromLeft (44));
+    jackPortsSlider.setBounds (jackArea.removeFromLeft (126).reduced (4));
+
+    // The radar sits to the right of the four head-model rows.
+    auto headModelRows = controls.removeFromTop (4 * rowH);
+    orbitRadarView.setBounds (headModelRows.removeFromRight (4 * rowH - 8));
+
+    auto row2 = headModelRows.removeFromTop (rowH);
     itdAmountSlider.setBounds (row2.reduced (labelWidth, 4));
 
-    auto row3 = controls.removeFromTop (rowH);
+    auto row3 = headModelRows.removeFromTop (rowH);
     shadowStrengthSlider.setBounds (row3.reduced (labelWidth, 4));
 
-    auto row4 = controls.removeFromTop (rowH);
+    auto row4 = headModelRows.removeFromTop (rowH);
     depthSlider.setBounds (row4.reduced (labelWidth, 4));
 
-    auto row5 = controls.removeFromTop (rowH);
+    auto row5 = headModelRows.removeFromTop (rowH);
     widthSlider.setBounds (row5.reduced (labelWidth, 4));
 
     auto row6 = controls.removeFromTop (rowH);
@@ -336,151 +865,244 @@ void MainComponent::resized()
 #endif
     reverbToggle.setBounds (row6.removeFromLeft (70).reduced (2, 4));
     reverbWetSlider.setBounds (row6.reduced (labelWidth, 4));
+
+    loudnessMeterView.setBounds (controls.removeFromTop (40).reduced (4, 2));
+    callbackStatsLabel.setBounds (controls.removeFromTop (24));
+}
+
+void MainComponent::timerCallback()
+{
+    if (jackClient.wasShutDown())
+    {
+        sourceLayoutCombo.setSelectedId (parameters.sourceLayout + 1, juce::dontSendNotification);
+        stopJackMode();
+        updateSourceControls();
+        timingLog->logMessage (juce::Time::getCurrentTime().toISO8601 (true) + "  JACK server shut down");
+        juce::AlertWindow::showMessageBoxAsync (juce::MessageBoxIconType::WarningIcon, "JACK stopped",
+                                                "The JACK server went away. OrbitAudio is back on the audio device.");
+    }
+
+    callbackMonitor.collect();
+    if (jackClient.isOpen())
+        callbackMonitor.setDeviceXRunCount (jackClient.getXRunCount());
+    else if (auto* device = deviceManager.getCurrentAudioDevice())
+        callbackMonitor.setDeviceXRunCount (device->getXRunCount());
+
+    finishLatencyMeasurement();
+
+    // The output latency the listener hears: the device's own plus the limiter's lookahead.
+    // With a measurement for this device and setup, the measured input-to-output latency.
+    juce::String latencyText;
+    if (jackClient.isOpen())
+        latencyText = ", JACK " + juce::String (jackClient.getNumInputPorts()) + " input ports";
+    else if (auto* device = deviceManager.getCurrentAudioDevice())
+    {
+        if (latencyMeasurement.matches (getDeviceName (*device), device->getCurrentSampleRate(),
+                                        device->getCurrentBufferSizeSamples()))
+            latencyText = ", through latency " + juce::String (latencyMeasurement.toMs (latencyMeasurement.getThroughSamples()), 1)
+                        + " ms (measured)";
+        else if (const auto rate = device->getCurrentSampleRate(); rate > 0.0)
+            latencyText = ", out latency " + juce::String (1000.0 * (device->getOutputLatencyInSamples()
+                                                                   + engine.getLatencySamples()) / rate, 1) + " ms";
+    }
+
+    if (bridging.load())
+        latencyText << ", " << clockBridge.getStats().toString();
+
+    if (headTracker.isConnected())
+    {
+        const int measurements = headTracker.getNumMeasurements();
+        latencyText << ", head " << (measurements - headMeasurementsSeen) * statsTimerHz << "/s";
+        headMeasurementsSeen = measurements;
+        updateHeadPrediction();
+    }
+
+    const auto stats = callbackMonitor.getStats();
+    callbackStatsLabel.setText ("Callback " + stats.toString() + latencyText, juce::dontSendNotification);
+    if (stats.getNumProblems() > 0)
+        callbackStatsLabel.setColour (juce::Label::textColourId, juce::Colours::orange);
+    else
+        callbackStatsLabel.removeColour (juce::Label::textColourId);
+
+    adaptBufferSize (stats);
+
+    // I log every logIntervalTicks, and straight away when a new xrun shows up. The
+    // totals restart with the device, so I follow them down too.
+    loggedProblems = juce::jmin (loggedProblems, stats.getNumProblems());
+    const bool newProblems = stats.getNumProblems() > loggedProblems;
+
+    if (++ticksSinceLog < logIntervalTicks && ! newProblems)
+        return;
+
+    ticksSinceLog = 0;
+    loggedProblems = stats.getNumProblems();
+
+    const auto interval = callbackMonitor.takeIntervalStats();
+    if (interval.numCallbacks > 0 || newProblems)
+        timingLog->logMessage (juce::Time::getCurrentTime().toISO8601 (true) + "  "
+                               + juce::String (interval.numCallbacks) + " callbacks, " + interval.toString()
+                               + ", worst margin " + juce::String (interval.worstMarginMs, 2) + " ms"
+                               + ", min fill " + juce::String (juce::roundToInt (100.0 * interval.minFill)) + "%"
+                               + (newProblems ? "  [xrun]" : ""));
+}
+
+void MainComponent::adaptBufferSize (const CallbackMonitor::Stats& stats)
+{
+    // A measurement needs the device to hold still.
+    auto* device = deviceManager.getCurrentAudioDevice();
+    if (device == nullptr || ! autoBufferToggle.getToggleState() || latencyProbe.isRunning())
+        return;
+
+    const auto now = juce::Time::getMillisecondCounterHiRes() * 0.001;
+    const auto deviceName = getDeviceName (*device);
+
+    // A new device, or a size picked by hand in the settings: I start over from there.
+    if (deviceName != controlledDeviceName
+         || device->getCurrentBufferSizeSamples() != bufferSizeController.getCurrentBufferSize())
+    {
+        if (deviceName != controlledDeviceName)
+            bufferSizeController.setAvailableBufferSizes (device->getAvailableBufferSizes());
+
+        controlledDeviceName = deviceName;
+        bufferSizeController.start (device->getCurrentBufferSizeSamples(), now);
+        return;
+    }
+
+    const auto decision = bufferSizeController.update (stats, now);
+    if (! decision.changesSize())
+        return;
+
+    // The device restarts at the new size, and the change listener saves it, so the next
+    // launch starts from where this one got to.
+    auto setup = deviceManager.getAudioDeviceSetup();
+    setup.bufferSize = decision.bufferSize;
+    const auto error = deviceManager.setAudioDeviceSetup (setup, true);
+
+    timingLog->logMessage (juce::Time::getCurrentTime().toISO8601 (true) + "  buffer size -> "
+                           + juce::String (decision.bufferSize) + " samples, " + decision.reason
+                           + (error.isNotEmpty() ? "  [failed: " + error + "]" : ""));
+
+    if (auto* restarted = deviceManager.getCurrentAudioDevice())
+        bufferSizeController.start (restarted->getCurrentBufferSizeSamples(), now);
+}
+
+void MainComponent::finishLatencyMeasurement()
+{
+    const auto result = latencyProbe.takeResult();
+    if (! result.has_value())
+        return;
+
+    updateSourceControls();
+    auto* device = deviceManager.getCurrentAudioDevice();
+
+    if (result->roundTripSamples < 0 || device == nullptr)
+    {
+        timingLog->logMessage (juce::Time::getCurrentTime().toISO8601 (true) + "  latency measurement failed, confidence "
+                               + juce::String (result->confidence, 2));
+        juce::AlertWindow::showMessageBoxAsync (juce::MessageBoxIconType::WarningIcon, "Latency not measured",
+                                                "The test burst didn't come back on the input. Check that the output "
+                                                "is routed back to the input, that the input is enabled in the audio "
+                                                "settings and that nothing else is playing.");
+        return;
+    }
+
+    LatencyProbe::Measurement m;
+    m.deviceName = getDeviceName (*device);
+    m.sampleRate = device->getCurrentSampleRate();
+    m.bufferSize = device->getCurrentBufferSizeSamples();
+    m.roundTripSamples = result->roundTripSamples;
+    m.inputSamples = device->getInputLatencyInSamples();
+    m.outputSamples = device->getOutputLatencyInSamples();
+    m.dspSamples = engine.getLatencySamples();
+    m.confidence = result->confidence;
+    m.time = juce::Time::getCurrentTime();
+
+    latencyMeasurement = m;
+    saveAudioState();
+
+    timingLog->logMessage (m.time.toISO8601 (true) + "  latency " + m.toString());
+    juce::AlertWindow::showMessageBoxAsync (juce::MessageBoxIconType::InfoIcon, "Latency measured",
+                                            m.toString().replace ("; ", "\n").replace (": ", ":\n"));
+}
+
+juce::String MainComponent::getDeviceName (juce::AudioIODevice& device)
+{
+    return device.getTypeName() + "/" + device.getName();
 }
 
 //==============================================================================
-juce::File MainComponent::getPresetsDirectory()
+bool MainComponent::loadHrirFolder (const juce::File& folder, bool reportErrors)
 {
-    // I store presets under ~/Library/Application Support/OrbitAudio/Presets/.
-    auto dir = juce::File::getSpecialLocation (juce::File::userApplicationDataDirectory)
-                   .getChildFile ("OrbitAudio")
-                   .getChildFile ("Presets");
-    if (! dir.exists())
-        dir.createDirectory();
-    return dir;
+    auto set = std::make_shared<HrirSet>();
+    const auto result = set->loadFromFolder (folder);
+
+    if (result.failed())
+    {
+        if (reportErrors)
+            juce::AlertWindow::showMessageBoxAsync (juce::MessageBoxIconType::WarningIcon,
+                                                    "HRIR set not loaded", result.getErrorMessage());
+        return false;
+    }
+
+    engine.setHrirSet (std::move (set));
+    return true;
 }
 
 juce::ValueTree MainComponent::getCurrentStateAsValueTree()
 {
-    juce::ValueTree vt ("OrbitAudioPreset");
-    vt.setProperty ("pan", (double) panValue.load(), nullptr);
-    vt.setProperty ("orbitMode", orbitMode.load(), nullptr);
-    vt.setProperty ("panSpeedHz", (double) panSpeedHz.load(), nullptr);
-    vt.setProperty ("itdAmount", (double) itdAmount.load(), nullptr);
-    vt.setProperty ("shadowStrength", (double) shadowStrength.load(), nullptr);
-    vt.setProperty ("depth", (double) depth.load(), nullptr);
-    vt.setProperty ("width", (double) width.load(), nullptr);
-    vt.setProperty ("reverbWet", (double) reverbWet.load(), nullptr);
-    return vt;
+    auto preset = parameters.toPreset();
+    preset.trajectory = trajectory;
+    return preset.toValueTree();
 }
 
 void MainComponent::applyValueTreeToState (const juce::ValueTree& vt)
 {
     if (! vt.isValid()) return;
-    double pan = vt.getProperty ("pan", 0.0);
-    int orbMode = vt.getProperty ("orbitMode", 0);
-    if (vt.getProperty ("autoPan", false)) orbMode = 1;
-    double speed = vt.getProperty ("panSpeedHz", 0.05);
-    double itd = vt.getProperty ("itdAmount", 1.0);
-    double shadow = vt.getProperty ("shadowStrength", 1.0);
-    double dep = vt.getProperty ("depth", 0.0);
-    double wid = vt.getProperty ("width", 1.0);
-    double rvbWet = vt.getProperty ("reverbWet", 0.33);
-
-    panValue.store ((float) pan);
-    panSlider.setValue (pan, juce::dontSendNotification);
-    orbitMode.store (orbMode);
-    orbitModeCombo.setSelectedId (orbMode + 1, juce::dontSendNotification);
-    panSlider.setEnabled (orbMode == 0);
-    panSpeedHz.store ((float) speed);
-    panSpeedSlider.setValue (speed, juce::dontSendNotification);
-    itdAmount.store ((float) itd);
-    itdAmountSlider.setValue (itd, juce::dontSendNotification);
-    spatializer.setItdAmount ((float) itd);
-    shadowStrength.store ((float) shadow);
-    shadowStrengthSlider.setValue (shadow, juce::dontSendNotification);
-    spatializer.setShadowStrength ((float) shadow);
-    depth.store ((float) dep);
-    depthSlider.setValue (dep, juce::dontSendNotification);
-    spatializer.setDepth ((float) dep);
-    width.store ((float) wid);
-    widthSlider.setValue (wid, juce::dontSendNotification);
-    spatializer.setWidth ((float) wid);
-    reverbWet.store ((float) rvbWet);
-    reverbWetSlider.setValue (rvbWet, juce::dontSendNotification);
-    auto params = reverb.getParameters();
-    params.wetLevel = (float) rvbWet;
-    reverb.setParameters (params);
+    const auto preset = OrbitPreset::fromValueTree (vt);
+
+    // I build the whole new state first and publish it once, so the switch is atomic.
+    auto next = OrbitEngine::Parameters::fromPreset (preset);
+    next.reverbEnabled = parameters.reverbEnabled;
+    next.headTracking = parameters.headTracking;
+    next.headPredictionMs = parameters.headPredictionMs;
+
+    // Built-in presets don't carry a source layout, so I keep the current routing for them.
+    if (! vt.hasProperty ("sourceLayout"))
+        next.sourceLayout = parameters.sourceLayout;
+    if (! vt.hasProperty ("headModel"))
+        next.useHrtf = parameters.useHrtf;
+    if (! vt.hasProperty ("ambisonicOrder"))
+        next.ambisonicOrder = parameters.ambisonicOrder;
+
+    parameters = next;
+    trajectory = preset.trajectory;
+    publishParameters();
+
+    panSlider.setValue (preset.pan, juce::dontSendNotification);
+    orbitModeCombo.setSelectedId (preset.orbitMode + 1, juce::dontSendNotification);
+    panSlider.setEnabled (preset.orbitMode == 0);
+    sourceLayoutCombo.setSelectedId (jackClient.isOpen() ? jackLayoutId : parameters.sourceLayout + 1,
+                                     juce::dontSendNotification);
+    headModelCombo.setSelectedId (parameters.ambisonicOrder > 0 ? parameters.ambisonicOrder + 2
+                                                                : parameters.useHrtf ? 2 : 1,
+                                  juce::dontSendNotification);
+    panSpeedSlider.setValue (preset.panSpeedHz, juce::dontSendNotification);
+    itdAmountSlider.setValue (preset.itdAmount, juce::dontSendNotification);
+    shadowStrengthSlider.setValue (preset.shadowStrength, juce::dontSendNotification);
+    depthSlider.setValue (preset.depth, juce::dontSendNotification);
+    widthSlider.setValue (preset.width, juce::dontSendNotification);
+    reverbWetSlider.setValue (preset.reverbWet, juce::dontSendNotification);
 }
 
-void MainComponent::loadPreset (const juce::String& presetName)
+void MainComponent::publishParameters()
 {
-    // I reset to neutral values for Default; otherwise I load from file or use built-ins.
-    if (presetName == "Default")
-    {
-        panValue.store (0.0f);
-        panSlider.setValue (0.0, juce::dontSendNotification);
-        orbitMode.store (0);
-        orbitModeCombo.setSelectedId (1, juce::dontSendNotification);
-        panSlider.setEnabled (true);
-        panSpeedHz.store (0.05f);
-        panSpeedSlider.setValue (0.05, juce::dontSendNotification);
-        itdAmount.store (1.0f);
-        itdAmountSlider.setValue (1.0, juce::dontSendNotification);
-        spatializer.setItdAmount (1.0f);
-        shadowStrength.store (1.0f);
-        shadowStrengthSlider.setValue (1.0, juce::dontSendNotification);
-        spatializer.setShadowStrength (1.0f);
-        depth.store (0.0f);
-        depthSlider.setValue (0.0, juce::dontSendNotification);
-        spatializer.setDepth (0.0f);
-        width.store (1.0f);
-        widthSlider.setValue (1.0, juce::dontSendNotification);
-        spatializer.setWidth (1.0f);
-        reverbWet.store (0.33f);
-        reverbWetSlider.setValue (0.33, juce::dontSendNotification);
-        auto params = reverb.getParameters();
-        params.wetLevel = 0.33f;
-        reverb.setParameters (params);
-        return;
-    }
-
-    juce::File file = getPresetsDirectory().getChildFile (presetName + ".xml");
-    if (file.existsAsFile())
-    {
-        if (auto xml = juce::parseXML (file))
-        {
-            juce::ValueTree vt = juce::ValueTree::fromXml (*xml);
-            applyValueTreeToState (vt);
-            return;
-        }
-    }
+    engine.setParameters (parameters);
+}
 
-    juce::ValueTree vt ("OrbitAudioPreset");
-    if (presetName == "Orbit")
-    {
-        vt.setProperty ("pan", 0.0, nullptr);
-        vt.setProperty ("orbitMode", 1, nullptr);
-        vt.setProperty ("panSpeedHz", 0.05, nullptr);
-        vt.setProperty ("itdAmount", 1.0, nullptr);
-        vt.setProperty ("shadowStrength", 1.0, nullptr);
-        vt.setProperty ("depth", 0.0, nullptr);
-        vt.setProperty ("width", 1.0, nullptr);
-        vt.setProperty ("reverbWet", 0.33, nullptr);
-    }
-    else if (presetName == "Wide")
-    {
-        vt.setProperty ("pan", 0.0, nullptr);
-        vt.setProperty ("orbitMode", 0, nullptr);
-        vt.setProperty ("panSpeedHz", 0.05, nullptr);
-        vt.setProperty ("itdAmount", 0.5, nullptr);
-        vt.setProperty ("shadowStrength", 0.5, nullptr);
-        vt.setProperty ("depth", 0.0, nullptr);
-        vt.setProperty ("width", 1.0, nullptr);
-        vt.setProperty ("reverbWet", 0.33, nullptr);
-    }
-    else if (presetName == "Narrow")
-    {
-        vt.setProperty ("pan", 0.0, nullptr);
-        vt.setProperty ("orbitMode", 2, nullptr);
-        vt.setProperty ("panSpeedHz", 0.1, nullptr);
-        vt.setProperty ("itdAmount", 1.0, nullptr);
-        vt.setProperty ("shadowStrength", 1.0, nullptr);
-        vt.setProperty ("depth", 0.2, nullptr);
-        vt.setProperty ("width", 0.7, nullptr);
-        vt.setProperty ("reverbWet", 0.25, nullptr);
-    }
-    applyValueTreeToState (vt);
+void MainComponent::loadPreset (const juce::String& presetName)
+{
+    // I load from file, or fall back to the built-in values (Default is always built in).
+    applyValueTreeToState (OrbitPreset::load (presetName));
 }
 
 void MainComponent::savePreset (const juce::String& presetName)
@@ -488,25 +1110,71 @@ void MainComponent::savePreset (const juce::String& presetName)
     if (presetName == "Default") return;
     juce::ValueTree vt = getCurrentStateAsValueTree();
     vt.setProperty ("name", presetName, nullptr);
-    juce::File file = getPresetsDirectory().getChildFile (presetName + ".xml");
+    juce::File file = OrbitPreset::getPresetsDirectory().getChildFile (presetName + ".xml");
     if (auto xml = vt.createXml())
         xml->writeTo (file);
 }
 
 juce::File MainComponent::getAudioStateFile()
 {
-    return getPresetsDirectory().getParentDirectory().getChildFile ("audioDeviceState.xml");
+    return OrbitPreset::getPresetsDirectory().getParentDirectory().getChildFile ("audioDeviceState.xml");
 }
 
 void MainComponent::changeListenerCallback (juce::ChangeBroadcaster*)
 {
-    if (auto xml = deviceManager.createStateXml())
-        xml->writeTo (getAudioStateFile());
+    if (audioSettingsExpanded)
+        updateSeparateInputDevices();
+
+    saveAudioState();
+}
+
+void MainComponent::saveAudioState()
+{
+    // With JACK running there may be no device setup to save, but the JACK settings still are.
+    auto xml = deviceManager.createStateXml();
+    if (xml == nullptr && ! OrbitJackClient::isAvailable())
+        return;
+
+    if (xml == nullptr)
+        xml = std::make_unique<juce::XmlElement> ("DEVICESETUP");
+
+    if (auto* old = xml->getChildByName ("JACKCLIENT"))
+        xml->removeChildElement (old, true);
+
+    if (OrbitJackClient::isAvailable())
+    {
+        auto* jack = xml->createNewChildElement ("JACKCLIENT");
+        jack->setAttribute ("enabled", jackClient.isOpen());
+        jack->setAttribute ("inputPorts", (int) jackPortsSlider.getValue());
+    }
+
+    if (auto* old = xml->getChildByName ("CLOCKBRIDGE"))
+        xml->removeChildElement (old, true);
+
+    auto* bridge = xml->createNewChildElement ("CLOCKBRIDGE");
+    bridge->setAttribute ("enabled", bridging.load());
+    bridge->setAttribute ("inputDevice", inputDeviceManager.getAudioDeviceSetup().inputDeviceName);
+
+    if (auto* old = xml->getChildByName ("HEADTRACKER"))
+        xml->removeChildElement (old, true);
+
+    auto* head = xml->createNewChildElement ("HEADTRACKER");
+    head->setAttribute ("enabled", headTracker.isConnected());
+    head->setAttribute ("port", (int) headPortSlider.getValue());
+
+    // The latency measurement rides along with the device state, for tools that sync to us.
+    if (auto* old = xml->getChildByName (LatencyProbe::Measurement::xmlTag))
+        xml->removeChildElement (old, true);
+
+    if (latencyMeasurement.isValid())
+        xml->addChildElement (latencyMeasurement.toXml().release());
+
+    xml->writeTo (getAudioStateFile());
 }
 
 juce::Point<int> MainComponent::getPreferredSize() const
 {
-    return { 540, audioSettingsExpanded ? 660 : 380 };
+    return { 540, audioSettingsExpanded ? 780 : 436 };
 }
 
 void MainComponent::setOnPreferredSizeChanged (std::function<void()> callback)
@@ -2,14 +2,37 @@
 
 #include <JuceHeader.h>
 #include <juce_audio_utils/juce_audio_utils.h>
-#include "Spatializer.h"
+#include "OrbitEngine.h"
+#include "CallbackMonitor.h"
+#include "BufferSizeController.h"
+#include "LatencyProbe.h"
+#include "OrbitJackClient.h"
+#include "ClockBridge.h"
+#include "HeadTracker.h"
+#include "LoudnessMeterView.h"
+#include "OrbitRadarView.h"
 
 //==============================================================================
 // I host the main UI and audio: device selector, spatializer controls, presets,
-// reverb, and a "Run tests" button. The Spatializer does the DSP; I only pass
-// parameters and run the reverb when enabled.
+// reverb, and a "Run tests" button. The OrbitEngine does the DSP; I only pass it
+// parameters. A CallbackMonitor times every callback; I show its numbers under the
+// controls and append them to OrbitAudio/CallbackTiming.log. A LoudnessMeter measures
+// the output, and its view shows levels and loudness above the timing line. The radar
+// beside the head-model sliders shows where the source is, from the engine's position ring.
+// With "Auto buffer size" on, a BufferSizeController moves the device buffer up on xruns
+// and back down when it has run clean for a while, and I log each move. "Measure latency"
+// times the round trip with a LatencyProbe and saves the result in audioDeviceState.xml.
+// Where JACK is available, the "JACK ports" source layout closes the device and runs the
+// engine from an OrbitJackClient instead, one source per input port. "Separate input clock"
+// opens the input as a device of its own and resamples it to the output's clock with a
+// ClockBridge, for an input and an output that don't share a crystal. "Head tracking"
+// listens for a tracker's OSC on a local UDP port with a HeadTracker and hands each pose
+// to the engine, which counter-rotates the scene with it.
 class MainComponent  : public juce::AudioAppComponent,
-                       public juce::ChangeListener
+                       public juce::ChangeListener,
+                       private juce::Timer,
+                       private OrbitJackClient::Callback,
+                       private HeadTracker::Callback
 {
 public:
     //==============================================================================
@@ -30,50 +53,135 @@ public:
 
 private:
     //==============================================================================
-    // I use atomics for values the audio thread reads so the UI can update them lock-free.
+    // I keep every setting in one Parameters struct on the message thread and publish a
+    // copy of the whole thing to the engine after each change, so the audio thread never
+    // sees half of an edit (or half of a preset).
+    OrbitEngine::Parameters parameters;
+    void publishParameters();
+
+    // The trajectory Path mode follows, from the last preset loaded; parameters only hold
+    // it compiled, so I keep it to save it back.
+    OrbitTrajectory trajectory;
 
     juce::AudioDeviceSelectorComponent audioDeviceSelector;
     juce::Label panLabel;
     juce::Slider panSlider;
-    std::atomic<float> panValue { 0.0f };
 
     juce::Slider panSpeedSlider;
-    std::atomic<float> panSpeedHz { 0.05f };
 
     juce::Slider itdAmountSlider;
     juce::Label itdAmountLabel;
-    std::atomic<float> itdAmount { 1.0f };
     juce::Slider shadowStrengthSlider;
     juce::Label shadowStrengthLabel;
-    std::atomic<float> shadowStrength { 1.0f };
 
     juce::Slider depthSlider;
     juce::Label depthLabel;
-    std::atomic<float> depth { 0.0f };
     juce::Slider widthSlider;
     juce::Label widthLabel;
-    std::atomic<float> width { 1.0f };
 
     juce::ComboBox orbitModeCombo;
-    std::atomic<int> orbitMode { 0 };
+
+    // Stereo source (channels 1/2), stereo pairs (every pair is a source) or mono channels,
+    // plus JACK ports where JACK is available.
+    juce::ComboBox sourceLayoutCombo;
+    static constexpr int jackLayoutId = 4;
+
+    // Parametric head model (ITD + shadow) or measured HRTF for the stereo source.
+    juce::ComboBox headModelCombo;
+    juce::TextButton loadHrirButton { "Load HRIRs..." };
+    std::unique_ptr<juce::FileChooser> hrirChooser;
 
     juce::ToggleButton audioSettingsToggle { "Audio settings" };
+    juce::ToggleButton autoBufferToggle { "Auto buffer size" };
     bool audioSettingsExpanded { false };
 
     juce::ComboBox presetCombo;
     juce::TextButton savePresetButton { "Save preset" };
     juce::TextButton quitButton { "Quit" };
+    juce::TextButton measureLatencyButton { "Measure latency" };
     juce::TextButton runTestsButton { "Run tests" };
     juce::ToggleButton reverbToggle { "" };
-    std::atomic<bool> reverbEnabled { false };
     juce::Slider reverbWetSlider;
     juce::Label reverbWetLabel;
-    std::atomic<float> reverbWet { 0.33f };
-
-    Spatializer spatializer;
-    juce::Reverb reverb;
 
-    juce::File getPresetsDirectory();
+    OrbitEngine engine;
+    OrbitRadarView orbitRadarView { engine };
+
+    LoudnessMeter loudnessMeter;
+    LoudnessMeterView loudnessMeterView { loudnessMeter };
+
+    CallbackMonitor callbackMonitor;
+    juce::Label callbackStatsLabel;
+    std::unique_ptr<juce::FileLogger> timingLog;
+    int ticksSinceLog = 0;
+    int loggedProblems = 0;
+    static constexpr int statsTimerHz = 4;
+    static constexpr int logIntervalTicks = 10 * statsTimerHz;   // a log line every 10 s
+
+    BufferSizeController bufferSizeController;
+    juce::String controlledDeviceName;   // empty until the controller follows a device
+
+    void timerCallback() override;
+    void adaptBufferSize (const CallbackMonitor::Stats& stats);
+
+    LatencyProbe latencyProbe;
+    LatencyProbe::Measurement latencyMeasurement;   // the last one, loaded with the device state
+    void finishLatencyMeasurement();
+    static juce::String getDeviceName (juce::AudioIODevice& device);
+
+    // JACK mode: the device is closed and JACK calls jackProcess() instead of the device
+    // calling getNextAudioBlock(). The port count takes the head-model controls' place.
+    OrbitJackClient jackClient;
+    juce::Label jackPortsLabel;
+    juce::Slider jackPortsSlider;
+    bool startJackMode();
+    void stopJackMode();
+    void updateSourceControls();
+    void jackAboutToStart (double sampleRate, int bufferSize) override;
+    void jackProcess (const float* const* inputs, int numInputs, float* left, float* right, int numSamples) override;
+
+    // Separate input clock: a second AudioDeviceManager runs the input device alone and
+    // feeds the bridge; the main device opens output only and pulls from it.
+    struct BridgeInputCallback  : public juce::AudioIODeviceCallback
+    {
+        explicit BridgeInputCallback (ClockBridge& b) : bridge (b) {}
+
+        void audioDeviceAboutToStart (juce::AudioIODevice* device) override;
+        void audioDeviceStopped() override;
+        void audioDeviceIOCallbackWithContext (const float* const* inputChannelData, int numInputChannels,
+                                               float* const* outputChannelData, int numOutputChannels,
+                                               int numSamples, const juce::AudioIODeviceCallbackContext&) override;
+        ClockBridge& bridge;
+    };
+
+    ClockBridge clockBridge;
+    juce::AudioDeviceManager inputDeviceManager;
+    BridgeInputCallback bridgeInputCallback { clockBridge };
+    juce::ToggleButton separateInputToggle { "Separate input clock" };
+    juce::ComboBox separateInputCombo;
+    std::atomic<bool> bridging { false };
+    int bridgeChannels = 2;
+    static constexpr int bridgeBlockSize = 512;
+    juce::AudioBuffer<float> bridgeBuffer { ClockBridge::maxChannels, bridgeBlockSize };
+    bool startSeparateInput (const juce::String& inputName, bool reportErrors);
+    void stopSeparateInput();
+    void updateSeparateInputDevices();
+    void processBridgedInput (const juce::AudioSourceChannelInfo& bufferToFill);
+
+    // Head tracking: the tracker's thread hands poses straight to the engine. The prediction
+    // covers the device's output latency, which I follow from the timer.
+    HeadTracker headTracker;
+    juce::ToggleButton headTrackingToggle { "Head tracking" };
+    juce::Label headPortLabel;
+    juce::Slider headPortSlider;
+    int headMeasurementsSeen = 0;
+    static constexpr float trackerLatencyMs = 10.0f;   // a typical sensor's, on top of the device's
+    bool startHeadTracking (bool reportErrors);
+    void stopHeadTracking();
+    void updateHeadPrediction();
+    void headPoseReceived (const HeadPose& pose) override;
+
+    bool loadHrirFolder (const juce::File& folder, bool reportErrors);
     juce::ValueTree getCurrentStateAsValueTree();
     void applyValueTreeToState (const juce::ValueTree& vt);
     void loadPreset (const juce::String& presetName);
@@ -82,6 +190,7 @@ private:
     void changeListenerCallback (juce::ChangeBroadcaster* source) override;
 
     juce::File getAudioStateFile();
+    void saveAudioState();
     void tryPreferLowLatencyBuffer();
 
     std::function<void()> onPreferredSizeChanged;
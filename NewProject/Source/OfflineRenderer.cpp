@@ -0,0 +1,178 @@
+#include "OfflineRenderer.h"
+
+//==============================================================================
+OfflineRenderer::OfflineRenderer (Settings s)
+    : settings (std::move (s))
+{
+    jassert (settings.blockSize > 0);
+    formatManager.registerBasicFormats();
+}
+
+juce::String OfflineRenderer::getReadableWildcard() const
+{
+    return formatManager.getWildcardForAllFormats();
+}
+
+bool OfflineRenderer::canWrite (const juce::File& output)
+{
+    return output.hasFileExtension ("wav;flac");
+}
+
+//==============================================================================
+OfflineRenderer::Report OfflineRenderer::renderFile (const Job& job)
+{
+    Report report;
+    report.job = job;
+
+    if (! canWrite (job.output))
+    {
+        report.result = juce::Result::fail ("Can't write " + job.output.getFileName() + ": use .wav or .flac");
+        return report;
+    }
+
+    std::unique_ptr<juce::AudioFormatReader> reader (formatManager.createReaderFor (job.input));
+    if (reader == nullptr)
+    {
+        report.result = juce::Result::fail ("Can't read " + job.input.getFullPathName());
+        return report;
+    }
+
+    const double sampleRate = reader->sampleRate;
+    const int fileChannels = (int) reader->numChannels;
+
+    // Write to a temporary file and move it into place only once it's complete, so a
+    // failed or interrupted render never leaves a truncated file behind.
+    juce::TemporaryFile temp (job.output);
+    std::unique_ptr<juce::AudioFormatWriter> writer;
+    {
+        std::unique_ptr<juce::OutputStream> stream = temp.getFile().createOutputStream();
+        if (stream == nullptr)
+        {
+            report.result = juce::Result::fail ("Can't create " + job.output.getFullPathName());
+            return report;
+        }
+
+        const bool isFlac = job.output.hasFileExtension ("flac");
+        const auto options = juce::AudioFormatWriterOptions{}
+                                 .withSampleRate (sampleRate)
+                                 .withNumChannels (2)
+                                 .withBitsPerSample (isFlac ? juce::jmin (24, settings.bitsPerSample) : settings.bitsPerSample)
+                                 .withSampleFormat (settings.bitsPerSample == 32
+                                                        ? juce::AudioFormatWriterOptions::SampleFormat::floatingPoint
+                                                        : juce::AudioFormatWriterOptions::SampleFormat::integral);
+
+        std::unique_ptr<juce::AudioFormat> format;
+        if (isFlac) format = std::make_unique<juce::FlacAudioFormat>();
+        else        format = std::make_unique<juce::WavAudioFormat>();
+
+        writer = format->createWriterFor (stream, options);
+        if (writer == nullptr)
+        {
+            report.result = juce::Result::fail ("Can't write " + juce::String (settings.bitsPerSample)
+                                                + "-bit " + format->getFormatName() + " at " + juce::String (sampleRate) + " Hz");
+            return report;
+        }
+    }
+
+    const auto startTicks = juce::Time::getHighResolutionTicks();
+    const juce::ScopedNoDenormals noDenormals;
+
+    // Multi-source layouts see every channel; the stereo source sees the first two, with
+    // a mono file feeding both ears.
+    const int numInputs = juce::jlimit (1, SpatializerBank::maxSources, fileChannels);
+    auto parameters = OrbitEngine::Parameters::fromPreset (settings.preset);
+    parameters.reverbEnabled = settings.reverbEnabled;
+
+    auto engine = std::make_unique<OrbitEngine>();
+    engine->setParameters (parameters);
+    engine->prepareToPlay (settings.blockSize, sampleRate, numInputs);
+
+    // Handing over the set after prepareToPlay() builds its cache once, at the file's rate.
+    if (settings.hrirSet != nullptr)
+        engine->setHrirSet (settings.hrirSet);
+
+    juce::AudioBuffer<float> buffer (juce::jmax (2, numInputs), settings.blockSize);
+
+    const auto totalLength = reader->lengthInSamples
+                           + (juce::int64) std::ceil (settings.tailSeconds * sampleRate);
+
+    // The output limiter delays everything by its lookahead; I render that much further
+    // and drop as much from the start, so the file lines up with its input.
+    const int latency = engine->getLatencySamples();
+
+    for (juce::int64 position = 0; position < totalLength + latency; position += settings.blockSize)
+    {
+        const int n = (int) juce::jmin ((juce::int64) settings.blockSize, totalLength + latency - position);
+
+        buffer.clear();
+        if (! reader->read (buffer.getArrayOfWritePointers(), numInputs, position, n))
+        {
+            report.result = juce::Result::fail ("Read error in " + job.input.getFullPathName());
+            return report;
+        }
+
+        if (numInputs == 1)
+            buffer.copyFrom (1, 0, buffer, 0, 0, n);
+
+        engine->process (buffer, 0, n);
+
+        const int skip = (int) juce::jlimit ((juce::int64) 0, (juce::int64) n, latency - position);
+        if (skip == n)
+            continue;
+
+        const float* output[] = { buffer.getReadPointer (0, skip), buffer.getReadPointer (1, skip) };
+        if (! writer->writeFromFloatArrays (output, 2, n - skip))
+        {
+            report.result = juce::Result::fail ("Write error in " + job.output.getFullPathName());
+            return report;
+        }
+    }
+
+    writer = nullptr;   // flushes and closes the stream
+
+    report.renderSeconds = juce::Time::highResolutionTicksToSeconds (juce::Time::getHighResolutionTicks() - startTicks);
+    report.audioSeconds = (double) totalLength / sampleRate;
+
+    if (! temp.overwriteTargetFileWithTemporary())
+        report.result = juce::Result::fail ("Can't replace " + job.output.getFullPathName());
+
+    return report;
+}
+
+std::vector<OfflineRenderer::Report> OfflineRenderer::renderAll (const std::vector<Job>& jobs, int numThreads,
+                                                                 std::function<void (const Report&)> onFinished)
+{
+    std::vector<Report> reports (jobs.size());
+    if (jobs.empty())
+        return reports;
+
+    juce::CriticalSection callbackLock;
+    juce::WaitableEvent allDone;
+    std::atomic<size_t> remaining { jobs.size() };
+
+    {
+        juce::ThreadPool pool (juce::ThreadPoolOptions{}.withThreadName ("OfflineRenderer")
+                                                        .withNumberOfThreads (juce::jlimit (1, (int) jobs.size(), numThreads)));
+
+        for (size_t i = 0; i < jobs.size(); ++i)
+        {
+            pool.addJob ([&, i]
+            {
+                reports[i] = renderFile (jobs[i]);
+
+                if (onFinished)
+                {
+                    const juce::ScopedLock sl (callbackLock);
+                    onFinished (reports[i]);
+                }
+
+                if (--remaining == 0)
+                    allDone.signal();
+            });
+        }
+
+        allDone.wait();
+    }
+
+    return reports;
+}
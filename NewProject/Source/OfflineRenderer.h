@@ -0,0 +1,59 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "OrbitEngine.h"
+
+//==============================================================================
+// I spatialize audio files offline through the OrbitEngine, the same chain the app runs
+// live, set up from a preset. I stream each file in large blocks, so memory stays flat
+// however long it is, and I render a batch of files in parallel on a juce::ThreadPool,
+// one file per job. Output is stereo WAV or FLAC, chosen by the output file extension.
+class OfflineRenderer
+{
+public:
+    struct Settings
+    {
+        OrbitPreset preset;
+        bool reverbEnabled = false;
+        std::shared_ptr<const HrirSet> hrirSet;   // needed when preset.headModel == 1
+        int blockSize = 16384;
+        int bitsPerSample = 24;                   // 16, 24, or 32 (float, WAV only)
+        double tailSeconds = 0.0;                 // silence rendered past the end, for reverb tails
+    };
+
+    struct Job
+    {
+        juce::File input, output;
+    };
+
+    struct Report
+    {
+        Job job;
+        juce::Result result = juce::Result::ok();
+        double audioSeconds = 0.0;
+        double renderSeconds = 0.0;
+
+        // Seconds of audio rendered per second of wall-clock time.
+        double getRealTimeFactor() const   { return renderSeconds > 0.0 ? audioSeconds / renderSeconds : 0.0; }
+    };
+
+    explicit OfflineRenderer (Settings settings);
+
+    // I render one file on the calling thread.
+    Report renderFile (const Job& job);
+
+    // I render every job on numThreads threads and call onFinished (from the worker
+    // thread, under a lock) as each file completes. Reports come back in job order.
+    std::vector<Report> renderAll (const std::vector<Job>& jobs, int numThreads,
+                                   std::function<void (const Report&)> onFinished = {});
+
+    // The extensions I can read (semicolon-separated wildcards) and write.
+    juce::String getReadableWildcard() const;
+    static bool canWrite (const juce::File& output);
+
+private:
+    Settings settings;
+    juce::AudioFormatManager formatManager;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (OfflineRenderer)
+};
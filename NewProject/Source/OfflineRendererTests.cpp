@@ -0,0 +1,152 @@
+#include <JuceHeader.h>
+#include "OfflineRenderer.h"
+
+//==============================================================================
+// I test presets and the OfflineRenderer: a preset must survive a round trip through its
+// ValueTree, a rendered file must match the live Spatializer sample for sample, and a
+// parallel batch must render every file and report in job order.
+class OfflineRendererTest : public juce::UnitTest
+{
+public:
+    OfflineRendererTest() : juce::UnitTest ("OfflineRenderer", "Audio") {}
+
+    static juce::AudioBuffer<float> makeTestSignal (int numSamples, double sampleRate)
+    {
+        juce::AudioBuffer<float> signal (2, numSamples);
+        for (int i = 0; i < numSamples; ++i)
+        {
+            const auto t = (double) i / sampleRate;
+            signal.setSample (0, i, 0.5f * (float) std::sin (juce::MathConstants<double>::twoPi * 440.0 * t));
+            signal.setSample (1, i, 0.25f * (float) std::sin (juce::MathConstants<double>::twoPi * 1250.0 * t));
+        }
+        return signal;
+    }
+
+    static void writeWav (const juce::File& file, const juce::AudioBuffer<float>& signal, double sampleRate)
+    {
+        juce::WavAudioFormat wav;
+        std::unique_ptr<juce::OutputStream> stream = file.createOutputStream();
+        if (auto writer = wav.createWriterFor (stream, juce::AudioFormatWriterOptions{}.withSampleRate (sampleRate)
+                                                                                      .withNumChannels (signal.getNumChannels())
+                                                                                      .withBitsPerSample (32)
+                                                                                      .withSampleFormat (juce::AudioFormatWriterOptions::SampleFormat::floatingPoint)))
+            writer->writeFromAudioSampleBuffer (signal, 0, signal.getNumSamples());
+    }
+
+    static juce::AudioBuffer<float> readFile (const juce::File& file)
+    {
+        juce::AudioFormatManager manager;
+        manager.registerBasicFormats();
+        juce::AudioBuffer<float> result;
+        if (std::unique_ptr<juce::AudioFormatReader> reader { manager.createReaderFor (file) })
+        {
+            result.setSize ((int) reader->numChannels, (int) reader->lengthInSamples);
+            reader->read (&result, 0, result.getNumSamples(), 0, true, true);
+        }
+        return result;
+    }
+
+    void runTest() override
+    {
+        const double sampleRate = 48000.0;
+        const int numSamples = 30000;
+
+        beginTest ("preset round-trips through its ValueTree");
+        {
+            OrbitPreset preset;
+            preset.pan = -0.4f;
+            preset.orbitMode = 2;
+            preset.sourceLayout = 1;
+            preset.headModel = 1;
+            preset.panSpeedHz = 0.2f;
+            preset.depth = 0.3f;
+            preset.width = 0.6f;
+
+            const auto loaded = OrbitPreset::fromValueTree (preset.toValueTree());
+            expectWithinAbsoluteError (loaded.pan, -0.4f, 1.0e-6f);
+            expectEquals (loaded.orbitMode, 2);
+            expectEquals (loaded.sourceLayout, 1);
+            expectEquals (loaded.headModel, 1);
+            expectWithinAbsoluteError (loaded.panSpeedHz, 0.2f, 1.0e-6f);
+            expectWithinAbsoluteError (loaded.width, 0.6f, 1.0e-6f);
+            expect (loaded.getOrbitMode() == Spatializer::OrbitMode::Figure8);
+
+            const auto narrow = OrbitPreset::fromValueTree (OrbitPreset::getBuiltIn ("Narrow"));
+            expectEquals (narrow.orbitMode, 2);
+            expectWithinAbsoluteError (narrow.depth, 0.2f, 1.0e-6f);
+        }
+
+        juce::TemporaryFile tempDir;
+        const auto folder = tempDir.getFile();
+        folder.createDirectory();
+
+        const auto signal = makeTestSignal (numSamples, sampleRate);
+        const auto input = folder.getChildFile ("input.wav");
+        writeWav (input, signal, sampleRate);
+
+        OfflineRenderer::Settings settings;
+        settings.preset = OrbitPreset::fromValueTree (OrbitPreset::getBuiltIn ("Orbit"));
+        settings.preset.panSpeedHz = 0.5f;
+        settings.bitsPerSample = 32;
+        settings.blockSize = 1024;   // a multiple of the control sub-block, like the live callbacks
+
+        beginTest ("rendered file matches the live spatializer");
+        {
+            OfflineRenderer renderer (settings);
+            const auto report = renderer.renderFile ({ input, folder.getChildFile ("output.wav") });
+            expect (report.result.wasOk(), report.result.getErrorMessage());
+            expectWithinAbsoluteError (report.audioSeconds, numSamples / sampleRate, 1.0e-9);
+            expectGreaterThan (report.getRealTimeFactor(), 0.0);
+
+            // The live path, in 256-sample callbacks.
+            Spatializer spatializer;
+            spatializer.prepareToPlay (256, sampleRate);
+            auto expected = signal;
+            for (int start = 0; start < numSamples; start += 256)
+                spatializer.process (expected, start, juce::jmin (256, numSamples - start), 0.0f,
+                                     Spatializer::OrbitMode::Orbit, 0.5f);
+
+            const auto rendered = readFile (report.job.output);
+            expectEquals (rendered.getNumChannels(), 2);
+            expectEquals (rendered.getNumSamples(), numSamples);
+
+            float maxError = 0.0f;
+            for (int ch = 0; ch < 2; ++ch)
+                for (int i = 0; i < numSamples; ++i)
+                    maxError = juce::jmax (maxError, std::abs (rendered.getSample (ch, i) - expected.getSample (ch, i)));
+            expectLessThan (maxError, 1.0e-5f);
+        }
+
+        beginTest ("batch renders every file in parallel, in job order");
+        {
+            settings.bitsPerSample = 24;
+            settings.reverbEnabled = true;
+            settings.tailSeconds = 0.25;
+            OfflineRenderer renderer (settings);
+
+            std::vector<OfflineRenderer::Job> jobs;
+            for (int i = 0; i < 4; ++i)
+                jobs.push_back ({ input, folder.getChildFile ("batch" + juce::String (i) + (i % 2 == 0 ? ".wav" : ".flac")) });
+            jobs.push_back ({ folder.getChildFile ("missing.wav"), folder.getChildFile ("missing_out.wav") });
+
+            std::atomic<int> callbacks { 0 };
+            const auto reports = renderer.renderAll (jobs, 3, [&callbacks] (const OfflineRenderer::Report&) { ++callbacks; });
+
+            expectEquals ((int) reports.size(), 5);
+            expectEquals (callbacks.load(), 5);
+            for (int i = 0; i < 4; ++i)
+            {
+                expect (reports[(size_t) i].result.wasOk(), reports[(size_t) i].result.getErrorMessage());
+                expect (reports[(size_t) i].job.output == jobs[(size_t) i].output);
+                expectEquals (readFile (jobs[(size_t) i].output).getNumSamples(), numSamples + 12000, "tail is appended");
+            }
+
+            expect (reports[4].result.failed());
+            expect (! jobs[4].output.exists(), "failed renders leave no output");
+        }
+
+        folder.deleteRecursively();
+    }
+};
+
+static OfflineRendererTest offlineRendererTest;
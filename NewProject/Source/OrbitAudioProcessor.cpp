@@ -0,0 +1,222 @@
+#include "OrbitAudioProcessor.h"
+
+//==============================================================================
+OrbitAudioProcessor::OrbitAudioProcessor()
+    : juce::AudioProcessor (BusesProperties().withInput ("Input", juce::AudioChannelSet::stereo(), true)
+                                             .withOutput ("Output", juce::AudioChannelSet::stereo(), true))
+{
+    const OrbitEngine::Parameters defaults;
+    const auto addFloat = [this] (juce::AudioProcessorParameterGroup& group, Ramped index, const char* id,
+                                  const char* label, juce::NormalisableRange<float> range, float defaultValue,
+                                  const char* unit = "")
+    {
+        auto parameter = std::make_unique<juce::AudioParameterFloat> (juce::ParameterID { id, 1 }, label, range, defaultValue,
+                                                                      juce::AudioParameterFloatAttributes().withLabel (unit));
+        rampedParameters[(size_t) index] = parameter.get();
+        group.addChild (std::move (parameter));
+    };
+
+    auto position = std::make_unique<juce::AudioProcessorParameterGroup> ("position", "Position", "|");
+    addFloat (*position, pan, "pan", "Pan", { -1.0f, 1.0f }, defaults.pan);
+    {
+        auto mode = std::make_unique<juce::AudioParameterChoice> (juce::ParameterID { "orbitMode", 1 }, "Orbit mode",
+                                                                  juce::StringArray { "Manual", "Orbit", "Figure 8", "Path" }, 0);
+        orbitMode = mode.get();
+        position->addChild (std::move (mode));
+    }
+    addFloat (*position, panSpeedHz, "orbitSpeed", "Orbit speed", { 0.02f, 0.5f }, defaults.panSpeedHz, "Hz");
+
+    auto headModel = std::make_unique<juce::AudioProcessorParameterGroup> ("headModel", "Head model", "|");
+    addFloat (*headModel, itdAmount, "itdAmount", "ITD amount", { 0.0f, 1.0f }, defaults.itdAmount);
+    addFloat (*headModel, shadowStrength, "shadowStrength", "Head shadow", { 0.0f, 1.0f }, defaults.shadowStrength);
+    addFloat (*headModel, depth, "depth", "Depth", { 0.0f, 1.0f }, defaults.depth);
+    addFloat (*headModel, width, "width", "Width", { 0.0f, 1.0f }, defaults.width);
+
+    auto room = std::make_unique<juce::AudioProcessorParameterGroup> ("room", "Room", "|");
+    {
+        auto enabled = std::make_unique<juce::AudioParameterBool> (juce::ParameterID { "reverb", 1 }, "Reverb", defaults.reverbEnabled);
+        reverbEnabled = enabled.get();
+        room->addChild (std::move (enabled));
+    }
+    addFloat (*room, reverbWet, "reverbWet", "Reverb wet", { 0.0f, 1.0f }, defaults.reverbWet);
+    addFloat (*room, roomSize, "roomSize", "Room size", { 0.0f, 1.0f }, defaults.reverbRoomSize);
+
+    auto output = std::make_unique<juce::AudioProcessorParameterGroup> ("output", "Output", "|");
+    {
+        auto enabled = std::make_unique<juce::AudioParameterBool> (juce::ParameterID { "limiter", 1 }, "Limiter", defaults.limiterEnabled);
+        limiterEnabled = enabled.get();
+        output->addChild (std::move (enabled));
+    }
+    addFloat (*output, limiterCeilingDb, "ceiling", "Limiter ceiling", { -12.0f, 0.0f }, defaults.limiterCeilingDb, "dBTP");
+
+    addParameterGroup (std::move (position));
+    addParameterGroup (std::move (headModel));
+    addParameterGroup (std::move (room));
+    addParameterGroup (std::move (output));
+
+    setTrajectory (OrbitPreset::fromValueTree (OrbitPreset::getBuiltIn ("Spiral")).trajectory);
+}
+
+void OrbitAudioProcessor::setTrajectory (const OrbitTrajectory& newTrajectory)
+{
+    trajectory = newTrajectory;
+    compiledPaths.write ({ trajectory.compile(), ++writtenPathVersion });
+}
+
+//==============================================================================
+void OrbitAudioProcessor::readParameters (float* values) const noexcept
+{
+    for (size_t i = 0; i < rampedParameters.size(); ++i)
+        values[i] = rampedParameters[i]->get();
+}
+
+OrbitEngine::Parameters OrbitAudioProcessor::makeEngineParameters (const float* values, const OrbitPath& path) const noexcept
+{
+    OrbitEngine::Parameters p;
+    p.pan = values[pan];
+    p.orbitMode = orbitMode->getIndex() == 1 ? Spatializer::OrbitMode::Orbit
+                : orbitMode->getIndex() == 2 ? Spatializer::OrbitMode::Figure8
+                : orbitMode->getIndex() == 3 ? Spatializer::OrbitMode::Path
+                                             : Spatializer::OrbitMode::Manual;
+    p.path = path;
+    p.panSpeedHz = values[panSpeedHz];
+    p.itdAmount = values[itdAmount];
+    p.shadowStrength = values[shadowStrength];
+    p.depth = values[depth];
+    p.width = values[width];
+    p.reverbEnabled = reverbEnabled->get();
+    p.reverbWet = values[reverbWet];
+    p.reverbRoomSize = values[roomSize];
+    p.limiterEnabled = limiterEnabled->get();
+    p.limiterCeilingDb = values[limiterCeilingDb];
+    p.tempoBpm = tempoBpm;
+    return p;
+}
+
+OrbitEngine::Automation OrbitAudioProcessor::makeAutomation (const float* values) const noexcept
+{
+    OrbitEngine::Automation a;
+    a.pan = values[pan];
+    a.panSpeedHz = values[panSpeedHz];
+    a.tempoBpm = tempoBpm;
+    a.itdAmount = values[itdAmount];
+    a.shadowStrength = values[shadowStrength];
+    a.depth = values[depth];
+    a.width = values[width];
+    a.reverbWet = values[reverbWet];
+    a.reverbRoomSize = values[roomSize];
+    a.limiterCeilingDb = values[limiterCeilingDb];
+    return a;
+}
+
+OrbitEngine::Parameters OrbitAudioProcessor::getEngineParameters() const
+{
+    std::array<float, numRamped> values;
+    readParameters (values.data());
+    return makeEngineParameters (values.data(), trajectory.compile());
+}
+
+double OrbitAudioProcessor::getTailLengthSeconds() const
+{
+    return reverbEnabled->get() ? (double) OrbitRoomReverb::getDecaySeconds (rampedParameters[roomSize]->get()) : 0.0;
+}
+
+bool OrbitAudioProcessor::isBusesLayoutSupported (const BusesLayout& layouts) const
+{
+    // Stereo out, from a stereo source or a mono one (which I spread to both sides).
+    const auto input = layouts.getMainInputChannelSet();
+    return layouts.getMainOutputChannelSet() == juce::AudioChannelSet::stereo()
+        && (input == juce::AudioChannelSet::stereo() || input == juce::AudioChannelSet::mono());
+}
+
+//==============================================================================
+void OrbitAudioProcessor::prepareToPlay (double sampleRate, int maximumExpectedSamplesPerBlock)
+{
+    // The ramps start where the parameters are, not from zero.
+    std::array<float, numRamped> values;
+    readParameters (values.data());
+    lastOrbitMode = orbitMode->getIndex();
+    lastReverbEnabled = reverbEnabled->get();
+    lastLimiterEnabled = limiterEnabled->get();
+
+    // The callback isn't running, so I can take the reader's side here.
+    const auto& compiled = compiledPaths.read();
+    lastPathVersion = compiled.version;
+
+    engine.setParameters (makeEngineParameters (values.data(), compiled.path));
+    engine.setAutomation (makeAutomation (values.data()));
+    engine.prepareToPlay (maximumExpectedSamplesPerBlock, sampleRate, 2);
+    setLatencySamples (engine.getLatencySamples());
+}
+
+void OrbitAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer&)
+{
+    const juce::ScopedNoDenormals noDenormals;
+    const int numSamples = buffer.getNumSamples();
+    if (numSamples == 0 || buffer.getNumChannels() < 2)
+        return;
+
+    // A mono input is the source on both sides.
+    if (getTotalNumInputChannels() == 1)
+        buffer.copyFrom (1, 0, buffer, 0, 0, numSamples);
+
+    // Tempo-locked paths follow the host.
+    if (auto* head = getPlayHead())
+        if (const auto position = head->getPosition())
+            if (const auto bpm = position->getBpm())
+                tempoBpm = (float) *bpm;
+
+    std::array<float, numRamped> target;
+    readParameters (target.data());
+    const auto& compiled = compiledPaths.read();
+
+    // A new snapshot only for the settings that can't ramp; the engine ramps the rest
+    // from where the last block left them.
+    if (orbitMode->getIndex() != lastOrbitMode
+        || reverbEnabled->get() != lastReverbEnabled
+        || limiterEnabled->get() != lastLimiterEnabled
+        || compiled.version != lastPathVersion)
+    {
+        engine.setParameters (makeEngineParameters (target.data(), compiled.path));
+
+        lastOrbitMode = orbitMode->getIndex();
+        lastReverbEnabled = reverbEnabled->get();
+        lastLimiterEnabled = limiterEnabled->get();
+        lastPathVersion = compiled.version;
+    }
+
+    engine.setAutomation (makeAutomation (target.data()));
+    engine.process (buffer, 0, numSamples);
+}
+
+//==============================================================================
+void OrbitAudioProcessor::getStateInformation (juce::MemoryBlock& destData)
+{
+    juce::ValueTree state ("OrbitAudioPlugin");
+    for (auto* parameter : getParameters())
+        if (auto* ranged = dynamic_cast<juce::RangedAudioParameter*> (parameter))
+            state.setProperty (ranged->getParameterID(), ranged->convertFrom0to1 (ranged->getValue()), nullptr);
+
+    state.appendChild (trajectory.toValueTree(), nullptr);
+
+    if (const auto xml = state.createXml())
+        copyXmlToBinary (*xml, destData);
+}
+
+void OrbitAudioProcessor::setStateInformation (const void* data, int sizeInBytes)
+{
+    const auto xml = getXmlFromBinary (data, sizeInBytes);
+    if (xml == nullptr)
+        return;
+
+    // Parameters the state doesn't mention (saved by an older version) keep their values.
+    const auto state = juce::ValueTree::fromXml (*xml);
+    for (auto* parameter : getParameters())
+        if (auto* ranged = dynamic_cast<juce::RangedAudioParameter*> (parameter))
+            if (state.hasProperty (ranged->getParameterID()))
+                ranged->setValueNotifyingHost (ranged->convertTo0to1 ((float) state.getProperty (ranged->getParameterID())));
+
+    const auto trajectoryState = state.getChildWithName ("Trajectory");
+    if (trajectoryState.isValid())
+        setTrajectory (OrbitTrajectory::fromValueTree (trajectoryState));
+}
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "OrbitEngine.h"
+
+//==============================================================================
+// I'm the OrbitEngine as an AudioProcessor, so a DAW can run the spatializer, room reverb
+// and limiter in-process instead of routing through BlackHole into the app: no device
+// round trip, and no second real-time thread. The OrbitPlugin target wraps me (adding
+// the generic editor); the app builds me too, for the tests, so both run the same DSP.
+//
+// The parameters are grouped as the app's panel is: position, head model, room and
+// output. JUCE hands me each parameter's latest value once per host block, with no
+// timestamps, so the nearest thing to sample-accurate automation is to ramp each
+// continuous parameter from where the last block left it to its new value. Once per
+// block I hand those values to the engine as its Automation, which ramps in
+// automationSliceSize slices inside the block: a change lands within a slice and never
+// steps. Only the discrete settings (mode, switches, trajectory) publish a new engine
+// snapshot, and only when they change.
+//
+// Path mode follows a trajectory, the Spiral preset's until the state says otherwise. It
+// isn't a parameter (hosts can't automate a shape), so it travels in my state as the
+// preset's Trajectory element, and a tempo-locked one follows the host's tempo.
+//
+// The limiter's lookahead is my latency, reported to the host at prepareToPlay.
+class OrbitAudioProcessor  : public juce::AudioProcessor
+{
+public:
+    static constexpr int automationSliceSize = OrbitEngine::automationSliceSize;
+
+    OrbitAudioProcessor();
+    ~OrbitAudioProcessor() override = default;
+
+    //==============================================================================
+    void prepareToPlay (double sampleRate, int maximumExpectedSamplesPerBlock) override;
+    void releaseResources() override {}
+    void processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midi) override;
+    using juce::AudioProcessor::processBlock;
+
+    bool isBusesLayoutSupported (const BusesLayout& layouts) const override;
+
+    //==============================================================================
+    // The plugin target adds the generic editor; headless, I have none.
+    juce::AudioProcessorEditor* createEditor() override     { return nullptr; }
+    bool hasEditor() const override                         { return false; }
+
+    //==============================================================================
+    const juce::String getName() const override             { return "OrbitAudio"; }
+    bool acceptsMidi() const override                       { return false; }
+    bool producesMidi() const override                      { return false; }
+    // The reverb's decay at the current room size, or none with the reverb off.
+    double getTailLengthSeconds() const override;
+
+    int getNumPrograms() override                           { return 1; }
+    int getCurrentProgram() override                        { return 0; }
+    void setCurrentProgram (int) override                   {}
+    const juce::String getProgramName (int) override        { return {}; }
+    void changeProgramName (int, const juce::String&) override {}
+
+    // Every parameter by ID, as a ValueTree in XML.
+    void getStateInformation (juce::MemoryBlock& destData) override;
+    void setStateInformation (const void* data, int sizeInBytes) override;
+
+    //==============================================================================
+    // The engine settings the parameters stand for right now (the ends of any ramps).
+    OrbitEngine::Parameters getEngineParameters() const;
+
+    // The trajectory Path mode follows. Message thread; I compile it there and hand the
+    // table to the audio thread, which picks it up at its next block.
+    void setTrajectory (const OrbitTrajectory& newTrajectory);
+    const OrbitTrajectory& getTrajectory() const noexcept   { return trajectory; }
+
+private:
+    // The continuous parameters, in the order I ramp them.
+    enum Ramped { pan, panSpeedHz, itdAmount, shadowStrength, depth, width, reverbWet, roomSize, limiterCeilingDb, numRamped };
+
+    void readParameters (float* values) const noexcept;
+    OrbitEngine::Parameters makeEngineParameters (const float* values, const OrbitPath& path) const noexcept;
+    OrbitEngine::Automation makeAutomation (const float* values) const noexcept;
+
+    OrbitEngine engine;
+
+    std::array<juce::AudioParameterFloat*, numRamped> rampedParameters {};
+    juce::AudioParameterChoice* orbitMode = nullptr;
+    juce::AudioParameterBool* reverbEnabled = nullptr;
+    juce::AudioParameterBool* limiterEnabled = nullptr;
+
+    // A compiled trajectory, numbered so the audio thread can tell a new one.
+    struct CompiledPath
+    {
+        OrbitPath path;
+        juce::uint32 version = 0;
+    };
+
+    OrbitTrajectory trajectory;                 // message thread
+    TripleBuffer<CompiledPath> compiledPaths;
+    juce::uint32 writtenPathVersion = 0;        // message thread
+
+    // Audio thread: the host's tempo, and the discrete settings and trajectory the engine
+    // snapshot was made with.
+    int lastOrbitMode = -1;
+    bool lastReverbEnabled = false, lastLimiterEnabled = true;
+    float tempoBpm = 120.0f;
+    juce::uint32 lastPathVersion = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (OrbitAudioProcessor)
+};
@@ -0,0 +1,256 @@
+#include <JuceHeader.h>
+#include "OrbitAudioProcessor.h"
+
+//==============================================================================
+// I test OrbitAudioProcessor the way a host drives it: the parameter layout and buses,
+// the latency and tail it reports, that steady parameters sound exactly like the OrbitEngine it
+// wraps, that Path mode follows its trajectory at the host's tempo, that an automated
+// jump ramps across the block instead of stepping, and that its state (trajectory
+// included) comes back whole.
+class OrbitAudioProcessorTest : public juce::UnitTest
+{
+public:
+    OrbitAudioProcessorTest() : juce::UnitTest ("OrbitAudioProcessor", "Audio") {}
+
+    static juce::RangedAudioParameter* findParameter (juce::AudioProcessor& processor, const juce::String& id)
+    {
+        for (auto* parameter : processor.getParameters())
+            if (auto* ranged = dynamic_cast<juce::RangedAudioParameter*> (parameter))
+                if (ranged->getParameterID() == id)
+                    return ranged;
+
+        return nullptr;
+    }
+
+    static void set (juce::AudioProcessor& processor, const juce::String& id, float value)
+    {
+        auto* parameter = findParameter (processor, id);
+        parameter->setValueNotifyingHost (parameter->convertTo0to1 (value));
+    }
+
+    // A host transport that only knows its tempo.
+    struct TempoPlayHead  : public juce::AudioPlayHead
+    {
+        juce::Optional<PositionInfo> getPosition() const override
+        {
+            PositionInfo info;
+            info.setBpm (bpm);
+            return info;
+        }
+
+        double bpm = 120.0;
+    };
+
+    static float maxDifference (const juce::AudioBuffer<float>& a, const juce::AudioBuffer<float>& b)
+    {
+        float maxError = 0.0f;
+        for (int ch = 0; ch < 2; ++ch)
+            for (int i = 0; i < a.getNumSamples(); ++i)
+                maxError = juce::jmax (maxError, std::abs (a.getSample (ch, i) - b.getSample (ch, i)));
+        return maxError;
+    }
+
+    static juce::AudioBuffer<float> makeNoise (int numSamples)
+    {
+        juce::AudioBuffer<float> noise (2, numSamples);
+        juce::Random random (5);
+        for (int ch = 0; ch < 2; ++ch)
+            for (int i = 0; i < numSamples; ++i)
+                noise.setSample (ch, i, 0.5f * (random.nextFloat() * 2.0f - 1.0f));
+        return noise;
+    }
+
+    void runTest() override
+    {
+        beginTest ("parameters, buses and latency");
+        {
+            OrbitAudioProcessor processor;
+            expectEquals (processor.getParameters().size(), 12);
+            expectEquals (processor.getParameterTree().getSubgroups (false).size(), 4);
+
+            for (const auto* id : { "pan", "orbitMode", "orbitSpeed", "itdAmount", "shadowStrength", "depth",
+                                    "width", "reverb", "reverbWet", "roomSize", "limiter", "ceiling" })
+                expect (findParameter (processor, id) != nullptr, id);
+
+            juce::AudioProcessor::BusesLayout layout;
+            layout.inputBuses.add (juce::AudioChannelSet::mono());
+            layout.outputBuses.add (juce::AudioChannelSet::stereo());
+            expect (processor.checkBusesLayoutSupported (layout), "mono in, stereo out");
+
+            layout.outputBuses.getReference (0) = juce::AudioChannelSet::create5point1();
+            expect (! processor.checkBusesLayoutSupported (layout), "stereo out only");
+
+            processor.prepareToPlay (48000.0, 512);
+            OrbitEngine engine;
+            engine.prepareToPlay (512, 48000.0);
+            expectEquals (processor.getLatencySamples(), engine.getLatencySamples());
+            expectGreaterThan (processor.getLatencySamples(), 0);
+
+            // The tail is the reverb's decay at the room size it's set to.
+            expectEquals (processor.getTailLengthSeconds(), 0.0, "reverb off");
+            set (processor, "reverb", 1.0f);
+            set (processor, "roomSize", 0.2f);
+            const double smallRoom = processor.getTailLengthSeconds();
+            expectWithinAbsoluteError (smallRoom, (double) OrbitRoomReverb::getDecaySeconds (0.2f), 1.0e-5);
+            set (processor, "roomSize", 1.0f);
+            expectGreaterThan (processor.getTailLengthSeconds(), smallRoom + 2.0);
+            expectWithinAbsoluteError (processor.getEngineParameters().reverbRoomSize, 1.0f, 1.0e-6f);
+        }
+
+        beginTest ("steady parameters sound like the engine");
+        {
+            const int blockSize = 256, numBlocks = 16;
+
+            OrbitAudioProcessor processor;
+            set (processor, "orbitMode", 2.0f);
+            set (processor, "orbitSpeed", 0.3f);
+            set (processor, "depth", 0.5f);
+            set (processor, "reverb", 1.0f);
+            processor.prepareToPlay (48000.0, blockSize);
+
+            OrbitEngine engine;
+            engine.setParameters (processor.getEngineParameters());
+            engine.prepareToPlay (blockSize, 48000.0);
+            expect (processor.getEngineParameters().orbitMode == Spatializer::OrbitMode::Figure8);
+            expect (processor.getEngineParameters().reverbEnabled);
+
+            auto rendered = makeNoise (blockSize * numBlocks);
+            auto expected = makeNoise (blockSize * numBlocks);
+            juce::MidiBuffer midi;
+
+            for (int block = 0; block < numBlocks; ++block)
+            {
+                juce::AudioBuffer<float> view (rendered.getArrayOfWritePointers(), 2, block * blockSize, blockSize);
+                processor.processBlock (view, midi);
+                engine.process (expected, block * blockSize, blockSize);
+            }
+
+            expectEquals (maxDifference (rendered, expected), 0.0f);
+        }
+
+        beginTest ("Path mode follows its trajectory at the host's tempo");
+        {
+            const int blockSize = 256, numBlocks = 32;
+            expect (OrbitAudioProcessor().getTrajectory().loopBeats > 0.0f, "the default trajectory is tempo-locked");
+
+            const auto render = [&] (double bpm, float engineBpm)
+            {
+                OrbitAudioProcessor processor;
+                TempoPlayHead playHead;
+                playHead.bpm = bpm;
+                processor.setPlayHead (&playHead);
+                set (processor, "orbitMode", 3.0f);
+                processor.prepareToPlay (48000.0, blockSize);
+
+                // An engine told the tempo directly, following the same trajectory.
+                auto parameters = processor.getEngineParameters();
+                expect (parameters.orbitMode == Spatializer::OrbitMode::Path);
+                parameters.tempoBpm = engineBpm;
+
+                OrbitEngine engine;
+                engine.setParameters (parameters);
+                engine.prepareToPlay (blockSize, 48000.0);
+
+                auto rendered = makeNoise (blockSize * numBlocks);
+                auto expected = makeNoise (blockSize * numBlocks);
+                juce::MidiBuffer midi;
+
+                for (int block = 0; block < numBlocks; ++block)
+                {
+                    juce::AudioBuffer<float> view (rendered.getArrayOfWritePointers(), 2, block * blockSize, blockSize);
+                    processor.processBlock (view, midi);
+                    engine.process (expected, block * blockSize, blockSize);
+                }
+
+                processor.setPlayHead (nullptr);
+                return maxDifference (rendered, expected);
+            };
+
+            expectEquals (render (240.0, 240.0f), 0.0f);
+            expectGreaterThan (render (240.0, 120.0f), 1.0e-3f, "the host's tempo, not the default");
+        }
+
+        beginTest ("an automated jump ramps across the block");
+        {
+            const int blockSize = 512;
+            const int numSlices = blockSize / OrbitAudioProcessor::automationSliceSize;
+
+            OrbitAudioProcessor processor;
+            set (processor, "pan", -1.0f);
+            set (processor, "limiter", 0.0f);
+            processor.prepareToPlay (48000.0, blockSize);
+
+            juce::AudioBuffer<float> buffer (2, blockSize);
+            juce::MidiBuffer midi;
+            for (int block = 0; block < 8; ++block)
+            {
+                buffer.clear();
+                for (int ch = 0; ch < 2; ++ch)
+                    juce::FloatVectorOperations::fill (buffer.getWritePointer (ch), 0.25f, blockSize);
+                processor.processBlock (buffer, midi);
+            }
+
+            // Hard left to hard right in one host block.
+            set (processor, "pan", 1.0f);
+            for (int ch = 0; ch < 2; ++ch)
+                juce::FloatVectorOperations::fill (buffer.getWritePointer (ch), 0.25f, blockSize);
+            processor.processBlock (buffer, midi);
+
+            // The right ear's share grows slice by slice; the first slice has barely moved.
+            std::vector<float> balance;
+            for (int slice = 0; slice < numSlices; ++slice)
+            {
+                const int start = slice * OrbitAudioProcessor::automationSliceSize;
+                const float left = buffer.getRMSLevel (0, start, OrbitAudioProcessor::automationSliceSize);
+                const float right = buffer.getRMSLevel (1, start, OrbitAudioProcessor::automationSliceSize);
+                balance.push_back (right / (left + right));
+            }
+
+            expectLessThan (balance.front(), 0.5f);
+            expectGreaterThan (balance.back(), 0.5f);
+            for (size_t i = 1; i < balance.size(); ++i)
+                expectGreaterOrEqual (balance[i], balance[i - 1] - 1.0e-4f);
+
+            expectEquals (processor.getEngineParameters().pan, 1.0f);
+        }
+
+        beginTest ("state comes back whole");
+        {
+            OrbitAudioProcessor processor;
+            set (processor, "pan", 0.25f);
+            set (processor, "orbitMode", 1.0f);
+            set (processor, "width", 0.4f);
+            set (processor, "reverb", 1.0f);
+            set (processor, "ceiling", -3.0f);
+
+            auto ellipse = OrbitTrajectory();
+            ellipse.shape = OrbitTrajectory::Shape::Ellipse;
+            ellipse.frontRadius = 2.5f;
+            ellipse.loopBeats = 4.0f;
+            processor.setTrajectory (ellipse);
+
+            juce::MemoryBlock state;
+            processor.getStateInformation (state);
+
+            OrbitAudioProcessor restored;
+            restored.setStateInformation (state.getData(), (int) state.getSize());
+
+            const auto p = restored.getEngineParameters();
+            expectWithinAbsoluteError (p.pan, 0.25f, 1.0e-6f);
+            expect (p.orbitMode == Spatializer::OrbitMode::Orbit);
+            expectWithinAbsoluteError (p.width, 0.4f, 1.0e-6f);
+            expect (p.reverbEnabled);
+            expectWithinAbsoluteError (p.limiterCeilingDb, -3.0f, 1.0e-5f);
+            expectWithinAbsoluteError (p.depth, OrbitEngine::Parameters().depth, 1.0e-6f);
+            expect (restored.getTrajectory().shape == OrbitTrajectory::Shape::Ellipse);
+            expectEquals (restored.getTrajectory().frontRadius, 2.5f);
+            expectEquals (p.path.loopBeats, 4.0f);
+
+            // Garbage is ignored.
+            restored.setStateInformation ("nonsense", 8);
+            expectWithinAbsoluteError (restored.getEngineParameters().pan, 0.25f, 1.0e-6f);
+        }
+    }
+};
+
+static OrbitAudioProcessorTest orbitAudioProcessorTest;
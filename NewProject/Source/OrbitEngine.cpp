@@ -0,0 +1,385 @@
+#include "OrbitEngine.h"
+
+//==============================================================================
+OrbitEngine::Parameters OrbitEngine::Parameters::fromPreset (const OrbitPreset& preset)
+{
+    Parameters p;
+    p.pan = preset.pan;
+    p.orbitMode = preset.getOrbitMode();
+    p.panSpeedHz = preset.panSpeedHz;
+    p.sourceLayout = preset.sourceLayout;
+    p.useHrtf = preset.headModel == 1;
+    p.ambisonicOrder = preset.ambisonicOrder;
+    p.itdAmount = preset.itdAmount;
+    p.shadowStrength = preset.shadowStrength;
+    p.depth = preset.depth;
+    p.width = preset.width;
+    p.reverbWet = preset.reverbWet;
+    p.tempoBpm = preset.tempoBpm;
+    p.path = preset.trajectory.compile();
+    return p;
+}
+
+OrbitPreset OrbitEngine::Parameters::toPreset() const
+{
+    OrbitPreset preset;
+    preset.pan = pan;
+    preset.orbitMode = orbitMode == Spatializer::OrbitMode::Manual  ? 0
+                     : orbitMode == Spatializer::OrbitMode::Orbit   ? 1
+                     : orbitMode == Spatializer::OrbitMode::Figure8 ? 2 : 3;
+    preset.sourceLayout = sourceLayout;
+    preset.headModel = useHrtf ? 1 : 0;
+    preset.ambisonicOrder = ambisonicOrder;
+    preset.panSpeedHz = panSpeedHz;
+    preset.itdAmount = itdAmount;
+    preset.shadowStrength = shadowStrength;
+    preset.depth = depth;
+    preset.width = width;
+    preset.reverbWet = reverbWet;
+    preset.tempoBpm = tempoBpm;
+    return preset;
+}
+
+float OrbitEngine::Parameters::getLoopsPerSecond (float speedHz, float bpm) const
+{
+    if (orbitMode == Spatializer::OrbitMode::Manual)
+        return 0.0f;
+
+    if (path.loopBeats > 0.0f)
+        return bpm / 60.0f / path.loopBeats;
+
+    return speedHz;
+}
+
+//==============================================================================
+OrbitEngine::Automation OrbitEngine::Automation::fromParameters (const Parameters& p) noexcept
+{
+    return { p.pan, p.panSpeedHz, p.tempoBpm, p.itdAmount, p.shadowStrength, p.depth, p.width,
+             p.reverbWet, p.reverbRoomSize, p.limiterCeilingDb };
+}
+
+OrbitEngine::Automation OrbitEngine::Automation::interpolate (const Automation& target, float t) const noexcept
+{
+    const auto lerp = [t] (float from, float to) { return from + (to - from) * t; };
+
+    // The tempo is the host transport's for the whole block, so it steps.
+    return { lerp (pan, target.pan), lerp (panSpeedHz, target.panSpeedHz), target.tempoBpm,
+             lerp (itdAmount, target.itdAmount), lerp (shadowStrength, target.shadowStrength),
+             lerp (depth, target.depth), lerp (width, target.width), lerp (reverbWet, target.reverbWet),
+             lerp (reverbRoomSize, target.reverbRoomSize), lerp (limiterCeilingDb, target.limiterCeilingDb) };
+}
+
+bool OrbitEngine::Automation::operator== (const Automation& other) const noexcept
+{
+    return pan == other.pan && panSpeedHz == other.panSpeedHz && tempoBpm == other.tempoBpm
+        && itdAmount == other.itdAmount && shadowStrength == other.shadowStrength
+        && depth == other.depth && width == other.width && reverbWet == other.reverbWet
+        && reverbRoomSize == other.reverbRoomSize
+        && limiterCeilingDb == other.limiterCeilingDb;
+}
+
+//==============================================================================
+OrbitEngine::OrbitEngine()
+    : positionFrames ((size_t) positionRingSize)
+{
+}
+
+void OrbitEngine::setParameters (const Parameters& newParameters)
+{
+    auto snapshot = newParameters;
+    snapshot.version = ++writtenVersion;
+
+    if (snapshot.orbitMode != Spatializer::OrbitMode::Path)
+        snapshot.path = OrbitTrajectory::compileForMode (snapshot.orbitMode, snapshot.pan, {});
+
+    parameters.write (snapshot);
+}
+
+void OrbitEngine::applyHeadModel (const Parameters& snapshot)
+{
+    spatializer.setItdAmount (snapshot.itdAmount);
+    spatializer.setShadowStrength (snapshot.shadowStrength);
+    spatializer.setDepth (snapshot.depth);
+    spatializer.setWidth (snapshot.width);
+
+    spatializerBank.setItdAmount (snapshot.itdAmount);
+    spatializerBank.setShadowStrength (snapshot.shadowStrength);
+    spatializerBank.setDepth (snapshot.depth);
+    spatializerBank.setWidth (snapshot.width);
+
+    hrtfRenderer.setDepth (snapshot.depth);
+
+    ambisonicBank.setDepth (snapshot.depth);
+    ambisonicBank.setWidth (snapshot.width);
+    if (snapshot.ambisonicOrder > 0)
+        ambisonicBank.setOrder (snapshot.ambisonicOrder);
+
+    appliedVersion = snapshot.version;
+}
+
+void OrbitEngine::setAutomation (const Automation& target) noexcept
+{
+    if (! automated)
+        automationStart = target;
+
+    automationTarget = target;
+    automated = true;
+}
+
+void OrbitEngine::applyAutomation (const Automation& values)
+{
+    // The processors only store these; they take effect from the next sub-block on.
+    spatializer.setItdAmount (values.itdAmount);
+    spatializer.setShadowStrength (values.shadowStrength);
+    spatializer.setDepth (values.depth);
+    spatializer.setWidth (values.width);
+
+    spatializerBank.setItdAmount (values.itdAmount);
+    spatializerBank.setShadowStrength (values.shadowStrength);
+    spatializerBank.setDepth (values.depth);
+    spatializerBank.setWidth (values.width);
+
+    hrtfRenderer.setDepth (values.depth);
+
+    ambisonicBank.setDepth (values.depth);
+    ambisonicBank.setWidth (values.width);
+}
+
+HeadMotion OrbitEngine::predictHeadMotion (const Parameters& snapshot)
+{
+    // The pose is read every block, tracking or not, so switching it on starts from the latest.
+    const auto& pose = headPoses.read();
+
+    HeadMotion motion;
+    if (snapshot.headTracking)
+    {
+        // The block is heard after my own latency and the device's, which the prediction covers.
+        const double lookahead = limiter.getLatencySamples() / currentSampleRate + snapshot.headPredictionMs * 0.001;
+        motion = HeadMotion::predict (pose, HeadPose::getClock(), lookahead);
+    }
+
+    return motion;
+}
+
+void OrbitEngine::setHeadMotion (const HeadMotion& motion)
+{
+    spatializer.setHeadMotion (motion);
+    spatializerBank.setHeadMotion (motion);
+    hrtfRenderer.setHeadMotion (motion);
+    ambisonicBank.setHeadMotion (motion);
+}
+
+//==============================================================================
+void OrbitEngine::prepareToPlay (int samplesPerBlockExpected, double sampleRate, int numInputChannels)
+{
+    numInputs = numInputChannels;
+    currentSampleRate = sampleRate;
+
+    // The callback isn't running, so I can take the reader's side here.
+    const auto& snapshot = parameters.read();
+    applyHeadModel (snapshot);
+
+    spatializer.prepareToPlay (samplesPerBlockExpected, sampleRate);
+    spatializerBank.prepareToPlay (samplesPerBlockExpected, sampleRate);
+    hrtfRenderer.prepareToPlay (samplesPerBlockExpected, sampleRate);
+    ambisonicBank.prepareToPlay (samplesPerBlockExpected, sampleRate);
+    ambisonicRunning = false;
+
+    reverb.setSampleRate (sampleRate);
+    auto params = reverb.getParameters();
+    params.wetLevel = appliedReverbWet = snapshot.reverbWet;
+    params.roomSize = appliedRoomSize = snapshot.reverbRoomSize;
+    reverb.setParameters (params);
+    reverb.reset();
+
+    limiter.prepare (sampleRate, snapshot.limiterLookaheadMs);
+    limiter.setCeilingDecibels (appliedCeilingDb = snapshot.limiterCeilingDb);
+
+    // A new start doesn't ramp from where the last run left off.
+    automationStart = automationTarget;
+    if (automated)
+        applyAutomation (automationTarget);
+}
+
+void OrbitEngine::process (juce::AudioBuffer<float>& buffer, int startSample, int numSamples)
+{
+    // One coherent snapshot for the whole block.
+    const auto& p = parameters.read();
+    if (p.version != appliedVersion)
+        applyHeadModel (p);
+
+    const auto motion = predictHeadMotion (p);
+
+    // Automation that moves is ramped slice by slice; anything else takes one slice.
+    const int sliceSize = automated && automationStart != automationTarget ? automationSliceSize : numSamples;
+    double orbitPhase = 0.0;
+    PositionFrame frame;
+
+    for (int offset = 0; offset < numSamples; offset += sliceSize)
+    {
+        const int n = juce::jmin (sliceSize, numSamples - offset);
+        const double end = (offset + n) / currentSampleRate;
+
+        auto values = Automation::fromParameters (p);
+        const OrbitPath* path = &p.path;
+
+        if (automated)
+        {
+            values = automationStart.interpolate (automationTarget, (float) (offset + n) / (float) numSamples);
+            applyAutomation (values);
+
+            if (p.orbitMode == Spatializer::OrbitMode::Manual)
+            {
+                if (values.pan != manualPathPan)
+                    manualPath.placeAt (Spatializer::getManualPosition (manualPathPan = values.pan));
+
+                path = &manualPath;
+            }
+        }
+
+        setHeadMotion (motion.after (offset / currentSampleRate));
+        orbitPhase = spatialize (p, *path, p.getLoopsPerSecond (values.panSpeedHz, values.tempoBpm),
+                                 buffer, startSample + offset, n, frame);
+
+        finishSlice (p, values, frame.position.azimuth - motion.at (end).yaw,
+                     buffer.getWritePointer (0, startSample + offset),
+                     buffer.getWritePointer (1, startSample + offset), n);
+    }
+
+    automationStart = automationTarget;
+    frame.head = motion.at (numSamples / currentSampleRate);
+    pushPositionFrame (frame, orbitPhase);
+}
+
+double OrbitEngine::spatialize (const Parameters& p, const OrbitPath& path, float loopsPerSecond,
+                                juce::AudioBuffer<float>& buffer, int startSample, int numSamples,
+                                PositionFrame& frame)
+{
+    double orbitPhase = 0.0;
+
+    if (p.sourceLayout == 0 && p.useHrtf && hrtfRenderer.hasHrirSet())
+    {
+        hrtfRenderer.process (buffer, startSample, numSamples, path, loopsPerSecond);
+        orbitPhase = hrtfRenderer.getOrbitPhase();
+        frame.hasCues = false;
+    }
+    else if (p.sourceLayout == 0)
+    {
+        spatializer.process (buffer, startSample, numSamples, path, loopsPerSecond);
+        orbitPhase = spatializer.getOrbitPhase();
+        frame.cues = spatializer.getCurrentCues();
+    }
+    else if (p.ambisonicOrder > 0)
+    {
+        const auto layout = p.sourceLayout == 1 ? SpatializerBank::SourceLayout::StereoPairs
+                                                : SpatializerBank::SourceLayout::MonoChannels;
+        if (! ambisonicRunning)
+            ambisonicBank.reset();
+
+        ambisonicBank.process (buffer, startSample, numSamples, numInputs, layout, path, loopsPerSecond);
+        orbitPhase = ambisonicBank.getOrbitPhase();
+        frame.hasCues = false;
+        frame.numSources = SpatializerBank::getNumSources (numInputs, layout);
+    }
+    else
+    {
+        const auto layout = p.sourceLayout == 1 ? SpatializerBank::SourceLayout::StereoPairs
+                                                : SpatializerBank::SourceLayout::MonoChannels;
+        spatializerBank.process (buffer, startSample, numSamples, numInputs, layout, path, loopsPerSecond);
+        orbitPhase = spatializerBank.getOrbitPhase();
+        frame.cues = spatializerBank.getCurrentCues (0);
+        frame.numSources = SpatializerBank::getNumSources (numInputs, layout);
+    }
+
+    ambisonicRunning = p.sourceLayout != 0 && p.ambisonicOrder > 0;
+
+    // The banks keep their ring at ear level and the reference distance; the others follow
+    // the whole path.
+    frame.position = path.getPosition (orbitPhase);
+    if (p.sourceLayout != 0)
+        frame.position = { frame.position.azimuth, 0.0f, SpatialDsp::referenceDistance };
+
+    return orbitPhase;
+}
+
+void OrbitEngine::processPorts (const float* const* inputs, int numPorts, float* left, float* right, int numSamples)
+{
+    const auto& p = parameters.read();
+    if (p.version != appliedVersion)
+        applyHeadModel (p);
+
+    const auto layout = SpatializerBank::SourceLayout::MonoChannels;
+    double orbitPhase = 0.0;
+    PositionFrame frame;
+    const auto motion = predictHeadMotion (p);
+    setHeadMotion (motion);
+    frame.head = motion.at (numSamples / currentSampleRate);
+
+    if (p.ambisonicOrder > 0)
+    {
+        if (! ambisonicRunning)
+            ambisonicBank.reset();
+
+        ambisonicBank.process (inputs, numPorts, left, right, numSamples, layout, p.path, p.getLoopsPerSecond());
+        orbitPhase = ambisonicBank.getOrbitPhase();
+        frame.hasCues = false;
+    }
+    else
+    {
+        spatializerBank.process (inputs, numPorts, left, right, numSamples, layout, p.path, p.getLoopsPerSecond());
+        orbitPhase = spatializerBank.getOrbitPhase();
+        frame.cues = spatializerBank.getCurrentCues (0);
+    }
+
+    ambisonicRunning = p.ambisonicOrder > 0;
+    frame.numSources = SpatializerBank::getNumSources (numPorts, layout);
+    frame.position = { p.path.getPosition (orbitPhase).azimuth, 0.0f, SpatialDsp::referenceDistance };
+
+    finishSlice (p, Automation::fromParameters (p), frame.position.azimuth - frame.head.yaw, left, right, numSamples);
+    pushPositionFrame (frame, orbitPhase);
+}
+
+void OrbitEngine::finishSlice (const Parameters& p, const Automation& values, float heardAzimuth,
+                               float* left, float* right, int numSamples)
+{
+    if (p.reverbEnabled)
+    {
+        if (values.reverbWet != appliedReverbWet || values.reverbRoomSize != appliedRoomSize)
+        {
+            auto params = reverb.getParameters();
+            params.wetLevel = appliedReverbWet = values.reverbWet;
+            params.roomSize = appliedRoomSize = values.reverbRoomSize;
+            reverb.setParameters (params);
+        }
+
+        // The reflections glide to where the source is at the end of this slice, as the
+        // turned head hears it. They're diffuse enough that the head's yaw will do.
+        reverb.setSourceAzimuth (heardAzimuth);
+        reverb.processStereo (left, right, numSamples);
+    }
+
+    if (values.limiterCeilingDb != appliedCeilingDb)
+        limiter.setCeilingDecibels (appliedCeilingDb = values.limiterCeilingDb);
+
+    limiter.processStereo (left, right, numSamples, ! p.limiterEnabled);
+}
+
+//==============================================================================
+void OrbitEngine::pushPositionFrame (PositionFrame& frame, double orbitPhase) noexcept
+{
+    frame.orbitPhase = (float) orbitPhase;
+    frame.cues.leftDelay *= (float) (1000.0 / currentSampleRate);
+    frame.cues.rightDelay *= (float) (1000.0 / currentSampleRate);
+
+    const auto scope = positionFifo.write (1);
+    if (scope.blockSize1 > 0)
+        positionFrames[(size_t) scope.startIndex1] = frame;
+}
+
+int OrbitEngine::readPositionFrames (PositionFrame* dest, int maxFrames)
+{
+    int numRead = 0;
+    const auto scope = positionFifo.read (juce::jmin (maxFrames, positionFifo.getNumReady()));
+    scope.forEach ([&] (int index) { dest[numRead++] = positionFrames[(size_t) index]; });
+    return numRead;
+}
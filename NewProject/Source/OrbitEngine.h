@@ -0,0 +1,226 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "OrbitPreset.h"
+#include "OrbitTrajectory.h"
+#include "Spatializer.h"
+#include "SpatializerBank.h"
+#include "HrtfRenderer.h"
+#include "AmbisonicBank.h"
+#include "OrbitRoomReverb.h"
+#include "OrbitLimiter.h"
+#include "TripleBuffer.h"
+
+//==============================================================================
+// I'm the whole audio path behind one callback: the Spatializer, the HrtfRenderer, the
+// SpatializerBank or the AmbisonicBank (picked by source layout, head model and ambisonic
+// order), then the optional room reverb, whose early reflections follow the source around
+// the orbit, and last a true-peak limiter on the output bus. The limiter's lookahead is my only latency.
+// MainComponent runs me live, the OfflineRenderer runs me over files, and the benchmarks
+// time me, so all three measure and hear the same code.
+//
+// Every setting arrives as one Parameters snapshot through a TripleBuffer: the UI publishes
+// a whole struct, and I pick up the latest one once per block. A preset switch is a single
+// publish, so the audio thread sees all of it or none of it, and never pays more than one
+// atomic exchange per block. The processors' setters are only called from process().
+// Trajectories arrive the same way, already compiled into the snapshot's path table.
+//
+// A plugin host moves the continuous settings every block, which is too often for a
+// snapshot (and the path compiled with it). The plugin hands me those as an Automation
+// instead, the values to reach by the end of the next block, and I ramp to them inside
+// the block in automationSliceSize slices, as the processors ramp a moving source.
+//
+// Head tracking comes in the same way: the tracker's thread publishes each pose through
+// its own TripleBuffer, and once per block I predict where the head will be while the block
+// is heard and counter-rotate the scene with it, sub-block by sub-block.
+//
+// The other way, after every block I push a PositionFrame (where the source is and what
+// that did to each ear) into a wait-free single-producer, single-consumer ring for the
+// UI's radar. If nobody reads, the ring fills and I drop frames; it costs the audio
+// thread one AbstractFifo write either way.
+class OrbitEngine
+{
+public:
+    struct Parameters
+    {
+        float pan = 0.0f;
+        Spatializer::OrbitMode orbitMode = Spatializer::OrbitMode::Manual;
+        float panSpeedHz = 0.05f;
+        int sourceLayout = 0;       // 0 = stereo source, 1 = stereo pairs, 2 = mono channels
+        bool useHrtf = false;       // measured HRTF for the stereo source, if a set is loaded
+        int ambisonicOrder = 0;     // 1-3: the multi-source layouts share one ambisonic bus; 0 = off
+        float itdAmount = 1.0f;
+        float shadowStrength = 1.0f;
+        float depth = 0.0f;
+        float width = 1.0f;
+        bool reverbEnabled = false;
+        float reverbWet = 0.33f;
+        float reverbRoomSize = 0.5f;    // 0–1, as OrbitRoomReverb::Parameters::roomSize
+        float tempoBpm = 120.0f;
+
+        // The output limiter. Its ceiling follows live; the lookahead sets the latency, so
+        // it only takes effect at the next prepareToPlay(). Off, the limiter keeps delaying
+        // the audio, so the latency never changes under the device.
+        bool limiterEnabled = true;
+        float limiterCeilingDb = -1.0f;
+        float limiterLookaheadMs = 2.0f;
+
+        // Whether the scene counter-rotates with the head poses setHeadPose() hands me, and
+        // how far ahead of the output (in ms, past my own latency) to predict the head:
+        // the device's output latency and the tracker's own, roughly.
+        bool headTracking = false;
+        float headPredictionMs = 20.0f;
+
+        // The compiled trajectory Path mode follows (fromPreset() compiles the preset's).
+        // For the other modes setParameters() replaces it with the mode's own path, so the
+        // audio thread only ever looks positions up in this table.
+        OrbitPath path = OrbitPath::getBuiltIn (Spatializer::OrbitMode::Orbit);
+
+        // Bumped by setParameters(); I only push head-model settings down when it changes.
+        juce::uint32 version = 0;
+
+        // A preset's settings (it doesn't say whether the reverb is on), and back. The way
+        // back has only the compiled path, so it leaves the preset's trajectory at its default.
+        static Parameters fromPreset (const OrbitPreset& preset);
+        OrbitPreset toPreset() const;
+
+        // How many times a second the source goes round its path: none in Manual, the
+        // path's beats at tempoBpm if it's tempo-locked, else panSpeedHz.
+        float getLoopsPerSecond() const   { return getLoopsPerSecond (panSpeedHz, tempoBpm); }
+
+        // As above, at a speed and tempo that automation has moved.
+        float getLoopsPerSecond (float speedHz, float bpm) const;
+    };
+
+    // The settings a host automates, as Parameters has them.
+    struct Automation
+    {
+        float pan = 0.0f;
+        float panSpeedHz = 0.05f;
+        float tempoBpm = 120.0f;
+        float itdAmount = 1.0f;
+        float shadowStrength = 1.0f;
+        float depth = 0.0f;
+        float width = 1.0f;
+        float reverbWet = 0.33f;
+        float reverbRoomSize = 0.5f;
+        float limiterCeilingDb = -1.0f;
+
+        static Automation fromParameters (const Parameters& p) noexcept;
+
+        // Where a ramp from here to target is at t (0 to 1). The tempo doesn't ramp.
+        Automation interpolate (const Automation& target, float t) const noexcept;
+
+        bool operator== (const Automation& other) const noexcept;
+        bool operator!= (const Automation& other) const noexcept   { return ! operator== (other); }
+    };
+
+    static constexpr int automationSliceSize = Spatializer::controlBlockSize;
+
+    // What one block left the source at.
+    struct PositionFrame
+    {
+        Spatializer::Position position;
+        Spatializer::Cues cues;     // delays in ms; source 0's for the multi-source layouts
+        float orbitPhase = 0.0f;
+        int numSources = 1;         // spread evenly round the ring from position's azimuth
+        bool hasCues = true;        // false for the HRTF and ambisonic paths, which have no gains or delays
+        HeadOrientation head;       // where the listener's head was predicted to point
+    };
+
+    static constexpr int positionRingSize = 256;
+
+    OrbitEngine();
+    ~OrbitEngine() = default;
+
+    // numInputChannels is how many input channels the multi-source layouts read.
+    void prepareToPlay (int samplesPerBlockExpected, double sampleRate, int numInputChannels = 2);
+
+    // I process channels 0 and 1 of buffer in place (reading more channels for the
+    // multi-source layouts), with the latest published parameters.
+    void process (juce::AudioBuffer<float>& buffer, int startSample, int numSamples);
+
+    // I spatialize numPorts separate input buffers, each its own source as in the mono
+    // channels layout (whatever sourceLayout says) and through the ambisonic bus if
+    // ambisonicOrder is set, straight into left and right, then run
+    // the reverb and limiter there. For JACK, where every buffer is a port's own memory.
+    void processPorts (const float* const* inputs, int numPorts, float* left, float* right, int numSamples);
+
+    // I publish a new snapshot. Call me from one thread at a time (the message thread, live).
+    void setParameters (const Parameters& newParameters);
+
+    // From the thread that calls process(), before it: where the automated settings should
+    // be by the end of the next block. I ramp there from where the last block left them
+    // (the first call, or the first after prepareToPlay(), starts there), and from the first
+    // call on these values override the snapshot's.
+    void setAutomation (const Automation& target) noexcept;
+
+    // One writer thread (the head tracker's): I publish the latest head pose, which the next
+    // block predicts from if headTracking is on.
+    void setHeadPose (const HeadPose& pose)   { headPoses.write (pose); }
+
+    // One reader thread (the UI): I copy out up to maxFrames of the oldest frames not yet
+    // read, and return how many.
+    int readPositionFrames (PositionFrame* dest, int maxFrames);
+
+    // How many samples my output lags my input, as of the last prepareToPlay().
+    int getLatencySamples() const noexcept   { return limiter.getLatencySamples(); }
+
+    // The measured HRTF's set, which the ambisonic bus decodes with too.
+    void setHrirSet (std::shared_ptr<const HrirSet> set)   { ambisonicBank.setHrirSet (set); hrtfRenderer.setHrirSet (std::move (set)); }
+    bool hasHrirSet() const                                  { return hrtfRenderer.hasHrirSet(); }
+
+private:
+    Spatializer spatializer;
+    SpatializerBank spatializerBank;
+    HrtfRenderer hrtfRenderer;
+    AmbisonicBank ambisonicBank;
+    OrbitRoomReverb reverb;
+    OrbitLimiter limiter;
+
+    void applyHeadModel (const Parameters& snapshot);
+    void applyAutomation (const Automation& values);
+
+    // I predict the head's motion over the coming block, and hand every processor the part
+    // of it that starts at a slice.
+    HeadMotion predictHeadMotion (const Parameters& snapshot);
+    void setHeadMotion (const HeadMotion& motion);
+
+    // Whether the last block went through the ambisonic bus, whose field outlives a block;
+    // coming back to it after other blocks starts it from silence.
+    bool ambisonicRunning = false;
+
+    // I run one slice of a block through the processor the snapshot picks, with the source
+    // on path, and leave where it got to in frame.
+    double spatialize (const Parameters& p, const OrbitPath& path, float loopsPerSecond,
+                       juce::AudioBuffer<float>& buffer, int startSample, int numSamples,
+                       PositionFrame& frame);
+
+    // Everything after the spatializer, for one slice: the reverb and limiter.
+    void finishSlice (const Parameters& p, const Automation& values, float heardAzimuth,
+                      float* left, float* right, int numSamples);
+    void pushPositionFrame (PositionFrame& frame, double orbitPhase) noexcept;
+
+    TripleBuffer<Parameters> parameters;
+    TripleBuffer<HeadPose> headPoses;
+    juce::uint32 writtenVersion = 0;      // writer side
+    juce::uint32 appliedVersion = 0;      // audio thread
+    float appliedReverbWet = -1.0f;
+    float appliedRoomSize = -1.0f;
+
+    // Audio thread: the automation ramp, and the path Manual mode follows under it, moved
+    // only when the pan does.
+    bool automated = false;
+    Automation automationStart, automationTarget;
+    OrbitPath manualPath = OrbitPath::still (Spatializer::getManualPosition (0.0f));
+    float manualPathPan = 0.0f;
+
+    float appliedCeilingDb = 1.0f;
+    int numInputs = 2;
+    double currentSampleRate = 44100.0;
+
+    juce::AbstractFifo positionFifo { positionRingSize };
+    std::vector<PositionFrame> positionFrames;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (OrbitEngine)
+};
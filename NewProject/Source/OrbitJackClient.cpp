@@ -0,0 +1,354 @@
+#include "OrbitJackClient.h"
+
+#if JUCE_JACK
+ // Only the headers are needed at build time (JUCE's JACK backend includes them too);
+ // libjack itself is opened at run time below. See README, "JACK (Linux)".
+ #include <jack/jack.h>
+ #include <dlfcn.h>
+
+//==============================================================================
+namespace
+{
+    // The libjack entry points I use, looked up once. Nothing links against libjack.
+    struct JackLibrary
+    {
+        JackLibrary()
+        {
+           #if JUCE_MAC
+            handle = dlopen ("libjack.dylib", RTLD_LAZY);
+           #else
+            handle = dlopen ("libjack.so.0", RTLD_LAZY);
+            if (handle == nullptr)
+                handle = dlopen ("libjack.so", RTLD_LAZY);
+           #endif
+
+            if (handle == nullptr)
+                return;
+
+            loaded = load (clientOpen, "jack_client_open")
+                  && load (clientClose, "jack_client_close")
+                  && load (getClientName, "jack_get_client_name")
+                  && load (activate, "jack_activate")
+                  && load (deactivate, "jack_deactivate")
+                  && load (getBufferSize, "jack_get_buffer_size")
+                  && load (getSampleRate, "jack_get_sample_rate")
+                  && load (onShutdown, "jack_on_shutdown")
+                  && load (setProcessCallback, "jack_set_process_callback")
+                  && load (setBufferSizeCallback, "jack_set_buffer_size_callback")
+                  && load (setXRunCallback, "jack_set_xrun_callback")
+                  && load (portRegister, "jack_port_register")
+                  && load (portUnregister, "jack_port_unregister")
+                  && load (portGetBuffer, "jack_port_get_buffer")
+                  && load (portName, "jack_port_name")
+                  && load (getPorts, "jack_get_ports")
+                  && load (connect, "jack_connect")
+                  && load (freeMemory, "jack_free");
+        }
+
+        template <typename Function>
+        bool load (Function& function, const char* symbol)
+        {
+            function = reinterpret_cast<Function> (dlsym (handle, symbol));
+            return function != nullptr;
+        }
+
+        void* handle = nullptr;
+        bool loaded = false;
+
+        decltype (&jack_client_open) clientOpen = nullptr;
+        decltype (&jack_client_close) clientClose = nullptr;
+        decltype (&jack_get_client_name) getClientName = nullptr;
+        decltype (&jack_activate) activate = nullptr;
+        decltype (&jack_deactivate) deactivate = nullptr;
+        decltype (&jack_get_buffer_size) getBufferSize = nullptr;
+        decltype (&jack_get_sample_rate) getSampleRate = nullptr;
+        decltype (&jack_on_shutdown) onShutdown = nullptr;
+        decltype (&jack_set_process_callback) setProcessCallback = nullptr;
+        decltype (&jack_set_buffer_size_callback) setBufferSizeCallback = nullptr;
+        decltype (&jack_set_xrun_callback) setXRunCallback = nullptr;
+        decltype (&jack_port_register) portRegister = nullptr;
+        decltype (&jack_port_unregister) portUnregister = nullptr;
+        decltype (&jack_port_get_buffer) portGetBuffer = nullptr;
+        decltype (&jack_port_name) portName = nullptr;
+        decltype (&jack_get_ports) getPorts = nullptr;
+        decltype (&jack_connect) connect = nullptr;
+        decltype (&jack_free) freeMemory = nullptr;
+    };
+
+    JackLibrary& getJackLibrary()
+    {
+        static JackLibrary library;
+        return library;
+    }
+}
+
+//==============================================================================
+struct OrbitJackClient::Impl
+{
+    const JackLibrary& jack = getJackLibrary();
+
+    jack_client_t* client = nullptr;
+    Callback* callback = nullptr;
+
+    // Written by the message thread, read by the process thread. A port's slot is filled
+    // before the count covers it and emptied only after the count has dropped below it
+    // and the cycle that might still use it has ended.
+    std::array<std::atomic<jack_port_t*>, maxInputPorts> inputPorts {};
+    std::atomic<int> numInputPorts { 0 };
+    jack_port_t* outputPorts[2] = {};
+
+    std::atomic<juce::uint32> cyclesDone { 0 };
+    std::atomic<int> xruns { 0 };
+    std::atomic<bool> shutDown { false };
+
+    int wantedInputPorts = 2;
+
+    //==============================================================================
+    static int processCallback (jack_nframes_t numFrames, void* arg)
+    {
+        static_cast<Impl*> (arg)->process (numFrames);
+        return 0;
+    }
+
+    static int bufferSizeCallback (jack_nframes_t numFrames, void* arg)
+    {
+        auto& self = *static_cast<Impl*> (arg);
+        self.callback->jackAboutToStart ((double) self.jack.getSampleRate (self.client), (int) numFrames);
+        return 0;
+    }
+
+    static int xrunCallback (void* arg)
+    {
+        static_cast<Impl*> (arg)->xruns.fetch_add (1, std::memory_order_relaxed);
+        return 0;
+    }
+
+    static void shutdownCallback (void* arg)
+    {
+        static_cast<Impl*> (arg)->shutDown.store (true);
+    }
+
+    void process (jack_nframes_t numFrames) noexcept
+    {
+        const int numInputs = numInputPorts.load (std::memory_order_acquire);
+
+        const float* inputs[maxInputPorts];
+        for (int i = 0; i < numInputs; ++i)
+            inputs[i] = static_cast<const float*> (jack.portGetBuffer (inputPorts[(size_t) i].load (std::memory_order_relaxed),
+                                                                       numFrames));
+
+        auto* left = static_cast<float*> (jack.portGetBuffer (outputPorts[0], numFrames));
+        auto* right = static_cast<float*> (jack.portGetBuffer (outputPorts[1], numFrames));
+
+        // With no sources the engine leaves the outputs alone, and JACK doesn't clear them.
+        if (numInputs == 0)
+        {
+            juce::FloatVectorOperations::clear (left, (int) numFrames);
+            juce::FloatVectorOperations::clear (right, (int) numFrames);
+        }
+
+        callback->jackProcess (inputs, numInputs, left, right, (int) numFrames);
+        cyclesDone.fetch_add (1, std::memory_order_release);
+    }
+
+    //==============================================================================
+    void resizeInputs (int numPorts)
+    {
+        const int current = numInputPorts.load();
+
+        int registered = current;
+        while (registered < numPorts)
+        {
+            const auto portName = "in_" + juce::String (registered + 1);
+            auto* port = jack.portRegister (client, portName.toRawUTF8(), JACK_DEFAULT_AUDIO_TYPE, JackPortIsInput, 0);
+            if (port == nullptr)
+                break;
+
+            inputPorts[(size_t) registered].store (port, std::memory_order_relaxed);
+            ++registered;
+        }
+
+        numInputPorts.store (juce::jmin (registered, numPorts), std::memory_order_release);
+
+        if (numPorts < current)
+        {
+            waitForCycleToEnd();
+
+            for (int i = numPorts; i < current; ++i)
+                jack.portUnregister (client, inputPorts[(size_t) i].exchange (nullptr));
+        }
+    }
+
+    // A cycle that started before the count dropped has ended once two more have been
+    // counted. If the server has stopped calling me, nothing is using the ports anyway.
+    void waitForCycleToEnd() const
+    {
+        const auto start = cyclesDone.load (std::memory_order_acquire);
+        const auto deadline = juce::Time::getMillisecondCounter() + 500;
+
+        while (cyclesDone.load (std::memory_order_acquire) - start < 2
+                && juce::Time::getMillisecondCounter() < deadline
+                && ! shutDown.load())
+            juce::Thread::sleep (1);
+    }
+
+    void connectOutputsToPlayback()
+    {
+        const auto** playback = jack.getPorts (client, nullptr, JACK_DEFAULT_AUDIO_TYPE, JackPortIsPhysical | JackPortIsInput);
+        if (playback == nullptr)
+            return;
+
+        for (int i = 0; i < 2 && playback[i] != nullptr; ++i)
+            jack.connect (client, jack.portName (outputPorts[i]), playback[i]);
+
+        jack.freeMemory (playback);
+    }
+};
+
+//==============================================================================
+OrbitJackClient::OrbitJackClient()  : impl (std::make_unique<Impl>()) {}
+
+OrbitJackClient::~OrbitJackClient()
+{
+    close();
+}
+
+bool OrbitJackClient::isAvailable()
+{
+    return getJackLibrary().loaded;
+}
+
+juce::String OrbitJackClient::open (int numInputPorts, Callback& callback)
+{
+    close();
+
+    auto& jack = impl->jack;
+    if (! jack.loaded)
+        return "JACK isn't installed (libjack couldn't be loaded).";
+
+    jack_status_t status {};
+    impl->client = jack.clientOpen (ProjectInfo::projectName, JackNoStartServer, &status);
+    if (impl->client == nullptr)
+        return "Couldn't connect to a JACK server. Is it running?";
+
+    impl->callback = &callback;
+    impl->shutDown = false;
+    impl->xruns = 0;
+
+    impl->outputPorts[0] = jack.portRegister (impl->client, "out_L", JACK_DEFAULT_AUDIO_TYPE, JackPortIsOutput, 0);
+    impl->outputPorts[1] = jack.portRegister (impl->client, "out_R", JACK_DEFAULT_AUDIO_TYPE, JackPortIsOutput, 0);
+    if (impl->outputPorts[0] == nullptr || impl->outputPorts[1] == nullptr)
+    {
+        close();
+        return "Couldn't register the JACK output ports.";
+    }
+
+    impl->wantedInputPorts = juce::jlimit (0, maxInputPorts, numInputPorts);
+    impl->resizeInputs (impl->wantedInputPorts);
+
+    callback.jackAboutToStart ((double) jack.getSampleRate (impl->client), (int) jack.getBufferSize (impl->client));
+
+    jack.setProcessCallback (impl->client, Impl::processCallback, impl.get());
+    jack.setBufferSizeCallback (impl->client, Impl::bufferSizeCallback, impl.get());
+    jack.setXRunCallback (impl->client, Impl::xrunCallback, impl.get());
+    jack.onShutdown (impl->client, Impl::shutdownCallback, impl.get());
+
+    if (jack.activate (impl->client) != 0)
+    {
+        close();
+        return "Couldn't activate the JACK client.";
+    }
+
+    impl->connectOutputsToPlayback();
+    return {};
+}
+
+void OrbitJackClient::close()
+{
+    if (impl->client != nullptr)
+    {
+        // After a server shutdown the client is a husk: closing it is all that's left.
+        if (! impl->shutDown.load())
+            impl->jack.deactivate (impl->client);
+
+        impl->jack.clientClose (impl->client);
+        impl->client = nullptr;
+    }
+
+    for (auto& port : impl->inputPorts)
+        port.store (nullptr);
+
+    impl->numInputPorts = 0;
+    impl->outputPorts[0] = impl->outputPorts[1] = nullptr;
+    impl->callback = nullptr;
+    impl->shutDown = false;
+}
+
+bool OrbitJackClient::isOpen() const noexcept
+{
+    return impl->client != nullptr;
+}
+
+void OrbitJackClient::setNumInputPorts (int numInputPorts)
+{
+    impl->wantedInputPorts = juce::jlimit (0, maxInputPorts, numInputPorts);
+
+    if (isOpen() && ! impl->shutDown.load())
+        impl->resizeInputs (impl->wantedInputPorts);
+}
+
+int OrbitJackClient::getNumInputPorts() const noexcept
+{
+    return isOpen() ? impl->numInputPorts.load() : impl->wantedInputPorts;
+}
+
+bool OrbitJackClient::wasShutDown() const noexcept
+{
+    return impl->shutDown.load();
+}
+
+double OrbitJackClient::getSampleRate() const
+{
+    return isOpen() && ! wasShutDown() ? (double) impl->jack.getSampleRate (impl->client) : 0.0;
+}
+
+int OrbitJackClient::getBufferSize() const
+{
+    return isOpen() && ! wasShutDown() ? (int) impl->jack.getBufferSize (impl->client) : 0;
+}
+
+int OrbitJackClient::getXRunCount() const noexcept
+{
+    return impl->xruns.load (std::memory_order_relaxed);
+}
+
+juce::String OrbitJackClient::getClientName() const
+{
+    return isOpen() ? juce::String::fromUTF8 (impl->jack.getClientName (impl->client)) : juce::String();
+}
+
+#else
+
+//==============================================================================
+// Without JUCE_JACK there's no jack.h to build against, so I never open.
+struct OrbitJackClient::Impl
+{
+    int wantedInputPorts = 2;
+};
+
+OrbitJackClient::OrbitJackClient()  : impl (std::make_unique<Impl>()) {}
+OrbitJackClient::~OrbitJackClient() = default;
+
+bool OrbitJackClient::isAvailable()                                 { return false; }
+juce::String OrbitJackClient::open (int, Callback&)                 { return "This build has no JACK support."; }
+void OrbitJackClient::close()                                       {}
+bool OrbitJackClient::isOpen() const noexcept                       { return false; }
+void OrbitJackClient::setNumInputPorts (int numInputPorts)          { impl->wantedInputPorts = juce::jlimit (0, maxInputPorts, numInputPorts); }
+int OrbitJackClient::getNumInputPorts() const noexcept              { return impl->wantedInputPorts; }
+bool OrbitJackClient::wasShutDown() const noexcept                  { return false; }
+double OrbitJackClient::getSampleRate() const                       { return 0.0; }
+int OrbitJackClient::getBufferSize() const                          { return 0; }
+int OrbitJackClient::getXRunCount() const noexcept                  { return 0; }
+juce::String OrbitJackClient::getClientName() const                 { return {}; }
+
+#endif
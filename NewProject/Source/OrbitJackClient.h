@@ -0,0 +1,69 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "SpatializerBank.h"
+
+//==============================================================================
+// I'm OrbitAudio as a JACK client of its own, for the Linux boxes that run JACK: a row of
+// input ports (in_1, in_2, ...), each of which the engine spatializes as its own source,
+// and a binaural pair out (out_L, out_R). JUCE's JACK device mirrors the hardware's ports
+// and hands its callback whichever happen to be connected; I register exactly as many
+// inputs as asked for, change that number while running, and give the callback the
+// jack_port_get_buffer memory itself, with no copy into an AudioBuffer.
+//
+// libjack is loaded when I open, the way JUCE loads it, so the app still starts on a
+// machine without JACK. The process thread sees the input ports through atomics: I
+// register new ports before I publish the larger count, and when ports go, I publish the
+// smaller count and wait for the cycle in flight to end before unregistering them.
+// Builds without JUCE_JACK get a client that never opens.
+class OrbitJackClient
+{
+public:
+    static constexpr int maxInputPorts = SpatializerBank::maxSources;
+
+    // Called on JACK's process thread, except where noted.
+    struct Callback
+    {
+        virtual ~Callback() = default;
+
+        // Before the first cycle (on the thread that calls open()), and again whenever the
+        // server changes its buffer size, between two cycles.
+        virtual void jackAboutToStart (double sampleRate, int bufferSize) = 0;
+
+        // The input ports' buffers, which are only to be read, and the output ports'.
+        virtual void jackProcess (const float* const* inputs, int numInputs,
+                                  float* left, float* right, int numSamples) = 0;
+    };
+
+    OrbitJackClient();
+    ~OrbitJackClient();
+
+    // Whether this build has JACK support and libjack can be loaded.
+    static bool isAvailable();
+
+    // Message thread. I open a client, register numInputPorts inputs and the outputs,
+    // connect the outputs to the first two playback ports and start calling callback.
+    // I return an error message, or an empty string.
+    juce::String open (int numInputPorts, Callback& callback);
+    void close();
+    bool isOpen() const noexcept;
+
+    // Message thread, open or not: I add or remove input ports from the end. Connections to
+    // the ports that stay are kept.
+    void setNumInputPorts (int numInputPorts);
+    int getNumInputPorts() const noexcept;
+
+    // True once the server has gone away under an open client; close() clears it.
+    bool wasShutDown() const noexcept;
+
+    double getSampleRate() const;
+    int getBufferSize() const;
+    int getXRunCount() const noexcept;
+    juce::String getClientName() const;
+
+private:
+    struct Impl;    // the JACK types stay in the .cpp
+    std::unique_ptr<Impl> impl;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (OrbitJackClient)
+};
@@ -0,0 +1,190 @@
+#include "OrbitLimiter.h"
+#include "SpatialDsp.h"
+
+//==============================================================================
+OrbitLimiter::OrbitLimiter()
+{
+    // Each phase is a Blackman-windowed sinc reaching 6 samples either side, normalized
+    // to unity gain at DC so a constant never reads as a peak above itself.
+    const double halfLength = (double) detectorLatency;
+
+    for (int p = 1; p < oversampling; ++p)
+    {
+        const double fraction = (double) p / (double) oversampling;
+        double sum = 0.0;
+        double taps[tapsPerPhase];
+
+        // Tap k weighs the sample k - 5 places from the one the phase follows.
+        for (int k = 0; k < tapsPerPhase; ++k)
+        {
+            const double t = fraction - (double) (k - (detectorLatency - 1));
+            const double x = juce::MathConstants<double>::pi * t;
+            const double sinc = std::abs (t) < 1.0e-9 ? 1.0 : std::sin (x) / x;
+            const double w = 0.42 + 0.5 * std::cos (juce::MathConstants<double>::pi * t / halfLength)
+                           + 0.08 * std::cos (juce::MathConstants<double>::twoPi * t / halfLength);
+            taps[k] = sinc * w;
+            sum += taps[k];
+        }
+
+        for (int k = 0; k < tapsPerPhase; ++k)
+            phases[p - 1][k] = (float) (taps[k] / sum);
+    }
+
+    prepare (sampleRate, 2.0f);
+}
+
+void OrbitLimiter::prepare (double newSampleRate, float lookaheadMs)
+{
+    sampleRate = newSampleRate;
+
+    const double lookaheadSamples = juce::jlimit (minLookaheadMs, maxLookaheadMs, lookaheadMs) * 0.001 * sampleRate;
+    lookaheadBlocks = juce::jmax (1, (int) std::ceil (lookaheadSamples / subBlockSize));
+
+    // A sub-block's gain is settled when it ends, and the ramp towards a peak has to
+    // finish as the sub-block holding it starts: so one sub-block on top of the lookahead.
+    latency = (lookaheadBlocks + 1) * subBlockSize + detectorLatency;
+
+    delayMemory.allocate ((size_t) (2 * latency), true);
+    ringL = delayMemory.getData();
+    ringR = ringL + latency;
+
+    const int windowSize = lookaheadBlocks + 1;
+    requiredGains.allocate ((size_t) windowSize, true);
+    gainBounds.allocate ((size_t) windowSize, true);
+    attackSlopes.allocate ((size_t) windowSize, true);
+
+    // The window holds the sub-block about to be played, then lookaheadBlocks beyond it.
+    // The next two must be reached exactly; one further out may sit a step of the ramp
+    // higher for each sub-block still to go.
+    for (int d = 0; d < windowSize; ++d)
+        attackSlopes[d] = (float) juce::jmax (0, d - 1) / (float) lookaheadBlocks;
+
+    setReleaseMs (releaseMs);
+    reset();
+}
+
+void OrbitLimiter::reset()
+{
+    juce::FloatVectorOperations::clear (delayMemory.getData(), 2 * latency);
+    juce::FloatVectorOperations::fill (requiredGains.getData(), 1.0f, lookaheadBlocks + 1);
+    juce::FloatVectorOperations::fill (gainRamp, 1.0f, subBlockSize);
+    std::fill (std::begin (historyL), std::end (historyL), 0.0f);
+    std::fill (std::begin (historyR), std::end (historyR), 0.0f);
+
+    ringPosition = 0;
+    gain = 1.0f;
+    subBlockPeak = 0.0f;
+    subBlockFill = 0;
+}
+
+void OrbitLimiter::setCeilingDecibels (float ceilingDb) noexcept
+{
+    ceiling = juce::Decibels::decibelsToGain (juce::jmin (0.0f, ceilingDb));
+}
+
+void OrbitLimiter::setReleaseMs (float newReleaseMs) noexcept
+{
+    releaseMs = juce::jmax (1.0f, newReleaseMs);
+    releaseCoefficient = (float) std::exp (-subBlockSize / (0.001 * releaseMs * sampleRate));
+}
+
+//==============================================================================
+float OrbitLimiter::detectPeak (const float* input, float* history, int numSamples) noexcept
+{
+    std::copy (history, history + historySize, scratch);
+    std::copy (input, input + numSamples, scratch + historySize);
+
+    // The samples themselves (phase 0), 6 behind the newest...
+    auto range = juce::FloatVectorOperations::findMinAndMax (scratch + detectorLatency - 1, numSamples);
+    float peak = juce::jmax (-range.getStart(), range.getEnd());
+
+    // ...and the three points after each of them. The tap loop has a fixed length, so
+    // the compiler runs it across several samples at once.
+    for (const auto& taps : phases)
+    {
+        for (int i = 0; i < numSamples; ++i)
+        {
+            float sum = 0.0f;
+            for (int k = 0; k < tapsPerPhase; ++k)
+                sum += taps[k] * scratch[i + k];
+            interpolated[i] = sum;
+        }
+
+        range = juce::FloatVectorOperations::findMinAndMax (interpolated, numSamples);
+        peak = juce::jmax (peak, -range.getStart(), range.getEnd());
+    }
+
+    std::copy (scratch + numSamples, scratch + numSamples + historySize, history);
+    return peak;
+}
+
+void OrbitLimiter::delay (float* samples, float* ring, int numSamples) noexcept
+{
+    // The ring is exactly one latency long, so what sits at the position is the sample
+    // from latency samples ago: I swap it out for the new one.
+    for (int done = 0, position = ringPosition; done < numSamples;)
+    {
+        const int n = juce::jmin (numSamples - done, latency - position);
+        float* r = ring + position;
+        float* s = samples + done;
+
+        for (int i = 0; i < n; ++i)
+            std::swap (r[i], s[i]);
+
+        done += n;
+        position = 0;
+    }
+}
+
+void OrbitLimiter::finishSubBlock (bool bypassed) noexcept
+{
+    const int windowSize = lookaheadBlocks + 1;
+
+    std::memmove (requiredGains.getData(), requiredGains.getData() + 1, sizeof (float) * (size_t) lookaheadBlocks);
+    requiredGains[lookaheadBlocks] = subBlockPeak > ceiling ? ceiling / subBlockPeak : 1.0f;
+    subBlockPeak = 0.0f;
+
+    // The highest gain that still reaches every peak in the window on time.
+    for (int d = 0; d < windowSize; ++d)
+        gainBounds[d] = requiredGains[d] + (1.0f - requiredGains[d]) * attackSlopes[d];
+
+    const float attack = juce::FloatVectorOperations::findMinimum (gainBounds.getData(), windowSize);
+    const float release = 1.0f - (1.0f - gain) * releaseCoefficient;
+    const float target = bypassed ? 1.0f : juce::jmin (attack, release);
+
+    SpatialDsp::fillRamp (gainRamp, gain, target, subBlockSize);
+    gain = target;
+}
+
+void OrbitLimiter::processStereo (float* left, float* right, int numSamples, bool bypassed) noexcept
+{
+    while (numSamples > 0)
+    {
+        // Chunks never cross a sub-block boundary.
+        const int n = juce::jmin (numSamples, subBlockSize - subBlockFill);
+
+        subBlockPeak = juce::jmax (subBlockPeak, detectPeak (left, historyL, n), detectPeak (right, historyR, n));
+
+        delay (left, ringL, n);
+        delay (right, ringR, n);
+        ringPosition = (ringPosition + n) % latency;
+
+        // Most of the time the ramp is flat at 1 and there is nothing to multiply.
+        if (gainRamp[0] != 1.0f || gainRamp[subBlockSize - 1] != 1.0f)
+        {
+            juce::FloatVectorOperations::multiply (left, gainRamp + subBlockFill, n);
+            juce::FloatVectorOperations::multiply (right, gainRamp + subBlockFill, n);
+        }
+
+        subBlockFill += n;
+        if (subBlockFill == subBlockSize)
+        {
+            finishSubBlock (bypassed);
+            subBlockFill = 0;
+        }
+
+        left += n;
+        right += n;
+        numSamples -= n;
+    }
+}
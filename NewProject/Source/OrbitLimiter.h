@@ -0,0 +1,105 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+// I'm a lookahead true-peak limiter for the stereo output bus: whatever the spatializer
+// and reverb produce, the reconstructed waveform stays under the ceiling (-1 dBTP by
+// default), including the peaks that fall between samples.
+//
+// I estimate the true peak at 4x oversampling with a polyphase windowed-sinc
+// interpolator: three 12-tap phases compute the points between each pair of samples,
+// each one a fixed-length loop over a whole sub-block that the compiler vectorizes. The
+// interpolator needs 6 samples of future, so my peaks lag the audio by that much. As
+// with the BS.1770 meter's own 4x estimate, content right up at Nyquist can peak a little
+// above what I see.
+//
+// Gain is computed once per 32-sample sub-block, never per sample: a SIMD max-reduction
+// gives the sub-block's peak, and from the last lookahead's worth of peaks I pick the
+// gain at the sub-block's end, so the gain ramps down linearly over the lookahead to
+// reach each peak's required gain just as that peak arrives, and recovers with a
+// one-pole release. Within a sub-block the gain is a linear ramp, applied with a vector
+// multiply. The audio is delayed by the lookahead plus one sub-block and the
+// interpolator's 6 samples; getLatencySamples() says exactly how much.
+//
+// I'm designed to run on the audio thread only; only prepare() allocates.
+class OrbitLimiter
+{
+public:
+    static constexpr int subBlockSize = 32;
+    static constexpr int oversampling = 4;
+    static constexpr int tapsPerPhase = 12;
+    static constexpr int detectorLatency = tapsPerPhase / 2;
+    static constexpr float minLookaheadMs = 1.0f;
+    static constexpr float maxLookaheadMs = 5.0f;
+
+    OrbitLimiter();
+    ~OrbitLimiter() = default;
+
+    // I size the delay for a rate and a lookahead (clamped to 1-5 ms, rounded up to whole
+    // sub-blocks), and clear all state. This allocates.
+    void prepare (double newSampleRate, float lookaheadMs);
+
+    // I clear the delay, the detector and the gain, keeping the sizes.
+    void reset();
+
+    // The ceiling for the true peak, in dBTP (at most 0).
+    void setCeilingDecibels (float ceilingDb) noexcept;
+    float getCeilingDecibels() const noexcept   { return juce::Decibels::gainToDecibels (ceiling); }
+
+    // How long gain takes to recover by 1 - 1/e after a peak has passed.
+    void setReleaseMs (float newReleaseMs) noexcept;
+
+    // How many samples my output lags my input.
+    int getLatencySamples() const noexcept   { return latency; }
+
+    // The lookahead in use: the attack ramp's length, in samples.
+    int getLookaheadSamples() const noexcept   { return lookaheadBlocks * subBlockSize; }
+
+    // The gain at the end of the last sub-block (1 when I'm not limiting).
+    float getCurrentGain() const noexcept   { return gain; }
+
+    // I limit left and right in place. Bypassed, I still delay the audio by the same
+    // latency but leave the gain at 1, so switching me never moves the output in time.
+    void processStereo (float* left, float* right, int numSamples, bool bypassed = false) noexcept;
+
+private:
+    static constexpr int historySize = tapsPerPhase - 1;
+
+    float detectPeak (const float* input, float* history, int numSamples) noexcept;
+    void delay (float* samples, float* ring, int numSamples) noexcept;
+    void finishSubBlock (bool bypassed) noexcept;
+
+    double sampleRate = 44100.0;
+    int lookaheadBlocks = 1;
+    int latency = 0;
+    float ceiling = juce::Decibels::decibelsToGain (-1.0f);
+    float releaseMs = 50.0f;
+    float releaseCoefficient = 0.0f;   // per sub-block
+
+    // The interpolator's phases at 1/4, 2/4 and 3/4 of the way to the next sample; the
+    // phase at 0 is the sample itself.
+    float phases[oversampling - 1][tapsPerPhase] = {};
+
+    // Detector input: the last historySize samples, then the current chunk.
+    float historyL[historySize] = {}, historyR[historySize] = {};
+    float scratch[historySize + subBlockSize] = {};
+    float interpolated[subBlockSize] = {};
+
+    // The audio delay, one ring per ear, read and written at the same position.
+    juce::HeapBlock<float> delayMemory;
+    float* ringL = nullptr;
+    float* ringR = nullptr;
+    int ringPosition = 0;
+
+    // The required gain of each of the last lookaheadBlocks + 1 sub-blocks, oldest
+    // first, and how far each may sit above it for the ramp to reach it in time.
+    juce::HeapBlock<float> requiredGains, attackSlopes, gainBounds;
+
+    float gainRamp[subBlockSize] = {};
+    float gain = 1.0f;
+    float subBlockPeak = 0.0f;
+    int subBlockFill = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (OrbitLimiter)
+};
@@ -0,0 +1,194 @@
+#include <JuceHeader.h>
+#include "OrbitLimiter.h"
+
+//==============================================================================
+// I test OrbitLimiter: below the ceiling it only delays, by exactly the latency it
+// reports; above it, the true peak (measured at 16x here, with a far longer filter than
+// the limiter's own) stays under the ceiling, inter-sample peaks included; the lookahead
+// covers what was asked at every rate; and the gain recovers once the peak has passed.
+class OrbitLimiterTest : public juce::UnitTest
+{
+public:
+    OrbitLimiterTest() : juce::UnitTest ("OrbitLimiter", "Audio") {}
+
+    // The true peak of a signal, by 16x windowed-sinc interpolation 32 samples either side.
+    static float measureTruePeak (const float* samples, int numSamples)
+    {
+        constexpr int factor = 16, half = 32;
+        float peak = 0.0f;
+
+        for (int i = half; i < numSamples - half; ++i)
+        {
+            peak = juce::jmax (peak, std::abs (samples[i]));
+
+            for (int p = 1; p < factor; ++p)
+            {
+                double sum = 0.0;
+                for (int j = -half + 1; j <= half; ++j)
+                {
+                    const double t = (double) p / factor - j;
+                    const double x = juce::MathConstants<double>::pi * t;
+                    const double w = 0.5 + 0.5 * std::cos (juce::MathConstants<double>::pi * t / half);
+                    sum += samples[i + j] * std::sin (x) / x * w;
+                }
+
+                peak = juce::jmax (peak, (float) std::abs (sum));
+            }
+        }
+
+        return peak;
+    }
+
+    // I run buffer through limiter in uneven blocks, as a device might call it.
+    static void processInBlocks (OrbitLimiter& limiter, juce::AudioBuffer<float>& buffer, bool bypassed = false)
+    {
+        const int blockSizes[] = { 100, 37, 256, 1, 64 };
+        for (int start = 0, b = 0; start < buffer.getNumSamples(); ++b)
+        {
+            const int n = juce::jmin (blockSizes[b % 5], buffer.getNumSamples() - start);
+            limiter.processStereo (buffer.getWritePointer (0, start), buffer.getWritePointer (1, start), n, bypassed);
+            start += n;
+        }
+    }
+
+    void runTest() override
+    {
+        beginTest ("below the ceiling, audio is only delayed by the reported latency");
+        {
+            OrbitLimiter limiter;
+            limiter.prepare (48000.0, 3.0f);
+            const int latency = limiter.getLatencySamples();
+
+            juce::AudioBuffer<float> input (2, 8192);
+            juce::Random random (5);
+            for (int ch = 0; ch < 2; ++ch)
+                for (int i = 0; i < input.getNumSamples(); ++i)
+                    input.setSample (ch, i, 0.4f * (random.nextFloat() - 0.5f));
+
+            auto output = input;
+            processInBlocks (limiter, output);
+
+            for (int ch = 0; ch < 2; ++ch)
+            {
+                for (int i = 0; i < latency; ++i)
+                    expectEquals (output.getSample (ch, i), 0.0f);
+                for (int i = latency; i < output.getNumSamples(); ++i)
+                    expectEquals (output.getSample (ch, i), input.getSample (ch, i - latency));
+            }
+
+            expectEquals (limiter.getCurrentGain(), 1.0f);
+        }
+
+        beginTest ("the latency covers the lookahead at every rate");
+        {
+            OrbitLimiter limiter;
+            for (double sampleRate : { 44100.0, 48000.0, 88200.0, 96000.0, 176400.0, 192000.0 })
+            {
+                for (float ms : { 0.2f, 1.0f, 2.5f, 5.0f, 20.0f })
+                {
+                    limiter.prepare (sampleRate, ms);
+                    const double asked = juce::jlimit (OrbitLimiter::minLookaheadMs, OrbitLimiter::maxLookaheadMs, ms) * 0.001 * sampleRate;
+
+                    expectGreaterOrEqual ((double) limiter.getLookaheadSamples(), asked);
+                    expectLessThan ((double) limiter.getLookaheadSamples(), asked + OrbitLimiter::subBlockSize);
+                    expectEquals (limiter.getLatencySamples(), limiter.getLookaheadSamples() + OrbitLimiter::subBlockSize
+                                                                   + OrbitLimiter::detectorLatency);
+                }
+            }
+        }
+
+        beginTest ("inter-sample peaks stay under the ceiling");
+        {
+            // A quarter-rate sine at 45 degrees: every sample is at 0.707 of the peak, so
+            // a sample-peak limiter at -1 dB would let a full-scale true peak through.
+            const double sampleRate = 48000.0;
+            juce::AudioBuffer<float> buffer (2, 24000);
+            for (int i = 0; i < buffer.getNumSamples(); ++i)
+            {
+                const double phase = juce::MathConstants<double>::halfPi * i + juce::MathConstants<double>::pi / 4.0;
+                const float envelope = i < 12000 ? 1.0f : 1.6f;
+                buffer.setSample (0, i, envelope * (float) std::sin (phase));
+                buffer.setSample (1, i, 0.5f * (float) std::sin (phase));
+            }
+
+            const float samplePeak = buffer.getMagnitude (0, 0, 12000);
+            expectLessThan (samplePeak, juce::Decibels::decibelsToGain (-1.0f), "samples alone look safe");
+            expectGreaterThan (measureTruePeak (buffer.getReadPointer (0), 12000), 0.99f, "but the waveform isn't");
+
+            OrbitLimiter limiter;
+            limiter.prepare (sampleRate, 2.0f);
+            processInBlocks (limiter, buffer);
+
+            const float ceiling = juce::Decibels::decibelsToGain (-1.0f);
+            for (int ch = 0; ch < 2; ++ch)
+                expectLessThan (measureTruePeak (buffer.getReadPointer (ch), buffer.getNumSamples()), ceiling * 1.01f);
+
+            expectWithinAbsoluteError (limiter.getCurrentGain(), ceiling / 1.6f, 0.01f);
+        }
+
+        beginTest ("loud bursts are caught ahead of time and released after");
+        {
+            const double sampleRate = 44100.0;
+            juce::AudioBuffer<float> buffer (2, 44100);
+            juce::Random random (11);
+            for (int i = 0; i < buffer.getNumSamples(); ++i)
+            {
+                // Quiet noise with a 10x burst of 1000 samples, then 200 ms of quiet.
+                const float level = i >= 20000 && i < 21000 ? 3.0f : 0.3f;
+                for (int ch = 0; ch < 2; ++ch)
+                    buffer.setSample (ch, i, level * (random.nextFloat() * 2.0f - 1.0f));
+            }
+
+            // Band-limited to 16 kHz, like program material: white noise right up to
+            // Nyquist can peak further between samples than any 4x estimate sees.
+            for (int ch = 0; ch < 2; ++ch)
+            {
+                for (int pass = 0; pass < 2; ++pass)
+                {
+                    juce::IIRFilter lowPass;
+                    lowPass.setCoefficients (juce::IIRCoefficients::makeLowPass (sampleRate, 16000.0));
+                    lowPass.processSamples (buffer.getWritePointer (ch), buffer.getNumSamples());
+                }
+            }
+            const auto input = buffer;
+
+            OrbitLimiter limiter;
+            limiter.setCeilingDecibels (-3.0f);
+            limiter.prepare (sampleRate, 5.0f);
+            processInBlocks (limiter, buffer);
+
+            const float ceiling = juce::Decibels::decibelsToGain (-3.0f);
+            for (int ch = 0; ch < 2; ++ch)
+                expectLessThan (measureTruePeak (buffer.getReadPointer (ch), buffer.getNumSamples()), ceiling * 1.03f);
+
+            // The gain is down before the burst's first sample comes out, and back to
+            // unity by the end.
+            const int latency = limiter.getLatencySamples();
+            const int burstOut = 20000 + latency;
+            const float before = buffer.getSample (0, burstOut - 1) / input.getSample (0, 19999);
+            expectLessThan (before, 0.5f);
+            expectWithinAbsoluteError (limiter.getCurrentGain(), 1.0f, 1.0e-3f);
+        }
+
+        beginTest ("bypassed, it still delays but leaves the level alone");
+        {
+            OrbitLimiter limiter;
+            limiter.prepare (96000.0, 1.0f);
+            const int latency = limiter.getLatencySamples();
+
+            juce::AudioBuffer<float> input (2, 4096);
+            for (int i = 0; i < input.getNumSamples(); ++i)
+                for (int ch = 0; ch < 2; ++ch)
+                    input.setSample (ch, i, 2.0f * (float) std::sin (0.01 * i + ch));
+
+            auto output = input;
+            processInBlocks (limiter, output, true);
+
+            for (int ch = 0; ch < 2; ++ch)
+                for (int i = latency; i < output.getNumSamples(); ++i)
+                    expectEquals (output.getSample (ch, i), input.getSample (ch, i - latency));
+        }
+    }
+};
+
+static OrbitLimiterTest orbitLimiterTest;
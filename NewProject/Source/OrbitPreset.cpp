@@ -0,0 +1,141 @@
+#include "OrbitPreset.h"
+
+//==============================================================================
+Spatializer::OrbitMode OrbitPreset::getOrbitMode() const
+{
+    return orbitMode == 0 ? Spatializer::OrbitMode::Manual
+         : orbitMode == 1 ? Spatializer::OrbitMode::Orbit
+         : orbitMode == 2 ? Spatializer::OrbitMode::Figure8
+         : Spatializer::OrbitMode::Path;
+}
+
+juce::ValueTree OrbitPreset::toValueTree() const
+{
+    juce::ValueTree vt ("OrbitAudioPreset");
+    vt.setProperty ("pan", (double) pan, nullptr);
+    vt.setProperty ("orbitMode", orbitMode, nullptr);
+    vt.setProperty ("sourceLayout", sourceLayout, nullptr);
+    vt.setProperty ("headModel", headModel, nullptr);
+    vt.setProperty ("ambisonicOrder", ambisonicOrder, nullptr);
+    vt.setProperty ("panSpeedHz", (double) panSpeedHz, nullptr);
+    vt.setProperty ("itdAmount", (double) itdAmount, nullptr);
+    vt.setProperty ("shadowStrength", (double) shadowStrength, nullptr);
+    vt.setProperty ("depth", (double) depth, nullptr);
+    vt.setProperty ("width", (double) width, nullptr);
+    vt.setProperty ("reverbWet", (double) reverbWet, nullptr);
+    vt.setProperty ("tempoBpm", (double) tempoBpm, nullptr);
+    vt.appendChild (trajectory.toValueTree(), nullptr);
+    return vt;
+}
+
+OrbitPreset OrbitPreset::fromValueTree (const juce::ValueTree& vt)
+{
+    OrbitPreset p;
+    if (! vt.isValid()) return p;
+
+    p.pan = (float) (double) vt.getProperty ("pan", 0.0);
+    p.orbitMode = juce::jlimit (0, 3, (int) vt.getProperty ("orbitMode", 0));
+    if (vt.getProperty ("autoPan", false)) p.orbitMode = 1;   // presets from before orbit modes
+    p.sourceLayout = juce::jlimit (0, 2, (int) vt.getProperty ("sourceLayout", 0));
+    p.headModel = juce::jlimit (0, 1, (int) vt.getProperty ("headModel", 0));
+    p.ambisonicOrder = juce::jlimit (0, 3, (int) vt.getProperty ("ambisonicOrder", 0));
+    p.panSpeedHz = (float) (double) vt.getProperty ("panSpeedHz", 0.05);
+    p.itdAmount = (float) (double) vt.getProperty ("itdAmount", 1.0);
+    p.shadowStrength = (float) (double) vt.getProperty ("shadowStrength", 1.0);
+    p.depth = (float) (double) vt.getProperty ("depth", 0.0);
+    p.width = (float) (double) vt.getProperty ("width", 1.0);
+    p.reverbWet = (float) (double) vt.getProperty ("reverbWet", 0.33);
+    p.tempoBpm = juce::jlimit (20.0f, 400.0f, (float) (double) vt.getProperty ("tempoBpm", 120.0));
+    p.trajectory = OrbitTrajectory::fromValueTree (vt.getChildWithName ("Trajectory"));
+    return p;
+}
+
+//==============================================================================
+juce::ValueTree OrbitPreset::load (const juce::String& name)
+{
+    if (name != "Default")
+    {
+        const auto file = getPresetsDirectory().getChildFile (name + ".xml");
+        if (file.existsAsFile())
+            if (auto xml = juce::parseXML (file))
+                return juce::ValueTree::fromXml (*xml);
+    }
+
+    return getBuiltIn (name);
+}
+
+juce::StringArray OrbitPreset::getBuiltInNames()
+{
+    return { "Default", "Orbit", "Wide", "Narrow", "Spiral" };
+}
+
+juce::ValueTree OrbitPreset::getBuiltIn (const juce::String& name)
+{
+    // Built-ins don't carry a source layout or head model, so applying one keeps the
+    // current routing.
+    juce::ValueTree vt ("OrbitAudioPreset");
+    const auto set = [&vt] (const char* property, const juce::var& value) { vt.setProperty (property, value, nullptr); };
+
+    set ("pan", 0.0);
+    set ("orbitMode", 0);
+    set ("panSpeedHz", 0.05);
+    set ("itdAmount", 1.0);
+    set ("shadowStrength", 1.0);
+    set ("depth", 0.0);
+    set ("width", 1.0);
+    set ("reverbWet", 0.33);
+
+    if (name == "Orbit")
+    {
+        set ("orbitMode", 1);
+    }
+    else if (name == "Wide")
+    {
+        set ("itdAmount", 0.5);
+        set ("shadowStrength", 0.5);
+    }
+    else if (name == "Narrow")
+    {
+        set ("orbitMode", 2);
+        set ("panSpeedHz", 0.1);
+        set ("depth", 0.2);
+        set ("width", 0.7);
+        set ("reverbWet", 0.25);
+    }
+    else if (name == "Spiral")
+    {
+        // Four turns a loop, rising from below the ears to well above the head and back,
+        // one loop every two bars at the preset's tempo.
+        OrbitTrajectory spiral;
+        spiral.shape = OrbitTrajectory::Shape::Spiral;
+        spiral.radius = 1.5f;
+        spiral.height = -0.5f;
+        spiral.topHeight = 1.5f;
+        spiral.turns = 4;
+        spiral.loopBeats = 8.0f;
+
+        set ("orbitMode", 3);
+        set ("reverbWet", 0.3);
+        vt.appendChild (spiral.toValueTree(), nullptr);
+    }
+
+    return vt;
+}
+
+juce::File OrbitPreset::getPresetsDirectory()
+{
+    auto dir = juce::File::getSpecialLocation (juce::File::userApplicationDataDirectory)
+                   .getChildFile ("OrbitAudio")
+                   .getChildFile ("Presets");
+    if (! dir.exists())
+        dir.createDirectory();
+    return dir;
+}
+
+juce::File OrbitPreset::getHrirDirectory()
+{
+    auto dir = getPresetsDirectory().getParentDirectory().getChildFile ("HRIR");
+    if (! dir.exists())
+        dir.createDirectory();
+    return dir;
+}
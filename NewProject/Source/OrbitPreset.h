@@ -0,0 +1,48 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "Spatializer.h"
+#include "OrbitTrajectory.h"
+
+//==============================================================================
+// I'm one set of spatialization settings as stored in a preset file. The app and the
+// offline renderer both read presets through me, so a preset renders the same way live
+// and in batch. Missing properties keep their defaults, which are the "Default" preset.
+struct OrbitPreset
+{
+    float pan = 0.0f;
+    int orbitMode = 0;        // 0 = Manual, 1 = Orbit, 2 = Figure-8, 3 = Path
+    int sourceLayout = 0;     // 0 = stereo source, 1 = stereo pairs, 2 = mono channels
+    int headModel = 0;        // 0 = parametric head, 1 = measured HRTF
+    int ambisonicOrder = 0;   // 0 = off, 1-3 = the multi-source layouts go through an ambisonic bus of this order
+    float panSpeedHz = 0.05f;
+    float itdAmount = 1.0f;
+    float shadowStrength = 1.0f;
+    float depth = 0.0f;
+    float width = 1.0f;
+    float reverbWet = 0.33f;
+    float tempoBpm = 120.0f;  // for trajectories locked to a number of beats
+
+    // The trajectory Path mode follows, stored as a Trajectory child.
+    OrbitTrajectory trajectory;
+
+    Spatializer::OrbitMode getOrbitMode() const;
+
+    juce::ValueTree toValueTree() const;
+    static OrbitPreset fromValueTree (const juce::ValueTree& vt);
+
+    // I return the preset called name: the saved file if there is one, else the built-in
+    // values. "Default" is never read from disk.
+    static juce::ValueTree load (const juce::String& name);
+
+    // Built-in presets, in menu order; the first is "Default".
+    static juce::StringArray getBuiltInNames();
+    static juce::ValueTree getBuiltIn (const juce::String& name);
+
+    // I store presets under ~/Library/Application Support/OrbitAudio/Presets/ (the user
+    // application data folder on other platforms).
+    static juce::File getPresetsDirectory();
+
+    // The HRIR set installed next to the presets, in OrbitAudio/HRIR/, is loaded by default.
+    static juce::File getHrirDirectory();
+};
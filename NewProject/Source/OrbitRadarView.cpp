@@ -0,0 +1,143 @@
+#include "OrbitRadarView.h"
+
+//==============================================================================
+OrbitRadarView::OrbitRadarView (OrbitEngine& engineToShow)
+    : engine (engineToShow)
+{
+    setOpaque (true);
+    setTooltip ("Where the source is, seen from above (ahead is up), with each ear's gain and delay. "
+                "Dots grow above ear level and shrink below it; the ring is 1 m from the head.");
+}
+
+void OrbitRadarView::resized()
+{
+    auto area = getLocalBounds();
+    readoutArea = area.removeFromBottom (30);
+
+    const auto side = (float) juce::jmin (area.getWidth(), area.getHeight());
+    radarArea = area.toFloat().withSizeKeepingCentre (side, side).reduced (4.0f);
+}
+
+//==============================================================================
+void OrbitRadarView::update (double timestampSec)
+{
+    if (! isShowing() || timestampSec - lastUpdateSec < 1.0 / refreshHz)
+        return;
+
+    lastUpdateSec = timestampSec;
+
+    // Everything since the last look, keeping only the newest.
+    int numRead = 0;
+    while (const int n = engine.readPositionFrames (drained.data(), (int) drained.size()))
+        numRead = n;
+
+    if (numRead == 0)
+        return;
+
+    const auto& latest = drained[(size_t) numRead - 1];
+    const auto oldDots = getDotsArea (shown);
+    const auto oldHead = shown.head;
+    shown = latest;
+    const auto newDots = getDotsArea (shown);
+
+    if (oldDots != newDots)
+        repaint (oldDots.getUnion (newDots));
+
+    if (oldHead.yaw != shown.head.yaw)
+        repaint (getHeadArea());
+
+    if (auto readout = getReadout(); readout != shownReadout)
+    {
+        shownReadout = readout;
+        repaint (readoutArea);
+    }
+}
+
+juce::Rectangle<float> OrbitRadarView::getDotBounds (const OrbitEngine::PositionFrame& frame, int source) const
+{
+    const auto& p = frame.position;
+    const float azimuth = p.azimuth + juce::MathConstants<float>::twoPi * (float) source / (float) frame.numSources;
+    const float ground = juce::jmin (maxShownDistance, p.distance * std::cos (p.elevation)) / maxShownDistance;
+    const float radius = radarArea.getWidth() * 0.5f;
+
+    const auto centre = radarArea.getCentre() + juce::Point<float> (std::sin (azimuth), -std::cos (azimuth)) * ground * radius;
+    const float size = juce::jlimit (4.0f, 16.0f, 9.0f + 6.0f * std::sin (p.elevation));
+    return juce::Rectangle<float> (size, size).withCentre (centre);
+}
+
+juce::Rectangle<int> OrbitRadarView::getDotsArea (const OrbitEngine::PositionFrame& frame) const
+{
+    juce::Rectangle<float> area;
+    for (int source = 0; source < frame.numSources; ++source)
+        area = source == 0 ? getDotBounds (frame, 0) : area.getUnion (getDotBounds (frame, source));
+
+    return area.getSmallestIntegerContainer().expanded (2);
+}
+
+float OrbitRadarView::getHeadRadius() const
+{
+    const float reference = radarArea.getWidth() * 0.5f * SpatialDsp::referenceDistance / maxShownDistance;
+    return juce::jmax (4.0f, reference * 0.3f);
+}
+
+juce::Rectangle<int> OrbitRadarView::getHeadArea() const
+{
+    const float reach = juce::jmax (getHeadRadius() * 1.4f, getHeadRadius() + 14.0f);   // the nose and the ears' labels
+    return juce::Rectangle<float> (2.0f * reach, 2.0f * reach).withCentre (radarArea.getCentre())
+               .getSmallestIntegerContainer().expanded (2);
+}
+
+juce::String OrbitRadarView::getReadout() const
+{
+    if (! shown.hasCues)
+        return "measured HRTF";
+
+    const auto& c = shown.cues;
+    return "L " + juce::String (juce::Decibels::gainToDecibels (c.leftGain), 1) + " dB  "
+         + juce::String (c.leftDelay, 2) + " ms\n"
+         + "R " + juce::String (juce::Decibels::gainToDecibels (c.rightGain), 1) + " dB  "
+         + juce::String (c.rightDelay, 2) + " ms";
+}
+
+//==============================================================================
+void OrbitRadarView::paint (juce::Graphics& g)
+{
+    g.fillAll (getLookAndFeel().findColour (juce::ResizableWindow::backgroundColourId));
+
+    const auto text = getLookAndFeel().findColour (juce::Label::textColourId);
+    const auto accent = getLookAndFeel().findColour (juce::Slider::thumbColourId);
+    const auto centre = radarArea.getCentre();
+    const float radius = radarArea.getWidth() * 0.5f;
+
+    // The field, with the reference distance as a ring and the ears marked.
+    g.setColour (text.withAlpha (0.06f));
+    g.fillEllipse (radarArea);
+    g.setColour (text.withAlpha (0.25f));
+    g.drawEllipse (radarArea, 1.0f);
+    const float reference = radius * SpatialDsp::referenceDistance / maxShownDistance;
+    g.drawEllipse (juce::Rectangle<float> (2.0f * reference, 2.0f * reference).withCentre (centre), 1.0f);
+
+    // The head, nose up unless it's been turned.
+    const float head = getHeadRadius();
+    const juce::Point<float> nose (std::sin (shown.head.yaw), -std::cos (shown.head.yaw));
+    g.setColour (text.withAlpha (0.6f));
+    g.drawEllipse (juce::Rectangle<float> (2.0f * head, 2.0f * head).withCentre (centre), 1.5f);
+    g.drawLine (juce::Line<float> (centre + nose * head, centre + nose * head * 1.4f), 1.5f);
+
+    g.setFont (juce::FontOptions (10.0f));
+    const juce::Point<float> leftEar (nose.y, -nose.x);
+    g.drawText ("L", juce::Rectangle<float> (12.0f, 12.0f).withCentre (centre + leftEar * (head + 8.0f)), juce::Justification::centred);
+    g.drawText ("R", juce::Rectangle<float> (12.0f, 12.0f).withCentre (centre - leftEar * (head + 8.0f)), juce::Justification::centred);
+
+    // The sources; source 0 is the one the path moves.
+    for (int source = shown.numSources; --source >= 0;)
+    {
+        const auto dot = getDotBounds (shown, source);
+        g.setColour (source == 0 ? accent : accent.withAlpha (0.5f));
+        g.fillEllipse (dot);
+    }
+
+    g.setColour (text);
+    g.setFont (juce::FontOptions (11.0f));
+    g.drawFittedText (shownReadout, readoutArea, juce::Justification::centred, 2);
+}
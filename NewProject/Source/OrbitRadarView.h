@@ -0,0 +1,49 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "OrbitEngine.h"
+
+//==============================================================================
+// I'm a radar of where the source is, seen from above: the head in the middle (its nose
+// up, or wherever the head tracker has turned it),
+// the reference distance as a ring, and a dot for each source, larger and brighter above
+// ear level and smaller below it. Under the radar I show each ear's gain and delay.
+//
+// I drain the engine's position ring on the display's vertical blank, at most refreshHz
+// times a second and only while I'm on screen, and keep the newest frame. I'm opaque and
+// I only repaint what changed: the old and new dots, and the readout when its text does,
+// so a panel left open costs little more than the dot moving.
+class OrbitRadarView  : public juce::Component,
+                        public juce::SettableTooltipClient
+{
+public:
+    static constexpr int refreshHz = 30;
+    static constexpr float maxShownDistance = 3.0f;   // metres at the edge; farther sources sit on it
+
+    explicit OrbitRadarView (OrbitEngine& engineToShow);
+    ~OrbitRadarView() override = default;
+
+    void paint (juce::Graphics& g) override;
+    void resized() override;
+
+private:
+    void update (double timestampSec);
+    juce::Rectangle<float> getDotBounds (const OrbitEngine::PositionFrame& frame, int source) const;
+    juce::Rectangle<int> getDotsArea (const OrbitEngine::PositionFrame& frame) const;
+    juce::Rectangle<int> getHeadArea() const;
+    float getHeadRadius() const;
+    juce::String getReadout() const;
+
+    OrbitEngine& engine;
+    OrbitEngine::PositionFrame shown;
+    std::array<OrbitEngine::PositionFrame, 32> drained;
+    juce::String shownReadout;
+    double lastUpdateSec = 0.0;
+
+    juce::Rectangle<float> radarArea;
+    juce::Rectangle<int> readoutArea;
+
+    juce::VBlankAttachment vBlank { this, [this] (double timestampSec) { update (timestampSec); } };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (OrbitRadarView)
+};
@@ -0,0 +1,269 @@
+#include "OrbitReverb.h"
+#include "SpatialDsp.h"
+
+namespace
+{
+    // juce::Reverb's tunings, in samples at 44.1 kHz.
+    constexpr short combTunings[] = { 1116, 1188, 1277, 1356, 1422, 1491, 1557, 1617 };
+    constexpr short allPassTunings[] = { 556, 441, 341, 225 };
+    constexpr int stereoSpread = 23;
+}
+
+//==============================================================================
+OrbitReverb::OrbitReverb()
+{
+    setParameters (Parameters());
+    setSampleRate (44100.0);
+}
+
+void OrbitReverb::setParameters (const Parameters& newParameters)
+{
+    const float wetScaleFactor = 3.0f;
+    const float dryScaleFactor = 2.0f;
+
+    const float wet = newParameters.wetLevel * wetScaleFactor;
+    dryGain.setTargetValue (newParameters.dryLevel * dryScaleFactor);
+    wetGain1.setTargetValue (0.5f * wet * (1.0f + newParameters.width));
+    wetGain2.setTargetValue (0.5f * wet * (1.0f - newParameters.width));
+
+    const bool frozen = newParameters.freezeMode >= 0.5f;
+    gain = frozen ? 0.0f : 0.015f;
+    parameters = newParameters;
+    updateDamping();
+}
+
+void OrbitReverb::updateDamping() noexcept
+{
+    const float roomScaleFactor = 0.28f;
+    const float roomOffset = 0.7f;
+    const float dampScaleFactor = 0.4f;
+
+    if (parameters.freezeMode >= 0.5f)
+    {
+        damping.setTargetValue (0.0f);
+        feedback.setTargetValue (1.0f);
+    }
+    else
+    {
+        damping.setTargetValue (parameters.damping * dampScaleFactor);
+        feedback.setTargetValue (parameters.roomSize * roomScaleFactor + roomOffset);
+    }
+}
+
+void OrbitReverb::setSampleRate (double sampleRate)
+{
+    jassert (sampleRate > 0);
+    const int intSampleRate = (int) sampleRate;
+
+    int total = 0;
+    for (int ch = 0; ch < numChannels; ++ch)
+    {
+        for (int i = 0; i < numCombs; ++i)
+        {
+            combSizes[ch * numCombs + i] = juce::jmax (1, (intSampleRate * (combTunings[i] + ch * stereoSpread)) / 44100);
+            total += combSizes[ch * numCombs + i];
+        }
+
+        for (int i = 0; i < numAllPasses; ++i)
+        {
+            allPassSizes[ch][i] = juce::jmax (1, (intSampleRate * (allPassTunings[i] + ch * stereoSpread)) / 44100);
+            total += allPassSizes[ch][i];
+        }
+    }
+
+    memory.calloc ((size_t) total);
+    auto* next = memory.get();
+
+    for (int lane = 0; lane < numCombLanes; ++lane)
+    {
+        combBuffers[lane] = next;
+        next += combSizes[lane];
+    }
+
+    for (int ch = 0; ch < numChannels; ++ch)
+    {
+        for (int i = 0; i < numAllPasses; ++i)
+        {
+            allPassBuffers[ch][i] = next;
+            next += allPassSizes[ch][i];
+        }
+    }
+
+    reset();
+
+    const double smoothTime = 0.01;
+    damping .reset (sampleRate, smoothTime);
+    feedback.reset (sampleRate, smoothTime);
+    dryGain .reset (sampleRate, smoothTime);
+    wetGain1.reset (sampleRate, smoothTime);
+    wetGain2.reset (sampleRate, smoothTime);
+}
+
+void OrbitReverb::reset()
+{
+    for (int lane = 0; lane < numCombLanes; ++lane)
+    {
+        juce::FloatVectorOperations::clear (combBuffers[lane], combSizes[lane]);
+        combPositions[lane] = 0;
+        combLast[lane] = 0.0f;
+    }
+
+    for (int ch = 0; ch < numChannels; ++ch)
+    {
+        for (int i = 0; i < numAllPasses; ++i)
+        {
+            juce::FloatVectorOperations::clear (allPassBuffers[ch][i], allPassSizes[ch][i]);
+            allPassPositions[ch][i] = 0;
+        }
+    }
+}
+
+//==============================================================================
+void OrbitReverb::processStereo (float* left, float* right, int numSamples) noexcept
+{
+    jassert (left != nullptr && right != nullptr);
+
+    for (int offset = 0; offset < numSamples;)
+    {
+        // I stop each sub-block at the nearest comb wrap, so every comb reads and writes
+        // one contiguous run.
+        int n = juce::jmin (subBlockSize, numSamples - offset);
+        for (int lane = 0; lane < numCombLanes; ++lane)
+            n = juce::jmin (n, combSizes[lane] - combPositions[lane]);
+
+        processSubBlock (left + offset, right + offset, n);
+        offset += n;
+    }
+}
+
+void OrbitReverb::processSubBlock (float* left, float* right, int n) noexcept
+{
+    alignas (16) float input[subBlockSize];
+    alignas (16) float wetLeft[subBlockSize];
+    alignas (16) float wetRight[subBlockSize];
+
+    for (int i = 0; i < n; ++i)
+        input[i] = (left[i] + right[i]) * gain;
+
+    // Damping and feedback hold their mid-sub-block value across it (exact when steady).
+    const auto midpoint = [n] (juce::SmoothedValue<float>& value)
+    {
+        const float from = value.getCurrentValue();
+        return (from + value.skip (n)) * 0.5f;
+    };
+
+    const float damp = midpoint (damping);
+    const float feedbackLevel = midpoint (feedback);
+    const float oneMinusDamp = 1.0f - damp;
+
+    // A comb only reads what it wrote a whole delay ago, so I can read the sub-block's
+    // delayed samples up front and write the new ones back afterwards. Both passes are
+    // contiguous per comb; in between the samples sit transposed, one row of lanes per
+    // sample, so the filter loop below works on whole rows.
+    alignas (16) float delayed[subBlockSize][numCombLanes];
+    alignas (16) float written[subBlockSize][numCombLanes];
+    alignas (16) float state[numCombLanes];
+
+    for (int lane = 0; lane < numCombLanes; ++lane)
+    {
+        const float* head = combBuffers[lane] + combPositions[lane];
+        for (int i = 0; i < n; ++i)
+            delayed[i][lane] = head[i];
+
+        state[lane] = combLast[lane];
+    }
+
+    for (int i = 0; i < n; ++i)
+    {
+        // Every comb's damping filter and feedback, side by side.
+        for (int lane = 0; lane < numCombLanes; ++lane)
+        {
+            float last = delayed[i][lane] * oneMinusDamp + state[lane] * damp;
+            JUCE_UNDENORMALISE (last);
+            state[lane] = last;
+
+            float temp = input[i] + last * feedbackLevel;
+            JUCE_UNDENORMALISE (temp);
+            written[i][lane] = temp;
+        }
+
+        // Summed in juce::Reverb's order, so the result is bit-identical.
+        float outLeft = 0.0f, outRight = 0.0f;
+        for (int j = 0; j < numCombs; ++j)
+        {
+            outLeft += delayed[i][j];
+            outRight += delayed[i][numCombs + j];
+        }
+
+        wetLeft[i] = outLeft;
+        wetRight[i] = outRight;
+    }
+
+    for (int lane = 0; lane < numCombLanes; ++lane)
+    {
+        float* head = combBuffers[lane] + combPositions[lane];
+        for (int i = 0; i < n; ++i)
+            head[i] = written[i][lane];
+
+        combLast[lane] = state[lane];
+        combPositions[lane] += n;
+        if (combPositions[lane] == combSizes[lane])
+            combPositions[lane] = 0;
+    }
+
+    // An all-pass only reads what it wrote a whole delay ago, so a sub-block can go through
+    // one stage before the next (split only where the ring wraps).
+    float* wet[numChannels] = { wetLeft, wetRight };
+    for (int ch = 0; ch < numChannels; ++ch)
+    {
+        for (int stage = 0; stage < numAllPasses; ++stage)
+        {
+            auto* buffer = allPassBuffers[ch][stage];
+            auto& position = allPassPositions[ch][stage];
+            const int size = allPassSizes[ch][stage];
+
+            for (int done = 0; done < n;)
+            {
+                const int run = juce::jmin (n - done, size - position);
+                float* io = wet[ch] + done;
+                float* head = buffer + position;
+
+                for (int i = 0; i < run; ++i)
+                {
+                    const float buffered = head[i];
+                    float temp = io[i] + buffered * 0.5f;
+                    JUCE_UNDENORMALISE (temp);
+                    head[i] = temp;
+                    io[i] = buffered - io[i];
+                }
+
+                done += run;
+                position += run;
+                if (position == size)
+                    position = 0;
+            }
+        }
+    }
+
+    // The output gains ramp across the sub-block.
+    alignas (16) float dry[subBlockSize];
+    alignas (16) float wet1[subBlockSize];
+    alignas (16) float wet2[subBlockSize];
+
+    const auto fillGainRamp = [n] (float* dest, juce::SmoothedValue<float>& value)
+    {
+        const float from = value.getCurrentValue();
+        SpatialDsp::fillRamp (dest, from, value.skip (n), n);
+    };
+
+    fillGainRamp (dry, dryGain);
+    fillGainRamp (wet1, wetGain1);
+    fillGainRamp (wet2, wetGain2);
+
+    for (int i = 0; i < n; ++i)
+    {
+        const float l = left[i], r = right[i];
+        left[i]  = wetLeft[i] * wet1[i] + wetRight[i] * wet2[i] + l * dry[i];
+        right[i] = wetRight[i] * wet1[i] + wetLeft[i] * wet2[i] + r * dry[i];
+    }
+}
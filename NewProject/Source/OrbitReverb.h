@@ -0,0 +1,68 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+// I'm juce::Reverb (Freeverb: 8 parallel combs and 4 series all-passes per channel,
+// same tunings, same parameters) laid out so the hot loop vectorizes.
+//
+// All 16 combs (8 per ear) are lanes of one struct-of-arrays state, so each sample
+// advances every comb's damping filter and feedback in a few SIMD operations; only
+// the delay reads and writes are per lane. I work in sub-blocks that never cross a
+// comb's wrap point, so there is no modulo per sample. The all-passes run a whole
+// sub-block per stage, since their delays are longer than a sub-block. Smoothed
+// parameters are evaluated once per sub-block: damping and feedback step, the
+// output gains ramp linearly across it.
+//
+// With steady parameters my output matches juce::Reverb to the last bit (the combs
+// are summed in the same order); while parameters glide it differs only by the
+// per-sub-block smoothing.
+class OrbitReverb
+{
+public:
+    using Parameters = juce::Reverb::Parameters;
+
+    static constexpr int numCombs = 8;
+    static constexpr int numAllPasses = 4;
+    static constexpr int numChannels = 2;
+    static constexpr int numCombLanes = numChannels * numCombs;   // left combs, then right
+    static constexpr int subBlockSize = 32;
+
+    OrbitReverb();
+    ~OrbitReverb() = default;
+
+    const Parameters& getParameters() const noexcept    { return parameters; }
+
+    // Like juce::Reverb, call me between process calls, not in parallel with them.
+    void setParameters (const Parameters& newParameters);
+
+    // I size (and clear) the delay lines for a rate. This allocates.
+    void setSampleRate (double sampleRate);
+
+    // I clear the delay lines.
+    void reset();
+
+    void processStereo (float* left, float* right, int numSamples) noexcept;
+
+private:
+    void updateDamping() noexcept;
+    void processSubBlock (float* left, float* right, int numSamples) noexcept;
+
+    Parameters parameters;
+    float gain = 0.015f;
+
+    // One arena for every delay line; each line is a ring with its own length and position.
+    juce::HeapBlock<float> memory;
+    float* combBuffers[numCombLanes] = {};
+    int combSizes[numCombLanes] = {};
+    int combPositions[numCombLanes] = {};
+    alignas (16) float combLast[numCombLanes] = {};
+
+    float* allPassBuffers[numChannels][numAllPasses] = {};
+    int allPassSizes[numChannels][numAllPasses] = {};
+    int allPassPositions[numChannels][numAllPasses] = {};
+
+    juce::SmoothedValue<float> damping, feedback, dryGain, wetGain1, wetGain2;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (OrbitReverb)
+};
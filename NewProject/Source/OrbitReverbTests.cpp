@@ -0,0 +1,120 @@
+#include <JuceHeader.h>
+#include "OrbitReverb.h"
+
+//==============================================================================
+// I test the OrbitReverb against juce::Reverb: bit-identical with steady parameters
+// at every rate and block size, a close match while parameters glide, and the same
+// freeze and reset behaviour.
+class OrbitReverbTest : public juce::UnitTest
+{
+public:
+    OrbitReverbTest() : juce::UnitTest ("OrbitReverb", "Audio") {}
+
+    static juce::AudioBuffer<float> makeNoise (int numSamples, int seed)
+    {
+        juce::AudioBuffer<float> noise (2, numSamples);
+        juce::Random random (seed);
+        for (int ch = 0; ch < 2; ++ch)
+            for (int i = 0; i < numSamples; ++i)
+                noise.setSample (ch, i, (random.nextFloat() * 2.0f - 1.0f) * 0.5f);
+        return noise;
+    }
+
+    // I run both reverbs over the same input in uneven blocks and return how far apart they
+    // are, switching both to changed after changeAt samples (if given).
+    static float compare (double sampleRate, int numSamples, const juce::Reverb::Parameters& parameters,
+                   int changeAt = -1, const juce::Reverb::Parameters& changed = {})
+    {
+        juce::Reverb reference;
+        OrbitReverb reverb;
+        reference.setParameters (parameters);
+        reverb.setParameters (parameters);
+        reference.setSampleRate (sampleRate);
+        reverb.setSampleRate (sampleRate);
+
+        auto expected = makeNoise (numSamples, 5);
+        auto rendered = makeNoise (numSamples, 5);
+
+        juce::Random random (9);
+        bool changeApplied = false;
+        for (int start = 0; start < numSamples;)
+        {
+            const int n = juce::jmin (numSamples - start, 1 + random.nextInt (700));
+            if (! changeApplied && changeAt >= 0 && start >= changeAt)
+            {
+                reference.setParameters (changed);
+                reverb.setParameters (changed);
+                changeApplied = true;
+            }
+
+            reference.processStereo (expected.getWritePointer (0, start), expected.getWritePointer (1, start), n);
+            reverb.processStereo (rendered.getWritePointer (0, start), rendered.getWritePointer (1, start), n);
+            start += n;
+        }
+
+        // The error's level relative to the output, in dB (-inf when identical).
+        double errorEnergy = 0.0, signalEnergy = 0.0;
+        for (int ch = 0; ch < 2; ++ch)
+        {
+            for (int i = 0; i < numSamples; ++i)
+            {
+                const double e = rendered.getSample (ch, i) - expected.getSample (ch, i);
+                errorEnergy += e * e;
+                signalEnergy += (double) expected.getSample (ch, i) * expected.getSample (ch, i);
+            }
+        }
+        return (float) juce::Decibels::gainToDecibels (std::sqrt (errorEnergy / signalEnergy), -1000.0);
+    }
+
+    void runTest() override
+    {
+        juce::Reverb::Parameters parameters;
+        parameters.roomSize = 0.8f;
+        parameters.damping = 0.3f;
+        parameters.wetLevel = 0.33f;
+        parameters.width = 0.7f;
+
+        beginTest ("steady parameters match juce::Reverb exactly");
+        {
+            for (auto rate : { 44100.0, 48000.0, 96000.0, 192000.0 })
+                expectEquals (compare (rate, 40000, parameters), -1000.0f, "at " + juce::String (rate) + " Hz");
+        }
+
+        beginTest ("gliding parameters stay close to juce::Reverb");
+        {
+            auto changed = parameters;
+            changed.roomSize = 0.3f;
+            changed.damping = 0.8f;
+            changed.wetLevel = 0.6f;
+            changed.dryLevel = 0.2f;
+            changed.width = 0.2f;
+
+            expectLessThan (compare (48000.0, 40000, parameters, 10000, changed), -60.0f);
+        }
+
+        beginTest ("freeze holds the tail");
+        {
+            auto frozen = parameters;
+            frozen.freezeMode = 1.0f;
+            expectLessThan (compare (44100.0, 30000, parameters, 12000, frozen), -60.0f);
+        }
+
+        beginTest ("reset clears the tail");
+        {
+            OrbitReverb reverb;
+            reverb.setParameters (parameters);
+            reverb.setSampleRate (48000.0);
+
+            auto noise = makeNoise (4800, 3);
+            reverb.processStereo (noise.getWritePointer (0), noise.getWritePointer (1), noise.getNumSamples());
+            reverb.reset();
+
+            juce::AudioBuffer<float> silence (2, 4800);
+            silence.clear();
+            reverb.processStereo (silence.getWritePointer (0), silence.getWritePointer (1), silence.getNumSamples());
+            expectEquals (silence.getMagnitude (0, silence.getNumSamples()), 0.0f);
+        }
+    }
+};
+
+static OrbitReverbTest orbitReverbTest;
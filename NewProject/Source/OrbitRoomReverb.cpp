@@ -0,0 +1,398 @@
+#include "OrbitRoomReverb.h"
+#include "SpatialDsp.h"
+
+namespace
+{
+    // FDN line lengths in ms, spread out and all longer than a sub-block. setSampleRate()
+    // rounds each to a prime number of samples, so no two lines share a factor and their
+    // echoes never line up into metallic modes.
+    constexpr float lineLengthsMs[OrbitRoomReverb::numLines] = { 23.3f, 28.9f, 31.7f, 37.1f, 41.3f, 47.9f, 53.1f, 59.7f };
+
+    bool isPrime (int n) noexcept
+    {
+        if (n < 2)
+            return false;
+
+        for (int divisor = 2; divisor * divisor <= n; ++divisor)
+            if (n % divisor == 0)
+                return false;
+
+        return true;
+    }
+
+    // The nearest prime to n above after, going up on a tie.
+    int nearestPrimeAbove (int n, int after) noexcept
+    {
+        n = juce::jmax (n, after + 1);
+
+        for (int step = 0;; ++step)
+        {
+            if (isPrime (n + step))
+                return n + step;
+
+            if (n - step > after && isPrime (n - step))
+                return n - step;
+        }
+    }
+
+    // Signs the reflections are injected with and the ears read the lines back with, so
+    // the two ears hear decorrelated mixes of the same tail.
+    constexpr float inputSigns[OrbitRoomReverb::numLines]  = { 1.0f, 1.0f, -1.0f, 1.0f, 1.0f, -1.0f, -1.0f, -1.0f };
+    constexpr float outputSigns[OrbitRoomReverb::numLines] = { 1.0f, 1.0f, 1.0f, -1.0f, -1.0f, 1.0f, -1.0f, -1.0f };
+
+    constexpr float speedOfSound = 343.0f;          // m/s
+    constexpr float sourceDistance = 1.5f;          // m, the radius of the orbit
+    constexpr float earHeight = 1.2f;               // m above the floor
+    constexpr float maxEarlyDelayMs = 100.0f;       // longer than any image path in the largest room
+    constexpr float freezeDecaySeconds = 1.0e6f;
+
+    // The wet level's calibration: at the default room size and damping, about 4 dB under
+    // juce::Reverb at the same wet level (its own factor is 3), since the reflections carry
+    // the sense of space with less wash. More damping takes more off than juce::Reverb's does.
+    constexpr float wetScaleFactor = 1.5f;
+
+    // I mix 8 lines with the orthonormal 8x8 Hadamard matrix, as three butterfly stages.
+    inline void hadamard8 (const float* in, float* out) noexcept
+    {
+        const float a0 = in[0] + in[1], a1 = in[0] - in[1], a2 = in[2] + in[3], a3 = in[2] - in[3];
+        const float a4 = in[4] + in[5], a5 = in[4] - in[5], a6 = in[6] + in[7], a7 = in[6] - in[7];
+
+        const float b0 = a0 + a2, b1 = a1 + a3, b2 = a0 - a2, b3 = a1 - a3;
+        const float b4 = a4 + a6, b5 = a5 + a7, b6 = a4 - a6, b7 = a5 - a7;
+
+        constexpr float scale = 0.35355339f;   // 1 / sqrt (8)
+        out[0] = (b0 + b4) * scale;  out[1] = (b1 + b5) * scale;
+        out[2] = (b2 + b6) * scale;  out[3] = (b3 + b7) * scale;
+        out[4] = (b0 - b4) * scale;  out[5] = (b1 - b5) * scale;
+        out[6] = (b2 - b6) * scale;  out[7] = (b3 - b7) * scale;
+    }
+}
+
+//==============================================================================
+OrbitRoomReverb::OrbitRoomReverb()
+{
+    setParameters (Parameters());
+    setSampleRate (44100.0);
+}
+
+float OrbitRoomReverb::getDecaySeconds (float roomSize) noexcept
+{
+    const float size = juce::jlimit (0.0f, 1.0f, roomSize);
+    return 0.3f + 3.2f * size * size;
+}
+
+void OrbitRoomReverb::setParameters (const Parameters& newParameters)
+{
+    parameters = newParameters;
+
+    const float wet = parameters.wetLevel * wetScaleFactor;
+    const float width = juce::jlimit (0.0f, 1.0f, parameters.width);
+    wetGain1.setTargetValue (0.5f * wet * (1.0f + width));
+    wetGain2.setTargetValue (0.5f * wet * (1.0f - width));
+    dryGain.setTargetValue (parameters.dryLevel);
+
+    inputGain.setTargetValue (parameters.freeze ? 0.0f : 1.0f);
+    decaySeconds.setTargetValue (parameters.freeze ? freezeDecaySeconds : getDecaySeconds (parameters.roomSize));
+    damping.setTargetValue (parameters.freeze ? 0.0f : juce::jlimit (0.0f, 1.0f, parameters.damping) * 0.5f);
+}
+
+void OrbitRoomReverb::setSampleRate (double newSampleRate)
+{
+    jassert (newSampleRate > 0);
+    sampleRate = newSampleRate;
+
+    const int maxEarlyDelay = (int) std::ceil (sampleRate * maxEarlyDelayMs / 1000.0);
+    const int earlySize = juce::nextPowerOfTwo (maxEarlyDelay + subBlockSize + 2);
+    earlyBuffer.calloc ((size_t) earlySize);
+    earlyMask = earlySize - 1;
+
+    // The lengths rise, so each line's prime is above the last one's and they're distinct.
+    int total = 0;
+    for (int line = 0; line < numLines; ++line)
+    {
+        const int previous = line > 0 ? lineSizes[line - 1] : subBlockSize;
+        lineSizes[line] = nearestPrimeAbove (juce::roundToInt (sampleRate * lineLengthsMs[line] / 1000.0), previous);
+        total += lineSizes[line];
+    }
+
+    lineMemory.calloc ((size_t) total);
+    auto* next = lineMemory.get();
+    for (int line = 0; line < numLines; ++line)
+    {
+        lineBuffers[line] = next;
+        next += lineSizes[line];
+    }
+
+    const double smoothTime = 0.01;
+    decaySeconds.reset (sampleRate, smoothTime);
+    damping     .reset (sampleRate, smoothTime);
+    inputGain   .reset (sampleRate, smoothTime);
+    wetGain1    .reset (sampleRate, smoothTime);
+    wetGain2    .reset (sampleRate, smoothTime);
+    dryGain     .reset (sampleRate, smoothTime);
+
+    appliedDecaySeconds = -1.0f;
+    reset();
+}
+
+void OrbitRoomReverb::reset()
+{
+    juce::FloatVectorOperations::clear (earlyBuffer.get(), earlyMask + 1);
+    earlyWritePosition = 0;
+
+    for (int line = 0; line < numLines; ++line)
+    {
+        juce::FloatVectorOperations::clear (lineBuffers[line], lineSizes[line]);
+        linePositions[line] = 0;
+        lineDamping[line] = 0.0f;
+    }
+
+    azimuth = targetAzimuth;
+    tapsNeedReset = true;
+}
+
+//==============================================================================
+void OrbitRoomReverb::computeTaps (Taps& dest, float sourceAzimuth, float roomSize, float wallDamping) const noexcept
+{
+    // A shoebox that grows with room size. The listener sits on the centre line, a little
+    // behind the middle, facing +y; x points right and z up from ear height.
+    const float size = juce::jlimit (0.0f, 1.0f, roomSize);
+    const float roomWidth = 4.0f + 8.0f * size;
+    const float roomLength = 5.0f + 10.0f * size;
+    const float roomHeight = 2.5f + 1.5f * size;
+
+    const float rightWall = 0.5f * roomWidth, leftWall = -rightWall;
+    const float frontWall = 0.65f * roomLength, backWall = -0.35f * roomLength;
+    const float floorHeight = -earHeight, ceilingHeight = roomHeight - earHeight;
+
+    const float sx = sourceDistance * std::sin (sourceAzimuth);
+    const float sy = sourceDistance * std::cos (sourceAzimuth);
+
+    // Image positions and how many walls each bounced off.
+    struct Image { float x, y, z; int order; };
+    const Image images[numReflections] =
+    {
+        { 2.0f * rightWall - sx, sy, 0.0f, 1 },
+        { 2.0f * leftWall  - sx, sy, 0.0f, 1 },
+        { sx, 2.0f * frontWall - sy, 0.0f, 1 },
+        { sx, 2.0f * backWall  - sy, 0.0f, 1 },
+        { sx, sy, 2.0f * floorHeight,   1 },
+        { sx, sy, 2.0f * ceilingHeight, 1 },
+        { 2.0f * rightWall - sx, 2.0f * frontWall - sy, 0.0f, 2 },
+        { 2.0f * leftWall  - sx, 2.0f * frontWall - sy, 0.0f, 2 },
+        { 2.0f * rightWall - sx, 2.0f * backWall  - sy, 0.0f, 2 },
+        { 2.0f * leftWall  - sx, 2.0f * backWall  - sy, 0.0f, 2 },
+    };
+
+    const float reflectivity = 0.9f - 0.5f * juce::jlimit (0.0f, 1.0f, wallDamping);
+    const float samplesPerMetre = (float) sampleRate / speedOfSound;
+    const float maxDelay = (float) sampleRate * maxEarlyDelayMs / 1000.0f;
+
+    for (int k = 0; k < numReflections; ++k)
+    {
+        const auto& image = images[k];
+        const float distance = std::sqrt (image.x * image.x + image.y * image.y + image.z * image.z);
+        const float lateral = image.x / distance;     // -1 = hard left, +1 = hard right
+
+        // The dry signal already carries the direct path, so I delay by the extra distance.
+        const float delay = juce::jlimit (1.0f, maxDelay, (distance - sourceDistance) * samplesPerMetre);
+        const float gain = (image.order == 1 ? reflectivity : reflectivity * reflectivity) * sourceDistance / distance;
+
+        dest.delay[k]      = delay;
+        dest.gainLeft[k]   = gain * std::sqrt (0.5f * (1.0f - lateral));
+        dest.gainRight[k]  = gain * std::sqrt (0.5f * (1.0f + lateral));
+    }
+}
+
+void OrbitRoomReverb::updateFeedback (float decay) noexcept
+{
+    // Each line loses 60 dB per decay time, however long it is.
+    for (int line = 0; line < numLines; ++line)
+        lineFeedback[line] = std::pow (10.0f, -3.0f * (float) lineSizes[line] / ((float) sampleRate * decay));
+
+    appliedDecaySeconds = decay;
+}
+
+//==============================================================================
+void OrbitRoomReverb::processStereo (float* left, float* right, int numSamples) noexcept
+{
+    jassert (left != nullptr && right != nullptr);
+
+    if (numSamples <= 0)
+        return;
+
+    // I glide along the shorter way round to the new azimuth.
+    const float startAzimuth = azimuth;
+    const float travel = std::remainder (targetAzimuth - startAzimuth, juce::MathConstants<float>::twoPi);
+
+    if (tapsNeedReset)
+    {
+        computeTaps (taps, startAzimuth, parameters.roomSize, parameters.damping);
+        tapsNeedReset = false;
+    }
+
+    for (int offset = 0; offset < numSamples;)
+    {
+        // Each sub-block stops at the nearest line wrap, so every line reads and writes one
+        // contiguous run.
+        int n = juce::jmin (subBlockSize, numSamples - offset);
+        for (int line = 0; line < numLines; ++line)
+            n = juce::jmin (n, lineSizes[line] - linePositions[line]);
+
+        Taps target;
+        const float fraction = (float) (offset + n) / (float) numSamples;
+        computeTaps (target, startAzimuth + travel * fraction, parameters.roomSize, parameters.damping);
+
+        processSubBlock (left + offset, right + offset, n, target);
+        taps = target;
+        offset += n;
+    }
+
+    azimuth = std::remainder (startAzimuth + travel, juce::MathConstants<float>::twoPi);
+}
+
+void OrbitRoomReverb::processSubBlock (float* left, float* right, int n, const Taps& target) noexcept
+{
+    alignas (16) float earlyLeft[subBlockSize];
+    alignas (16) float earlyRight[subBlockSize];
+
+    // Early reflections: the mono input goes into the ring, then every tap reads it back
+    // with its delay and gain ramping to the new control point.
+    auto* ring = earlyBuffer.get();
+    const int writePosition = earlyWritePosition;
+
+    for (int i = 0; i < n; ++i)
+        ring[(writePosition + i) & earlyMask] = 0.5f * (left[i] + right[i]);
+
+    juce::FloatVectorOperations::clear (earlyLeft, n);
+    juce::FloatVectorOperations::clear (earlyRight, n);
+
+    for (int k = 0; k < numReflections; ++k)
+    {
+        // One interpolated read per reflection, at positions relative to the write position,
+        // then both ears' gains.
+        alignas (16) float position[subBlockSize];
+        alignas (16) float tap[subBlockSize];
+        const float delayStep = (target.delay[k] - taps.delay[k]) / (float) n;
+
+        // Biased by the ring size so they stay positive and truncation rounds down.
+        for (int i = 0; i < n; ++i)
+            position[i] = (float) (i + earlyMask + 1) - (taps.delay[k] + delayStep * (float) (i + 1));
+
+        for (int i = 0; i < n; ++i)
+        {
+            const int whole = (int) position[i];
+            const int index = writePosition + whole;
+            const float frac = position[i] - (float) whole;
+            const float a = ring[index & earlyMask];
+            const float b = ring[(index + 1) & earlyMask];
+            tap[i] = a + frac * (b - a);
+        }
+
+        const float leftStep = (target.gainLeft[k] - taps.gainLeft[k]) / (float) n;
+        const float rightStep = (target.gainRight[k] - taps.gainRight[k]) / (float) n;
+
+        for (int i = 0; i < n; ++i)
+        {
+            earlyLeft[i]  += (taps.gainLeft[k]  + leftStep  * (float) (i + 1)) * tap[i];
+            earlyRight[i] += (taps.gainRight[k] + rightStep * (float) (i + 1)) * tap[i];
+        }
+    }
+
+    earlyWritePosition = (writePosition + n) & earlyMask;
+
+    // Late tail. Like the OrbitReverb's combs, a line only reads what it wrote a whole delay
+    // ago, so I read the sub-block's delayed samples up front, run the network on rows of
+    // lanes, and write the new samples back afterwards.
+    const auto midpoint = [n] (juce::SmoothedValue<float>& value)
+    {
+        const float from = value.getCurrentValue();
+        return (from + value.skip (n)) * 0.5f;
+    };
+
+    const float decay = midpoint (decaySeconds);
+    if (decay != appliedDecaySeconds)
+        updateFeedback (decay);
+
+    const float damp = midpoint (damping);
+    const float gainIn = midpoint (inputGain);   // freezing mutes the reflections too
+
+    alignas (16) float delayed[subBlockSize][numLines];
+    alignas (16) float written[subBlockSize][numLines];
+    alignas (16) float state[numLines];
+    alignas (16) float wetLeft[subBlockSize];
+    alignas (16) float wetRight[subBlockSize];
+
+    for (int line = 0; line < numLines; ++line)
+    {
+        const float* head = lineBuffers[line] + linePositions[line];
+        for (int i = 0; i < n; ++i)
+            delayed[i][line] = head[i];
+
+        state[line] = lineDamping[line];
+    }
+
+    for (int i = 0; i < n; ++i)
+    {
+        alignas (16) float mixed[numLines];
+        hadamard8 (delayed[i], mixed);
+
+        // The left reflections feed the even lines, the right ones the odd lines.
+        const float injectLeft = earlyLeft[i] * gainIn;
+        const float injectRight = earlyRight[i] * gainIn;
+
+        for (int line = 0; line < numLines; ++line)
+        {
+            float filtered = mixed[line] + damp * (state[line] - mixed[line]);
+            JUCE_UNDENORMALISE (filtered);
+            state[line] = filtered;
+
+            const float inject = (line & 1) != 0 ? injectRight : injectLeft;
+            written[i][line] = filtered * lineFeedback[line] + inject * inputSigns[line];
+        }
+
+        float lateLeft = 0.0f, lateRight = 0.0f;
+        for (int line = 0; line < numLines; line += 2)
+        {
+            lateLeft  += delayed[i][line] * outputSigns[line];
+            lateRight += delayed[i][line + 1] * outputSigns[line + 1];
+        }
+
+        wetLeft[i]  = earlyLeft[i] * gainIn + lateLeft;
+        wetRight[i] = earlyRight[i] * gainIn + lateRight;
+    }
+
+    for (int line = 0; line < numLines; ++line)
+    {
+        float* head = lineBuffers[line] + linePositions[line];
+        for (int i = 0; i < n; ++i)
+            head[i] = written[i][line];
+
+        lineDamping[line] = state[line];
+        linePositions[line] += n;
+        if (linePositions[line] == lineSizes[line])
+            linePositions[line] = 0;
+    }
+
+    // The output gains ramp across the sub-block.
+    alignas (16) float dry[subBlockSize];
+    alignas (16) float wet1[subBlockSize];
+    alignas (16) float wet2[subBlockSize];
+
+    const auto fillGainRamp = [n] (float* dest, juce::SmoothedValue<float>& value)
+    {
+        const float from = value.getCurrentValue();
+        SpatialDsp::fillRamp (dest, from, value.skip (n), n);
+    };
+
+    fillGainRamp (dry, dryGain);
+    fillGainRamp (wet1, wetGain1);
+    fillGainRamp (wet2, wetGain2);
+
+    for (int i = 0; i < n; ++i)
+    {
+        const float l = left[i], r = right[i];
+        left[i]  = wetLeft[i] * wet1[i] + wetRight[i] * wet2[i] + l * dry[i];
+        right[i] = wetRight[i] * wet1[i] + wetLeft[i] * wet2[i] + r * dry[i];
+    }
+}
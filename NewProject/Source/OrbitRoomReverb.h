@@ -0,0 +1,100 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+// I'm the room the source orbits in: a handful of early reflections that follow the
+// source's position, then a feedback-delay-network (FDN) tail.
+//
+// Early reflections: I place the source on a circle around the listener in a shoebox
+// room and trace its first-order images (four walls, floor, ceiling) and the four
+// second-order wall corners. Each image becomes one tap on a mono delay line, delayed by
+// its extra path length, and reaches the ears with a gain for its distance and wall
+// absorption, panned at constant power from its direction. The taps are recomputed
+// every sub-block from the source azimuth and ramp there, so they glide with the orbit.
+//
+// Late tail: 8 delay lines mixed by an orthonormal Hadamard matrix, each with a one-pole
+// damping filter and a feedback gain set from the decay time. The left reflections feed
+// the even lines and the right ones the odd lines, which the ears read back, so the tail
+// starts on the side the reflections came from. The line lengths are fixed (room size
+// only sets the decay time and the reflection geometry), so my cost per sample is the
+// same for any room, and are distinct primes in samples, so no two share a factor.
+class OrbitRoomReverb
+{
+public:
+    struct Parameters
+    {
+        float roomSize = 0.5f;      // 0–1: room dimensions and decay time
+        float damping = 0.5f;       // 0–1: wall absorption and high-frequency decay
+        float wetLevel = 0.33f;
+        float dryLevel = 1.0f;
+        float width = 1.0f;         // 0 = mono wet, 1 = full stereo
+        bool freeze = false;        // hold the tail indefinitely, ignoring new input
+    };
+
+    static constexpr int numLines = 8;
+    static constexpr int numReflections = 10;
+    static constexpr int subBlockSize = 32;
+
+    OrbitRoomReverb();
+    ~OrbitRoomReverb() = default;
+
+    const Parameters& getParameters() const noexcept    { return parameters; }
+
+    // Call me between process calls, not in parallel with them.
+    void setParameters (const Parameters& newParameters);
+
+    // I size (and clear) the delay lines for a rate. This allocates.
+    void setSampleRate (double sampleRate);
+
+    // I clear the delay lines.
+    void reset();
+
+    // Where the source is, in radians clockwise from straight ahead (pi/2 = right, pi = behind).
+    // The next processStereo() call glides the reflections from the previous position to
+    // this one across its block.
+    void setSourceAzimuth (float azimuthRadians) noexcept    { targetAzimuth = azimuthRadians; }
+
+    void processStereo (float* left, float* right, int numSamples) noexcept;
+
+    // The tail's decay time (to -60 dB) at low frequencies for a room size.
+    static float getDecaySeconds (float roomSize) noexcept;
+
+    // A late-tail delay line's length in samples at the current rate: always prime.
+    int getLineLength (int line) const noexcept    { return lineSizes[line]; }
+
+private:
+    // One control point for the reflection taps.
+    struct Taps
+    {
+        float delay[numReflections] = {};   // in samples
+        float gainLeft[numReflections] = {}, gainRight[numReflections] = {};
+    };
+
+    void computeTaps (Taps& dest, float azimuth, float roomSize, float damping) const noexcept;
+    void updateFeedback (float decaySeconds) noexcept;
+    void processSubBlock (float* left, float* right, int numSamples, const Taps& target) noexcept;
+
+    Parameters parameters;
+    double sampleRate = 44100.0;
+
+    // The reflections read a power-of-two ring of the mono input.
+    juce::HeapBlock<float> earlyBuffer;
+    int earlyMask = 0, earlyWritePosition = 0;
+    Taps taps;
+    bool tapsNeedReset = true;
+    float azimuth = 0.0f, targetAzimuth = 0.0f;
+
+    // One arena for the FDN lines.
+    juce::HeapBlock<float> lineMemory;
+    float* lineBuffers[numLines] = {};
+    int lineSizes[numLines] = {};
+    int linePositions[numLines] = {};
+    alignas (16) float lineFeedback[numLines] = {};
+    alignas (16) float lineDamping[numLines] = {};     // one-pole filter state
+    float appliedDecaySeconds = -1.0f;
+
+    juce::SmoothedValue<float> decaySeconds, damping, inputGain, wetGain1, wetGain2, dryGain;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (OrbitRoomReverb)
+};
@@ -0,0 +1,244 @@
+#include <JuceHeader.h>
+#include "OrbitRoomReverb.h"
+
+//==============================================================================
+// I test the OrbitRoomReverb: its tail decays at the decay time it promises, its early
+// reflections lean towards the side the source is on, a moving source glides without
+// clicks, freeze, reset and silence behave, its delay lines share no factor, and its
+// level sits where its calibration says against juce::Reverb.
+class OrbitRoomReverbTest : public juce::UnitTest
+{
+public:
+    OrbitRoomReverbTest() : juce::UnitTest ("OrbitRoomReverb", "Audio") {}
+
+    static OrbitRoomReverb::Parameters wetOnly()
+    {
+        OrbitRoomReverb::Parameters parameters;
+        parameters.wetLevel = 1.0f;
+        parameters.dryLevel = 0.0f;
+        return parameters;
+    }
+
+    // I return the wet response to a unit impulse from a source at azimuth.
+    static juce::AudioBuffer<float> impulseResponse (const OrbitRoomReverb::Parameters& parameters,
+                                                     double sampleRate, int numSamples, float azimuth)
+    {
+        OrbitRoomReverb reverb;
+        reverb.setParameters (parameters);
+        reverb.setSampleRate (sampleRate);
+        reverb.setSourceAzimuth (azimuth);
+        reverb.reset();
+
+        juce::AudioBuffer<float> response (2, numSamples);
+        response.clear();
+        response.setSample (0, 0, 1.0f);
+        response.setSample (1, 0, 1.0f);
+
+        for (int start = 0; start < numSamples; start += 512)
+        {
+            const int n = juce::jmin (512, numSamples - start);
+            reverb.processStereo (response.getWritePointer (0, start), response.getWritePointer (1, start), n);
+        }
+        return response;
+    }
+
+    static double energy (const juce::AudioBuffer<float>& buffer, int channel, int start, int numSamples)
+    {
+        double sum = 0.0;
+        for (int i = start; i < start + numSamples; ++i)
+            sum += (double) buffer.getSample (channel, i) * buffer.getSample (channel, i);
+        return sum;
+    }
+
+    void runTest() override
+    {
+        beginTest ("the delay lines are distinct primes at every rate");
+        {
+            for (auto rate : { 22050.0, 44100.0, 48000.0, 88200.0, 96000.0, 192000.0 })
+            {
+                OrbitRoomReverb reverb;
+                reverb.setSampleRate (rate);
+
+                for (int line = 0; line < OrbitRoomReverb::numLines; ++line)
+                {
+                    const int length = reverb.getLineLength (line);
+                    expect (length >= OrbitRoomReverb::subBlockSize);
+
+                    for (int other = 0; other < line; ++other)
+                        expectEquals (std::gcd (length, reverb.getLineLength (other)), 1,
+                                      "lines " + juce::String (other) + " and " + juce::String (line)
+                                        + " at " + juce::String (rate) + " Hz");
+                }
+            }
+        }
+
+        beginTest ("the wet level sits about 4 dB under juce::Reverb's at the defaults");
+        {
+            const double rate = 44100.0;
+            const int numSamples = (int) rate * 4;
+            juce::AudioBuffer<float> room (2, numSamples), reference (2, numSamples);
+            juce::Random random (3);
+            for (int i = 0; i < numSamples; ++i)
+            {
+                const float noise = random.nextFloat() * 2.0f - 1.0f;
+                for (int ch = 0; ch < 2; ++ch)
+                {
+                    room.setSample (ch, i, noise);
+                    reference.setSample (ch, i, noise);
+                }
+            }
+
+            OrbitRoomReverb::Parameters parameters;
+            parameters.dryLevel = 0.0f;
+            OrbitRoomReverb reverb;
+            reverb.setParameters (parameters);
+            reverb.setSampleRate (rate);
+            reverb.reset();
+
+            juce::Reverb::Parameters referenceParameters;
+            referenceParameters.roomSize = parameters.roomSize;
+            referenceParameters.damping = parameters.damping;
+            referenceParameters.wetLevel = parameters.wetLevel;
+            referenceParameters.dryLevel = 0.0f;
+            juce::Reverb referenceReverb;
+            referenceReverb.setParameters (referenceParameters);
+            referenceReverb.setSampleRate (rate);
+            referenceReverb.reset();
+
+            for (int start = 0; start < numSamples; start += 512)
+            {
+                const int n = juce::jmin (512, numSamples - start);
+                reverb.processStereo (room.getWritePointer (0, start), room.getWritePointer (1, start), n);
+                referenceReverb.processStereo (reference.getWritePointer (0, start), reference.getWritePointer (1, start), n);
+            }
+
+            // The second half, once both tails have built up.
+            const int from = numSamples / 2;
+            const double difference = 10.0 * std::log10 ((energy (room, 0, from, numSamples - from) + energy (room, 1, from, numSamples - from))
+                                                          / (energy (reference, 0, from, numSamples - from) + energy (reference, 1, from, numSamples - from)));
+            expectWithinAbsoluteError (difference, -4.0, 1.5);
+        }
+
+        beginTest ("tail decays at the room's decay time");
+        {
+            for (auto rate : { 44100.0, 96000.0 })
+            {
+                auto parameters = wetOnly();
+                parameters.roomSize = 0.6f;
+                parameters.damping = 0.0f;
+                const float decay = OrbitRoomReverb::getDecaySeconds (parameters.roomSize);
+
+                const int window = (int) (0.1 * rate);
+                const int first = (int) (0.3 * rate), second = (int) (0.9 * rate);
+                const auto response = impulseResponse (parameters, rate, second + window, 0.0f);
+
+                const double dropDb = 10.0 * std::log10 ((energy (response, 0, first, window) + energy (response, 1, first, window))
+                                                       / (energy (response, 0, second, window) + energy (response, 1, second, window)));
+                const double measured = 60.0 * (double) (second - first) / rate / dropDb;
+                expectWithinAbsoluteError (measured, (double) decay, 0.2 * decay, "at " + juce::String (rate) + " Hz");
+            }
+        }
+
+        beginTest ("early reflections lean towards the source");
+        {
+            const double rate = 48000.0;
+            const int early = (int) (0.025 * rate);     // before the tail's first return
+            const float halfPi = juce::MathConstants<float>::halfPi;
+
+            const auto right = impulseResponse (wetOnly(), rate, early, halfPi);
+            const auto left = impulseResponse (wetOnly(), rate, early, -halfPi);
+            const auto front = impulseResponse (wetOnly(), rate, early, 0.0f);
+
+            const auto balanceDb = [early] (const juce::AudioBuffer<float>& response)
+            {
+                return 10.0 * std::log10 (energy (response, 1, 0, early) / energy (response, 0, 0, early));
+            };
+
+            expectGreaterThan (balanceDb (right), 3.0, "source on the right");
+            expectLessThan (balanceDb (left), -3.0, "source on the left");
+            expectWithinAbsoluteError (balanceDb (front), 0.0, 0.5, "source ahead");
+            expectWithinAbsoluteError (balanceDb (right), -balanceDb (left), 0.5, "mirror images");
+        }
+
+        beginTest ("a moving source glides without clicks");
+        {
+            const double rate = 48000.0;
+            const int blockSize = 256, numSamples = 188 * blockSize;
+
+            OrbitRoomReverb reverb;
+            reverb.setParameters (wetOnly());
+            reverb.setSampleRate (rate);
+
+            // A low sine, so any step in a reflection's delay or gain shows as a jump.
+            juce::AudioBuffer<float> buffer (2, numSamples);
+            for (int i = 0; i < numSamples; ++i)
+                for (int ch = 0; ch < 2; ++ch)
+                    buffer.setSample (ch, i, 0.5f * std::sin (juce::MathConstants<float>::twoPi * 100.0f * (float) i / (float) rate));
+
+            for (int start = 0; start < numSamples; start += blockSize)
+            {
+                // Two turns a second.
+                reverb.setSourceAzimuth (juce::MathConstants<float>::twoPi * 2.0f * (float) (start + blockSize) / (float) rate);
+                reverb.processStereo (buffer.getWritePointer (0, start), buffer.getWritePointer (1, start), blockSize);
+            }
+
+            float peak = 0.0f, worstSecondDifference = 0.0f;
+            for (int ch = 0; ch < 2; ++ch)
+            {
+                const float* samples = buffer.getReadPointer (ch);
+                for (int i = (int) rate / 10; i < numSamples; ++i)
+                {
+                    peak = juce::jmax (peak, std::abs (samples[i]));
+                    worstSecondDifference = juce::jmax (worstSecondDifference,
+                                                        std::abs (samples[i] - 2.0f * samples[i - 1] + samples[i - 2]));
+                }
+            }
+
+            // A 100 Hz sine's second difference is about peak * 0.0017; a click would be far larger.
+            expectGreaterThan (peak, 0.01f);
+            expectLessThan (worstSecondDifference, peak * 0.02f);
+        }
+
+        beginTest ("freeze holds the tail, reset clears it");
+        {
+            auto parameters = wetOnly();
+            OrbitRoomReverb reverb;
+            reverb.setParameters (parameters);
+            reverb.setSampleRate (48000.0);
+
+            juce::AudioBuffer<float> buffer (2, 4800);
+            juce::Random random (4);
+            for (int ch = 0; ch < 2; ++ch)
+                for (int i = 0; i < buffer.getNumSamples(); ++i)
+                    buffer.setSample (ch, i, random.nextFloat() - 0.5f);
+            reverb.processStereo (buffer.getWritePointer (0), buffer.getWritePointer (1), buffer.getNumSamples());
+
+            parameters.freeze = true;
+            reverb.setParameters (parameters);
+
+            // Let the freeze ramp in, then compare two later stretches of silence in.
+            for (int pass = 0; pass < 3; ++pass)
+            {
+                buffer.clear();
+                reverb.processStereo (buffer.getWritePointer (0), buffer.getWritePointer (1), buffer.getNumSamples());
+            }
+            const float held = buffer.getRMSLevel (0, 0, buffer.getNumSamples());
+
+            for (int pass = 0; pass < 20; ++pass)
+            {
+                buffer.clear();
+                reverb.processStereo (buffer.getWritePointer (0), buffer.getWritePointer (1), buffer.getNumSamples());
+            }
+            expectGreaterThan (held, 0.001f);
+            expectWithinAbsoluteError (buffer.getRMSLevel (0, 0, buffer.getNumSamples()), held, held * 0.1f,
+                                       "two seconds later");
+
+            reverb.reset();
+            buffer.clear();
+            reverb.processStereo (buffer.getWritePointer (0), buffer.getWritePointer (1), buffer.getNumSamples());
+            expectEquals (buffer.getMagnitude (0, buffer.getNumSamples()), 0.0f);
+        }
+    }
+};
+
+static OrbitRoomReverbTest orbitRoomReverbTest;
@@ -0,0 +1,360 @@
+#include "OrbitTrajectory.h"
+
+namespace
+{
+    constexpr double twoPi = juce::MathConstants<double>::twoPi;
+
+    const char* const shapeNames[] = { "circle", "ellipse", "spiral", "figure8", "keyframes", "randomWalk" };
+
+    // I store the point at index k, converting to azimuth, elevation and distance and
+    // unwrapping azimuth against the point before. Straight overhead (or at the centre)
+    // azimuth is undefined, so I keep the previous one.
+    void storePoint (OrbitPath& path, int k, double x, double y, double z)
+    {
+        const double horizontal = std::sqrt (x * x + y * y);
+        const double distance = std::sqrt (horizontal * horizontal + z * z);
+        const float previous = k > 0 ? path.azimuth[k - 1] : 0.0f;
+
+        float azimuth = horizontal > 1.0e-6 ? (float) std::atan2 (x, y) : previous;
+        if (k > 0)
+            azimuth = previous + std::remainder (azimuth - previous, juce::MathConstants<float>::twoPi);
+
+        path.azimuth[k] = azimuth;
+        path.elevation[k] = distance > 1.0e-6 ? (float) std::asin (z / distance) : 0.0f;
+        path.distance[k] = (float) distance;
+    }
+
+    // The keyframes of a closed loop, in radians, with azimuth unwrapped from one keyframe
+    // to the next (the shorter way round) and the loop's whole turns in turnOffset.
+    // I extend them periodically: keyframe j + m is keyframe j one loop later.
+    struct PeriodicKeyframes
+    {
+        std::vector<double> time, azimuth, elevation, distance;
+        double turnOffset = 0.0;
+
+        int size() const    { return (int) time.size(); }
+
+        int wrap (int j, int& loops) const
+        {
+            const int m = size();
+            loops = (j >= 0 ? j : j - m + 1) / m;
+            return j - loops * m;
+        }
+
+        double timeAt (int j) const         { int loops; const int i = wrap (j, loops); return time[(size_t) i] + loops; }
+        double azimuthAt (int j) const      { int loops; const int i = wrap (j, loops); return azimuth[(size_t) i] + turnOffset * loops; }
+        double elevationAt (int j) const    { int loops; const int i = wrap (j, loops); return elevation[(size_t) i]; }
+        double distanceAt (int j) const     { int loops; const int i = wrap (j, loops); return distance[(size_t) i]; }
+    };
+
+    // A cubic Hermite segment from a to b over [t0, t1], with Catmull-Rom tangents from the
+    // neighbours before (at tb) and after (at ta), at time t.
+    double hermite (double before, double a, double b, double after,
+                    double tb, double t0, double t1, double ta, double t)
+    {
+        const double span = t1 - t0;
+        const double u = (t - t0) / span;
+        const double m0 = (b - before) / juce::jmax (1.0e-9, t1 - tb) * span;
+        const double m1 = (after - a) / juce::jmax (1.0e-9, ta - t0) * span;
+        const double u2 = u * u, u3 = u2 * u;
+
+        return (2.0 * u3 - 3.0 * u2 + 1.0) * a + (u3 - 2.0 * u2 + u) * m0
+             + (-2.0 * u3 + 3.0 * u2) * b + (u3 - u2) * m1;
+    }
+
+    void compileSpline (OrbitPath& path, std::vector<OrbitTrajectory::Keyframe> keyframes)
+    {
+        if (keyframes.size() < 2)
+        {
+            const auto only = keyframes.empty() ? OrbitTrajectory::Keyframe() : keyframes.front();
+            Spatializer::Position p;
+            p.azimuth = juce::degreesToRadians (only.azimuthDegrees);
+            p.elevation = juce::degreesToRadians (only.elevationDegrees);
+            p.distance = only.distance;
+
+            const float loopBeats = path.loopBeats;
+            path = OrbitPath::still (p);
+            path.loopBeats = loopBeats;
+            return;
+        }
+
+        for (auto& keyframe : keyframes)
+            keyframe.time -= std::floor (keyframe.time);
+
+        std::stable_sort (keyframes.begin(), keyframes.end(),
+                          [] (const auto& a, const auto& b) { return a.time < b.time; });
+
+        PeriodicKeyframes loop;
+
+        for (const auto& keyframe : keyframes)
+        {
+            const double azimuth = juce::degreesToRadians ((double) keyframe.azimuthDegrees);
+            loop.time.push_back (keyframe.time);
+            loop.azimuth.push_back (loop.azimuth.empty() ? azimuth
+                                                         : loop.azimuth.back() + std::remainder (azimuth - loop.azimuth.back(), twoPi));
+            loop.elevation.push_back (juce::degreesToRadians ((double) keyframe.elevationDegrees));
+            loop.distance.push_back (keyframe.distance);
+        }
+
+        // Back round to the first keyframe, the shorter way, fixes how many turns the loop makes.
+        const double closing = loop.azimuth.back()
+                             + std::remainder (loop.azimuth.front() - loop.azimuth.back(), twoPi);
+        loop.turnOffset = closing - loop.azimuth.front();
+
+        // Time 0 falls in the segment that closes the previous loop (keyframe -1 to 0), or later.
+        int j = -1;
+        for (int k = 0; k <= OrbitPath::numPoints; ++k)
+        {
+            const double t = (double) k / OrbitPath::numPoints;
+            while (loop.timeAt (j + 1) <= t)
+                ++j;
+
+            const double tb = loop.timeAt (j - 1), t0 = loop.timeAt (j), t1 = loop.timeAt (j + 1), ta = loop.timeAt (j + 2);
+            const auto at = [&] (double (PeriodicKeyframes::* value) (int) const)
+            {
+                return hermite ((loop.*value) (j - 1), (loop.*value) (j), (loop.*value) (j + 1), (loop.*value) (j + 2),
+                                tb, t0, t1, ta, t);
+            };
+
+            path.azimuth[k] = (float) at (&PeriodicKeyframes::azimuthAt);
+            path.elevation[k] = (float) juce::jlimit (-juce::MathConstants<double>::halfPi,
+                                                      juce::MathConstants<double>::halfPi,
+                                                      at (&PeriodicKeyframes::elevationAt));
+            path.distance[k] = (float) juce::jmax ((double) SpatialDsp::nearFieldDistance,
+                                                   at (&PeriodicKeyframes::distanceAt));
+        }
+    }
+
+    // A random walk of steps keyframes from straight ahead at radius, bent so that it
+    // closes: whatever drift it ends with (beyond whole turns) is spread back over its steps.
+    std::vector<OrbitTrajectory::Keyframe> makeRandomWalk (const OrbitTrajectory& trajectory)
+    {
+        const int steps = juce::jlimit (2, 64, trajectory.steps);
+        const float stepDegrees = juce::jlimit (0.0f, 80.0f, trajectory.stepDegrees);
+        juce::Random random (trajectory.seed);
+
+        std::vector<OrbitTrajectory::Keyframe> walk ((size_t) steps + 1);
+        walk[0].distance = juce::jlimit (SpatialDsp::nearFieldDistance, SpatialDsp::farDistance, trajectory.radius);
+
+        for (size_t i = 1; i < walk.size(); ++i)
+        {
+            const auto& from = walk[i - 1];
+            auto& to = walk[i];
+            to.azimuthDegrees = from.azimuthDegrees + (random.nextFloat() * 2.0f - 1.0f) * stepDegrees;
+            to.elevationDegrees = juce::jlimit (-30.0f, 60.0f, from.elevationDegrees
+                                                               + (random.nextFloat() * 2.0f - 1.0f) * stepDegrees / 3.0f);
+            to.distance = juce::jlimit (SpatialDsp::nearFieldDistance, SpatialDsp::farDistance,
+                                        from.distance * std::exp2 ((random.nextFloat() * 2.0f - 1.0f) * 0.5f));
+        }
+
+        const auto& last = walk.back();
+        const float azimuthDrift = last.azimuthDegrees - 360.0f * std::round (last.azimuthDegrees / 360.0f);
+        const float elevationDrift = last.elevationDegrees;
+        const float distanceDrift = std::log2 (last.distance / walk[0].distance);
+
+        for (size_t i = 0; i < walk.size(); ++i)
+        {
+            const float t = (float) i / (float) steps;
+            walk[i].time = t;
+            walk[i].azimuthDegrees -= azimuthDrift * t;
+            walk[i].elevationDegrees -= elevationDrift * t;
+            walk[i].distance *= std::exp2 (-distanceDrift * t);
+        }
+
+        walk.pop_back();
+        return walk;
+    }
+}
+
+//==============================================================================
+Spatializer::Position OrbitPath::getPosition (double phase) const noexcept
+{
+    const float index = juce::jlimit (0.0f, (float) numPoints,
+                                      (float) (phase * (numPoints / juce::MathConstants<double>::twoPi)));
+    const int i = juce::jmin ((int) index, numPoints - 1);
+    const float t = index - (float) i;
+
+    Spatializer::Position p;
+    p.azimuth   = azimuth[i]   + (azimuth[i + 1]   - azimuth[i])   * t;
+    p.elevation = elevation[i] + (elevation[i + 1] - elevation[i]) * t;
+    p.distance  = distance[i]  + (distance[i + 1]  - distance[i])  * t;
+    return p;
+}
+
+OrbitPath OrbitPath::still (const Spatializer::Position& position) noexcept
+{
+    OrbitPath path;
+    path.placeAt (position);
+    return path;
+}
+
+void OrbitPath::placeAt (const Spatializer::Position& position) noexcept
+{
+    std::fill (std::begin (azimuth), std::end (azimuth), position.azimuth);
+    std::fill (std::begin (elevation), std::end (elevation), position.elevation);
+    std::fill (std::begin (distance), std::end (distance), position.distance);
+}
+
+const OrbitPath& OrbitPath::getBuiltIn (Spatializer::OrbitMode orbitMode)
+{
+    // Both behind one guard, so after the first call a lookup is a single flag check.
+    struct BuiltIns
+    {
+        OrbitPath orbit = OrbitTrajectory::circle().compile();
+        OrbitPath figure8 = OrbitTrajectory::figure8().compile();
+    };
+
+    static const BuiltIns builtIns;
+
+    jassert (orbitMode == Spatializer::OrbitMode::Orbit || orbitMode == Spatializer::OrbitMode::Figure8);
+    return orbitMode == Spatializer::OrbitMode::Figure8 ? builtIns.figure8 : builtIns.orbit;
+}
+
+//==============================================================================
+OrbitPath OrbitTrajectory::compile() const
+{
+    OrbitPath path;
+    path.loopBeats = juce::jmax (0.0f, loopBeats);
+
+    if (shape == Shape::Keyframes)
+    {
+        compileSpline (path, keyframes);
+        return path;
+    }
+
+    if (shape == Shape::RandomWalk)
+    {
+        compileSpline (path, makeRandomWalk (*this));
+        return path;
+    }
+
+    const int spiralTurns = juce::jmax (1, turns);
+
+    for (int k = 0; k <= OrbitPath::numPoints; ++k)
+    {
+        const double phase = twoPi * k / OrbitPath::numPoints;
+        double x = 0.0, y = 0.0, z = height;
+
+        if (shape == Shape::Ellipse)
+        {
+            x = radius * std::sin (phase);
+            y = frontRadius * std::cos (phase);
+        }
+        else if (shape == Shape::Spiral)
+        {
+            x = radius * std::sin (phase * spiralTurns);
+            y = radius * std::cos (phase * spiralTurns);
+            z = height + (topHeight - height) * 0.5 * (1.0 - std::cos (phase));
+        }
+        else if (shape == Shape::Figure8)
+        {
+            // Left-right twice per loop while going front to back once, lifted over the
+            // head as it crosses from one loop to the other.
+            x = 0.75 * radius * std::sin (2.0 * phase);
+            y = radius * std::cos (phase);
+            z = height + 0.375 * radius * std::sin (phase);
+        }
+        else
+        {
+            x = radius * std::sin (phase);
+            y = radius * std::cos (phase);
+        }
+
+        storePoint (path, k, x, y, z);
+    }
+
+    return path;
+}
+
+OrbitPath OrbitTrajectory::compileForMode (Spatializer::OrbitMode orbitMode, float manualPan,
+                                           const OrbitTrajectory& custom)
+{
+    if (orbitMode == Spatializer::OrbitMode::Manual)
+        return OrbitPath::still (Spatializer::getManualPosition (manualPan));
+
+    if (orbitMode == Spatializer::OrbitMode::Path)
+        return custom.compile();
+
+    return OrbitPath::getBuiltIn (orbitMode);
+}
+
+OrbitTrajectory OrbitTrajectory::circle()
+{
+    return {};
+}
+
+OrbitTrajectory OrbitTrajectory::figure8()
+{
+    OrbitTrajectory trajectory;
+    trajectory.shape = Shape::Figure8;
+    trajectory.radius = 2.0f;
+    return trajectory;
+}
+
+//==============================================================================
+juce::ValueTree OrbitTrajectory::toValueTree() const
+{
+    juce::ValueTree vt ("Trajectory");
+    vt.setProperty ("shape", shapeNames[(int) shape], nullptr);
+    vt.setProperty ("radius", (double) radius, nullptr);
+    vt.setProperty ("frontRadius", (double) frontRadius, nullptr);
+    vt.setProperty ("height", (double) height, nullptr);
+    vt.setProperty ("topHeight", (double) topHeight, nullptr);
+    vt.setProperty ("turns", turns, nullptr);
+    vt.setProperty ("steps", steps, nullptr);
+    vt.setProperty ("stepDegrees", (double) stepDegrees, nullptr);
+    vt.setProperty ("seed", seed, nullptr);
+    vt.setProperty ("loopBeats", (double) loopBeats, nullptr);
+
+    for (const auto& keyframe : keyframes)
+    {
+        juce::ValueTree child ("Keyframe");
+        child.setProperty ("time", (double) keyframe.time, nullptr);
+        child.setProperty ("azimuth", (double) keyframe.azimuthDegrees, nullptr);
+        child.setProperty ("elevation", (double) keyframe.elevationDegrees, nullptr);
+        child.setProperty ("distance", (double) keyframe.distance, nullptr);
+        vt.appendChild (child, nullptr);
+    }
+
+    return vt;
+}
+
+OrbitTrajectory OrbitTrajectory::fromValueTree (const juce::ValueTree& vt)
+{
+    OrbitTrajectory t;
+    if (! vt.isValid()) return t;
+
+    const auto shapeName = vt.getProperty ("shape", shapeNames[0]).toString();
+    for (int i = 0; i < (int) std::size (shapeNames); ++i)
+        if (shapeName == shapeNames[i])
+            t.shape = (Shape) i;
+
+    t.radius = (float) (double) vt.getProperty ("radius", (double) SpatialDsp::referenceDistance);
+    t.frontRadius = (float) (double) vt.getProperty ("frontRadius", (double) t.radius);
+    t.height = (float) (double) vt.getProperty ("height", 0.0);
+    t.topHeight = (float) (double) vt.getProperty ("topHeight", 1.0);
+    t.turns = juce::jlimit (1, 64, (int) vt.getProperty ("turns", 3));
+    t.steps = juce::jlimit (2, 64, (int) vt.getProperty ("steps", 8));
+    t.stepDegrees = (float) (double) vt.getProperty ("stepDegrees", 60.0);
+    t.seed = (int) vt.getProperty ("seed", 1);
+    t.loopBeats = juce::jmax (0.0f, (float) (double) vt.getProperty ("loopBeats", 0.0));
+
+    // Keyframes without a time are spread evenly around the loop.
+    const int numKeyframes = vt.getNumChildren();
+    for (int i = 0; i < numKeyframes; ++i)
+    {
+        const auto child = vt.getChild (i);
+        if (! child.hasType ("Keyframe"))
+            continue;
+
+        Keyframe keyframe;
+        keyframe.time = (float) (double) child.getProperty ("time", (double) i / numKeyframes);
+        keyframe.azimuthDegrees = (float) (double) child.getProperty ("azimuth", 0.0);
+        keyframe.elevationDegrees = juce::jlimit (-90.0f, 90.0f, (float) (double) child.getProperty ("elevation", 0.0));
+        keyframe.distance = juce::jlimit (SpatialDsp::nearFieldDistance, SpatialDsp::farDistance,
+                                          (float) (double) child.getProperty ("distance", (double) SpatialDsp::referenceDistance));
+        t.keyframes.push_back (keyframe);
+    }
+
+    return t;
+}
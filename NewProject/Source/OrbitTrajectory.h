@@ -0,0 +1,95 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "Spatializer.h"
+
+//==============================================================================
+// I'm a trajectory compiled for the audio thread: the source's position at evenly spaced
+// phases around one loop, with azimuth unwrapped so neighbouring points never differ by
+// a whole turn. Looking a position up is two reads and a linear interpolation per
+// coordinate, with no trig, so the renderers can follow any path at control rate. (Straight
+// over or under the head, where azimuth turns half a turn at once, the interpolation cuts
+// that corner across one table step.)
+//
+// I'm a plain block of floats, so I travel inside the engine's parameter snapshot.
+struct OrbitPath
+{
+    static constexpr int numPoints = 128;
+
+    // numPoints + 1 points, the last one closing the loop (same place as the first, plus
+    // any whole turns the path makes).
+    float azimuth[numPoints + 1] = {};      // radians, unwrapped
+    float elevation[numPoints + 1] = {};    // radians
+    float distance[numPoints + 1] = {};     // metres
+
+    // How many beats one loop lasts when tempo-locked; 0 runs at the free orbit speed.
+    float loopBeats = 0.0f;
+
+    // Where the source is at phase (radians, 0 to 2 pi around the loop).
+    Spatializer::Position getPosition (double phase) const noexcept;
+
+    // A path that stays at one position, and the same in place: a path kept for Manual
+    // mode moves to a new pan without building a table on the stack.
+    static OrbitPath still (const Spatializer::Position& position) noexcept;
+    void placeAt (const Spatializer::Position& position) noexcept;
+
+    // The fixed paths of the Orbit and Figure-8 modes, compiled the first time anyone asks.
+    // The processors ask in prepareToPlay(), so that's never the audio thread.
+    static const OrbitPath& getBuiltIn (Spatializer::OrbitMode orbitMode);
+};
+
+//==============================================================================
+// I'm a user-defined trajectory as stored in a preset: a shape and its dimensions, or a
+// list of keyframes. I'm compiled into an OrbitPath on the message thread (when a preset
+// loads or the mode changes); the audio thread only ever sees the table.
+//
+// Coordinates are metres around the centre of the head: x to the right, y ahead, z up.
+// Every shape is one closed loop, traced once per orbit period (or per loopBeats beats).
+struct OrbitTrajectory
+{
+    enum class Shape
+    {
+        Circle,         // radius, at height
+        Ellipse,        // radius side to side, frontRadius front to back, at height
+        Spiral,         // turns circles of radius, rising from height to topHeight and back
+        Figure8,        // the Figure-8 mode's loop, scaled so radius is its front-back reach
+        Keyframes,      // a closed spline through keyframes
+        RandomWalk      // a closed spline through steps random keyframes, from seed
+    };
+
+    // A point the Keyframes spline passes through, at a time from 0 to 1 around the loop.
+    struct Keyframe
+    {
+        float time = 0.0f;
+        float azimuthDegrees = 0.0f;     // clockwise from ahead
+        float elevationDegrees = 0.0f;   // up from ear level
+        float distance = SpatialDsp::referenceDistance;
+    };
+
+    Shape shape = Shape::Circle;
+    float radius = SpatialDsp::referenceDistance;
+    float frontRadius = SpatialDsp::referenceDistance;
+    float height = 0.0f;
+    float topHeight = 1.0f;
+    int turns = 3;
+    int steps = 8;
+    float stepDegrees = 60.0f;
+    int seed = 1;
+    float loopBeats = 0.0f;
+    std::vector<Keyframe> keyframes;
+
+    // I sample the loop into a table. Allocation-free for the geometric shapes.
+    OrbitPath compile() const;
+
+    juce::ValueTree toValueTree() const;
+    static OrbitTrajectory fromValueTree (const juce::ValueTree& vt);
+
+    // The loops behind the Orbit and Figure-8 modes.
+    static OrbitTrajectory circle();
+    static OrbitTrajectory figure8();
+
+    // The path a mode follows: Manual stays where manualPan puts the source, Orbit and
+    // Figure-8 are the built-ins, and Path follows custom.
+    static OrbitPath compileForMode (Spatializer::OrbitMode orbitMode, float manualPan,
+                                     const OrbitTrajectory& custom);
+};
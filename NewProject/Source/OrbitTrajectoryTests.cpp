@@ -0,0 +1,222 @@
+#include <JuceHeader.h>
+#include "OrbitTrajectory.h"
+#include "OrbitEngine.h"
+
+//==============================================================================
+// I test OrbitTrajectory and its compiled OrbitPath: the built-in paths land where the
+// old formulas put the source, every shape closes its loop, keyframe splines pass through
+// their keyframes, random walks are repeatable, presets keep trajectories, and tempo-locked
+// loops run at the preset's tempo.
+class OrbitTrajectoryTest : public juce::UnitTest
+{
+public:
+    OrbitTrajectoryTest() : juce::UnitTest ("OrbitTrajectory", "Audio") {}
+
+    static constexpr double twoPi = juce::MathConstants<double>::twoPi;
+
+    static float angleBetween (float a, float b)
+    {
+        return std::abs (std::remainder (a - b, juce::MathConstants<float>::twoPi));
+    }
+
+    // I check that a path ends where it starts, up to whole turns of azimuth.
+    void expectClosed (const OrbitPath& path, const juce::String& label)
+    {
+        const auto start = path.getPosition (0.0);
+        const auto end = path.getPosition (twoPi);
+        expectLessThan (angleBetween (start.azimuth, end.azimuth), 1.0e-4f, label + " azimuth");
+        expectWithinAbsoluteError (end.elevation, start.elevation, 1.0e-4f, label + " elevation");
+        expectWithinAbsoluteError (end.distance, start.distance, 1.0e-4f, label + " distance");
+    }
+
+    void runTest() override
+    {
+        beginTest ("built-in paths match the orbit modes' shapes");
+        {
+            const auto& orbit = OrbitPath::getBuiltIn (Spatializer::OrbitMode::Orbit);
+            const auto& figure8 = OrbitPath::getBuiltIn (Spatializer::OrbitMode::Figure8);
+            float worstOrbit = 0.0f, worstFigure8 = 0.0f;
+
+            for (int i = 0; i < 1000; ++i)
+            {
+                const double phase = twoPi * i / 1000.0;
+
+                const auto o = orbit.getPosition (phase);
+                worstOrbit = juce::jmax (worstOrbit, angleBetween (o.azimuth, (float) phase),
+                                         std::abs (o.elevation), std::abs (o.distance - 1.0f));
+
+                // The Figure-8 in metres, as the position it should have compiled to. It passes
+                // straight over and under the head, where azimuth turns half a turn at once and
+                // the table cuts the corner for a step, so I check it away from there.
+                const double fromPole = juce::MathConstants<double>::halfPi
+                                      - std::abs (std::remainder (phase, juce::MathConstants<double>::pi));
+                if (fromPole < 2.0 * twoPi / OrbitPath::numPoints)
+                    continue;
+
+                const double x = 1.5 * std::sin (2.0 * phase), y = 2.0 * std::cos (phase), z = 0.75 * std::sin (phase);
+                const auto f = figure8.getPosition (phase);
+                const double fx = f.distance * std::cos (f.elevation) * std::sin (f.azimuth);
+                const double fy = f.distance * std::cos (f.elevation) * std::cos (f.azimuth);
+                const double fz = f.distance * std::sin (f.elevation);
+                worstFigure8 = juce::jmax (worstFigure8, (float) std::sqrt ((fx - x) * (fx - x) + (fy - y) * (fy - y) + (fz - z) * (fz - z)));
+            }
+
+            expectLessThan (worstOrbit, 1.0e-5f, "a circle is exact");
+            expectLessThan (worstFigure8, 0.01f, "metres off the Figure-8");
+            expectLessThan (std::abs (orbit.azimuth[OrbitPath::numPoints] - orbit.azimuth[0] - (float) twoPi), 1.0e-5f,
+                            "the circle makes one turn");
+        }
+
+        beginTest ("every shape closes its loop");
+        {
+            for (auto shape : { OrbitTrajectory::Shape::Circle, OrbitTrajectory::Shape::Ellipse, OrbitTrajectory::Shape::Spiral,
+                                OrbitTrajectory::Shape::Figure8, OrbitTrajectory::Shape::RandomWalk })
+            {
+                OrbitTrajectory trajectory;
+                trajectory.shape = shape;
+                trajectory.radius = 1.5f;
+                trajectory.frontRadius = 3.0f;
+                trajectory.height = -0.5f;
+                expectClosed (trajectory.compile(), juce::String ((int) shape));
+            }
+
+            // A spiral rises to its top height halfway round and comes back down.
+            OrbitTrajectory spiral;
+            spiral.shape = OrbitTrajectory::Shape::Spiral;
+            spiral.radius = 1.0f;
+            spiral.height = 0.0f;
+            spiral.topHeight = 1.0f;
+            const auto top = spiral.compile().getPosition (twoPi * 0.5);
+            expectWithinAbsoluteError (top.distance * std::sin (top.elevation), 1.0f, 1.0e-3f);
+        }
+
+        beginTest ("a keyframe spline passes through its keyframes");
+        {
+            OrbitTrajectory trajectory;
+            trajectory.shape = OrbitTrajectory::Shape::Keyframes;
+            trajectory.keyframes = { { 0.1f, 0.0f, 0.0f, 1.0f },
+                                     { 0.35f, 120.0f, 30.0f, 2.0f },
+                                     { 0.6f, -120.0f, -10.0f, 0.5f },
+                                     { 0.8f, -40.0f, 45.0f, 3.0f } };
+            const auto path = trajectory.compile();
+
+            for (const auto& keyframe : trajectory.keyframes)
+            {
+                const auto p = path.getPosition (twoPi * keyframe.time);
+                expectLessThan (angleBetween (p.azimuth, juce::degreesToRadians (keyframe.azimuthDegrees)), 0.02f);
+                expectWithinAbsoluteError (p.elevation, juce::degreesToRadians (keyframe.elevationDegrees), 0.02f);
+                expectWithinAbsoluteError (p.distance, keyframe.distance, 0.02f);
+            }
+
+            expectClosed (path, "keyframes");
+
+            // 0 -> 120 -> 240 -> 320 degrees, each the shorter way, is one turn clockwise.
+            expectWithinAbsoluteError (path.azimuth[OrbitPath::numPoints] - path.azimuth[0], (float) twoPi, 1.0e-4f);
+        }
+
+        beginTest ("random walks are repeatable and stay in range");
+        {
+            OrbitTrajectory walk;
+            walk.shape = OrbitTrajectory::Shape::RandomWalk;
+            walk.steps = 12;
+            walk.stepDegrees = 80.0f;
+            walk.radius = 2.0f;
+
+            walk.seed = 7;
+            const auto a = walk.compile(), b = walk.compile();
+            walk.seed = 8;
+            const auto c = walk.compile();
+
+            expect (std::memcmp (&a, &b, sizeof (a)) == 0, "same seed, same path");
+            expect (std::memcmp (&a, &c, sizeof (a)) != 0, "another seed, another path");
+
+            float biggestStep = 0.0f;
+            for (int k = 0; k <= OrbitPath::numPoints; ++k)
+            {
+                expect (a.distance[k] >= SpatialDsp::nearFieldDistance && a.distance[k] <= SpatialDsp::farDistance * 1.5f);
+                expect (std::abs (a.elevation[k]) <= juce::MathConstants<float>::halfPi);
+                if (k > 0)
+                    biggestStep = juce::jmax (biggestStep, std::abs (a.azimuth[k] - a.azimuth[k - 1]));
+            }
+
+            // 12 steps of up to 80 degrees over 128 points: no jump anywhere near half a turn.
+            expectLessThan (biggestStep, 0.5f);
+        }
+
+        beginTest ("presets keep their trajectory");
+        {
+            OrbitPreset preset;
+            preset.orbitMode = 3;
+            preset.tempoBpm = 96.0f;
+            preset.trajectory.shape = OrbitTrajectory::Shape::Keyframes;
+            preset.trajectory.loopBeats = 4.0f;
+            preset.trajectory.keyframes = { { 0.0f, -90.0f, 0.0f, 1.0f }, { 0.5f, 90.0f, 20.0f, 4.0f } };
+
+            const auto xml = preset.toValueTree().createXml();
+            expect (xml != nullptr);
+            const auto loaded = OrbitPreset::fromValueTree (juce::ValueTree::fromXml (*xml));
+
+            expect (loaded.getOrbitMode() == Spatializer::OrbitMode::Path);
+            expectEquals (loaded.tempoBpm, 96.0f);
+            expect (loaded.trajectory.shape == OrbitTrajectory::Shape::Keyframes);
+            expectEquals ((int) loaded.trajectory.keyframes.size(), 2);
+
+            const auto expected = preset.trajectory.compile(), compiled = loaded.trajectory.compile();
+            expect (std::memcmp (&expected, &compiled, sizeof (expected)) == 0, "compiles to the same table");
+
+            // Presets from before trajectories follow a circle in Path mode.
+            juce::ValueTree old ("OrbitAudioPreset");
+            old.setProperty ("orbitMode", 1, nullptr);
+            expect (OrbitPreset::fromValueTree (old).trajectory.shape == OrbitTrajectory::Shape::Circle);
+        }
+
+        beginTest ("tempo-locked loops follow the tempo");
+        {
+            auto parameters = OrbitEngine::Parameters::fromPreset (OrbitPreset::fromValueTree (OrbitPreset::getBuiltIn ("Spiral")));
+            expect (parameters.orbitMode == Spatializer::OrbitMode::Path);
+
+            // Eight beats at 120 bpm is four seconds a loop.
+            expectWithinAbsoluteError (parameters.getLoopsPerSecond(), 0.25f, 1.0e-6f);
+
+            parameters.tempoBpm = 90.0f;
+            expectWithinAbsoluteError (parameters.getLoopsPerSecond(), 90.0f / 60.0f / 8.0f, 1.0e-6f);
+
+            parameters.orbitMode = Spatializer::OrbitMode::Orbit;
+            parameters.path = OrbitPath::getBuiltIn (Spatializer::OrbitMode::Orbit);
+            parameters.panSpeedHz = 0.3f;
+            expectWithinAbsoluteError (parameters.getLoopsPerSecond(), 0.3f, 1.0e-6f);
+        }
+
+        beginTest ("a still path renders like a fixed position");
+        {
+            Spatializer::Position position;
+            position.azimuth = 1.0f;
+            position.elevation = 0.3f;
+            position.distance = 2.5f;
+            const auto path = OrbitPath::still (position);
+
+            Spatializer fixed, following;
+            fixed.prepareToPlay (256, 48000.0);
+            following.prepareToPlay (256, 48000.0);
+
+            juce::AudioBuffer<float> a (2, 256), b (2, 256);
+            juce::Random random (3);
+            for (int block = 0; block < 8; ++block)
+            {
+                for (int ch = 0; ch < 2; ++ch)
+                    for (int i = 0; i < 256; ++i)
+                        a.setSample (ch, i, random.nextFloat() - 0.5f);
+                b.makeCopyOf (a);
+
+                fixed.process (a, 0, 256, position);
+                following.process (b, 0, 256, path, 0.5f);
+
+                for (int ch = 0; ch < 2; ++ch)
+                    for (int i = 0; i < 256; ++i)
+                        expectWithinAbsoluteError (b.getSample (ch, i), a.getSample (ch, i), 1.0e-6f);
+            }
+        }
+    }
+};
+
+static OrbitTrajectoryTest orbitTrajectoryTest;
@@ -0,0 +1,162 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+// Small block helpers shared by the Spatializer and the SpatializerBank. They work
+// on one control-rate sub-block at a time and never allocate.
+namespace SpatialDsp
+{
+    // Head model shared by every spatializer: maximum ITD, far-ear shadow cutoff range,
+    // and the depth (distance) cutoff range from close to far.
+    constexpr float maxDelayMs = 0.5f;
+    constexpr float minCutoffHz = 2000.0f;
+    constexpr float maxCutoffHz = 18000.0f;
+    constexpr float nearDepthCutoffHz = 18000.0f;
+    constexpr float farDepthCutoffHz = 1500.0f;
+
+    // Distance model, in metres. At the reference distance a source has unity gain and no
+    // propagation delay; nearer, the near ear gains ILD up to nearFieldDistance; farther,
+    // it is delayed (which, gliding, is Doppler) and loses highs until farDistance.
+    constexpr float referenceDistance = 1.0f;
+    constexpr float nearFieldDistance = 0.25f;
+    constexpr float farDistance = 20.0f;
+    constexpr float maxDistanceGain = 2.0f;
+    constexpr float speedOfSound = 343.0f;     // m/s
+
+    // The full ITD in samples at a rate, rounded up: what the delay lines must hold for it.
+    inline int maxItdSamples (double sampleRate) noexcept
+    {
+        return (int) std::ceil (sampleRate * maxDelayMs / 1000.0);
+    }
+
+    // Behind the head both ears lose some highs (pinna shadow), as a share of the far-ear shadow.
+    constexpr float rearShadow = 0.5f;
+
+    // I return how far behind the head an azimuth is (0 anywhere in the front half, 1 straight
+    // behind), scaled by the cosine of the elevation. The small dead zone keeps hard left and
+    // right, where cos() rounds to a hair below zero, out of the rear.
+    inline float rearAmount (float azimuth, float cosElevation) noexcept
+    {
+        const float ahead = std::cos (azimuth) * cosElevation;
+        return ahead < -1.0e-4f ? -ahead : 0.0f;
+    }
+
+    // I fill dest with a linear ramp that reaches `to` on the last sample, matching the
+    // control-point convention (the previous sub-block already ended on `from`).
+    inline void fillRamp (float* dest, float from, float to, int numSamples) noexcept
+    {
+        const float step = (to - from) / (float) numSamples;
+
+        for (int i = 0; i < numSamples; ++i)
+            dest[i] = from + step * (float) (i + 1);
+    }
+
+    // I run a one-pole low-pass with a ramped coefficient in place. This is the only
+    // serial dependency left in the chain.
+    inline void onePoleInPlace (float* samples, const float* alpha, float& state, int numSamples) noexcept
+    {
+        float y = state;
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            y = samples[i] + alpha[i] * (y - samples[i]);
+            samples[i] = y;
+        }
+
+        state = y;
+    }
+
+    // I return the one-pole coefficient for a cutoff: alpha = exp(-2*pi*fc/fs).
+    inline float onePoleAlpha (float cutoffHz, double sampleRate) noexcept
+    {
+        return std::exp (-2.0f * juce::MathConstants<float>::pi * cutoffHz / (float) sampleRate);
+    }
+
+    //==============================================================================
+    // The SpatializerBank works out every source's control point a SIMD register at a time.
+    // A lane group is a juce::dsp::SIMDRegister<float> where JUCE has SIMD for the target,
+    // else a plain float; the helpers below have both forms, and the approximations use
+    // nothing else, so the same code runs either way.
+    inline float laneMin (float a, float b) noexcept                      { return a < b ? a : b; }
+    inline float laneMax (float a, float b) noexcept                      { return a > b ? a : b; }
+    inline float laneTruncate (float a) noexcept                          { return (float) (int) a; }
+    inline float laneKeepAbove (float value, float test, float threshold) noexcept   { return test > threshold ? value : 0.0f; }
+
+   #if JUCE_USE_SIMD
+    using ControlLanes = juce::dsp::SIMDRegister<float>;
+
+    inline ControlLanes laneMin (ControlLanes a, ControlLanes b) noexcept  { return ControlLanes::min (a, b); }
+    inline ControlLanes laneMax (ControlLanes a, ControlLanes b) noexcept  { return ControlLanes::max (a, b); }
+    inline ControlLanes laneTruncate (ControlLanes a) noexcept             { return ControlLanes::truncate (a); }
+
+    // value where test is above threshold, else 0.
+    inline ControlLanes laneKeepAbove (ControlLanes value, ControlLanes test, float threshold) noexcept
+    {
+        return value & ControlLanes::greaterThan (test, ControlLanes::expand (threshold));
+    }
+
+    inline ControlLanes loadLanes (const float* source) noexcept           { return ControlLanes::fromRawArray (source); }
+    inline void storeLanes (ControlLanes lanes, float* dest) noexcept      { lanes.copyToRawArray (dest); }
+   #else
+    using ControlLanes = float;
+
+    inline float loadLanes (const float* source) noexcept                 { return *source; }
+    inline void storeLanes (float lanes, float* dest) noexcept            { *dest = lanes; }
+   #endif
+
+    constexpr int numControlLanes = (int) (sizeof (ControlLanes) / sizeof (float));
+
+    // An angle from -pi upwards, wrapped into -pi to pi.
+    template <typename Lanes>
+    inline Lanes wrapAngle (Lanes x) noexcept
+    {
+        const float twoPi = juce::MathConstants<float>::twoPi;
+        return x - laneTruncate (x * (1.0f / twoPi) + 0.5f) * twoPi;
+    }
+
+    // sin (x) for x from -3pi/2 to 3pi/2, to within 2e-7: folded into -pi/2 to pi/2, then
+    // the Taylor series to x^11.
+    template <typename Lanes>
+    inline Lanes sinApprox (Lanes x) noexcept
+    {
+        const float pi = juce::MathConstants<float>::pi;
+        x = laneMax (laneMin (x, Lanes (pi) - x), Lanes (-pi) - x);
+
+        const Lanes x2 = x * x;
+        Lanes p = x2 * (-1.0f / 39916800.0f) + (1.0f / 362880.0f);
+        p = p * x2 + (-1.0f / 5040.0f);
+        p = p * x2 + (1.0f / 120.0f);
+        p = p * x2 + (-1.0f / 6.0f);
+        p = p * x2 + 1.0f;
+        return x * p;
+    }
+
+    // How many times expApprox() must square to cover exponents down to -maxMagnitude.
+    inline int expSquarings (float maxMagnitude) noexcept
+    {
+        int squarings = 0;
+        for (; maxMagnitude > 0.125f && squarings < 16; maxMagnitude *= 0.5f)
+            ++squarings;
+        return squarings;
+    }
+
+    // exp (x) for x within expSquarings()' range, to about 1e-5 of itself: the Taylor
+    // series to x^6 at x / 2^squarings, squared back up.
+    template <typename Lanes>
+    inline Lanes expApprox (Lanes x, int squarings) noexcept
+    {
+        const Lanes z = x * (1.0f / (float) (1 << squarings));
+        Lanes p = z * (1.0f / 720.0f) + (1.0f / 120.0f);
+        p = p * z + (1.0f / 24.0f);
+        p = p * z + (1.0f / 6.0f);
+        p = p * z + 0.5f;
+        p = p * z + 1.0f;
+        p = p * z + 1.0f;
+
+        for (int i = 0; i < squarings; ++i)
+            p = p * p;
+
+        return p;
+    }
+}
@@ -1,4 +1,6 @@
 #include "Spatializer.h"
+#include "SpatialDsp.h"
+#include "OrbitTrajectory.h"
 
 //==============================================================================
 Spatializer::Spatializer() = default;
@@ -8,138 +10,310 @@ void Spatializer::prepareToPlay (int /*samplesPerBlockExpected*/, double sampleR
 {
     sampleRate = sampleRateIn;
     lfoPhase = 0.0;
-    std::fill (std::begin (leftDelayBuffer),  std::end (leftDelayBuffer),  0.0f);
-    std::fill (std::begin (rightDelayBuffer), std::end (rightDelayBuffer), 0.0f);
+
+    // The far ear's full ITD at this rate on top of the propagation delay of the farthest source.
+    const int maxPropagation = (int) std::ceil ((SpatialDsp::farDistance - SpatialDsp::referenceDistance)
+                                                / SpatialDsp::speedOfSound * sampleRate);
+    leftDelayLine.prepare (SpatialDsp::maxItdSamples (sampleRate) + maxPropagation);
+    rightDelayLine.prepare (SpatialDsp::maxItdSamples (sampleRate) + maxPropagation);
     leftLPF = rightLPF = 0.0f;
     depthLPF_L = depthLPF_R = 0.0f;
-    delayWriteIndex = 0;
+    controlNeedsReset = true;
+
+    // The built-in paths are compiled here rather than on the first audio callback.
+    OrbitPath::getBuiltIn (OrbitMode::Orbit);
 }
 
 void Spatializer::setDepth (float d)
 {
-    depth.store (juce::jlimit (0.0f, 1.0f, d));
+    depth = juce::jlimit (0.0f, 1.0f, d);
 }
 
 void Spatializer::setWidth (float w)
 {
-    width.store (juce::jlimit (0.0f, 1.0f, w));
+    width = juce::jlimit (0.0f, 1.0f, w);
 }
 
 //==============================================================================
 void Spatializer::setItdAmount (float amount)
 {
-    itdAmount.store (juce::jlimit (0.0f, 1.0f, amount));
+    itdAmount = juce::jlimit (0.0f, 1.0f, amount);
 }
 
 void Spatializer::setShadowStrength (float strength)
 {
-    shadowStrength.store (juce::jlimit (0.0f, 1.0f, strength));
+    shadowStrength = juce::jlimit (0.0f, 1.0f, strength);
 }
 
 //==============================================================================
-void Spatializer::process (juce::AudioBuffer<float>& buffer,
-                           int startSample,
-                           int numSamples,
-                           float manualPan,
-                           OrbitMode orbitMode,
-                           float panSpeedHz)
+Spatializer::Position Spatializer::getManualPosition (float manualPan)
+{
+    Position p;
+    p.azimuth = std::asin (juce::jlimit (-1.0f, 1.0f, manualPan));
+    return p;
+}
+
+Spatializer::Position Spatializer::toHeadRelative (const Position& source, const HeadOrientation& orientation)
 {
-    const float itd = itdAmount.load();
-    const float shadow = shadowStrength.load();
-    const float depthVal = depth.load();
-    const float widthVal = width.load();
+    if (orientation.isZero())
+        return source;
+
+    const float cosElevation = std::cos (source.elevation);
+    float x = std::cos (source.azimuth) * cosElevation;
+    float y = -std::sin (source.azimuth) * cosElevation;
+    float z = std::sin (source.elevation);
+    orientation.toHeadRelative (x, y, z);
+
+    return { std::atan2 (-y, x), std::asin (juce::jlimit (-1.0f, 1.0f, z)), source.distance };
+}
+
+Spatializer::ControlState Spatializer::computeControlState (const Position& source,
+                                                            float maxDelayUsed,
+                                                            float shadow,
+                                                            float depthVal,
+                                                            float widthVal) const
+{
+    ControlState state;
+
+    // The interaural axis sees the lateral part of the direction: pan -1 = hard left, +1 = hard right.
+    const float cosElevation = std::cos (source.elevation);
+    const float pan = std::sin (source.azimuth) * cosElevation;
+    const float rear = SpatialDsp::rearAmount (source.azimuth, cosElevation);
+    const float distance = juce::jlimit (SpatialDsp::nearFieldDistance, SpatialDsp::farDistance, source.distance);
+
+    // Beyond the reference distance the source arrives later; as it moves this delay glides
+    // through the delay lines, which is the Doppler shift.
+    const float propagation = juce::jmax (0.0f, distance - SpatialDsp::referenceDistance)
+                                * (float) sampleRate / SpatialDsp::speedOfSound;
+
+    // I delay the far ear only: positive pan puts the source on the right, so the left ear is far.
+    state.leftDelay  = propagation + juce::jmax (pan, 0.0f) * maxDelayUsed;
+    state.rightDelay = propagation + juce::jmax (-pan, 0.0f) * maxDelayUsed;
+
+    // I give each ear its own shadow coefficient; the near ear gets 0 (bypass) unless the
+    // source is behind, so the far-ear filter fades in and out smoothly as pan crosses the centre.
+    const auto shadowAlphaFor = [this, shadow] (float farAmount)
+    {
+        if (farAmount <= 0.0f)
+            return 0.0f;
+
+        const float cutoffHz = juce::jmap (1.0f - farAmount * shadow, 0.0f, 1.0f, SpatialDsp::minCutoffHz, SpatialDsp::maxCutoffHz);
+        return SpatialDsp::onePoleAlpha (cutoffHz, sampleRate);
+    };
 
-    int maxDelaySamplesUsed = (int) (sampleRate * maxDelayMs / 1000.0f * itd);
-    maxDelaySamplesUsed = juce::jmin (maxDelaySamplesUsed, maxDelaySamples);
+    const float rearShade = rear * SpatialDsp::rearShadow;
+    state.leftAlpha  = shadowAlphaFor (juce::jmax (pan, rearShade));
+    state.rightAlpha = shadowAlphaFor (juce::jmax (-pan, rearShade));
 
-    float pan = 0.0f;
+    state.leftGain  = std::cos ((pan + 1.0f) * juce::MathConstants<float>::halfPi * 0.5f);
+    state.rightGain = std::sin ((pan + 1.0f) * juce::MathConstants<float>::halfPi * 0.5f);
 
-    if (orbitMode == OrbitMode::Orbit)
+    if (widthVal < 1.0f)
+    {
+        const float mid = 0.5f * (state.leftGain + state.rightGain);
+        const float side = 0.5f * (state.rightGain - state.leftGain);
+        state.leftGain  = mid - side * widthVal;
+        state.rightGain = mid + side * widthVal;
+    }
+
+    // Near field: closer than the reference, the head shades the far ear more and the near
+    // ear gets louder, up to 6 dB each way at nearFieldDistance for a source at the side.
+    const float nearField = juce::jlimit (0.0f, 1.0f, (SpatialDsp::referenceDistance - distance)
+                                                      / (SpatialDsp::referenceDistance - SpatialDsp::nearFieldDistance));
+    const float boost = 1.0f + nearField * std::abs (pan);
+    const float distanceGain = juce::jmin (SpatialDsp::maxDistanceGain, SpatialDsp::referenceDistance / distance);
+    state.leftGain  *= distanceGain * (pan < 0.0f ? boost : 1.0f / boost);
+    state.rightGain *= distanceGain * (pan > 0.0f ? boost : 1.0f / boost);
+
+    // Air absorption grows with distance beyond the reference and adds to the depth setting.
+    const float air = juce::jlimit (0.0f, 1.0f, (distance - SpatialDsp::referenceDistance)
+                                                / (SpatialDsp::farDistance - SpatialDsp::referenceDistance));
+    const float depthAmount = 1.0f - (1.0f - depthVal) * (1.0f - air);
+
+    if (depthAmount > 0.0f)
     {
-        pan = (float) std::sin (lfoPhase);
+        const float depthCutoffHz = juce::jmap (depthAmount, 0.0f, 1.0f, SpatialDsp::nearDepthCutoffHz, SpatialDsp::farDepthCutoffHz);
+        state.depthAlpha = SpatialDsp::onePoleAlpha (depthCutoffHz, sampleRate);
+        state.depthMix = depthAmount;
     }
-    else if (orbitMode == OrbitMode::Figure8)
+
+    return state;
+}
+
+//==============================================================================
+const Spatializer::SubBlockKernel Spatializer::subBlockKernels[8] =
+{
+    &Spatializer::processSubBlock<false, false, false>,
+    &Spatializer::processSubBlock<false, false, true>,
+    &Spatializer::processSubBlock<false, true,  false>,
+    &Spatializer::processSubBlock<false, true,  true>,
+    &Spatializer::processSubBlock<true,  false, false>,
+    &Spatializer::processSubBlock<true,  false, true>,
+    &Spatializer::processSubBlock<true,  true,  false>,
+    &Spatializer::processSubBlock<true,  true,  true>
+};
+
+template <bool applyDepth, bool shadowLeft, bool shadowRight>
+void Spatializer::processSubBlock (float* left, float* right, int n,
+                                   const ControlState& start, const ControlState& target)
+{
+    alignas (16) float ramp[controlBlockSize];
+
+    // Stage 1: depth (distance) low-pass, cross-faded in by the ramped depth amount.
+    if constexpr (applyDepth)
     {
-        pan = (float) std::sin (2.0 * lfoPhase);
+        alignas (16) float mixRamp[controlBlockSize];
+        alignas (16) float filtered[controlBlockSize];
+        SpatialDsp::fillRamp (ramp, start.depthAlpha, target.depthAlpha, n);
+        SpatialDsp::fillRamp (mixRamp, start.depthMix, target.depthMix, n);
+
+        const auto depthStage = [&] (float* channel, float& state)
+        {
+            juce::FloatVectorOperations::copy (filtered, channel, n);
+            SpatialDsp::onePoleInPlace (filtered, ramp, state, n);
+            juce::FloatVectorOperations::subtract (filtered, channel, n);
+            juce::FloatVectorOperations::addWithMultiply (channel, filtered, mixRamp, n);
+        };
+
+        depthStage (left, depthLPF_L);
+        depthStage (right, depthLPF_R);
     }
     else
     {
-        pan = manualPan;
+        // With the filter bypassed its state follows the input, as it would with alpha = 0.
+        depthLPF_L = left[n - 1];
+        depthLPF_R = right[n - 1];
     }
 
-    if (orbitMode != OrbitMode::Manual)
+    // Stage 2: ITD. The delay glides with sub-sample precision between control points.
+    leftDelayLine.write (left, n);
+    rightDelayLine.write (right, n);
+    leftDelayLine.read (left, n, start.leftDelay, target.leftDelay);
+    rightDelayLine.read (right, n, start.rightDelay, target.rightDelay);
+
+    // Stage 3: ILD gains.
+    SpatialDsp::fillRamp (ramp, start.leftGain, target.leftGain, n);
+    juce::FloatVectorOperations::multiply (left, ramp, n);
+    SpatialDsp::fillRamp (ramp, start.rightGain, target.rightGain, n);
+    juce::FloatVectorOperations::multiply (right, ramp, n);
+
+    // Stage 4: head shadow on whichever ear is (or is becoming) the far one.
+    if constexpr (shadowLeft)
     {
-        const double phaseIncrement =
-            juce::MathConstants<double>::twoPi * (double) panSpeedHz / sampleRate;
-        lfoPhase += phaseIncrement * numSamples;
-        if (lfoPhase > juce::MathConstants<double>::twoPi)
-            lfoPhase -= juce::MathConstants<double>::twoPi;
+        SpatialDsp::fillRamp (ramp, start.leftAlpha, target.leftAlpha, n);
+        SpatialDsp::onePoleInPlace (left, ramp, leftLPF, n);
+    }
+    else
+    {
+        leftLPF = left[n - 1];
     }
 
-    const int leftDelaySamples  = pan > 0.0f ? (int) (pan * maxDelaySamplesUsed) : 0;
-    const int rightDelaySamples = pan < 0.0f ? (int) (-pan * maxDelaySamplesUsed) : 0;
+    if constexpr (shadowRight)
+    {
+        SpatialDsp::fillRamp (ramp, start.rightAlpha, target.rightAlpha, n);
+        SpatialDsp::onePoleInPlace (right, ramp, rightLPF, n);
+    }
+    else
+    {
+        rightLPF = right[n - 1];
+    }
+}
 
-    const float shadowAmount = std::abs (pan) * shadow;
-    const float cutoffHz = juce::jmap (1.0f - shadowAmount, 0.0f, 1.0f, minCutoffHz, maxCutoffHz);
-    const float alpha = std::exp (-2.0f * juce::MathConstants<float>::pi * cutoffHz / (float) sampleRate);
+//==============================================================================
+template <typename PositionAt>
+void Spatializer::processPath (juce::AudioBuffer<float>& buffer, int startSample, int numSamples,
+                               const Position& initial, PositionAt&& positionAt)
+{
+    const float itd = itdAmount;
+    const float shadow = shadowStrength;
+    const float depthVal = depth;
+    const float widthVal = width;
 
-    float leftGain  = std::cos ((pan + 1.0f) * juce::MathConstants<float>::halfPi * 0.5f);
-    float rightGain = std::sin ((pan + 1.0f) * juce::MathConstants<float>::halfPi * 0.5f);
+    const float maxDelayUsed = (float) (sampleRate * SpatialDsp::maxDelayMs / 1000.0f * itd);
 
-    if (widthVal < 1.0f)
+    if (controlNeedsReset)
     {
-        const float mid = 0.5f * (leftGain + rightGain);
-        const float side = 0.5f * (rightGain - leftGain);
-        leftGain  = mid - side * widthVal;
-        rightGain = mid + side * widthVal;
+        position = initial;
+        control = computeControlState (toHeadRelative (position, headMotion.start), maxDelayUsed, shadow, depthVal, widthVal);
+        controlNeedsReset = false;
     }
 
-    const float depthCutoffHz = depthVal > 0.0f
-        ? juce::jmap (depthVal, 0.0f, 1.0f, 18000.0f, 1500.0f)
-        : 18000.0f;
-    const float depthAlpha = depthVal > 0.0f
-        ? std::exp (-2.0f * juce::MathConstants<float>::pi * depthCutoffHz / (float) sampleRate)
-        : 0.0f;
-
     auto* left  = buffer.getWritePointer (0, startSample);
     auto* right = buffer.getWritePointer (1, startSample);
 
-    for (int i = 0; i < numSamples; ++i)
+    for (int offset = 0; offset < numSamples; offset += controlBlockSize)
     {
-        float inL = left[i];
-        float inR = right[i];
+        const int n = juce::jmin (controlBlockSize, numSamples - offset);
 
-        if (depthVal > 0.0f)
-        {
-            depthLPF_L = depthAlpha * depthLPF_L + (1.0f - depthAlpha) * inL;
-            depthLPF_R = depthAlpha * depthLPF_R + (1.0f - depthAlpha) * inR;
-            inL = juce::jmap (depthVal, 0.0f, 1.0f, inL, depthLPF_L);
-            inR = juce::jmap (depthVal, 0.0f, 1.0f, inR, depthLPF_R);
-        }
+        // I evaluate the trajectory, and where the head has turned, at the end of this
+        // sub-block and ramp towards it.
+        position = positionAt (n, offset + n);
+        const auto heard = toHeadRelative (position, headMotion.at ((offset + n) / sampleRate));
+        const auto target = computeControlState (heard, maxDelayUsed, shadow, depthVal, widthVal);
 
-        leftDelayBuffer[delayWriteIndex]  = inL;
-        rightDelayBuffer[delayWriteIndex] = inR;
+        // I pick the kernel for this sub-block once, so the per-sample loops never test
+        // whether depth or either ear's head shadow is active.
+        const bool applyDepth  = control.depthMix > 0.0f || target.depthMix > 0.0f;
+        const bool shadowLeft  = control.leftAlpha > 0.0f || target.leftAlpha > 0.0f;
+        const bool shadowRight = control.rightAlpha > 0.0f || target.rightAlpha > 0.0f;
+        const auto kernel = subBlockKernels[(applyDepth ? 4 : 0) + (shadowLeft ? 2 : 0) + (shadowRight ? 1 : 0)];
 
-        const int leftReadIndex  = (delayWriteIndex - leftDelaySamples + maxDelaySamples) % maxDelaySamples;
-        const int rightReadIndex = (delayWriteIndex - rightDelaySamples + maxDelaySamples) % maxDelaySamples;
+        (this->*kernel) (left + offset, right + offset, n, control, target);
 
-        float outL = leftDelayBuffer[leftReadIndex]  * leftGain;
-        float outR = rightDelayBuffer[rightReadIndex] * rightGain;
+        control = target;
+    }
+}
 
-        if (pan > 0.0f)
-        {
-            leftLPF = alpha * leftLPF + (1.0f - alpha) * outL;
-            outL = leftLPF;
-        }
-        else if (pan < 0.0f)
-        {
-            rightLPF = alpha * rightLPF + (1.0f - alpha) * outR;
-            outR = rightLPF;
-        }
+void Spatializer::process (juce::AudioBuffer<float>& buffer,
+                           int startSample,
+                           int numSamples,
+                           const Position& target)
+{
+    // I glide along the shorter way round in azimuth, and straight in elevation and distance.
+    const Position from = controlNeedsReset ? target : position;
+    const float azimuthTravel = std::remainder (target.azimuth - from.azimuth, juce::MathConstants<float>::twoPi);
+
+    processPath (buffer, startSample, numSamples, target, [&] (int, int end)
+    {
+        const float t = (float) end / (float) numSamples;
+        Position p;
+        p.azimuth = from.azimuth + azimuthTravel * t;
+        p.elevation = from.elevation + (target.elevation - from.elevation) * t;
+        p.distance = from.distance + (target.distance - from.distance) * t;
+        return p;
+    });
+}
 
-        left[i]  = outL;
-        right[i] = outR;
+void Spatializer::process (juce::AudioBuffer<float>& buffer,
+                           int startSample,
+                           int numSamples,
+                           const OrbitPath& path,
+                           float loopsPerSecond)
+{
+    const double phaseIncrement = juce::MathConstants<double>::twoPi * (double) loopsPerSecond / sampleRate;
 
-        delayWriteIndex = (delayWriteIndex + 1) % maxDelaySamples;
-    }
+    processPath (buffer, startSample, numSamples, path.getPosition (lfoPhase), [&] (int n, int)
+    {
+        lfoPhase += phaseIncrement * n;
+        if (lfoPhase > juce::MathConstants<double>::twoPi)
+            lfoPhase -= juce::MathConstants<double>::twoPi;
+
+        return path.getPosition (lfoPhase);
+    });
+}
+
+void Spatializer::process (juce::AudioBuffer<float>& buffer,
+                           int startSample,
+                           int numSamples,
+                           float manualPan,
+                           OrbitMode orbitMode,
+                           float panSpeedHz)
+{
+    jassert (orbitMode != OrbitMode::Path);
+
+    // Manual mode glides to where the pan puts the source, without a path table.
+    if (orbitMode == OrbitMode::Manual)
+        process (buffer, startSample, numSamples, getManualPosition (manualPan));
+    else
+        process (buffer, startSample, numSamples, OrbitPath::getBuiltIn (orbitMode), panSpeedHz);
 }
@@ -1,25 +1,61 @@
 #pragma once
 
 #include <JuceHeader.h>
+#include "FractionalDelayLine.h"
+#include "SpatialDsp.h"
+#include "HeadMotion.h"
+
+struct OrbitPath;
 
 //==============================================================================
-// I do binaural-style stereo spatialization: pan + ITD (interaural time difference)
-// + a head-shadow low-pass on the far ear. I support 3D/8D-style effects: depth
-// (HF rolloff for distance), width (stereo field scale), and multiple orbit modes.
-// I'm designed to run on the audio thread only with minimal latency.
+// I do binaural-style stereo spatialization of a source at a 3D position: ITD
+// (interaural time difference), ILD (level difference, stronger in the near field),
+// a head-shadow low-pass on the far ear and a milder one on both ears from behind,
+// distance gain, air absorption, and a propagation delay whose glide gives Doppler.
+// I also apply depth (extra HF rolloff for distance) and width (stereo field scale).
+// I'm designed to run on the audio thread only with minimal latency; my setters belong
+// to the same thread as process() (the OrbitEngine calls them between blocks).
 class Spatializer
 {
 public:
-    enum class OrbitMode { Manual, Orbit, Figure8 };
+    enum class OrbitMode { Manual, Orbit, Figure8, Path };
+
+    // Where the source is: azimuth in radians clockwise from straight ahead (pi/2 = right,
+    // pi = behind), elevation in radians up from ear level, and distance in metres from
+    // the centre of the head.
+    struct Position
+    {
+        float azimuth = 0.0f;
+        float elevation = 0.0f;
+        float distance = SpatialDsp::referenceDistance;
+    };
 
     Spatializer();
     ~Spatializer() = default;
 
-    // I reset my delay/LPF/LFO state when sample rate (or block size) changes.
+    // I reset my delay/LPF/LFO state when sample rate (or block size) changes, and size
+    // the delay lines for the full ITD and the farthest source at this rate.
     void prepareToPlay (int samplesPerBlockExpected, double sampleRate);
 
-    // I process a block of stereo audio in-place. If orbitMode != Manual I drive
-    // pan from an internal LFO at panSpeedHz; otherwise I use manualPan (-1 = left, +1 = right).
+    // I process a block of stereo audio in-place, with the source moving from where it
+    // was to target (reached on the last sample). I update gains, delays and filters every
+    // controlBlockSize samples and ramp between those control points per sample, so large
+    // buffers move as smoothly as small ones.
+    void process (juce::AudioBuffer<float>& buffer,
+                  int startSample,
+                  int numSamples,
+                  const Position& target);
+
+    // As above, with the source following a compiled path, loopsPerSecond times around it a
+    // second. I look the position up in the path's table once per sub-block.
+    void process (juce::AudioBuffer<float>& buffer,
+                  int startSample,
+                  int numSamples,
+                  const OrbitPath& path,
+                  float loopsPerSecond);
+
+    // As above, on a built-in mode's path at panSpeedHz. In Manual mode I place the source
+    // at manualPan (-1 = left, +1 = right). Path mode needs a path, so it isn't taken here.
     void process (juce::AudioBuffer<float>& buffer,
                   int startSample,
                   int numSamples,
@@ -43,28 +79,90 @@ public:
     void setWidth (float width);
     float getWidth() const { return width; }
 
-private:
-    static constexpr int maxDelaySamples = 64;
-    static constexpr float maxDelayMs = 0.5f;
-    static constexpr float minCutoffHz = 2000.0f;
-    static constexpr float maxCutoffHz = 18000.0f;
+    // How the listener's head moves over the next process() call, measured from its first
+    // sample. I place the source relative to the head at the end of every sub-block, so a
+    // turn of the head counter-rotates the scene. Still and facing ahead by default.
+    void setHeadMotion (const HeadMotion& motion)   { headMotion = motion; }
+
+    // Where the orbit has got to (radians), and where that put the source in the world.
+    double getOrbitPhase() const { return lfoPhase; }
+    const Position& getCurrentPosition() const { return position; }
+
+    // Each ear's gain and delay (in samples: ITD plus propagation), as the last sub-block
+    // left them. They're for display; read them from the thread that calls process().
+    struct Cues
+    {
+        float leftGain = 1.0f, rightGain = 1.0f;
+        float leftDelay = 0.0f, rightDelay = 0.0f;
+    };
+
+    Cues getCurrentCues() const { return { control.leftGain, control.rightGain, control.leftDelay, control.rightDelay }; }
 
+    // Where Manual mode's pan puts the source: on the front half at ear level and the
+    // reference distance (-1 = hard left, +1 = hard right). The moving modes' paths are
+    // OrbitTrajectory shapes: Orbit circles the head at ear level, passing behind it;
+    // Figure-8 loops left and right in front of and behind the head, rising over it between
+    // the loops, and comes closer and goes farther as it does.
+    static Position getManualPosition (float manualPan);
+
+    // Where a source in the world is relative to a head pointing at orientation.
+    static Position toHeadRelative (const Position& source, const HeadOrientation& orientation);
+
+    // Number of samples between control-rate updates of pan, gains, delay and filter coefficients.
+    static constexpr int controlBlockSize = 32;
+
+private:
     double sampleRate = 44100.0;
     double lfoPhase = 0.0;
 
-    // I use short delay lines for ITD: delay the “far” ear so the sound feels off to one side.
-    float leftDelayBuffer[maxDelaySamples] = {};
-    float rightDelayBuffer[maxDelaySamples] = {};
-    int delayWriteIndex = 0;
+    // I hold everything that depends on pan/depth at one control point. I interpolate
+    // linearly from the previous control point to the next one across each sub-block.
+    struct ControlState
+    {
+        float leftGain = 1.0f, rightGain = 1.0f;
+        float leftDelay = 0.0f, rightDelay = 0.0f;     // in samples
+        float leftAlpha = 0.0f, rightAlpha = 0.0f;     // head-shadow one-pole coefficients (0 = bypass)
+        float depthAlpha = 0.0f, depthMix = 0.0f;      // distance one-pole coefficient and wet amount
+    };
+
+    ControlState computeControlState (const Position& source, float maxDelayUsed, float shadow,
+                                      float depthVal, float widthVal) const;
+
+    // I run the sub-block loop, asking positionAt (numSamples, endOffset) where the source
+    // is at the end of each sub-block.
+    template <typename PositionAt>
+    void processPath (juce::AudioBuffer<float>& buffer, int startSample, int numSamples,
+                      const Position& initial, PositionAt&& positionAt);
+
+    Position position;
+    HeadMotion headMotion;
+    ControlState control;
+    bool controlNeedsReset = true;
+
+    // I process one sub-block through the stages depth filter -> ITD delay -> ILD gain ->
+    // head shadow, each stage over the whole sub-block. The template flags drop the stages
+    // that are inactive for this sub-block so the loops stay branch-free.
+    template <bool applyDepth, bool shadowLeft, bool shadowRight>
+    void processSubBlock (float* left, float* right, int numSamples,
+                          const ControlState& start, const ControlState& target);
+
+    using SubBlockKernel = void (Spatializer::*) (float*, float*, int, const ControlState&, const ControlState&);
+    static const SubBlockKernel subBlockKernels[8];
+
+    // I use fractional delay lines for ITD (delay the “far” ear so the sound feels off to one
+    // side) plus the propagation delay, sized in prepareToPlay() for the farthest source.
+    FractionalDelayLine leftDelayLine;
+    FractionalDelayLine rightDelayLine;
+    static_assert (controlBlockSize <= FractionalDelayLine::maxBlockSize, "sub-blocks must fit the delay line");
 
     // I use one-pole LPFs on the far ear to mimic head shadow.
     float leftLPF = 0.0f;
     float rightLPF = 0.0f;
 
-    std::atomic<float> itdAmount { 1.0f };
-    std::atomic<float> shadowStrength { 1.0f };
-    std::atomic<float> depth { 0.0f };
-    std::atomic<float> width { 1.0f };
+    float itdAmount = 1.0f;
+    float shadowStrength = 1.0f;
+    float depth = 0.0f;
+    float width = 1.0f;
 
     // One-pole LPFs for depth (distance) HF rolloff.
     float depthLPF_L = 0.0f;
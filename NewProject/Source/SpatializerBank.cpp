@@ -0,0 +1,350 @@
+#include "SpatializerBank.h"
+#include "SpatialDsp.h"
+#include "OrbitTrajectory.h"
+
+//==============================================================================
+SpatializerBank::SpatializerBank() = default;
+
+//==============================================================================
+void SpatializerBank::prepareToPlay (int /*samplesPerBlockExpected*/, double sampleRateIn)
+{
+    sampleRate = sampleRateIn;
+    lfoPhase = 0.0;
+    controlledSources = 0;
+    OrbitPath::getBuiltIn (Spatializer::OrbitMode::Orbit);   // compiled now, not on the first callback
+
+    for (int s = 0; s < maxSources; ++s)
+    {
+        leftDelayLines[s].prepare (SpatialDsp::maxItdSamples (sampleRate));
+        rightDelayLines[s].prepare (SpatialDsp::maxItdSamples (sampleRate));
+    }
+
+    std::fill (std::begin (depthLPF_L), std::end (depthLPF_L), 0.0f);
+    std::fill (std::begin (depthLPF_R), std::end (depthLPF_R), 0.0f);
+    std::fill (std::begin (shadowLPF_L), std::end (shadowLPF_L), 0.0f);
+    std::fill (std::begin (shadowLPF_R), std::end (shadowLPF_R), 0.0f);
+}
+
+int SpatializerBank::getNumSources (int numInputChannels, SourceLayout layout)
+{
+    const int sources = layout == SourceLayout::StereoPairs ? (numInputChannels + 1) / 2
+                                                            : numInputChannels;
+    return juce::jlimit (0, maxSources, sources);
+}
+
+float SpatializerBank::getMixGain (int numSources) noexcept
+{
+    return 1.0f / std::sqrt ((float) juce::jmax (1, numSources));
+}
+
+//==============================================================================
+void SpatializerBank::setItdAmount (float amount)
+{
+    itdAmount = juce::jlimit (0.0f, 1.0f, amount);
+}
+
+void SpatializerBank::setShadowStrength (float strength)
+{
+    shadowStrength = juce::jlimit (0.0f, 1.0f, strength);
+}
+
+void SpatializerBank::setDepth (float d)
+{
+    depth = juce::jlimit (0.0f, 1.0f, d);
+}
+
+void SpatializerBank::setWidth (float w)
+{
+    width = juce::jlimit (0.0f, 1.0f, w);
+}
+
+//==============================================================================
+void SpatializerBank::computeControlArrays (ControlArrays& dest,
+                                            int numSources,
+                                            float modeAngle,
+                                            float maxDelayUsed,
+                                            float shadow,
+                                            float widthVal) const
+{
+    // One pass over the per-source arrays, SpatialDsp::numControlLanes sources at a time,
+    // with polynomial stand-ins for sin and exp so nothing leaves the registers. The
+    // arrays hold maxSources, so the last group may run past numSources harmlessly.
+    using Lanes = SpatialDsp::ControlLanes;
+    constexpr int lanes = SpatialDsp::numControlLanes;
+    static_assert (maxSources % lanes == 0, "whole lane groups");
+
+    alignas (sizeof (Lanes)) static constexpr float sourceIndex[maxSources] =
+        {  0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14, 15,
+          16, 17, 18, 19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29, 30, 31 };
+    static_assert (maxSources == 32, "one index per source");
+
+    const float pi = juce::MathConstants<float>::pi;
+    const float spread = juce::MathConstants<float>::twoPi / (float) numSources;
+    const float firstAngle = std::remainder (modeAngle, juce::MathConstants<float>::twoPi);
+
+    // The shadow's alpha is exp (alphaScale * cutoff), with the cutoff falling from
+    // maxCutoffHz as the ear gets farther: exp (alphaAtFront + alphaPerFar * far).
+    const float alphaScale = -2.0f * pi / (float) sampleRate;
+    const float alphaAtFront = alphaScale * SpatialDsp::maxCutoffHz;
+    const float alphaPerFar = -alphaScale * shadow * (SpatialDsp::maxCutoffHz - SpatialDsp::minCutoffHz);
+    const int squarings = SpatialDsp::expSquarings (-alphaAtFront);
+
+    for (int s = 0; s < numSources; s += lanes)
+    {
+        // Every angle lies between -pi and 3pi here; wrapped, its sine is the pan and its
+        // cosine (the sine a quarter turn on) says how far behind the head it is.
+        const auto angle = SpatialDsp::wrapAngle (SpatialDsp::loadLanes (sourceIndex + s) * spread + firstAngle);
+        const auto pan = SpatialDsp::sinApprox (angle);
+        const auto behind = Lanes (0.0f) - SpatialDsp::sinApprox (angle + 0.5f * pi);
+        const auto rearShade = SpatialDsp::laneKeepAbove (behind, behind, 1.0e-4f) * SpatialDsp::rearShadow;
+
+        // Constant-power gains, narrowed towards the middle by width.
+        const auto gainAngle = (pan + 1.0f) * (0.25f * pi);
+        const auto l = SpatialDsp::sinApprox (Lanes (0.5f * pi) - gainAngle);
+        const auto r = SpatialDsp::sinApprox (gainAngle);
+        const auto mid = (l + r) * 0.5f;
+        const auto side = (r - l) * (0.5f * widthVal);
+        SpatialDsp::storeLanes (mid - side, dest.leftGain + s);
+        SpatialDsp::storeLanes (mid + side, dest.rightGain + s);
+
+        const auto right = SpatialDsp::laneMax (pan, Lanes (0.0f));
+        const auto left = SpatialDsp::laneMax (Lanes (0.0f) - pan, Lanes (0.0f));
+        SpatialDsp::storeLanes (right * maxDelayUsed, dest.leftDelay + s);
+        SpatialDsp::storeLanes (left * maxDelayUsed, dest.rightDelay + s);
+
+        // The far ear's shadow, or both ears' milder one for a source behind the head; an
+        // ear with neither is bypassed (alpha 0).
+        const auto farL = SpatialDsp::laneMax (right, rearShade);
+        const auto farR = SpatialDsp::laneMax (left, rearShade);
+        const auto alphaL = SpatialDsp::expApprox (farL * alphaPerFar + alphaAtFront, squarings);
+        const auto alphaR = SpatialDsp::expApprox (farR * alphaPerFar + alphaAtFront, squarings);
+        SpatialDsp::storeLanes (SpatialDsp::laneKeepAbove (alphaL, farL, 0.0f), dest.leftAlpha + s);
+        SpatialDsp::storeLanes (SpatialDsp::laneKeepAbove (alphaR, farR, 0.0f), dest.rightAlpha + s);
+    }
+}
+
+//==============================================================================
+void SpatializerBank::processSource (int s, const float* inL, const float* inR, int n,
+                                     float* mixL, float* mixR,
+                                     float depthAlphaStart, float depthAlphaEnd,
+                                     float depthMixStart, float depthMixEnd)
+{
+    alignas (16) float earL[controlBlockSize];
+    alignas (16) float earR[controlBlockSize];
+    alignas (16) float ramp[controlBlockSize];
+
+    juce::FloatVectorOperations::copy (earL, inL, n);
+    juce::FloatVectorOperations::copy (earR, inR, n);
+
+    // Depth (distance) low-pass, cross-faded in by the ramped depth amount.
+    if (depthMixStart > 0.0f || depthMixEnd > 0.0f)
+    {
+        alignas (16) float mixRamp[controlBlockSize];
+        alignas (16) float filtered[controlBlockSize];
+        SpatialDsp::fillRamp (ramp, depthAlphaStart, depthAlphaEnd, n);
+        SpatialDsp::fillRamp (mixRamp, depthMixStart, depthMixEnd, n);
+
+        const auto depthStage = [&] (float* channel, float& state)
+        {
+            juce::FloatVectorOperations::copy (filtered, channel, n);
+            SpatialDsp::onePoleInPlace (filtered, ramp, state, n);
+            juce::FloatVectorOperations::subtract (filtered, channel, n);
+            juce::FloatVectorOperations::addWithMultiply (channel, filtered, mixRamp, n);
+        };
+
+        depthStage (earL, depthLPF_L[s]);
+        depthStage (earR, depthLPF_R[s]);
+    }
+    else
+    {
+        depthLPF_L[s] = earL[n - 1];
+        depthLPF_R[s] = earR[n - 1];
+    }
+
+    leftDelayLines[s].write (earL, n);
+    rightDelayLines[s].write (earR, n);
+    leftDelayLines[s].read (earL, n, control.leftDelay[s], target.leftDelay[s]);
+    rightDelayLines[s].read (earR, n, control.rightDelay[s], target.rightDelay[s]);
+
+    SpatialDsp::fillRamp (ramp, control.leftGain[s], target.leftGain[s], n);
+    juce::FloatVectorOperations::multiply (earL, ramp, n);
+    SpatialDsp::fillRamp (ramp, control.rightGain[s], target.rightGain[s], n);
+    juce::FloatVectorOperations::multiply (earR, ramp, n);
+
+    if (control.leftAlpha[s] > 0.0f || target.leftAlpha[s] > 0.0f)
+    {
+        SpatialDsp::fillRamp (ramp, control.leftAlpha[s], target.leftAlpha[s], n);
+        SpatialDsp::onePoleInPlace (earL, ramp, shadowLPF_L[s], n);
+    }
+    else
+    {
+        shadowLPF_L[s] = earL[n - 1];
+    }
+
+    if (control.rightAlpha[s] > 0.0f || target.rightAlpha[s] > 0.0f)
+    {
+        SpatialDsp::fillRamp (ramp, control.rightAlpha[s], target.rightAlpha[s], n);
+        SpatialDsp::onePoleInPlace (earR, ramp, shadowLPF_R[s], n);
+    }
+    else
+    {
+        shadowLPF_R[s] = earR[n - 1];
+    }
+
+    juce::FloatVectorOperations::add (mixL, earL, n);
+    juce::FloatVectorOperations::add (mixR, earR, n);
+}
+
+//==============================================================================
+void SpatializerBank::process (juce::AudioBuffer<float>& buffer,
+                               int startSample,
+                               int numSamples,
+                               int numInputChannels,
+                               SourceLayout layout,
+                               const OrbitPath& path,
+                               float loopsPerSecond)
+{
+    jassert (buffer.getNumChannels() >= 2);
+    numInputChannels = juce::jmin (numInputChannels, buffer.getNumChannels(), 2 * maxSources);
+
+    const float* inputs[2 * maxSources];
+    for (int ch = 0; ch < numInputChannels; ++ch)
+        inputs[ch] = buffer.getReadPointer (ch, startSample);
+
+    process (inputs, numInputChannels, buffer.getWritePointer (0, startSample), buffer.getWritePointer (1, startSample),
+             numSamples, layout, path, loopsPerSecond);
+}
+
+void SpatializerBank::process (const float* const* inputs,
+                               int numInputChannels,
+                               float* outLeft,
+                               float* outRight,
+                               int numSamples,
+                               SourceLayout layout,
+                               const OrbitPath& path,
+                               float loopsPerSecond)
+{
+    const int numSources = getNumSources (numInputChannels, layout);
+
+    if (numSources == 0)
+        return;
+
+    const float itd = itdAmount;
+    const float shadow = shadowStrength;
+    const float depthVal = depth;
+    const float widthVal = width;
+
+    const float maxDelayUsed = (float) (sampleRate * SpatialDsp::maxDelayMs / 1000.0f * itd);
+
+    const double phaseIncrement = juce::MathConstants<double>::twoPi * (double) loopsPerSecond / sampleRate;
+
+    const float mixGainTarget = getMixGain (numSources);
+
+    const float depthAlphaTarget = depthVal > 0.0f
+        ? SpatialDsp::onePoleAlpha (juce::jmap (depthVal, 0.0f, 1.0f, SpatialDsp::nearDepthCutoffHz,
+                                                SpatialDsp::farDepthCutoffHz), sampleRate)
+        : 0.0f;
+
+    // Sources that just became active start at their current position instead of ramping
+    // in from stale values, with fresh delay and filter state.
+    if (numSources > controlledSources)
+    {
+        if (controlledSources == 0)
+        {
+            depthAlpha = depthAlphaTarget;
+            depthMix = depthVal;
+            mixGain = mixGainTarget;
+        }
+
+        computeControlArrays (target, numSources, path.getPosition (lfoPhase).azimuth - headMotion.start.yaw,
+                              maxDelayUsed, shadow, widthVal);
+
+        for (int s = controlledSources; s < numSources; ++s)
+        {
+            control.leftGain[s]   = target.leftGain[s];
+            control.rightGain[s]  = target.rightGain[s];
+            control.leftDelay[s]  = target.leftDelay[s];
+            control.rightDelay[s] = target.rightDelay[s];
+            control.leftAlpha[s]  = target.leftAlpha[s];
+            control.rightAlpha[s] = target.rightAlpha[s];
+            leftDelayLines[s].reset();
+            rightDelayLines[s].reset();
+            depthLPF_L[s] = depthLPF_R[s] = shadowLPF_L[s] = shadowLPF_R[s] = 0.0f;
+        }
+    }
+
+    controlledSources = numSources;
+
+    const int sourceStride = layout == SourceLayout::StereoPairs ? 2 : 1;
+
+    for (int offset = 0; offset < numSamples; offset += controlBlockSize)
+    {
+        const int n = juce::jmin (controlBlockSize, numSamples - offset);
+
+        lfoPhase += phaseIncrement * n;
+        if (lfoPhase > juce::MathConstants<double>::twoPi)
+            lfoPhase -= juce::MathConstants<double>::twoPi;
+
+        const float headYaw = headMotion.at ((offset + n) / sampleRate).yaw;
+        computeControlArrays (target, numSources, path.getPosition (lfoPhase).azimuth - headYaw,
+                              maxDelayUsed, shadow, widthVal);
+
+        alignas (16) float mixL[controlBlockSize];
+        alignas (16) float mixR[controlBlockSize];
+        juce::FloatVectorOperations::clear (mixL, n);
+        juce::FloatVectorOperations::clear (mixR, n);
+
+        for (int s = 0; s < numSources; ++s)
+        {
+            // A trailing odd channel in pair layout is treated as a mono source.
+            const int chL = s * sourceStride;
+            const int chR = juce::jmin (chL + sourceStride - 1, numInputChannels - 1);
+
+            processSource (s, inputs[chL] + offset, inputs[chR] + offset, n, mixL, mixR,
+                           depthAlpha, depthAlphaTarget, depthMix, depthVal);
+        }
+
+        // Every source has consumed this sub-block of input, so I can overwrite it with the
+        // mix, ramping the gain when sources come or go.
+        if (mixGain == mixGainTarget)
+        {
+            juce::FloatVectorOperations::multiply (outLeft + offset, mixL, mixGain, n);
+            juce::FloatVectorOperations::multiply (outRight + offset, mixR, mixGain, n);
+        }
+        else
+        {
+            alignas (16) float gainRamp[controlBlockSize];
+            SpatialDsp::fillRamp (gainRamp, mixGain, mixGainTarget, n);
+            juce::FloatVectorOperations::multiply (outLeft + offset, mixL, gainRamp, n);
+            juce::FloatVectorOperations::multiply (outRight + offset, mixR, gainRamp, n);
+        }
+
+        control = target;
+        depthAlpha = depthAlphaTarget;
+        depthMix = depthVal;
+        mixGain = mixGainTarget;
+    }
+}
+
+void SpatializerBank::process (juce::AudioBuffer<float>& buffer,
+                               int startSample,
+                               int numSamples,
+                               int numInputChannels,
+                               SourceLayout layout,
+                               float manualPan,
+                               Spatializer::OrbitMode orbitMode,
+                               float panSpeedHz)
+{
+    jassert (orbitMode != Spatializer::OrbitMode::Path);
+
+    if (orbitMode == Spatializer::OrbitMode::Manual)
+    {
+        if (manualPan != manualPathPan)
+            manualPath.placeAt (Spatializer::getManualPosition (manualPathPan = manualPan));
+
+        process (buffer, startSample, numSamples, numInputChannels, layout, manualPath, 0.0f);
+    }
+    else
+        process (buffer, startSample, numSamples, numInputChannels, layout,
+                 OrbitPath::getBuiltIn (orbitMode), panSpeedHz);
+}
@@ -0,0 +1,151 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "FractionalDelayLine.h"
+#include "SpatialDsp.h"
+#include "Spatializer.h"
+#include "OrbitTrajectory.h"
+
+//==============================================================================
+// I spatialize many sources at once and mix them down to binaural stereo. Each input
+// channel (or each stereo pair of channels) is one source with its own place on the
+// orbit: I spread the sources evenly around the circle, with source 0 at the path's
+// azimuth, so on a moving path they chase each other and in Manual the pan knob rotates
+// the whole ring. The ring stays at ear level and the reference distance, so sources get
+// the Spatializer's ITD, ILD and head and rear shadow, but not its distance cues.
+//
+// I keep per-source parameters and filter state in struct-of-arrays form, so the
+// control-rate update is one SIMD pass across all sources, and I accumulate every source
+// straight into a single stereo sub-block mix instead of giving each one a buffer.
+// The mix is scaled by getMixGain(), so a full bank of uncorrelated sources comes out
+// at about the level of one instead of up to 15 dB hotter.
+// I'm designed to run on the audio thread only and never allocate.
+class SpatializerBank
+{
+public:
+    static constexpr int maxSources = 32;
+    static constexpr int controlBlockSize = Spatializer::controlBlockSize;
+
+    enum class SourceLayout { StereoPairs, MonoChannels };
+
+    // I return the gain applied to the mix of numSources sources: 1 / sqrt (numSources),
+    // which keeps the power of uncorrelated sources constant. One source is left as is.
+    static float getMixGain (int numSources) noexcept;
+
+    SpatializerBank();
+    ~SpatializerBank() = default;
+
+    // I reset all per-source delay/filter state and the shared orbit phase, and size every
+    // delay line for the full ITD at this rate.
+    void prepareToPlay (int samplesPerBlockExpected, double sampleRate);
+
+    // I read numInputChannels input channels from buffer and replace channels 0 and 1
+    // with the binaural mix of all sources. Channels beyond maxSources are ignored.
+    // Source 0 follows path's azimuth, loopsPerSecond times around it a second.
+    void process (juce::AudioBuffer<float>& buffer,
+                  int startSample,
+                  int numSamples,
+                  int numInputChannels,
+                  SourceLayout layout,
+                  const OrbitPath& path,
+                  float loopsPerSecond);
+
+    // As above, reading numInputChannels separate input buffers and writing the mix to
+    // outLeft and outRight, for hosts that hand out one buffer per channel (JACK ports),
+    // so nothing is copied into an AudioBuffer first. An output may be one of the inputs.
+    void process (const float* const* inputs,
+                  int numInputChannels,
+                  float* outLeft,
+                  float* outRight,
+                  int numSamples,
+                  SourceLayout layout,
+                  const OrbitPath& path,
+                  float loopsPerSecond);
+
+    // As above, on a built-in mode's path at panSpeedHz, or placed at manualPan in Manual.
+    void process (juce::AudioBuffer<float>& buffer,
+                  int startSample,
+                  int numSamples,
+                  int numInputChannels,
+                  SourceLayout layout,
+                  float manualPan,
+                  Spatializer::OrbitMode orbitMode,
+                  float panSpeedHz);
+
+    // I return how many sources a given channel count produces in a layout.
+    static int getNumSources (int numInputChannels, SourceLayout layout);
+
+    // Shared head-model controls, with the same ranges as the Spatializer's. Like the
+    // Spatializer's, they're set from the thread that calls process().
+    void setItdAmount (float amount);
+    void setShadowStrength (float strength);
+    void setDepth (float depth);
+    void setWidth (float width);
+
+    // As Spatializer::setHeadMotion(). The ring stays at ear level, so I only follow the
+    // head's yaw: turning the head turns the whole ring the other way.
+    void setHeadMotion (const HeadMotion& motion)   { headMotion = motion; }
+
+    // Where the orbit has got to (radians), as Spatializer::getOrbitPhase(). Source 0 sits
+    // at the path's azimuth there.
+    double getOrbitPhase() const { return lfoPhase; }
+
+    // A source's gains and delays as the last sub-block left them, as
+    // Spatializer::getCurrentCues().
+    Spatializer::Cues getCurrentCues (int source) const
+    {
+        return { control.leftGain[source], control.rightGain[source], control.leftDelay[source], control.rightDelay[source] };
+    }
+
+private:
+    static_assert (controlBlockSize <= FractionalDelayLine::maxBlockSize, "sub-blocks must fit the delay line");
+
+    // One control point for every source, stored field by field (and aligned for SIMD
+    // loads) so the update runs a register of sources at a time.
+    struct ControlArrays
+    {
+        alignas (sizeof (SpatialDsp::ControlLanes)) float leftGain[maxSources] = {};
+        alignas (sizeof (SpatialDsp::ControlLanes)) float rightGain[maxSources] = {};
+        alignas (sizeof (SpatialDsp::ControlLanes)) float leftDelay[maxSources] = {};
+        alignas (sizeof (SpatialDsp::ControlLanes)) float rightDelay[maxSources] = {};
+        alignas (sizeof (SpatialDsp::ControlLanes)) float leftAlpha[maxSources] = {};
+        alignas (sizeof (SpatialDsp::ControlLanes)) float rightAlpha[maxSources] = {};
+    };
+
+    void computeControlArrays (ControlArrays& dest, int numSources, float modeAngle,
+                               float maxDelayUsed, float shadow, float widthVal) const;
+
+    void processSource (int source, const float* inL, const float* inR, int numSamples,
+                        float* mixL, float* mixR, float depthAlphaStart, float depthAlphaEnd,
+                        float depthMixStart, float depthMixEnd);
+
+    double sampleRate = 44100.0;
+    double lfoPhase = 0.0;
+    HeadMotion headMotion;
+
+    // Manual mode's still path, moved only when the pan does.
+    OrbitPath manualPath = OrbitPath::still (Spatializer::getManualPosition (0.0f));
+    float manualPathPan = 0.0f;
+
+    ControlArrays control;   // the last control point reached
+    ControlArrays target;    // the control point the current sub-block ramps towards
+    float depthAlpha = 0.0f, depthMix = 0.0f;
+    float mixGain = 1.0f;   // the mix gain the last sub-block ended on
+    int controlledSources = 0;   // sources whose control point is valid; others snap on first use
+
+    // Per-source filter state, one array per ear.
+    float depthLPF_L[maxSources] = {};
+    float depthLPF_R[maxSources] = {};
+    float shadowLPF_L[maxSources] = {};
+    float shadowLPF_R[maxSources] = {};
+
+    FractionalDelayLine leftDelayLines[maxSources];
+    FractionalDelayLine rightDelayLines[maxSources];
+
+    float itdAmount = 1.0f;
+    float shadowStrength = 1.0f;
+    float depth = 0.0f;
+    float width = 1.0f;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SpatializerBank)
+};
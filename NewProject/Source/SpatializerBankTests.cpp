@@ -0,0 +1,228 @@
+#include <JuceHeader.h>
+#include "SpatializerBank.h"
+#include "OrbitTrajectory.h"
+
+//==============================================================================
+// I test the SpatializerBank: one stereo source must sound exactly like the single
+// Spatializer, sources in a ring must land on opposite sides of the head, the ITD
+// must reach its full length at every sample rate, separate port buffers (as JACK
+// hands them out) must sound exactly like the same channels in an AudioBuffer, the mix
+// must stay near one source's level as sources are added, and the polynomial sin and
+// exp behind the control update must track the real ones.
+class SpatializerBankTest : public juce::UnitTest
+{
+public:
+    SpatializerBankTest() : juce::UnitTest ("SpatializerBank", "Audio") {}
+
+    void runTest() override
+    {
+        const double sampleRate = 44100.0;
+        const int blockSize = 512;
+
+        beginTest ("one stereo source matches Spatializer");
+        {
+            // I orbit the same noise through both and expect the same output.
+            Spatializer single;
+            SpatializerBank bank;
+            single.prepareToPlay (blockSize, sampleRate);
+            bank.prepareToPlay (blockSize, sampleRate);
+            single.setDepth (0.3f);
+            bank.setDepth (0.3f);
+
+            juce::AudioBuffer<float> a (2, blockSize), b (2, blockSize);
+            juce::Random random (42);
+            float maxDifference = 0.0f;
+
+            for (int block = 0; block < 8; ++block)
+            {
+                for (int ch = 0; ch < 2; ++ch)
+                    for (int i = 0; i < blockSize; ++i)
+                        a.setSample (ch, i, random.nextFloat() * 2.0f - 1.0f);
+                b.makeCopyOf (a);
+
+                single.process (a, 0, blockSize, 0.0f, Spatializer::OrbitMode::Orbit, 0.5f);
+                bank.process (b, 0, blockSize, 2, SpatializerBank::SourceLayout::StereoPairs,
+                              0.0f, Spatializer::OrbitMode::Orbit, 0.5f);
+
+                for (int ch = 0; ch < 2; ++ch)
+                    for (int i = 0; i < blockSize; ++i)
+                        maxDifference = juce::jmax (maxDifference, std::abs (a.getSample (ch, i) - b.getSample (ch, i)));
+            }
+            expectLessThan (maxDifference, 1.0e-4f, "bank with one source should match Spatializer");
+        }
+
+        beginTest ("two stereo pairs: sources on opposite sides");
+        {
+            // Manual pan +1 puts source 0 full right and source 1 (opposite on the ring) full left.
+            // I feed only source 0 and expect the mix to be right dominant.
+            SpatializerBank bank;
+            bank.prepareToPlay (blockSize, sampleRate);
+            juce::AudioBuffer<float> buffer (4, blockSize);
+            buffer.clear();
+            for (int i = 0; i < blockSize; ++i)
+            {
+                buffer.setSample (0, i, 1.0f);
+                buffer.setSample (1, i, 1.0f);
+            }
+
+            bank.process (buffer, 0, blockSize, 4, SpatializerBank::SourceLayout::StereoPairs,
+                          1.0f, Spatializer::OrbitMode::Manual, 0.05f);
+
+            float sumL = 0.0f, sumR = 0.0f;
+            for (int i = 0; i < blockSize; ++i)
+            {
+                sumL += buffer.getSample (0, i);
+                sumR += buffer.getSample (1, i);
+            }
+            expectGreaterThan (sumR, sumL, "source 0 at pan=+1 should be right dominant");
+
+            // Now only source 1 (channels 2/3) plays: it sits at the opposite side.
+            buffer.clear();
+            for (int i = 0; i < blockSize; ++i)
+            {
+                buffer.setSample (2, i, 1.0f);
+                buffer.setSample (3, i, 1.0f);
+            }
+
+            bank.process (buffer, 0, blockSize, 4, SpatializerBank::SourceLayout::StereoPairs,
+                          1.0f, Spatializer::OrbitMode::Manual, 0.05f);
+
+            sumL = sumR = 0.0f;
+            for (int i = 0; i < blockSize; ++i)
+            {
+                sumL += buffer.getSample (0, i);
+                sumR += buffer.getSample (1, i);
+            }
+            expectGreaterThan (sumL, sumR, "source 1 opposite on the ring should be left dominant");
+        }
+
+        beginTest ("the full ITD at every sample rate");
+        {
+            // One mono source hard right: the left ear must lag by the whole 0.5 ms at any rate.
+            for (auto rate : { 44100.0, 48000.0, 88200.0, 96000.0, 176400.0, 192000.0 })
+            {
+                SpatializerBank bank;
+                bank.prepareToPlay (blockSize, rate);
+
+                juce::AudioBuffer<float> impulse (2, blockSize);
+                impulse.clear();
+                impulse.setSample (0, 0, 1.0f);
+                bank.process (impulse, 0, blockSize, 1, SpatializerBank::SourceLayout::MonoChannels,
+                              1.0f, Spatializer::OrbitMode::Manual, 0.05f);
+
+                const auto peakAt = [&impulse] (int channel)
+                {
+                    int peak = 0;
+                    for (int i = 1; i < impulse.getNumSamples(); ++i)
+                        if (std::abs (impulse.getSample (channel, i)) > std::abs (impulse.getSample (channel, peak)))
+                            peak = i;
+                    return peak;
+                };
+
+                expectWithinAbsoluteError ((float) (peakAt (0) - peakAt (1)), (float) (rate * SpatialDsp::maxDelayMs / 1000.0),
+                                           1.0f, "at " + juce::String (rate) + " Hz");
+            }
+        }
+
+        beginTest ("separate port buffers match an AudioBuffer");
+        {
+            const int numPorts = 5;
+            SpatializerBank fromBuffer, fromPorts;
+            fromBuffer.prepareToPlay (blockSize, sampleRate);
+            fromPorts.prepareToPlay (blockSize, sampleRate);
+
+            const auto path = OrbitPath::getBuiltIn (Spatializer::OrbitMode::Orbit);
+            juce::AudioBuffer<float> buffer (numPorts, blockSize);
+            std::vector<std::vector<float>> ports ((size_t) numPorts, std::vector<float> ((size_t) blockSize));
+            std::vector<float> left ((size_t) blockSize), right ((size_t) blockSize);
+            juce::Random random (7);
+            float maxDifference = 0.0f;
+
+            for (int block = 0; block < 8; ++block)
+            {
+                const float* inputs[numPorts];
+                for (int ch = 0; ch < numPorts; ++ch)
+                {
+                    for (int i = 0; i < blockSize; ++i)
+                        ports[(size_t) ch][(size_t) i] = random.nextFloat() * 2.0f - 1.0f;
+
+                    buffer.copyFrom (ch, 0, ports[(size_t) ch].data(), blockSize);
+                    inputs[ch] = ports[(size_t) ch].data();
+                }
+
+                fromBuffer.process (buffer, 0, blockSize, numPorts, SpatializerBank::SourceLayout::MonoChannels, path, 0.3f);
+                fromPorts.process (inputs, numPorts, left.data(), right.data(), blockSize,
+                                   SpatializerBank::SourceLayout::MonoChannels, path, 0.3f);
+
+                for (int i = 0; i < blockSize; ++i)
+                {
+                    maxDifference = juce::jmax (maxDifference, std::abs (buffer.getSample (0, i) - left[(size_t) i]));
+                    maxDifference = juce::jmax (maxDifference, std::abs (buffer.getSample (1, i) - right[(size_t) i]));
+                }
+            }
+
+            expectEquals (maxDifference, 0.0f);
+            expect (std::abs (left[(size_t) blockSize - 1]) > 0.0f, "the ports produced output");
+        }
+
+        beginTest ("the mix level stays put as uncorrelated sources are added");
+        {
+            const auto path = OrbitPath::getBuiltIn (Spatializer::OrbitMode::Orbit);
+
+            auto mixRms = [&] (int numSources)
+            {
+                SpatializerBank bank;
+                bank.prepareToPlay (blockSize, sampleRate);
+
+                juce::AudioBuffer<float> buffer (juce::jmax (2, numSources), blockSize);
+                juce::Random random (11);
+                double sumOfSquares = 0.0;
+                const int numBlocks = 64;
+
+                for (int block = 0; block < numBlocks; ++block)
+                {
+                    for (int ch = 0; ch < buffer.getNumChannels(); ++ch)
+                        for (int i = 0; i < blockSize; ++i)
+                            buffer.setSample (ch, i, random.nextFloat() * 2.0f - 1.0f);
+
+                    bank.process (buffer, 0, blockSize, numSources, SpatializerBank::SourceLayout::MonoChannels, path, 1.0f);
+
+                    for (int ch = 0; ch < 2; ++ch)
+                        for (int i = 0; i < blockSize; ++i)
+                            sumOfSquares += juce::square ((double) buffer.getSample (ch, i));
+                }
+
+                return std::sqrt (sumOfSquares / (2.0 * numBlocks * blockSize));
+            };
+
+            const double oneSource = mixRms (1);
+            for (int numSources : { 4, 16, SpatializerBank::maxSources })
+                expectWithinAbsoluteError (juce::Decibels::gainToDecibels (mixRms (numSources) / oneSource), 0.0, 2.0,
+                                           juce::String (numSources) + " sources");
+        }
+
+        beginTest ("control-rate approximations track std::sin and std::exp");
+        {
+            const float pi = juce::MathConstants<float>::pi;
+            float sinError = 0.0f, wrapError = 0.0f, expError = 0.0f;
+
+            for (float x = -1.5f * pi; x <= 1.5f * pi; x += 1.0e-3f)
+                sinError = juce::jmax (sinError, std::abs (SpatialDsp::sinApprox (x) - std::sin (x)));
+
+            for (float x = -pi; x < 3.0f * pi; x += 1.0e-3f)
+                wrapError = juce::jmax (wrapError, std::abs (std::sin (SpatialDsp::wrapAngle (x)) - std::sin (x)));
+
+            // The deepest exponent is the shadow's alpha at 8 kHz.
+            const float deepest = 2.0f * pi * SpatialDsp::maxCutoffHz / 8000.0f;
+            const int squarings = SpatialDsp::expSquarings (deepest);
+            for (float x = -deepest; x <= 0.0f; x += 1.0e-3f)
+                expError = juce::jmax (expError, std::abs (SpatialDsp::expApprox (x, squarings) / std::exp (x) - 1.0f));
+
+            expectLessThan (sinError, 1.0e-6f);
+            expectLessThan (wrapError, 1.0e-6f);
+            expectLessThan (expError, 3.0e-5f);
+        }
+    }
+};
+
+static SpatializerBankTest spatializerBankTest;
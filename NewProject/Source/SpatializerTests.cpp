@@ -3,12 +3,73 @@
 
 //==============================================================================
 // I test the Spatializer: at pan=0 I expect equal L/R; at pan=-1 left dominant;
-// at pan=+1 right dominant. I run when the user clicks "Run tests" (Audio category).
+// at pan=+1 right dominant; the ITD must reach its full 0.5 ms at every sample rate.
+// With 3D positions I expect front and back, elevation, distance, the near field and
+// Doppler to behave. I run when the user clicks "Run tests" (Audio category).
 class SpatializerTest : public juce::UnitTest
 {
 public:
     SpatializerTest() : juce::UnitTest ("Spatializer", "Audio") {}
 
+    static Spatializer::Position at (float azimuthDegrees, float elevationDegrees, float distance)
+    {
+        Spatializer::Position p;
+        p.azimuth = juce::degreesToRadians (azimuthDegrees);
+        p.elevation = juce::degreesToRadians (elevationDegrees);
+        p.distance = distance;
+        return p;
+    }
+
+    // I render the same seeded noise (or a sine at sineHz) from a source that moves from
+    // `from` to `to` over the whole buffer, in 256-sample blocks.
+    static juce::AudioBuffer<float> render (const Spatializer::Position& from, const Spatializer::Position& to,
+                                            int numSamples, double sampleRate, float sineHz = 0.0f)
+    {
+        Spatializer spatializer;
+        spatializer.prepareToPlay (256, sampleRate);
+
+        juce::AudioBuffer<float> buffer (2, numSamples);
+        juce::Random random (17);
+        for (int i = 0; i < numSamples; ++i)
+        {
+            const float x = sineHz > 0.0f ? std::sin (juce::MathConstants<float>::twoPi * sineHz * (float) i / (float) sampleRate)
+                                          : random.nextFloat() * 2.0f - 1.0f;
+            buffer.setSample (0, i, x);
+            buffer.setSample (1, i, x);
+        }
+
+        spatializer.process (buffer, 0, 0, from);
+        for (int start = 0; start < numSamples; start += 256)
+        {
+            const int n = juce::jmin (256, numSamples - start);
+            const float t = (float) (start + n) / (float) numSamples;
+            Spatializer::Position p;
+            p.azimuth = from.azimuth + (to.azimuth - from.azimuth) * t;
+            p.elevation = from.elevation + (to.elevation - from.elevation) * t;
+            p.distance = from.distance + (to.distance - from.distance) * t;
+            spatializer.process (buffer, start, n, p);
+        }
+        return buffer;
+    }
+
+    // I count rising zero crossings of channel 0 in [start, start + numSamples) and return the frequency.
+    static double measureFrequency (const juce::AudioBuffer<float>& buffer, int start, int numSamples, double sampleRate)
+    {
+        int first = -1, last = -1, crossings = 0;
+        for (int i = start + 1; i < start + numSamples; ++i)
+        {
+            if (buffer.getSample (0, i - 1) < 0.0f && buffer.getSample (0, i) >= 0.0f)
+            {
+                if (first < 0)
+                    first = i;
+                else
+                    ++crossings;
+                last = i;
+            }
+        }
+        return crossings > 0 ? crossings * sampleRate / (double) (last - first) : 0.0;
+    }
+
     void runTest() override
     {
         Spatializer spatializer;
@@ -83,6 +144,139 @@ public:
             sumR /= blockSize;
             expectGreaterThan (sumR, sumL, "at pan=+1 (full right) R should be greater than L");
         }
+
+        beginTest ("orbit: no zipper steps across large blocks");
+        {
+            // I run a fast orbit over two 4096-sample blocks of DC and expect the gain trajectory
+            // to move in small per-sample steps, including across the block boundary.
+            Spatializer orbiter;
+            const int largeBlock = 4096;
+            orbiter.prepareToPlay (largeBlock, sampleRate);
+            juce::AudioBuffer<float> large (2, largeBlock);
+
+            float previousL = 0.0f, maxStep = 0.0f;
+            for (int block = 0; block < 2; ++block)
+            {
+                for (int i = 0; i < largeBlock; ++i)
+                {
+                    large.setSample (0, i, 1.0f);
+                    large.setSample (1, i, 1.0f);
+                }
+                orbiter.process (large, 0, largeBlock, 0.0f, Spatializer::OrbitMode::Orbit, 0.5f);
+
+                // I skip the first few samples while the ITD line and shadow filter settle.
+                for (int i = 0; i < largeBlock; ++i)
+                {
+                    const float l = large.getSample (0, i);
+                    if (block > 0 || i > 64)
+                        maxStep = juce::jmax (maxStep, std::abs (l - previousL));
+                    previousL = l;
+                }
+            }
+            expectLessThan (maxStep, 0.01f, "orbit gain should change smoothly sample to sample");
+        }
+
+        beginTest ("3D: behind sounds duller than ahead, equally in both ears");
+        {
+            const int n = 8192;
+            const auto ahead = render (at (0, 0, 1), at (0, 0, 1), n, sampleRate);
+            const auto behind = render (at (180, 0, 1), at (180, 0, 1), n, sampleRate);
+
+            expectWithinAbsoluteError (behind.getRMSLevel (0, 0, n), behind.getRMSLevel (1, 0, n), 1.0e-3f);
+            expectLessThan (behind.getRMSLevel (0, 0, n), ahead.getRMSLevel (0, 0, n) * 0.9f);
+        }
+
+        beginTest ("3D: elevation narrows the level difference");
+        {
+            const int n = 8192;
+            const auto level = render (at (90, 0, 1), at (90, 0, 1), n, sampleRate);
+            const auto raised = render (at (90, 60, 1), at (90, 60, 1), n, sampleRate);
+
+            const auto ildDb = [n] (const juce::AudioBuffer<float>& b)
+            {
+                return juce::Decibels::gainToDecibels (b.getRMSLevel (1, 0, n) / b.getRMSLevel (0, 0, n));
+            };
+            expectGreaterThan (ildDb (raised), 1.0f);
+            expectLessThan (ildDb (raised), ildDb (level) - 3.0f);
+        }
+
+        beginTest ("the full ITD at every sample rate");
+        {
+            // 0.5 ms is 22 samples at 44.1 kHz and 96 at 192 kHz; none of it may be cut short.
+            for (auto rate : { 44100.0, 48000.0, 88200.0, 96000.0, 176400.0, 192000.0 })
+            {
+                Spatializer side;
+                side.prepareToPlay (blockSize, rate);
+
+                juce::AudioBuffer<float> impulse (2, blockSize);
+                impulse.clear();
+                side.process (impulse, 0, blockSize, at (90, 0, 1));
+
+                impulse.setSample (0, 0, 1.0f);
+                impulse.setSample (1, 0, 1.0f);
+                side.process (impulse, 0, blockSize, at (90, 0, 1));
+
+                const auto peakAt = [&impulse] (int channel)
+                {
+                    int peak = 0;
+                    for (int i = 1; i < impulse.getNumSamples(); ++i)
+                        if (std::abs (impulse.getSample (channel, i)) > std::abs (impulse.getSample (channel, peak)))
+                            peak = i;
+                    return peak;
+                };
+
+                expectWithinAbsoluteError ((float) (peakAt (0) - peakAt (1)), (float) (rate * SpatialDsp::maxDelayMs / 1000.0),
+                                           1.0f, "at " + juce::String (rate) + " Hz");
+            }
+        }
+
+        beginTest ("3D: a farther source is quieter and arrives later");
+        {
+            const int n = 8192;
+            const auto nearby = render (at (0, 0, 1), at (0, 0, 1), n, sampleRate, 100.0f);
+            const auto distant = render (at (0, 0, 4), at (0, 0, 4), n, sampleRate, 100.0f);
+
+            // Inverse distance, with air absorption barely touching 100 Hz.
+            const float ratioDb = juce::Decibels::gainToDecibels (distant.getRMSLevel (0, 2048, n - 2048)
+                                                                 / nearby.getRMSLevel (0, 2048, n - 2048));
+            expectWithinAbsoluteError (ratioDb, -12.04f, 0.5f);
+
+            const auto firstSound = [] (const juce::AudioBuffer<float>& b)
+            {
+                for (int i = 0; i < b.getNumSamples(); ++i)
+                    if (std::abs (b.getSample (0, i)) > 1.0e-6f)
+                        return i;
+                return -1;
+            };
+            const float expectedDelay = 3.0f / SpatialDsp::speedOfSound * (float) sampleRate;
+            expectWithinAbsoluteError ((float) (firstSound (distant) - firstSound (nearby)), expectedDelay, 2.0f);
+        }
+
+        beginTest ("3D: the near field widens the level difference");
+        {
+            const int n = 8192;
+            const auto reference = render (at (90, 0, 1), at (90, 0, 1), n, sampleRate);
+            const auto close = render (at (90, 0, 0.3f), at (90, 0, 0.3f), n, sampleRate);
+
+            const auto ildDb = [n] (const juce::AudioBuffer<float>& b)
+            {
+                return juce::Decibels::gainToDecibels (b.getRMSLevel (1, 0, n) / b.getRMSLevel (0, 0, n));
+            };
+            expectGreaterThan (ildDb (close), ildDb (reference) + 6.0f);
+        }
+
+        beginTest ("3D: Doppler follows the change in distance");
+        {
+            // 1 kHz from 10 m to 1 m over a second approaches at 9 m/s: c / (c - v) higher. Receding lowers it.
+            const int n = (int) sampleRate;
+            const double ratio = SpatialDsp::speedOfSound / (SpatialDsp::speedOfSound - 9.0);
+            const auto approaching = render (at (0, 0, 10), at (0, 0, 1), n, sampleRate, 1000.0f);
+            const auto receding = render (at (0, 0, 1), at (0, 0, 10), n, sampleRate, 1000.0f);
+
+            expectWithinAbsoluteError (measureFrequency (approaching, n / 4, n / 2, sampleRate), 1000.0 * ratio, 3.0);
+            expectWithinAbsoluteError (measureFrequency (receding, n / 4, n / 2, sampleRate),
+                                       1000.0 * SpatialDsp::speedOfSound / (SpatialDsp::speedOfSound + 9.0), 3.0);
+        }
     }
 };
 
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+// I hand a whole value from one writer thread to one reader thread without locks
+// or waiting on either side. There are three slots: the writer fills its back slot
+// and swaps it into the middle; the reader swaps the middle out to its front slot
+// when something new is there. Neither ever touches the other's slot, so the reader
+// always sees a complete value, never half of one write and half of the next.
+//
+// T is copied whole, so keep it small and trivially copyable (a struct of numbers).
+template <typename T>
+class TripleBuffer
+{
+public:
+    static_assert (std::is_trivially_copyable_v<T>, "values are copied between threads as plain bytes");
+
+    explicit TripleBuffer (const T& initialValue = {})
+    {
+        slots.fill (initialValue);
+    }
+
+    // Writer thread only: I publish value, replacing anything the reader hasn't picked up.
+    void write (const T& value) noexcept
+    {
+        slots[(size_t) backIndex] = value;
+        backIndex = middle.exchange (backIndex | newFlag, std::memory_order_acq_rel) & indexMask;
+    }
+
+    // Reader thread only: I pick up the latest published value, if there is one, and
+    // return the value the reader now holds.
+    const T& read() noexcept
+    {
+        if ((middle.load (std::memory_order_relaxed) & newFlag) != 0)
+            frontIndex = middle.exchange (frontIndex, std::memory_order_acq_rel) & indexMask;
+
+        return slots[(size_t) frontIndex];
+    }
+
+private:
+    static constexpr int indexMask = 3;
+    static constexpr int newFlag = 4;
+
+    std::array<T, 3> slots;
+    int backIndex = 0;              // writer's slot
+    std::atomic<int> middle { 1 };  // the slot in between, with newFlag when it's unread
+    int frontIndex = 2;             // reader's slot
+
+    JUCE_DECLARE_NON_COPYABLE (TripleBuffer)
+};
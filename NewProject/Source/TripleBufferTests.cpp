@@ -0,0 +1,171 @@
+#include <JuceHeader.h>
+#include "TripleBuffer.h"
+#include "OrbitEngine.h"
+
+//==============================================================================
+// I test the parameter transport: the reader must always get the latest whole value,
+// never a torn one, even with a writer thread hammering it, and the OrbitEngine must
+// render a published snapshot exactly like processors configured by hand. The other way,
+// the engine's position ring must hand the UI one frame per block, in order.
+class TripleBufferTest : public juce::UnitTest
+{
+public:
+    TripleBufferTest() : juce::UnitTest ("TripleBuffer", "Audio") {}
+
+    // Every field carries the same number, so a torn read shows up as a mismatch.
+    struct Probe
+    {
+        juce::uint32 values[16] = {};
+    };
+
+    static juce::AudioBuffer<float> makeNoise (int numSamples)
+    {
+        juce::AudioBuffer<float> noise (2, numSamples);
+        juce::Random random (11);
+        for (int ch = 0; ch < 2; ++ch)
+            for (int i = 0; i < numSamples; ++i)
+                noise.setSample (ch, i, random.nextFloat() * 2.0f - 1.0f);
+        return noise;
+    }
+
+    void runTest() override
+    {
+        beginTest ("reader sees the initial value, then only the latest write");
+        {
+            Probe initial;
+            initial.values[0] = 7;
+            TripleBuffer<Probe> buffer (initial);
+            expectEquals ((int) buffer.read().values[0], 7);
+
+            for (juce::uint32 i = 1; i <= 5; ++i)
+            {
+                Probe p;
+                p.values[0] = i;
+                buffer.write (p);
+            }
+
+            expectEquals ((int) buffer.read().values[0], 5);
+            expectEquals ((int) buffer.read().values[0], 5, "no new write, same value");
+        }
+
+        beginTest ("a racing writer never tears a value");
+        {
+            TripleBuffer<Probe> buffer;
+            const juce::uint32 numWrites = 200000;
+
+            std::thread writer ([&]
+            {
+                for (juce::uint32 i = 1; i <= numWrites; ++i)
+                {
+                    Probe p;
+                    std::fill (std::begin (p.values), std::end (p.values), i);
+                    buffer.write (p);
+                }
+            });
+
+            juce::uint32 last = 0;
+            int torn = 0, backwards = 0;
+            while (last < numWrites)
+            {
+                const auto& p = buffer.read();
+                for (auto v : p.values)
+                    torn += v != p.values[0] ? 1 : 0;
+                backwards += p.values[0] < last ? 1 : 0;
+                last = p.values[0];
+            }
+
+            writer.join();
+            expectEquals (torn, 0);
+            expectEquals (backwards, 0);
+        }
+
+        beginTest ("engine renders a published snapshot like hand-set processors");
+        {
+            const double sampleRate = 48000.0;
+            const int numSamples = 4096, blockSize = 256;
+
+            OrbitEngine::Parameters parameters;
+            parameters.orbitMode = Spatializer::OrbitMode::Figure8;
+            parameters.panSpeedHz = 0.4f;
+            parameters.itdAmount = 0.5f;
+            parameters.shadowStrength = 0.7f;
+            parameters.depth = 0.4f;
+            parameters.width = 0.6f;
+            parameters.limiterEnabled = false;
+
+            OrbitEngine engine;
+            engine.prepareToPlay (blockSize, sampleRate);
+            engine.setParameters (parameters);
+
+            Spatializer spatializer;
+            spatializer.setItdAmount (0.5f);
+            spatializer.setShadowStrength (0.7f);
+            spatializer.setDepth (0.4f);
+            spatializer.setWidth (0.6f);
+            spatializer.prepareToPlay (blockSize, sampleRate);
+
+            auto rendered = makeNoise (numSamples);
+            auto expected = makeNoise (numSamples);
+            for (int start = 0; start < numSamples; start += blockSize)
+            {
+                engine.process (rendered, start, blockSize);
+                spatializer.process (expected, start, blockSize, 0.0f, Spatializer::OrbitMode::Figure8, 0.4f);
+            }
+
+            // With the limiter off, its delay is all that's left between the two.
+            const int latency = engine.getLatencySamples();
+            float maxError = 0.0f;
+            for (int ch = 0; ch < 2; ++ch)
+                for (int i = latency; i < numSamples; ++i)
+                    maxError = juce::jmax (maxError, std::abs (rendered.getSample (ch, i) - expected.getSample (ch, i - latency)));
+            expectEquals (maxError, 0.0f);
+
+            const auto preset = parameters.toPreset();
+            expectEquals (preset.orbitMode, 2);
+            expectWithinAbsoluteError (OrbitEngine::Parameters::fromPreset (preset).depth, 0.4f, 1.0e-6f);
+        }
+
+        beginTest ("engine publishes where each block left the source");
+        {
+            const double sampleRate = 48000.0;
+            const int blockSize = 480;
+
+            OrbitEngine::Parameters parameters;
+            parameters.orbitMode = Spatializer::OrbitMode::Orbit;
+            parameters.panSpeedHz = 0.25f;
+
+            OrbitEngine engine;
+            engine.prepareToPlay (blockSize, sampleRate);
+            engine.setParameters (parameters);
+
+            auto buffer = makeNoise (blockSize);
+            for (int block = 0; block < 10; ++block)
+                engine.process (buffer, 0, blockSize);
+
+            std::array<OrbitEngine::PositionFrame, 16> frames;
+            expectEquals (engine.readPositionFrames (frames.data(), (int) frames.size()), 10);
+            expectEquals (engine.readPositionFrames (frames.data(), (int) frames.size()), 0);
+
+            // A quarter of a turn a second, 10 ms a block: the 10th block ends 0.025 of a
+            // turn round, and a source at ear level delays its far ear by up to the full ITD.
+            const auto& last = frames[9];
+            expectWithinAbsoluteError (last.orbitPhase, juce::MathConstants<float>::twoPi * 0.025f, 1.0e-4f);
+            expectWithinAbsoluteError (last.position.azimuth, last.orbitPhase, 1.0e-4f);
+            expect (last.hasCues);
+            expectEquals (last.numSources, 1);
+            expectLessThan (std::abs (last.cues.rightDelay - last.cues.leftDelay), SpatialDsp::maxDelayMs + 0.01f);
+            expectGreaterThan (last.cues.rightGain, last.cues.leftGain, "the source is on the right");
+
+            // Nobody reading: the ring fills and the engine carries on.
+            for (int block = 0; block < OrbitEngine::positionRingSize * 2; ++block)
+                engine.process (buffer, 0, 32);
+
+            int total = 0;
+            while (const int n = engine.readPositionFrames (frames.data(), (int) frames.size()))
+                total += n;
+            expectEquals (total, OrbitEngine::positionRingSize - 1);
+        }
+    }
+};
+
+static TripleBufferTest tripleBufferTest;
@@ -0,0 +1,504 @@
+/*
+  ==============================================================================
+    OrbitBench: headless micro-benchmarks for the OrbitAudio hot path.
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "../../../Source/OrbitEngine.h"
+#include "../../../Source/OrbitReverb.h"
+
+#if JUCE_INTEL
+ #if JUCE_MSVC
+  #include <intrin.h>
+ #else
+  #include <x86intrin.h>
+ #endif
+#endif
+
+//==============================================================================
+namespace
+{
+    const char* const helpText =
+        "Usage: OrbitBench [options]\n"
+        "\n"
+        "Times Spatializer::process, the reverbs (OrbitRoomReverb, which the callback runs, plus\n"
+        "the Freeverb-style OrbitReverb and juce::Reverb for reference), the output limiter (OrbitLimiter)\n"
+        "and the full audio callback (OrbitEngine, as run by MainComponent::getNextAudioBlock, also with\n"
+        "32 mono sources through SpatializerBank and through the third-order AmbisonicBank) across\n"
+        "buffer sizes, sample rates and orbit modes. Input is seeded noise, so runs are repeatable.\n"
+        "\n"
+        "  --filter=<text>         Only run benchmarks whose name contains text\n"
+        "  --quick                 Block sizes 64/256/1024 at 48 and 192 kHz only\n"
+        "  --seconds=<s>           Audio processed per repeat. Default: 0.5\n"
+        "  --repeats=<n>           Repeats per case; ns/sample is their median. Default: 5\n"
+        "  --csv=<file>            Also write the results as CSV\n"
+        "  --baseline=<file.csv>   Compare ns/sample against an earlier --csv run and fail\n"
+        "                          if any case got slower by more than --tolerance\n"
+        "  --tolerance=<percent>   Allowed slowdown against the baseline. Default: 15\n";
+
+    const int blockSizes[]    = { 16, 32, 64, 128, 256, 512, 1024, 2048, 4096 };
+    const double sampleRates[] = { 44100.0, 48000.0, 88200.0, 96000.0, 176400.0, 192000.0 };
+    const int quickBlockSizes[]    = { 64, 256, 1024 };
+    const double quickSampleRates[] = { 48000.0, 192000.0 };
+
+    const Spatializer::OrbitMode orbitModes[] = { Spatializer::OrbitMode::Manual,
+                                                  Spatializer::OrbitMode::Orbit,
+                                                  Spatializer::OrbitMode::Figure8 };
+
+    juce::String getModeName (Spatializer::OrbitMode mode)
+    {
+        return mode == Spatializer::OrbitMode::Manual ? "Manual"
+             : mode == Spatializer::OrbitMode::Orbit  ? "Orbit"
+             : "Figure8";
+    }
+
+    //==============================================================================
+    // I read the CPU's cycle counter where there is one (the TSC on x86). Elsewhere I
+    // convert elapsed time at the nominal clock speed, which is what the TSC counts too.
+    struct CycleClock
+    {
+        static juce::uint64 now() noexcept
+        {
+           #if JUCE_INTEL
+            return (juce::uint64) __rdtsc();
+           #else
+            return (juce::uint64) juce::Time::getHighResolutionTicks();
+           #endif
+        }
+
+        static double toCycles (juce::uint64 elapsed) noexcept
+        {
+           #if JUCE_INTEL
+            return (double) elapsed;
+           #else
+            return juce::Time::highResolutionTicksToSeconds ((juce::int64) elapsed)
+                     * juce::SystemStats::getCpuSpeedInMegahertz() * 1.0e6;
+           #endif
+        }
+
+        static juce::String describe()
+        {
+           #if JUCE_INTEL
+            return "TSC";
+           #else
+            return "time x " + juce::String (juce::SystemStats::getCpuSpeedInMegahertz()) + " MHz";
+           #endif
+        }
+    };
+
+    //==============================================================================
+    // One thing to time: I build a fresh processor for each case and hand back the
+    // per-block call, so no state leaks between cases.
+    using BlockFunction = std::function<void (juce::AudioBuffer<float>&, int)>;
+
+    struct Benchmark
+    {
+        juce::String name;
+        bool dependsOnMode = true;
+        std::function<BlockFunction (double sampleRate, int blockSize, Spatializer::OrbitMode)> create;
+    };
+
+    struct Result
+    {
+        juce::String name, mode;
+        double sampleRate = 0.0;
+        int blockSize = 0;
+        double nsPerSample = 0.0;
+        double cyclesPerSample = 0.0;
+        double worstBlockMicroseconds = 0.0;
+
+        // The worst block as a share of its real-time deadline (blockSize / sampleRate).
+        double getWorstBlockLoad() const   { return worstBlockMicroseconds * 1.0e-6 * sampleRate / blockSize; }
+
+        juce::String getKey() const
+        {
+            return name + "," + mode + "," + juce::String ((int) sampleRate) + "," + juce::String (blockSize);
+        }
+    };
+
+    // A deterministic HRIR set, so the HRTF callback has real filters to run without any
+    // files: decaying noise per ear every 15 degrees, three elevation rings.
+    std::shared_ptr<const HrirSet> makeSyntheticHrirSet()
+    {
+        auto set = std::make_shared<HrirSet>();
+        juce::Random random (0x0b17);
+
+        for (int elevation = -30; elevation <= 30; elevation += 30)
+        {
+            for (int azimuth = 0; azimuth < 360; azimuth += 15)
+            {
+                juce::AudioBuffer<float> ir (2, 256);
+                for (int ch = 0; ch < 2; ++ch)
+                    for (int i = 0; i < ir.getNumSamples(); ++i)
+                        ir.setSample (ch, i, (random.nextFloat() * 2.0f - 1.0f) * std::exp (-0.02f * (float) i));
+
+                set->addMeasurement ((float) azimuth, (float) elevation, ir, 48000.0);
+            }
+        }
+
+        return set;
+    }
+
+    std::vector<Benchmark> createBenchmarks()
+    {
+        std::vector<Benchmark> benchmarks;
+
+        benchmarks.push_back ({ "Spatializer", true, [] (double sampleRate, int blockSize, Spatializer::OrbitMode mode) -> BlockFunction
+        {
+            auto spatializer = std::make_shared<Spatializer>();
+            spatializer->setDepth (0.3f);
+            spatializer->prepareToPlay (blockSize, sampleRate);
+
+            // Compiled up front, as the engine's snapshot carries it.
+            auto path = std::make_shared<OrbitPath> (OrbitTrajectory::compileForMode (mode, 0.3f, {}));
+            const float loopsPerSecond = mode == Spatializer::OrbitMode::Manual ? 0.0f : 0.25f;
+
+            return [spatializer, path, loopsPerSecond] (juce::AudioBuffer<float>& buffer, int n)
+            {
+                spatializer->process (buffer, 0, n, *path, loopsPerSecond);
+            };
+        } });
+
+        // The room reverb the callback runs, with the source circling once every four seconds.
+        benchmarks.push_back ({ "RoomReverb", false, [] (double sampleRate, int, Spatializer::OrbitMode) -> BlockFunction
+        {
+            auto reverb = std::make_shared<OrbitRoomReverb>();
+            reverb->setSampleRate (sampleRate);
+            auto azimuth = std::make_shared<float> (0.0f);
+            const float radiansPerSample = juce::MathConstants<float>::twoPi * 0.25f / (float) sampleRate;
+
+            return [reverb, azimuth, radiansPerSample] (juce::AudioBuffer<float>& buffer, int n)
+            {
+                *azimuth = std::remainder (*azimuth + radiansPerSample * (float) n, juce::MathConstants<float>::twoPi);
+                reverb->setSourceAzimuth (*azimuth);
+                reverb->processStereo (buffer.getWritePointer (0), buffer.getWritePointer (1), n);
+            };
+        } });
+
+        benchmarks.push_back ({ "Reverb", false, [] (double sampleRate, int, Spatializer::OrbitMode) -> BlockFunction
+        {
+            auto reverb = std::make_shared<OrbitReverb>();
+            reverb->setSampleRate (sampleRate);
+            return [reverb] (juce::AudioBuffer<float>& buffer, int n)
+            {
+                reverb->processStereo (buffer.getWritePointer (0), buffer.getWritePointer (1), n);
+            };
+        } });
+
+        benchmarks.push_back ({ "JuceReverb", false, [] (double sampleRate, int, Spatializer::OrbitMode) -> BlockFunction
+        {
+            auto reverb = std::make_shared<juce::Reverb>();
+            reverb->setSampleRate (sampleRate);
+            return [reverb] (juce::AudioBuffer<float>& buffer, int n)
+            {
+                reverb->processStereo (buffer.getWritePointer (0), buffer.getWritePointer (1), n);
+            };
+        } });
+
+        // The output limiter, on noise loud enough that it limits all the time.
+        benchmarks.push_back ({ "Limiter", false, [] (double sampleRate, int, Spatializer::OrbitMode) -> BlockFunction
+        {
+            auto limiter = std::make_shared<OrbitLimiter>();
+            limiter->prepare (sampleRate, 2.0f);
+            limiter->setCeilingDecibels (-12.0f);
+            return [limiter] (juce::AudioBuffer<float>& buffer, int n)
+            {
+                limiter->processStereo (buffer.getWritePointer (0), buffer.getWritePointer (1), n);
+            };
+        } });
+
+        // The full callback as MainComponent runs it: parametric head and reverb on.
+        benchmarks.push_back ({ "Callback", true, [] (double sampleRate, int blockSize, Spatializer::OrbitMode mode) -> BlockFunction
+        {
+            OrbitEngine::Parameters parameters;
+            parameters.pan = 0.3f;
+            parameters.orbitMode = mode;
+            parameters.panSpeedHz = 0.25f;
+            parameters.depth = 0.3f;
+            parameters.reverbEnabled = true;
+
+            auto engine = std::make_shared<OrbitEngine>();
+            engine->setParameters (parameters);
+            engine->prepareToPlay (blockSize, sampleRate);
+
+            return [engine] (juce::AudioBuffer<float>& buffer, int n)
+            {
+                engine->process (buffer, 0, n);
+            };
+        } });
+
+        benchmarks.push_back ({ "CallbackHrtf", true, [] (double sampleRate, int blockSize, Spatializer::OrbitMode mode) -> BlockFunction
+        {
+            static const auto hrirSet = makeSyntheticHrirSet();
+
+            OrbitEngine::Parameters parameters;
+            parameters.pan = 0.3f;
+            parameters.orbitMode = mode;
+            parameters.panSpeedHz = 0.25f;
+            parameters.useHrtf = true;
+            parameters.depth = 0.3f;
+            parameters.reverbEnabled = true;
+
+            auto engine = std::make_shared<OrbitEngine>();
+            engine->setParameters (parameters);
+            engine->prepareToPlay (blockSize, sampleRate);
+            engine->setHrirSet (hrirSet);
+
+            return [engine] (juce::AudioBuffer<float>& buffer, int n)
+            {
+                engine->process (buffer, 0, n);
+            };
+        } });
+
+        // 32 mono sources, per-source through the SpatializerBank or all together through
+        // the third-order ambisonic bus. The timed buffer only has the stereo pair, so the
+        // other 30 channels hold fixed noise and the pair is copied in and out around the
+        // engine (two short copies against 32 sources' work).
+        const auto addMultiSource = [&benchmarks] (const char* benchmarkName, int ambisonicOrder)
+        {
+            benchmarks.push_back ({ benchmarkName, true, [ambisonicOrder] (double sampleRate, int blockSize, Spatializer::OrbitMode mode) -> BlockFunction
+            {
+                constexpr int numSources = SpatializerBank::maxSources;
+
+                OrbitEngine::Parameters parameters;
+                parameters.pan = 0.3f;
+                parameters.orbitMode = mode;
+                parameters.panSpeedHz = 0.25f;
+                parameters.sourceLayout = 2;
+                parameters.ambisonicOrder = ambisonicOrder;
+                parameters.depth = 0.3f;
+                parameters.reverbEnabled = true;
+
+                auto engine = std::make_shared<OrbitEngine>();
+                engine->setParameters (parameters);
+                engine->prepareToPlay (blockSize, sampleRate, numSources);
+
+                auto sources = std::make_shared<juce::AudioBuffer<float>> (numSources, blockSize);
+                juce::Random random (7);
+                for (int ch = 0; ch < numSources; ++ch)
+                    for (int i = 0; i < blockSize; ++i)
+                        sources->setSample (ch, i, 0.05f * (random.nextFloat() * 2.0f - 1.0f));
+
+                return [engine, sources] (juce::AudioBuffer<float>& buffer, int n)
+                {
+                    for (int ch = 0; ch < 2; ++ch)
+                        sources->copyFrom (ch, 0, buffer, ch, 0, n);
+
+                    engine->process (*sources, 0, n);
+
+                    for (int ch = 0; ch < 2; ++ch)
+                        buffer.copyFrom (ch, 0, *sources, ch, 0, n);
+                };
+            } });
+        };
+
+        addMultiSource ("Bank32", 0);
+        addMultiSource ("Ambisonic32", 3);
+
+        return benchmarks;
+    }
+
+    //==============================================================================
+    Result runCase (const Benchmark& benchmark, double sampleRate, int blockSize, Spatializer::OrbitMode mode,
+                    double seconds, int repeats, const juce::AudioBuffer<float>& noise)
+    {
+        Result result { benchmark.name, benchmark.dependsOnMode ? getModeName (mode) : juce::String ("-"),
+                        sampleRate, blockSize };
+
+        const int numBlocks = juce::jmax (8, (int) std::ceil (seconds * sampleRate / blockSize));
+        const int warmUpBlocks = juce::jmax (4, numBlocks / 8);
+        const int noiseBlocks = noise.getNumSamples() / blockSize;
+
+        juce::AudioBuffer<float> buffer (2, blockSize);
+        std::vector<double> nsPerSample, cyclesPerSample;
+        juce::int64 worstTicks = 0;
+
+        for (int repeat = 0; repeat < repeats; ++repeat)
+        {
+            auto process = benchmark.create (sampleRate, blockSize, mode);
+            juce::int64 totalTicks = 0;
+            juce::uint64 totalCycles = 0;
+
+            for (int block = -warmUpBlocks; block < numBlocks; ++block)
+            {
+                // Fresh input every block, as from a device; the copy isn't timed.
+                const int offset = ((block + warmUpBlocks) % noiseBlocks) * blockSize;
+                for (int ch = 0; ch < 2; ++ch)
+                    buffer.copyFrom (ch, 0, noise, ch, offset, blockSize);
+
+                const auto startCycles = CycleClock::now();
+                const auto startTicks = juce::Time::getHighResolutionTicks();
+                process (buffer, blockSize);
+                const auto ticks = juce::Time::getHighResolutionTicks() - startTicks;
+                const auto cycles = CycleClock::now() - startCycles;
+
+                if (block >= 0)
+                {
+                    totalTicks += ticks;
+                    totalCycles += cycles;
+                    worstTicks = juce::jmax (worstTicks, ticks);
+                }
+            }
+
+            const double samples = (double) numBlocks * blockSize;
+            nsPerSample.push_back (juce::Time::highResolutionTicksToSeconds (totalTicks) * 1.0e9 / samples);
+            cyclesPerSample.push_back (CycleClock::toCycles (totalCycles) / samples);
+        }
+
+        // Medians, so one preempted repeat doesn't skew the figure.
+        std::sort (nsPerSample.begin(), nsPerSample.end());
+        std::sort (cyclesPerSample.begin(), cyclesPerSample.end());
+        result.nsPerSample = nsPerSample[nsPerSample.size() / 2];
+        result.cyclesPerSample = cyclesPerSample[cyclesPerSample.size() / 2];
+        result.worstBlockMicroseconds = juce::Time::highResolutionTicksToSeconds (worstTicks) * 1.0e6;
+        return result;
+    }
+
+    juce::String formatRow (const Result& r)
+    {
+        return r.name.paddedRight (' ', 14)
+             + r.mode.paddedRight (' ', 9)
+             + juce::String ((int) r.sampleRate).paddedLeft (' ', 7)
+             + juce::String (r.blockSize).paddedLeft (' ', 7)
+             + juce::String (r.nsPerSample, 2).paddedLeft (' ', 11)
+             + juce::String (r.cyclesPerSample, 1).paddedLeft (' ', 12)
+             + juce::String (r.worstBlockMicroseconds, 1).paddedLeft (' ', 12)
+             + (juce::String (r.getWorstBlockLoad() * 100.0, 1) + "%").paddedLeft (' ', 10);
+    }
+
+    std::map<juce::String, double> readBaseline (const juce::File& file)
+    {
+        std::map<juce::String, double> baseline;
+        juce::StringArray lines;
+        file.readLines (lines);
+
+        for (int i = 1; i < lines.size(); ++i)
+        {
+            const auto fields = juce::StringArray::fromTokens (lines[i], ",", {});
+            if (fields.size() >= 5)
+                baseline[fields[0] + "," + fields[1] + "," + fields[2] + "," + fields[3]] = fields[4].getDoubleValue();
+        }
+
+        return baseline;
+    }
+
+    //==============================================================================
+    void runBenchmarks (juce::ArgumentList args)
+    {
+        const auto filter = args.removeValueForOption ("--filter");
+        const bool quick = args.removeOptionIfFound ("--quick");
+        const double seconds = juce::jlimit (0.01, 60.0, args.containsOption ("--seconds")
+                                                           ? args.removeValueForOption ("--seconds").getDoubleValue() : 0.5);
+        const int repeats = juce::jlimit (1, 101, args.containsOption ("--repeats")
+                                                     ? args.removeValueForOption ("--repeats").getIntValue() : 5);
+        const auto csvPath = args.removeValueForOption ("--csv");
+        const auto baselinePath = args.removeValueForOption ("--baseline");
+        const double tolerance = args.containsOption ("--tolerance")
+                                   ? args.removeValueForOption ("--tolerance").getDoubleValue() : 15.0;
+
+        if (! args.arguments.isEmpty())
+            juce::ConsoleApplication::fail ("Unknown argument " + args.arguments.getReference (0).text + "\n\n" + helpText);
+
+        std::map<juce::String, double> baseline;
+        if (baselinePath.isNotEmpty())
+        {
+            const auto file = juce::File::getCurrentWorkingDirectory().getChildFile (baselinePath);
+            if (! file.existsAsFile())
+                juce::ConsoleApplication::fail ("No baseline at " + file.getFullPathName());
+            baseline = readBaseline (file);
+        }
+
+        std::vector<int> sizes;
+        std::vector<double> rates;
+        if (quick)
+        {
+            sizes.assign (std::begin (quickBlockSizes), std::end (quickBlockSizes));
+            rates.assign (std::begin (quickSampleRates), std::end (quickSampleRates));
+        }
+        else
+        {
+            sizes.assign (std::begin (blockSizes), std::end (blockSizes));
+            rates.assign (std::begin (sampleRates), std::end (sampleRates));
+        }
+
+        // Seeded noise at -12 dBFS, long enough to give the largest block fresh input.
+        juce::AudioBuffer<float> noise (2, 16 * 4096);
+        juce::Random random (42);
+        for (int ch = 0; ch < 2; ++ch)
+            for (int i = 0; i < noise.getNumSamples(); ++i)
+                noise.setSample (ch, i, 0.25f * (random.nextFloat() * 2.0f - 1.0f));
+
+        const juce::ScopedNoDenormals noDenormals;
+
+        std::cout << juce::SystemStats::getCpuModel() << ", " << juce::SystemStats::getOperatingSystemName()
+                  << "; cycles from " << CycleClock::describe() << "; " << repeats << " x "
+                  << seconds << " s per case" << std::endl << std::endl;
+        std::cout << "Benchmark     Mode        Rate  Block  ns/sample  cyc/sample  worst (us)  worst/deadline" << std::endl;
+
+        std::vector<Result> results;
+        int regressions = 0;
+
+        for (const auto& benchmark : createBenchmarks())
+        {
+            if (filter.isNotEmpty() && ! benchmark.name.containsIgnoreCase (filter))
+                continue;
+
+            for (auto mode : orbitModes)
+            {
+                if (! benchmark.dependsOnMode && mode != Spatializer::OrbitMode::Manual)
+                    continue;
+
+                for (auto rate : rates)
+                {
+                    for (auto size : sizes)
+                    {
+                        const auto result = runCase (benchmark, rate, size, mode, seconds, repeats, noise);
+                        results.push_back (result);
+
+                        auto line = formatRow (result);
+                        const auto previous = baseline.find (result.getKey());
+                        if (previous != baseline.end() && previous->second > 0.0)
+                        {
+                            const double change = (result.nsPerSample / previous->second - 1.0) * 100.0;
+                            line << "  " << (change >= 0.0 ? "+" : "") << juce::String (change, 1) << "%";
+                            if (change > tolerance)
+                            {
+                                line << " REGRESSION";
+                                ++regressions;
+                            }
+                        }
+
+                        std::cout << line << std::endl;
+                    }
+                }
+            }
+        }
+
+        if (csvPath.isNotEmpty())
+        {
+            juce::String csv ("benchmark,mode,sampleRate,blockSize,nsPerSample,cyclesPerSample,worstBlockUs,worstBlockLoad\n");
+            for (const auto& r : results)
+                csv << r.getKey() << "," << juce::String (r.nsPerSample, 4) << "," << juce::String (r.cyclesPerSample, 2)
+                    << "," << juce::String (r.worstBlockMicroseconds, 2) << "," << juce::String (r.getWorstBlockLoad(), 5) << "\n";
+
+            const auto file = juce::File::getCurrentWorkingDirectory().getChildFile (csvPath);
+            if (! file.replaceWithText (csv))
+                juce::ConsoleApplication::fail ("Can't write " + file.getFullPathName());
+        }
+
+        if (regressions > 0)
+            juce::ConsoleApplication::fail (juce::String (regressions) + " case(s) slower than the baseline by more than "
+                                            + juce::String (tolerance, 1) + "%", 2);
+    }
+}
+
+//==============================================================================
+int main (int argc, char* argv[])
+{
+    juce::ConsoleApplication app;
+    app.addHelpCommand ("--help|-h", helpText, false);
+    app.addDefaultCommand ({ "", "[options]", "Run the benchmarks", helpText, runBenchmarks });
+
+    return app.findAndRunCommand (argc, argv);
+}
@@ -0,0 +1,74 @@
+/*
+  ==============================================================================
+    OrbitHeadSender: plays recorded head movement to OrbitAudio's head tracking.
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "../../../Source/HeadMotionRecording.h"
+#include "../../../Source/HeadTracker.h"
+
+//==============================================================================
+namespace
+{
+    const char* const helpText =
+        "Usage: OrbitHeadSender [options] <recording.csv>\n"
+        "\n"
+        "Sends a head-motion recording to OrbitAudio's head tracking port as OSC, the way a\n"
+        "head tracker would, at the pace it was recorded. A recording has one measurement per\n"
+        "line: seconds, yaw, pitch, roll, in degrees. Lines starting with # are comments.\n"
+        "Recordings/LookAround.csv is an example.\n"
+        "\n"
+        "  --host=<address>    Where OrbitAudio is running. Default: 127.0.0.1\n"
+        "  --port=<n>          Its head tracking port. Default: 9000\n"
+        "  --speed=<factor>    Play faster (2) or slower (0.5). Default: 1\n"
+        "  --loop              Play the recording over and over, until interrupted\n";
+
+    void send (juce::ArgumentList args)
+    {
+        const auto hostOption = args.removeValueForOption ("--host").trim();
+        const auto host = hostOption.isEmpty() ? juce::String ("127.0.0.1") : hostOption;
+
+        const auto portText = args.removeValueForOption ("--port");
+        const int port = portText.isEmpty() ? HeadTracker::defaultPort : portText.getIntValue();
+        if ((portText.isNotEmpty() && ! portText.containsOnly ("0123456789")) || port < 1 || port > 65535)
+            juce::ConsoleApplication::fail ("--port must be between 1 and 65535");
+
+        const auto speedText = args.removeValueForOption ("--speed");
+        const double speed = speedText.isEmpty() ? 1.0 : speedText.getDoubleValue();
+        if (speed < 0.01 || speed > 100.0)
+            juce::ConsoleApplication::fail ("--speed must be between 0.01 and 100");
+
+        const bool loop = args.removeOptionIfFound ("--loop");
+
+        for (const auto& arg : args.arguments)
+            if (arg.isOption())
+                juce::ConsoleApplication::fail ("Unknown option " + arg.text);
+
+        if (args.size() != 1)
+            juce::ConsoleApplication::fail ("Give one recording to play.\n\n" + juce::String (helpText));
+
+        HeadMotionRecording recording;
+        const auto file = args[0].resolveAsFile();
+        if (const auto loaded = recording.load (file); loaded.failed())
+            juce::ConsoleApplication::fail (file.getFileName() + ": " + loaded.getErrorMessage());
+
+        std::cout << "Sending " << recording.frames.size() << " measurements ("
+                  << juce::String (recording.getLength(), 1) << " s) to "
+                  << host << ":" << port << (loop ? ", looping" : "") << std::endl;
+
+        if (const auto played = recording.play (host, port, speed, loop ? 0 : 1); played.failed())
+            juce::ConsoleApplication::fail (played.getErrorMessage());
+    }
+}
+
+//==============================================================================
+int main (int argc, char* argv[])
+{
+    juce::ConsoleApplication app;
+    app.addHelpCommand ("--help|-h", helpText, false);
+    app.addVersionCommand ("--version|-v", juce::String (ProjectInfo::projectName) + " " + ProjectInfo::versionString);
+    app.addDefaultCommand ({ "", "[options] <recording.csv>", "Play a head-motion recording", helpText, send });
+
+    return app.findAndRunCommand (argc, argv);
+}